@@ -670,10 +670,11 @@ PAM_EXTERN int pam_sm_acct_mgmt(pam_handle_t *pamh, int flags
 	if (_load_cgroup_config() != SLURM_SUCCESS)
 		return rc;
 
-	/* Check if there are any steps on the node from any user. A failure here
+	/* Obtain this user's steps on the node from slurmd. A failure here
 	 * likely means failures everywhere so exit on failure or if no local jobs
 	 * exist. */
-	steps = stepd_available(NULL, opts.node_name);
+	steps = stepd_available_filter(NULL, opts.node_name, NO_VAL,
+				       pwd.pw_uid);
 	if (!steps) {
 		error("Error obtaining local step information.");
 		goto cleanup;
@@ -192,6 +192,12 @@ enum cluster_fed_states {
 #define SLURMDB_CLASSIFIED_FLAG 0x0100
 #define SLURMDB_CLASS_BASE      0x00ff
 
+/* with_usage of slurmdb_assoc_cond_t and slurmdb_wckey_cond_t */
+#define SLURMDB_USAGE_PERIODS 1 /* An accounting record per TRES and
+				 * rollup period */
+#define SLURMDB_USAGE_SUMMED  2 /* An accounting record per TRES, summed by
+				 * the database over usage_start-usage_end */
+
 /* Cluster flags */
 #define CLUSTER_FLAG_BG     0x00000001 /* This is a bluegene cluster */
 #define CLUSTER_FLAG_BGL    0x00000002 /* This is a bluegene/l cluster */
@@ -260,7 +266,7 @@ typedef struct {
 
 	List user_list;		/* list of char * */
 
-	uint16_t with_usage;  /* fill in usage */
+	uint16_t with_usage;  /* fill in usage, SLURMDB_USAGE_* */
 	uint16_t with_deleted; /* return deleted associations */
 	uint16_t with_raw_qos; /* return a raw qos or delta_qos */
 	uint16_t with_sub_accts; /* return sub acct information also */
@@ -1134,7 +1140,7 @@ typedef struct {
 
 	List user_list;		/* list of char * */
 
-	uint16_t with_usage;    /* fill in usage */
+	uint16_t with_usage;    /* fill in usage, SLURMDB_USAGE_* */
 	uint16_t with_deleted;  /* return deleted associations */
 } slurmdb_wckey_cond_t;
 
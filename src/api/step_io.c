@@ -37,6 +37,7 @@
 #include <sys/select.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <time.h>
 
 #include "src/common/fd.h"
@@ -60,6 +61,9 @@
 
 #define STDIO_MAX_FREE_BUF 1024
 
+/* Most queued messages gathered into a single writev() to a file */
+#define IO_BATCH_MAX 64
+
 struct io_buf {
 	int ref_count;
 	uint32_t length;
@@ -568,6 +572,68 @@ static bool _file_writable(eio_obj_t *obj)
 	return false;
 }
 
+/* Return the bytes of msg to write to the file of info, 0 if the message is
+ * from a task whose output info ignores */
+static int _file_msg_len(struct file_write_info *info, struct io_buf *msg)
+{
+	if ((info->taskid != (uint32_t) -1) &&
+	    (msg->header.gtaskid != info->taskid))
+		return 0;
+	return msg->length;
+}
+
+/*
+ * Write the rest of info->out_msg and the messages queued behind it with as
+ * few system calls as possible, for output without labels. Messages written
+ * in full are freed and the first one not written stays in info->out_msg.
+ */
+static int _file_write_batch(eio_obj_t *obj, struct file_write_info *info)
+{
+	struct iovec iov[IO_BATCH_MAX];
+	ListIterator msgs;
+	struct io_buf *msg;
+	int cnt = 0, len, n;
+
+	if (_file_msg_len(info, info->out_msg)) {
+		iov[cnt].iov_base = info->out_msg->data +
+			(info->out_msg->length - info->out_remaining);
+		iov[cnt++].iov_len = info->out_remaining;
+	}
+	msgs = list_iterator_create(info->msg_queue);
+	while ((cnt < IO_BATCH_MAX) && (msg = list_next(msgs))) {
+		if (!(len = _file_msg_len(info, msg)))
+			continue;
+		iov[cnt].iov_base = msg->data;
+		iov[cnt++].iov_len = len;
+	}
+	list_iterator_destroy(msgs);
+
+	if ((n = write_unlabelled_iov(obj->fd, iov, cnt)) < 0) {
+		list_enqueue(info->cio->free_outgoing, info->out_msg);
+		info->out_msg = NULL;
+		info->eof = true;
+		return SLURM_ERROR;
+	}
+	debug3("  wrote %d bytes in %d messages", n, cnt);
+
+	while (info->out_msg) {
+		len = _file_msg_len(info, info->out_msg) ?
+		      info->out_remaining : 0;
+		if (n < len) {
+			info->out_remaining -= n;
+			break;
+		}
+		n -= len;
+		info->out_msg->ref_count--;
+		if (info->out_msg->ref_count == 0)
+			list_enqueue(info->cio->free_outgoing, info->out_msg);
+		if ((info->out_msg = list_dequeue(info->msg_queue)))
+			info->out_remaining = info->out_msg->length;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 static int _file_write(eio_obj_t *obj, List objs)
 {
 	struct file_write_info *info = (struct file_write_info *) obj->arg;
@@ -588,6 +654,9 @@ static int _file_write(eio_obj_t *obj, List objs)
 		info->out_remaining = info->out_msg->length;
 	}
 
+	if (!info->cio->label && !info->eof)
+		return _file_write_batch(obj, info);
+
 	/*
 	 * Write message to file.
 	 */
@@ -77,6 +77,7 @@
 
 #define MAX_THREADS      8	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_PIPELINE     16	/* Maximum blocks in flight */
 
 int block_len;				/* block size */
 int fd;					/* source file descriptor */
@@ -377,6 +378,205 @@ static int _next_block(struct bcast_parameters *params,
 	return _get_block_none(buffer, orig_len, more);
 }
 
+/*
+ * Compress one block of the file independently of the others, so several
+ * blocks can be compressed at once. Unlike _get_block_lz4(), lz4 consumes
+ * exactly len bytes so the block boundaries are known in advance.
+ * RET compressed length or -1 if the block should be sent uncompressed
+ */
+static int _compress_block(uint16_t compress, void *position, int len,
+			   char *out, int out_len)
+{
+	switch (compress) {
+	case COMPRESS_ZLIB:
+	{
+#if HAVE_LIBZ
+		uLongf size = out_len;
+		if (compress2((Bytef *) out, &size, position, len,
+			      Z_DEFAULT_COMPRESSION) != Z_OK)
+			return -1;
+		return size;
+#else
+		return -1;
+#endif
+	}
+	case COMPRESS_LZ4:
+	{
+#if HAVE_LZ4
+		int size = LZ4_compress_default(position, out, len, out_len);
+		return size ? size : -1;
+#else
+		return -1;
+#endif
+	}
+	}
+
+	return -1;
+}
+
+/* worst case compressed size of a block */
+static int _compress_bound(uint16_t compress, int len)
+{
+	switch (compress) {
+#if HAVE_LIBZ
+	case COMPRESS_ZLIB:
+		return compressBound(len);
+#endif
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		return LZ4_compressBound(len);
+#endif
+	}
+
+	return 0;
+}
+
+typedef struct {
+	file_bcast_msg_t *bcast_msg;	/* template for all blocks */
+	uint32_t last_block_no;		/* block sent after all others */
+	pthread_mutex_t mutex;
+	uint32_t next_block_no;		/* next block to compress and send */
+	struct bcast_parameters *params;
+	int rc;
+	uint64_t size_compressed;
+	uint64_t size_uncompressed;
+	uint32_t time_compression;
+} bcast_pipe_t;
+
+/* Compress and send the block with the given number, no locks needed */
+static int _pipe_send_block(bcast_pipe_t *pipe, uint32_t block_no, char *out,
+			    int out_len, uint64_t *size_compressed,
+			    uint32_t *time_compression)
+{
+	file_bcast_msg_t bcast_msg;
+	uint64_t offset = (uint64_t) (block_no - 1) * block_len;
+	int len = MIN(block_len, f_stat.st_size - offset);
+	int size = -1;
+	DEF_TIMERS;
+
+	memcpy(&bcast_msg, pipe->bcast_msg, sizeof(file_bcast_msg_t));
+	bcast_msg.block_no	= block_no;
+	bcast_msg.block_offset	= offset;
+	bcast_msg.uncomp_len	= len;
+	bcast_msg.last_block	= (block_no == pipe->last_block_no);
+
+	if (out && len) {
+		START_TIMER;
+		size = _compress_block(pipe->params->compress, src + offset,
+				       len, out, out_len);
+		END_TIMER;
+		*time_compression += DELTA_TIMER;
+	}
+	if (size >= 0) {
+		bcast_msg.compress = pipe->params->compress;
+		bcast_msg.block = out;
+		bcast_msg.block_len = size;
+	} else {
+		/* the message is packed, so the mmap is sent as is */
+		bcast_msg.compress = COMPRESS_OFF;
+		bcast_msg.block = src + offset;
+		bcast_msg.block_len = len;
+	}
+	*size_compressed += bcast_msg.block_len;
+	debug("block %u, size %u", bcast_msg.block_no, bcast_msg.block_len);
+
+	return _file_bcast(pipe->params, &bcast_msg, sbcast_cred);
+}
+
+/* worker thread, sends the middle blocks of the file in any order */
+static void *_pipe_worker(void *arg)
+{
+	bcast_pipe_t *pipe = (bcast_pipe_t *) arg;
+	int out_len = _compress_bound(pipe->params->compress, block_len);
+	char *out = out_len ? xmalloc(out_len) : NULL;
+	uint64_t size_compressed;
+	uint32_t block_no, time_compression;
+	int rc;
+
+	while (1) {
+		slurm_mutex_lock(&pipe->mutex);
+		if ((pipe->rc != SLURM_SUCCESS) ||
+		    (pipe->next_block_no >= pipe->last_block_no)) {
+			slurm_mutex_unlock(&pipe->mutex);
+			break;
+		}
+		block_no = pipe->next_block_no++;
+		slurm_mutex_unlock(&pipe->mutex);
+
+		size_compressed = 0;
+		time_compression = 0;
+		rc = _pipe_send_block(pipe, block_no, out, out_len,
+				      &size_compressed, &time_compression);
+
+		slurm_mutex_lock(&pipe->mutex);
+		pipe->rc = MAX(pipe->rc, rc);
+		pipe->size_compressed += size_compressed;
+		pipe->time_compression += time_compression;
+		slurm_mutex_unlock(&pipe->mutex);
+	}
+	xfree(out);
+
+	return NULL;
+}
+
+/*
+ * Broadcast the file keeping up to params->pipeline blocks in flight.
+ * Each block is written by the slurmd at its own offset, so the middle
+ * blocks can be compressed and sent in parallel. The first block opens
+ * the file and the last one closes it, so they are sent on their own.
+ */
+static int _bcast_file_pipeline(struct bcast_parameters *params,
+				file_bcast_msg_t *bcast_msg,
+				uint64_t *size_uncompressed,
+				uint64_t *size_compressed,
+				uint32_t *time_compression)
+{
+	bcast_pipe_t pipe;
+	pthread_t thread_id[MAX_PIPELINE];
+	int i, out_len, threads, rc;
+	char *out;
+
+	memset(&pipe, 0, sizeof(bcast_pipe_t));
+	pipe.bcast_msg = bcast_msg;
+	pipe.params = params;
+	if (block_len)
+		pipe.last_block_no = (f_stat.st_size + block_len - 1) /
+				     block_len;
+	else
+		pipe.last_block_no = 1;		/* empty file */
+	pipe.next_block_no = 2;
+	slurm_mutex_init(&pipe.mutex);
+	*size_uncompressed = f_stat.st_size;
+
+	out_len = _compress_bound(params->compress, block_len);
+	out = out_len ? xmalloc(out_len) : NULL;
+	rc = _pipe_send_block(&pipe, 1, out, out_len, size_compressed,
+			      time_compression);
+
+	threads = MIN(params->pipeline, MAX_PIPELINE);
+	threads = MIN(threads, (int) pipe.last_block_no - 2);
+	if ((rc == SLURM_SUCCESS) && (threads > 0)) {
+		verbose("sending %u blocks with %d in flight",
+			pipe.last_block_no, threads);
+		for (i = 0; i < threads; i++)
+			slurm_thread_create(&thread_id[i], _pipe_worker, &pipe);
+		for (i = 0; i < threads; i++)
+			pthread_join(thread_id[i], NULL);
+		rc = pipe.rc;
+		*size_compressed += pipe.size_compressed;
+		*time_compression += pipe.time_compression;
+	}
+
+	if ((rc == SLURM_SUCCESS) && (pipe.last_block_no > 1)) {
+		rc = _pipe_send_block(&pipe, pipe.last_block_no, out, out_len,
+				      size_compressed, time_compression);
+	}
+	xfree(out);
+	slurm_mutex_destroy(&pipe.mutex);
+
+	return rc;
+}
+
 /* read and broadcast the file */
 static int _bcast_file(struct bcast_parameters *params)
 {
@@ -414,6 +614,13 @@ static int _bcast_file(struct bcast_parameters *params)
 		params->fanout = MAX_THREADS;
 	slurm_set_tree_width(MIN(MAX_THREADS, params->fanout));
 
+	if (params->pipeline > 1) {
+		rc = _bcast_file_pipeline(params, &bcast_msg,
+					  &size_uncompressed, &size_compressed,
+					  &time_compression);
+		more = false;
+	}
+
 	while (more) {
 		START_TIMER;
 		bcast_msg.block_len = _next_block(params, &buffer, &orig_len,
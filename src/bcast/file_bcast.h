@@ -48,6 +48,8 @@ struct bcast_parameters {
 	bool force;
 	uint32_t job_id;		/* Job ID or Pack Job ID */
 	uint32_t pack_job_offset;	/* Pack Job Offset or NO_VAL */
+	int pipeline;			/* blocks in flight, 0 or 1 for one
+					 * block at a time */
 	bool preserve;
 	char *src_fname;
 	uint32_t step_id;
@@ -70,14 +70,22 @@ List assoc_mgr_wckey_list = NULL;
 
 static char *assoc_mgr_cluster_name = NULL;
 static int setup_children = 0;
-static assoc_mgr_lock_flags_t assoc_mgr_locks;
 static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
 static int *assoc_mgr_tres_old_pos = NULL;
 
-static pthread_mutex_t locks_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t locks_cond = PTHREAD_COND_INITIALIZER;
+/*
+ * One rwlock per data type, so readers of a list run concurrently with each
+ * other and only wait on a writer of that same list. Writers are preferred
+ * where the platform allows it, as the old counting locks did, so a steady
+ * stream of readers (e.g. the scheduler) can not starve usage updates.
+ * This only splits the locks: lookups and limit checks still read the live
+ * records, and the usage of associations and QOS is still updated under
+ * the write lock of their list, so these readers do wait on usage writers.
+ */
+static pthread_rwlock_t entity_locks[ASSOC_MGR_ENTITY_COUNT];
+static pthread_once_t entity_locks_once = PTHREAD_ONCE_INIT;
 
 static bool _running_cache(void)
 {
@@ -1905,68 +1913,62 @@ static int _refresh_assoc_wckey_list(void *db_conn, int enforce)
 	return SLURM_SUCCESS;
 }
 
+static void _init_entity_locks(void)
+{
+	pthread_rwlockattr_t attr;
+	int i;
+
+	pthread_rwlockattr_init(&attr);
+#if defined(__GLIBC__)
+	pthread_rwlockattr_setkind_np(
+		&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+	for (i = 0; i < ASSOC_MGR_ENTITY_COUNT; i++) {
+		if (pthread_rwlock_init(&entity_locks[i], &attr))
+			fatal("%s: pthread_rwlock_init(): %m", __func__);
+	}
+	pthread_rwlockattr_destroy(&attr);
+}
+
 /* _wr_rdlock - Issue a read lock on the specified data type */
 static void _wr_rdlock(assoc_mgr_lock_datatype_t datatype)
 {
-	//info("going to read lock on %d", datatype);
-	slurm_mutex_lock(&locks_mutex);
-	//info("read lock on %d", datatype);
-	while (1) {
-		if ((assoc_mgr_locks.entity[write_wait_lock(datatype)] ==
-		     0)
-		    && (assoc_mgr_locks.entity[write_lock(datatype)] ==
-			0)) {
-			assoc_mgr_locks.entity[read_lock(datatype)]++;
-			break;
-		} else {	/* wait for state change and retry */
-			slurm_cond_wait(&locks_cond, &locks_mutex);
-		}
+	int err;
+
+	pthread_once(&entity_locks_once, _init_entity_locks);
+	if ((err = pthread_rwlock_rdlock(&entity_locks[datatype]))) {
+		errno = err;
+		fatal("%s: pthread_rwlock_rdlock(%d): %m", __func__, datatype);
 	}
-	slurm_mutex_unlock(&locks_mutex);
 }
 
 /* _wr_rdunlock - Issue a read unlock on the specified data type */
 static void _wr_rdunlock(assoc_mgr_lock_datatype_t datatype)
 {
-	//info("going to read unlock on %d", datatype);
-	slurm_mutex_lock(&locks_mutex);
-	//info("read unlock on %d", datatype);
-	assoc_mgr_locks.entity[read_lock(datatype)]--;
-	slurm_cond_broadcast(&locks_cond);
-	slurm_mutex_unlock(&locks_mutex);
+	int err;
+
+	if ((err = pthread_rwlock_unlock(&entity_locks[datatype]))) {
+		errno = err;
+		fatal("%s: pthread_rwlock_unlock(%d): %m", __func__, datatype);
+	}
 }
 
 /* _wr_wrlock - Issue a write lock on the specified data type */
 static void _wr_wrlock(assoc_mgr_lock_datatype_t datatype)
 {
-	//info("going to write lock on %d", datatype);
-	slurm_mutex_lock(&locks_mutex);
-	assoc_mgr_locks.entity[write_wait_lock(datatype)]++;
-
-	//info("write lock on %d", datatype);
-	while (1) {
-		if ((assoc_mgr_locks.entity[read_lock(datatype)] == 0) &&
-		    (assoc_mgr_locks.entity[write_lock(datatype)] == 0)) {
-			assoc_mgr_locks.entity[write_lock(datatype)]++;
-			assoc_mgr_locks.
-				entity[write_wait_lock(datatype)]--;
-			break;
-		} else {	/* wait for state change and retry */
-			slurm_cond_wait(&locks_cond, &locks_mutex);
-		}
+	int err;
+
+	pthread_once(&entity_locks_once, _init_entity_locks);
+	if ((err = pthread_rwlock_wrlock(&entity_locks[datatype]))) {
+		errno = err;
+		fatal("%s: pthread_rwlock_wrlock(%d): %m", __func__, datatype);
 	}
-	slurm_mutex_unlock(&locks_mutex);
 }
 
 /* _wr_wrunlock - Issue a write unlock on the specified data type */
 static void _wr_wrunlock(assoc_mgr_lock_datatype_t datatype)
 {
-	//info("going to write unlock on %d", datatype);
-	slurm_mutex_lock(&locks_mutex);
-	//info("write unlock on %d", datatype);
-	assoc_mgr_locks.entity[write_lock(datatype)]--;
-	slurm_cond_broadcast(&locks_cond);
-	slurm_mutex_unlock(&locks_mutex);
+	_wr_rdunlock(datatype);
 }
 
 extern int assoc_mgr_init(void *db_conn, assoc_init_args_t *args,
@@ -1981,7 +1983,6 @@ extern int assoc_mgr_init(void *db_conn, assoc_init_args_t *args,
 
 		xfree(prio);
 		checked_prio = 1;
-		memset(&assoc_mgr_locks, 0, sizeof(assoc_mgr_locks));
 		memset(&init_setup, 0, sizeof(assoc_init_args_t));
 		init_setup.cache_level = ASSOC_MGR_CACHE_ALL;
 	}
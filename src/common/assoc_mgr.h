@@ -60,7 +60,10 @@
 #define ASSOC_MGR_CACHE_TRES  0x0020
 #define ASSOC_MGR_CACHE_ALL   0xffff
 
-/* to lock or not */
+/*
+ * to lock or not, each data type has a rwlock of its own. The usage of the
+ * association and QOS records is protected by the lock of their list.
+ */
 typedef struct {
 	lock_level_t assoc;
 	lock_level_t file;
@@ -71,13 +74,7 @@ typedef struct {
 	lock_level_t wckey;
 } assoc_mgr_lock_t;
 
-/* Interval lock structure
- * we actually use the count for each data type, see macros below
- *   (assoc_mgr_lock_datatype_t * 4 + 0) = read_lock        read locks in use
- *   (assoc_mgr_lock_datatype_t * 4 + 1) = write_lock       write locks in use
- *   (assoc_mgr_lock_datatype_t * 4 + 2) = write_wait_lock  write locks pending
- *   (assoc_mgr_lock_datatype_t * 4 + 3) = write_cnt_lock   write lock count
- */
+/* Data types with a lock of their own */
 typedef enum {
 	ASSOC_LOCK,
 	FILE_LOCK,
@@ -89,10 +86,6 @@ typedef enum {
 	ASSOC_MGR_ENTITY_COUNT
 } assoc_mgr_lock_datatype_t;
 
-typedef struct {
-	int entity[ASSOC_MGR_ENTITY_COUNT * 4];
-} assoc_mgr_lock_flags_t;
-
 typedef struct {
  	uint16_t cache_level;
 	uint16_t enforce;
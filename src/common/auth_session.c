@@ -0,0 +1,560 @@
+/*****************************************************************************\
+ *  auth_session.c - session tokens signed with a key carried by one
+ *	authentication credential
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/auth_session.h"
+#include "src/common/fd.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_auth.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/*
+ * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
+ * for details.
+ */
+strong_alias(auth_session_sign,		slurm_auth_session_sign);
+strong_alias(auth_session_verify,	slurm_auth_session_verify);
+strong_alias(auth_session_forget,	slurm_auth_session_forget);
+strong_alias(auth_session_token_free,	slurm_auth_session_token_free);
+strong_alias(auth_session_fini,		slurm_auth_session_fini);
+
+#define SESSION_MAGIC		"SLURMSES"
+#define SESSION_MAGIC_LEN	8
+#define SESSION_PEER_MAX	64	/* longest recipient address */
+/* magic, key, uid of the recipient, then its address */
+#define SESSION_PAYLOAD_MIN	(SESSION_MAGIC_LEN + AUTH_SESSION_KEY_LEN + 4)
+#define SESSION_PAYLOAD_MAX	(SESSION_PAYLOAD_MIN + SESSION_PEER_MAX)
+#define SESSION_MAX_TTL		3600	/* longest lifetime accepted */
+#define SESSION_CLOCK_SKEW	60	/* how far ahead a token may be */
+#define SESSION_WINDOW		1024	/* out of order sequence numbers */
+#define SESSION_HASH_SIZE	1024
+#define SESSION_CACHE_MAX	65536	/* sessions remembered each way */
+#define SESSION_PURGE_INTERVAL	60
+
+/* A session created by this process for one recipient */
+typedef struct send_session {
+	char *name;
+	char *peer;		/* recipient */
+	uid_t peer_uid;		/* only uid able to decode cred */
+	pid_t pid;		/* creator, so a forked child makes its own */
+	uid_t uid;		/* effective uid and gid of the creator */
+	gid_t gid;
+	char *cred;
+	unsigned char key[AUTH_SESSION_KEY_LEN];
+	time_t renew;		/* when to create a new session */
+	uint32_t seq;
+	struct send_session *next;
+} send_session_t;
+
+/* A session received from another process */
+typedef struct recv_session {
+	char *cred;
+	unsigned char key[AUTH_SESSION_KEY_LEN];
+	uid_t uid;
+	gid_t gid;
+	time_t expire;
+	bool decoding;		/* cred being decoded, the rest not set yet */
+	uint32_t max_seq;	/* highest sequence number seen */
+	uint64_t window[SESSION_WINDOW / 64];	/* bit seq % SESSION_WINDOW
+						 * set if seq was seen */
+	struct recv_session *next;
+} recv_session_t;
+
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static send_session_t **send_hash = NULL;
+static int send_session_cnt = 0;
+static time_t send_next_purge = 0;
+
+static pthread_mutex_t recv_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t recv_cond = PTHREAD_COND_INITIALIZER;
+static recv_session_t **recv_hash = NULL;
+static int recv_session_cnt = 0;
+static time_t recv_next_purge = 0;
+
+/*
+ * MAC of a token, made by mac_func() over its credential, seq and time, the
+ * digest of the message body and the recipient
+ */
+static void _token_mac(auth_session_token_t *token, unsigned char *key,
+		       char *peer, unsigned char *digest,
+		       auth_session_mac_t mac_func, unsigned char *mac)
+{
+	int cred_len = strlen(token->cred), peer_len = strlen(peer), i;
+	int len = cred_len + 12 + AUTH_SESSION_DIGEST_LEN + peer_len;
+	unsigned char *data = xmalloc(len), *p = data;
+	uint64_t time64 = (uint64_t) token->time;
+
+	memcpy(p, token->cred, cred_len);
+	p += cred_len;
+	for (i = 0; i < 4; i++)
+		*p++ = (unsigned char) (token->seq >> (24 - i * 8));
+	for (i = 0; i < 8; i++)
+		*p++ = (unsigned char) (time64 >> (56 - i * 8));
+	memcpy(p, digest, AUTH_SESSION_DIGEST_LEN);
+	p += AUTH_SESSION_DIGEST_LEN;
+	memcpy(p, peer, peer_len);
+	(*mac_func)(key, AUTH_SESSION_KEY_LEN, data, len, mac);
+	xfree(data);
+}
+
+static int _random_key(unsigned char *key)
+{
+	int fd, rc;
+
+	if ((fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC)) < 0) {
+		error("%s: open(/dev/urandom): %m", __func__);
+		return SLURM_ERROR;
+	}
+	rc = fd_read_n(fd, key, AUTH_SESSION_KEY_LEN);
+	close(fd);
+	if (rc != AUTH_SESSION_KEY_LEN) {
+		error("%s: read(/dev/urandom): %m", __func__);
+		return SLURM_ERROR;
+	}
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Create the credential of a new session and its key, only to be decoded by
+ * peer_uid and bound to recipient peer. Locks not held.
+ */
+static char *_session_create(unsigned char *key, char *peer, uid_t peer_uid,
+			     int ttl, auth_session_encode_t encode, void *arg)
+{
+	unsigned char payload[SESSION_PAYLOAD_MAX], *p = payload;
+	int peer_len = strlen(peer), i;
+	char *cred;
+
+	if (peer_len > SESSION_PEER_MAX)
+		return NULL;
+	if (_random_key(key) != SLURM_SUCCESS)
+		return NULL;
+	memcpy(p, SESSION_MAGIC, SESSION_MAGIC_LEN);
+	p += SESSION_MAGIC_LEN;
+	memcpy(p, key, AUTH_SESSION_KEY_LEN);
+	p += AUTH_SESSION_KEY_LEN;
+	for (i = 0; i < 4; i++)
+		*p++ = (unsigned char) ((uint32_t) peer_uid >> (24 - i * 8));
+	memcpy(p, peer, peer_len);
+	p += peer_len;
+
+	cred = (*encode)(payload, p - payload, ttl, peer_uid, arg);
+	memset(payload, 0, sizeof(payload));
+	return cred;
+}
+
+static uint32_t _str_hash(char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (unsigned char) *str++;
+		hash *= 16777619;
+	}
+	return hash % SESSION_HASH_SIZE;
+}
+
+static void _send_session_free(send_session_t *s)
+{
+	memset(s->key, 0, sizeof(s->key));
+	xfree(s->name);
+	xfree(s->peer);
+	xfree(s->cred);
+	xfree(s);
+}
+
+/*
+ * Drop sessions due for renewal, or all of them if now is 0, or those for
+ * peer if not NULL. send_lock must be held.
+ */
+static void _send_purge(time_t now, char *peer)
+{
+	send_session_t **sp, *s;
+	int i;
+
+	if (!send_hash)
+		return;
+	for (i = 0; i < SESSION_HASH_SIZE; i++) {
+		sp = &send_hash[i];
+		while ((s = *sp)) {
+			if ((peer && xstrcmp(s->peer, peer)) ||
+			    (now && (s->renew > now))) {
+				sp = &s->next;
+				continue;
+			}
+			*sp = s->next;
+			_send_session_free(s);
+			send_session_cnt--;
+		}
+	}
+}
+
+static send_session_t *_send_find(char *name, char *peer, uid_t peer_uid,
+				  pid_t pid, uid_t uid, gid_t gid)
+{
+	send_session_t *s;
+
+	for (s = send_hash[_str_hash(peer)]; s; s = s->next) {
+		if ((s->pid == pid) && (s->uid == uid) && (s->gid == gid) &&
+		    (s->peer_uid == peer_uid) &&
+		    !xstrcmp(s->peer, peer) && !xstrcmp(s->name, name))
+			return s;
+	}
+	return NULL;
+}
+
+extern int auth_session_sign(auth_session_token_t *token, char *name,
+			     char *peer, uid_t peer_uid,
+			     unsigned char digest[AUTH_SESSION_DIGEST_LEN],
+			     int ttl, auth_session_encode_t encode,
+			     auth_session_mac_t mac, void *arg)
+{
+	unsigned char key[AUTH_SESSION_KEY_LEN];
+	send_session_t *s;
+	time_t now = time(NULL);
+	pid_t pid = getpid();
+	uid_t uid = geteuid();
+	gid_t gid = getegid();
+	char *cred;
+	int i;
+
+	xassert(token);
+	xassert(peer);
+	xassert(ttl > 0);
+
+	/* Without a known recipient uid anyone could decode the key */
+	if (peer_uid == (uid_t) NO_VAL)
+		return SLURM_ERROR;
+
+	ttl = MIN(ttl, SESSION_MAX_TTL);
+	slurm_mutex_lock(&send_lock);
+	if (!send_hash)
+		send_hash = xmalloc(sizeof(send_session_t *) *
+				    SESSION_HASH_SIZE);
+	if (now >= send_next_purge) {
+		_send_purge(now, NULL);
+		send_next_purge = now + SESSION_PURGE_INTERVAL;
+	}
+	s = _send_find(name, peer, peer_uid, pid, uid, gid);
+	if (!s || (now >= s->renew) || (s->seq == UINT32_MAX)) {
+		/* The encode is slow, let other sessions be used */
+		slurm_mutex_unlock(&send_lock);
+		cred = _session_create(key, peer, peer_uid, ttl, encode, arg);
+		if (!cred)
+			return SLURM_ERROR;
+		slurm_mutex_lock(&send_lock);
+		if (!(s = _send_find(name, peer, peer_uid, pid, uid, gid))) {
+			if (send_session_cnt >= SESSION_CACHE_MAX)
+				_send_purge(0, NULL);
+			s = xmalloc(sizeof(send_session_t));
+			s->name = xstrdup(name);
+			s->peer = xstrdup(peer);
+			s->peer_uid = peer_uid;
+			s->pid = pid;
+			s->uid = uid;
+			s->gid = gid;
+			i = _str_hash(peer);
+			s->next = send_hash[i];
+			send_hash[i] = s;
+			send_session_cnt++;
+		}
+		xfree(s->cred);
+		s->cred = cred;
+		memcpy(s->key, key, sizeof(key));
+		memset(key, 0, sizeof(key));
+		s->seq = 0;
+		/* Leave receivers half of the lifetime to get the last ones */
+		s->renew = now + MAX(ttl / 2, 1);
+	}
+
+	token->cred = xstrdup(s->cred);
+	token->seq = ++s->seq;
+	token->time = now;
+	_token_mac(token, s->key, peer, digest, mac, token->mac);
+	slurm_mutex_unlock(&send_lock);
+
+	return SLURM_SUCCESS;
+}
+
+extern void auth_session_forget(char *peer)
+{
+	if (!peer)
+		return;
+
+	slurm_mutex_lock(&send_lock);
+	_send_purge(0, peer);
+	slurm_mutex_unlock(&send_lock);
+}
+
+static void _recv_session_free(recv_session_t *r)
+{
+	memset(r->key, 0, sizeof(r->key));
+	xfree(r->cred);
+	xfree(r);
+}
+
+/*
+ * Drop expired sessions, or all of them if now is 0. Sessions still being
+ * decoded are kept. recv_lock must be held.
+ */
+static void _recv_purge(time_t now)
+{
+	recv_session_t **rp, *r;
+	int i;
+
+	if (!recv_hash)
+		return;
+	for (i = 0; i < SESSION_HASH_SIZE; i++) {
+		rp = &recv_hash[i];
+		while ((r = *rp)) {
+			if (r->decoding || (now && (r->expire > now))) {
+				rp = &r->next;
+				continue;
+			}
+			*rp = r->next;
+			_recv_session_free(r);
+			recv_session_cnt--;
+		}
+	}
+}
+
+static recv_session_t *_recv_find(char *cred)
+{
+	recv_session_t *r;
+
+	for (r = recv_hash[_str_hash(cred)]; r; r = r->next) {
+		if (!xstrcmp(r->cred, cred))
+			return r;
+	}
+	return NULL;
+}
+
+static void _recv_remove(recv_session_t *r)
+{
+	recv_session_t **rp;
+
+	for (rp = &recv_hash[_str_hash(r->cred)]; *rp; rp = &(*rp)->next) {
+		if (*rp == r) {
+			*rp = r->next;
+			_recv_session_free(r);
+			recv_session_cnt--;
+			return;
+		}
+	}
+}
+
+/*
+ * Decode the credential of session r, which is marked as being decoded so
+ * nothing else touches it. recv_lock not held.
+ */
+static int _recv_decode(recv_session_t *r, char *peer,
+			auth_session_decode_t decode, void *arg, time_t now)
+{
+	unsigned char payload[SESSION_PAYLOAD_MAX], *p;
+	auth_session_cred_info_t info;
+	int len = sizeof(payload), rc, i;
+	uint32_t peer_uid = 0;
+
+	memset(&info, 0, sizeof(info));
+	rc = (*decode)(r->cred, payload, &len, &info, arg);
+	if (rc != SLURM_SUCCESS)
+		return rc;
+	if ((len < SESSION_PAYLOAD_MIN) ||
+	    memcmp(payload, SESSION_MAGIC, SESSION_MAGIC_LEN)) {
+		error("%s: credential is not a session credential", __func__);
+		memset(payload, 0, sizeof(payload));
+		return SLURM_AUTH_INVALID;
+	}
+	/*
+	 * The key must only have been readable by us: the credential names
+	 * our address and uid, and no other uid could decode it
+	 */
+	p = payload + SESSION_MAGIC_LEN + AUTH_SESSION_KEY_LEN;
+	for (i = 0; i < 4; i++)
+		peer_uid = (peer_uid << 8) | *p++;
+	if ((info.restrict_uid != geteuid()) ||
+	    (peer_uid != (uint32_t) info.restrict_uid) ||
+	    ((size_t) (payload + len - p) != strlen(peer)) ||
+	    memcmp(p, peer, payload + len - p)) {
+		error("%s: session credential made for another recipient",
+		      __func__);
+		memset(payload, 0, sizeof(payload));
+		return SLURM_AUTH_INVALID;
+	}
+	/*
+	 * Each session is made for one recipient. If its credential was
+	 * decoded on this host before, but not by this process since it
+	 * started, the key is not ours alone to know (e.g. a process which
+	 * had our address before us decoded it).
+	 */
+	if (info.replayed) {
+		error("%s: session credential decoded before", __func__);
+		memset(payload, 0, sizeof(payload));
+		return SLURM_AUTH_INVALID;
+	}
+	memcpy(r->key, payload + SESSION_MAGIC_LEN, AUTH_SESSION_KEY_LEN);
+	memset(payload, 0, sizeof(payload));
+	r->uid = info.uid;
+	r->gid = info.gid;
+	r->expire = info.encoded + MIN(MAX(info.ttl, 0), SESSION_MAX_TTL);
+	if (r->expire <= now)
+		return SLURM_AUTH_INVALID;
+
+	return SLURM_SUCCESS;
+}
+
+/* Record sequence number seq of session r, false if seen or too old */
+static bool _recv_seq(recv_session_t *r, uint32_t seq)
+{
+	uint32_t s;
+
+	if (seq > r->max_seq) {
+		if ((seq - r->max_seq) >= SESSION_WINDOW) {
+			memset(r->window, 0, sizeof(r->window));
+		} else {
+			for (s = r->max_seq + 1; s != seq; s++)
+				r->window[(s % SESSION_WINDOW) / 64] &=
+					~((uint64_t) 1 << (s % 64));
+		}
+		r->max_seq = seq;
+	} else if (((r->max_seq - seq) >= SESSION_WINDOW) ||
+		   (r->window[(seq % SESSION_WINDOW) / 64] &
+		    ((uint64_t) 1 << (seq % 64)))) {
+		return false;
+	}
+	r->window[(seq % SESSION_WINDOW) / 64] |= (uint64_t) 1 << (seq % 64);
+	return true;
+}
+
+extern int auth_session_verify(auth_session_token_t *token, char *peer,
+			       unsigned char digest[AUTH_SESSION_DIGEST_LEN],
+			       auth_session_decode_t decode,
+			       auth_session_mac_t mac_func, void *arg,
+			       uid_t *uid, gid_t *gid)
+{
+	unsigned char mac[AUTH_SESSION_MAC_LEN], diff = 0;
+	recv_session_t *r;
+	time_t now = time(NULL);
+	int i, rc = SLURM_SUCCESS;
+
+	if (!token || !token->cred || !peer)
+		return SLURM_AUTH_BADARG;
+
+	slurm_mutex_lock(&recv_lock);
+	if (!recv_hash)
+		recv_hash = xmalloc(sizeof(recv_session_t *) *
+				    SESSION_HASH_SIZE);
+	if (now >= recv_next_purge) {
+		_recv_purge(now);
+		recv_next_purge = now + SESSION_PURGE_INTERVAL;
+	}
+	/* Decode each credential once, other messages of it wait */
+	while ((r = _recv_find(token->cred)) && r->decoding)
+		slurm_cond_wait(&recv_cond, &recv_lock);
+	if (!r) {
+		if (recv_session_cnt >= SESSION_CACHE_MAX)
+			_recv_purge(0);
+		r = xmalloc(sizeof(recv_session_t));
+		r->cred = xstrdup(token->cred);
+		r->decoding = true;
+		i = _str_hash(r->cred);
+		r->next = recv_hash[i];
+		recv_hash[i] = r;
+		recv_session_cnt++;
+
+		/* The decode is slow, let other sessions be verified */
+		slurm_mutex_unlock(&recv_lock);
+		rc = _recv_decode(r, peer, decode, arg, now);
+		slurm_mutex_lock(&recv_lock);
+		r->decoding = false;
+		slurm_cond_broadcast(&recv_cond);
+		if (rc != SLURM_SUCCESS) {
+			_recv_remove(r);
+			goto fini;
+		}
+	}
+
+	if ((r->expire <= now) ||
+	    (token->time > (now + SESSION_CLOCK_SKEW)) ||
+	    (token->time >= r->expire)) {
+		rc = SLURM_AUTH_INVALID;
+		goto fini;
+	}
+
+	_token_mac(token, r->key, peer, digest, mac_func, mac);
+	for (i = 0; i < AUTH_SESSION_MAC_LEN; i++)
+		diff |= mac[i] ^ token->mac[i];
+	if (diff || !_recv_seq(r, token->seq)) {
+		rc = SLURM_AUTH_INVALID;
+		goto fini;
+	}
+
+	*uid = r->uid;
+	*gid = r->gid;
+
+fini:
+	slurm_mutex_unlock(&recv_lock);
+	return rc;
+}
+
+extern void auth_session_token_free(auth_session_token_t *token)
+{
+	if (token)
+		xfree(token->cred);
+}
+
+extern void auth_session_fini(void)
+{
+	slurm_mutex_lock(&send_lock);
+	_send_purge(0, NULL);
+	xfree(send_hash);
+	slurm_mutex_unlock(&send_lock);
+
+	slurm_mutex_lock(&recv_lock);
+	_recv_purge(0);
+	xfree(recv_hash);
+	slurm_mutex_unlock(&recv_lock);
+}
@@ -0,0 +1,146 @@
+/*****************************************************************************\
+ *  auth_session.h - session tokens signed with a key carried by one
+ *	authentication credential
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _AUTH_SESSION_H
+#define _AUTH_SESSION_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+/*
+ * A sender creates one authentication credential (e.g. from munge) per
+ * recipient, carrying a random session key. Only the uid of the recipient
+ * can decode it, and it names the recipient's address and uid. Each message
+ * to that recipient then carries the credential plus a sequence number, a
+ * time stamp and a MAC made with the session key over them, a digest of
+ * the message body and the address of the recipient. A receiver decodes
+ * each session credential once, checks it was made for its address and
+ * uid, caches its key, uid and gid, and only checks the MAC of later
+ * messages. Sequence numbers already seen are rejected.
+ *
+ * The caller computes the digest of message bodies and provides the MAC
+ * function (e.g. SHA-256 and HMAC-SHA256 from a crypto library).
+ */
+
+#define AUTH_SESSION_KEY_LEN	32
+#define AUTH_SESSION_MAC_LEN	32	/* e.g. HMAC-SHA256 */
+#define AUTH_SESSION_DIGEST_LEN	32	/* e.g. SHA-256 */
+
+/*
+ * Create a credential holding the len bytes of payload, valid for ttl
+ * seconds, which only restrict_uid can decode. Return it as an xmalloc()'d
+ * string, NULL on failure.
+ */
+typedef char *(*auth_session_encode_t) (void *payload, int len, int ttl,
+					uid_t restrict_uid, void *arg);
+
+/* Compute the AUTH_SESSION_MAC_LEN bytes MAC of data with key */
+typedef void (*auth_session_mac_t) (const unsigned char *key, int key_len,
+				    const unsigned char *data, int data_len,
+				    unsigned char *mac);
+
+/* What decoding a credential tells about it besides its payload */
+typedef struct {
+	uid_t uid;		/* creator of the credential */
+	gid_t gid;
+	uid_t restrict_uid;	/* only uid allowed to decode it */
+	time_t encoded;		/* when it was created */
+	int ttl;		/* its lifetime from then, in seconds */
+	bool replayed;		/* already decoded before on this host */
+} auth_session_cred_info_t;
+
+/*
+ * Decode a credential made by an auth_session_encode_t, copying its payload
+ * into payload (at most *len bytes, *len set to the payload size) and
+ * filling info. A credential which was already decoded must still be
+ * decoded, with info->replayed set. Return SLURM_SUCCESS or an error code
+ * of the caller's plugin.
+ */
+typedef int (*auth_session_decode_t) (char *cred, void *payload, int *len,
+				      auth_session_cred_info_t *info,
+				      void *arg);
+
+/* What a message carries to prove it was sent by a session's creator */
+typedef struct {
+	char *cred;		/* session credential, xmalloc()'d */
+	uint32_t seq;		/* message number within the session */
+	time_t time;		/* when the token was made */
+	unsigned char mac[AUTH_SESSION_MAC_LEN];
+} auth_session_token_t;
+
+/*
+ * Fill token for a message with body digest to recipient peer, run as
+ * peer_uid, using the session of this process and its effective uid and
+ * gid for "name" (NULL for a default) and peer. The session is created with
+ * encode() if there is none or it is older than half its ttl seconds.
+ * Return SLURM_SUCCESS, or SLURM_ERROR (e.g. peer_uid is NO_VAL).
+ */
+extern int auth_session_sign(auth_session_token_t *token, char *name,
+			     char *peer, uid_t peer_uid,
+			     unsigned char digest[AUTH_SESSION_DIGEST_LEN],
+			     int ttl, auth_session_encode_t encode,
+			     auth_session_mac_t mac, void *arg);
+
+/*
+ * Check a token received by peer for a message with body digest, decoding
+ * its credential with decode() if the session is not known yet, and set
+ * the uid and gid of its sender. The credential must have been made for
+ * peer and for the effective uid of this process, and only be decodable by
+ * it. A credential decoded before on this host (e.g. by a previous instance
+ * of this process) starts no session.
+ * Return SLURM_SUCCESS, the error from decode() or SLURM_AUTH_INVALID.
+ */
+extern int auth_session_verify(auth_session_token_t *token, char *peer,
+			       unsigned char digest[AUTH_SESSION_DIGEST_LEN],
+			       auth_session_decode_t decode,
+			       auth_session_mac_t mac, void *arg,
+			       uid_t *uid, gid_t *gid);
+
+/*
+ * Forget the sessions created for recipient peer, e.g. after it failed to
+ * answer, so the next message to it starts a new one.
+ */
+extern void auth_session_forget(char *peer);
+
+/* Free the members of a token */
+extern void auth_session_token_free(auth_session_token_t *token);
+
+/* Forget all sessions, both created and received */
+extern void auth_session_fini(void);
+
+#endif
@@ -0,0 +1,383 @@
+/*****************************************************************************\
+ *  columnar.c - binary columnar dump of command output
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <errno.h>
+#include <string.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/columnar.h"
+#include "src/common/macros.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define COLUMNAR_HEADER_SIZE	32
+#define COLUMNAR_ENTRY_SIZE	40
+#define COLUMNAR_MIN_ROWS	1024
+
+#define ALIGN8(_x) (((_x) + 7) & ~((uint64_t) 7))
+
+typedef struct {
+	char *str;
+	uint32_t index;
+} dict_entry_t;
+
+typedef struct {
+	char *name;
+	uint32_t type;
+	uint64_t *valid;	/* one bit per row, set if not null */
+	uint64_t *values;	/* numeric columns */
+	uint32_t *index;	/* string columns, into dict_str */
+	xhash_t *dict;		/* dict_entry_t of every string, by value */
+	char **dict_str;	/* the strings, by index */
+	uint32_t dict_cnt;
+	uint64_t chars_len;	/* length of all the strings and their '\0' */
+} column_t;
+
+struct columnar {
+	column_t *cols;
+	int col_cnt;
+	uint64_t row_cnt;	/* rows ended, the current one is next */
+	uint64_t row_alloc;	/* rows allocated in every column */
+};
+
+static const char *_dict_id(void *item)
+{
+	return ((dict_entry_t *) item)->str;
+}
+
+static void _dict_free(void *item)
+{
+	dict_entry_t *entry = (dict_entry_t *) item;
+
+	xfree(entry->str);
+	xfree(entry);
+}
+
+static void _column_alloc(column_t *col, uint64_t rows)
+{
+	xrealloc(col->valid, ((rows + 63) / 64) * sizeof(uint64_t));
+	if (col->type == COLUMNAR_STRING)
+		xrealloc(col->index, rows * sizeof(uint32_t));
+	else
+		xrealloc(col->values, rows * sizeof(uint64_t));
+}
+
+/* Make room for the current row in every column */
+static void _reserve_row(columnar_t *dump)
+{
+	int i;
+
+	if (dump->row_cnt < dump->row_alloc)
+		return;
+
+	dump->row_alloc = MAX(COLUMNAR_MIN_ROWS, dump->row_alloc * 2);
+	for (i = 0; i < dump->col_cnt; i++)
+		_column_alloc(&dump->cols[i], dump->row_alloc);
+}
+
+static void _set_valid(columnar_t *dump, column_t *col)
+{
+	col->valid[dump->row_cnt / 64] |=
+		((uint64_t) 1) << (dump->row_cnt % 64);
+}
+
+static column_t *_get_column(columnar_t *dump, int col, uint32_t type)
+{
+	column_t *column;
+
+	if ((col < 0) || (col >= dump->col_cnt))
+		return NULL;
+	column = &dump->cols[col];
+	if ((column->type == COLUMNAR_STRING) != (type == COLUMNAR_STRING))
+		return NULL;
+	_reserve_row(dump);
+	return column;
+}
+
+extern columnar_t *columnar_create(void)
+{
+	return xmalloc(sizeof(columnar_t));
+}
+
+extern void columnar_destroy(columnar_t *dump)
+{
+	int i;
+
+	if (!dump)
+		return;
+
+	for (i = 0; i < dump->col_cnt; i++) {
+		column_t *col = &dump->cols[i];
+		xfree(col->name);
+		xfree(col->valid);
+		xfree(col->values);
+		xfree(col->index);
+		xfree(col->dict_str);
+		if (col->dict)
+			xhash_free(col->dict);
+	}
+	xfree(dump->cols);
+	xfree(dump);
+}
+
+extern int columnar_add_column(columnar_t *dump, const char *name,
+			       uint32_t type)
+{
+	column_t *col;
+
+	xrealloc(dump->cols, (dump->col_cnt + 1) * sizeof(column_t));
+	col = &dump->cols[dump->col_cnt];
+	col->name = xstrdup(name ? name : "");
+	col->type = type;
+	if (type == COLUMNAR_STRING)
+		col->dict = xhash_init(_dict_id, _dict_free, NULL, 0);
+	/* rows already there are null in the new column */
+	if (dump->row_alloc)
+		_column_alloc(col, dump->row_alloc);
+
+	return dump->col_cnt++;
+}
+
+extern int columnar_col_cnt(columnar_t *dump)
+{
+	return dump->col_cnt;
+}
+
+extern void columnar_set_str(columnar_t *dump, int col, const char *value)
+{
+	column_t *column = _get_column(dump, col, COLUMNAR_STRING);
+	dict_entry_t *entry;
+
+	if (!column || !value)
+		return;
+
+	if (!(entry = xhash_get(column->dict, value))) {
+		entry = xmalloc(sizeof(dict_entry_t));
+		entry->str = xstrdup(value);
+		entry->index = column->dict_cnt;
+		xhash_add(column->dict, entry);
+		if (!(column->dict_cnt % COLUMNAR_MIN_ROWS))
+			xrealloc(column->dict_str,
+				 (column->dict_cnt + COLUMNAR_MIN_ROWS) *
+				 sizeof(char *));
+		column->dict_str[column->dict_cnt++] = entry->str;
+		column->chars_len += strlen(value) + 1;
+	}
+	column->index[dump->row_cnt] = entry->index;
+	_set_valid(dump, column);
+}
+
+extern void columnar_set_int64(columnar_t *dump, int col, int64_t value)
+{
+	column_t *column = _get_column(dump, col, COLUMNAR_INT64);
+
+	if (!column)
+		return;
+	column->values[dump->row_cnt] = (uint64_t) value;
+	_set_valid(dump, column);
+}
+
+extern void columnar_set_uint64(columnar_t *dump, int col, uint64_t value)
+{
+	column_t *column = _get_column(dump, col, COLUMNAR_UINT64);
+
+	if (!column)
+		return;
+	column->values[dump->row_cnt] = value;
+	_set_valid(dump, column);
+}
+
+extern void columnar_set_double(columnar_t *dump, int col, double value)
+{
+	column_t *column = _get_column(dump, col, COLUMNAR_DOUBLE);
+
+	if (!column)
+		return;
+	memcpy(&column->values[dump->row_cnt], &value, sizeof(uint64_t));
+	_set_valid(dump, column);
+}
+
+extern void columnar_end_row(columnar_t *dump)
+{
+	/* unset columns of the row are still zeroed by xrealloc() */
+	_reserve_row(dump);
+	dump->row_cnt++;
+}
+
+static uint64_t _valid_len(columnar_t *dump)
+{
+	return ((dump->row_cnt + 63) / 64) * sizeof(uint64_t);
+}
+
+static uint64_t _data_len(columnar_t *dump, column_t *col)
+{
+	if (col->type != COLUMNAR_STRING)
+		return _valid_len(dump) + dump->row_cnt * sizeof(uint64_t);
+
+	return _valid_len(dump) +
+	       ALIGN8(dump->row_cnt * sizeof(uint32_t)) +
+	       (col->dict_cnt + 1) * sizeof(uint64_t) +
+	       ALIGN8(col->chars_len);
+}
+
+static int _write(FILE *stream, const void *data, size_t len)
+{
+	if (len && (fwrite(data, 1, len, stream) != len))
+		return SLURM_ERROR;
+	return SLURM_SUCCESS;
+}
+
+static int _write_pad(FILE *stream, uint64_t len)
+{
+	static const char zero[8] = { 0 };
+
+	return _write(stream, zero, ALIGN8(len) - len);
+}
+
+static int _write_column(FILE *stream, columnar_t *dump, column_t *col)
+{
+	uint64_t words = (dump->row_cnt + 63) / 64, offset = 0;
+	uint64_t last_word;
+	uint32_t i;
+
+	/* the valid bits of an unfinished row are not part of the dump */
+	if (words) {
+		if (_write(stream, col->valid, (words - 1) * sizeof(uint64_t)))
+			return SLURM_ERROR;
+		last_word = col->valid[words - 1];
+		if (dump->row_cnt % 64)
+			last_word &= (((uint64_t) 1) << (dump->row_cnt % 64))
+				     - 1;
+		if (_write(stream, &last_word, sizeof(uint64_t)))
+			return SLURM_ERROR;
+	}
+
+	if (col->type != COLUMNAR_STRING)
+		return _write(stream, col->values,
+			      dump->row_cnt * sizeof(uint64_t));
+
+	if (_write(stream, col->index, dump->row_cnt * sizeof(uint32_t)) ||
+	    _write_pad(stream, dump->row_cnt * sizeof(uint32_t)))
+		return SLURM_ERROR;
+	for (i = 0; i <= col->dict_cnt; i++) {
+		if (_write(stream, &offset, sizeof(uint64_t)))
+			return SLURM_ERROR;
+		if (i < col->dict_cnt)
+			offset += strlen(col->dict_str[i]) + 1;
+	}
+	for (i = 0; i < col->dict_cnt; i++) {
+		if (_write(stream, col->dict_str[i],
+			   strlen(col->dict_str[i]) + 1))
+			return SLURM_ERROR;
+	}
+	return _write_pad(stream, col->chars_len);
+}
+
+extern int columnar_write(columnar_t *dump, FILE *stream)
+{
+	uint32_t u32;
+	uint64_t u64, names_len = 0, name_offset, data_offset;
+	int i;
+
+	for (i = 0; i < dump->col_cnt; i++)
+		names_len += strlen(dump->cols[i].name) + 1;
+	name_offset = COLUMNAR_HEADER_SIZE +
+		      dump->col_cnt * COLUMNAR_ENTRY_SIZE;
+	data_offset = name_offset + ALIGN8(names_len);
+
+	if (_write(stream, COLUMNAR_MAGIC, 8))
+		goto fail;
+	u32 = COLUMNAR_VERSION;
+	if (_write(stream, &u32, sizeof(u32)))
+		goto fail;
+	u32 = COLUMNAR_BYTE_ORDER;
+	if (_write(stream, &u32, sizeof(u32)))
+		goto fail;
+	if (_write(stream, &dump->row_cnt, sizeof(uint64_t)))
+		goto fail;
+	u32 = dump->col_cnt;
+	if (_write(stream, &u32, sizeof(u32)))
+		goto fail;
+	u32 = 0;
+	if (_write(stream, &u32, sizeof(u32)))
+		goto fail;
+
+	for (i = 0; i < dump->col_cnt; i++) {
+		column_t *col = &dump->cols[i];
+
+		u32 = col->type;
+		if (_write(stream, &u32, sizeof(u32)))
+			goto fail;
+		u32 = strlen(col->name);
+		if (_write(stream, &u32, sizeof(u32)))
+			goto fail;
+		if (_write(stream, &name_offset, sizeof(uint64_t)))
+			goto fail;
+		name_offset += u32 + 1;
+		if (_write(stream, &data_offset, sizeof(uint64_t)))
+			goto fail;
+		u64 = _data_len(dump, col);
+		data_offset += u64;
+		if (_write(stream, &u64, sizeof(uint64_t)))
+			goto fail;
+		u64 = col->dict_cnt;
+		if (_write(stream, &u64, sizeof(uint64_t)))
+			goto fail;
+	}
+
+	for (i = 0; i < dump->col_cnt; i++) {
+		if (_write(stream, dump->cols[i].name,
+			   strlen(dump->cols[i].name) + 1))
+			goto fail;
+	}
+	if (_write_pad(stream, names_len))
+		goto fail;
+
+	for (i = 0; i < dump->col_cnt; i++) {
+		if (_write_column(stream, dump, &dump->cols[i]))
+			goto fail;
+	}
+
+	if (fflush(stream))
+		goto fail;
+	return SLURM_SUCCESS;
+
+fail:
+	if (!errno)
+		errno = EIO;
+	return SLURM_ERROR;
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************\
+ *  columnar.h - binary columnar dump of command output
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _COLUMNAR_H
+#define _COLUMNAR_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * A columnar dump holds a table of rows, one column per output field, and
+ * is written in one pass so that consumers can mmap it rather than parse
+ * delimited text. All integers are in host byte order, see byte_order.
+ * All sections start on an 8 byte boundary.
+ *
+ *   header:    char     magic[8]		"SLURMCOL"
+ *		uint32_t version		COLUMNAR_VERSION
+ *		uint32_t byte_order		0x01020304 as written
+ *		uint64_t row_cnt
+ *		uint32_t col_cnt
+ *		uint32_t reserved
+ *   columns:	col_cnt entries of
+ *		uint32_t type			COLUMNAR_*
+ *		uint32_t name_len		excluding the ending '\0'
+ *		uint64_t name_offset		from the start of the dump
+ *		uint64_t data_offset		from the start of the dump
+ *		uint64_t data_len
+ *		uint64_t dict_cnt		strings in the dictionary
+ *   names:	the column names, each ending with '\0'
+ *   data:	for each column, at its data_offset:
+ *		uint64_t valid[(row_cnt + 63) / 64]	bit set if not null
+ *		then for numeric columns:
+ *		int64_t/uint64_t/double value[row_cnt]
+ *		or for COLUMNAR_STRING columns:
+ *		uint32_t index[row_cnt]		into the dictionary
+ *		uint64_t offset[dict_cnt + 1]	of each string in chars
+ *		char     chars[]		strings, each ending with '\0'
+ *
+ * Null values are stored as 0, with their valid bit cleared.
+ */
+
+#define COLUMNAR_MAGIC		"SLURMCOL"
+#define COLUMNAR_VERSION	1
+#define COLUMNAR_BYTE_ORDER	0x01020304
+
+enum {
+	COLUMNAR_STRING = 1,	/* dictionary encoded strings */
+	COLUMNAR_INT64,
+	COLUMNAR_UINT64,
+	COLUMNAR_DOUBLE,
+	COLUMNAR_TIME,		/* int64_t seconds since the Epoch */
+	COLUMNAR_DURATION	/* int64_t seconds */
+};
+
+typedef struct columnar columnar_t;
+
+/* Create an empty dump, free with columnar_destroy() */
+extern columnar_t *columnar_create(void);
+extern void columnar_destroy(columnar_t *dump);
+
+/* Append a column of the given COLUMNAR_* type, return its index */
+extern int columnar_add_column(columnar_t *dump, const char *name,
+			       uint32_t type);
+extern int columnar_col_cnt(columnar_t *dump);
+
+/*
+ * Set the value of column col in the current row. A column not set when
+ * the row ends is null.
+ */
+extern void columnar_set_str(columnar_t *dump, int col, const char *value);
+extern void columnar_set_int64(columnar_t *dump, int col, int64_t value);
+extern void columnar_set_uint64(columnar_t *dump, int col, uint64_t value);
+extern void columnar_set_double(columnar_t *dump, int col, double value);
+
+/* End the current row and start a new one */
+extern void columnar_end_row(columnar_t *dump);
+
+/*
+ * Write the rows ended so far to stream.
+ * RET SLURM_SUCCESS or SLURM_ERROR with errno set
+ */
+extern int columnar_write(columnar_t *dump, FILE *stream);
+
+#endif /* !_COLUMNAR_H */
@@ -42,6 +42,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -118,10 +119,13 @@ strong_alias(hostset_count,		slurm_hostset_count);
 strong_alias(hostset_create,		slurm_hostset_create);
 strong_alias(hostset_delete,		slurm_hostset_delete);
 strong_alias(hostset_destroy,		slurm_hostset_destroy);
+strong_alias(hostset_difference,	slurm_hostset_difference);
 strong_alias(hostset_find,		slurm_hostset_find);
 strong_alias(hostset_insert,		slurm_hostset_insert);
+strong_alias(hostset_intersection,	slurm_hostset_intersection);
 strong_alias(hostset_shift,		slurm_hostset_shift);
 strong_alias(hostset_shift_range,	slurm_hostset_shift_range);
+strong_alias(hostset_union,		slurm_hostset_union);
 strong_alias(hostset_within,		slurm_hostset_within);
 strong_alias(hostset_nth,		slurm_hostset_nth);
 
@@ -248,6 +252,17 @@ struct hostlist {
 /* a hostset is a wrapper around a hostlist */
 struct hostset {
 	hostlist_t hl;
+
+	/* sorted host span index of hl, see _hostset_index() */
+	struct host_span *span;
+	int span_cnt;
+	int span_overlap;	/* some host is in more than one span */
+	int span_digit;		/* some prefix ends in a digit */
+
+	/* state of hl when the index was built */
+	hostrange_t *span_hr;
+	int span_nranges;
+	int span_nhosts;
 };
 
 struct hostlist_iterator {
@@ -483,13 +498,22 @@ bracket: 	open_bracket = strchr(parse, '[');
 
 
 /*
- * return the number of zeros needed to pad "num" to "width"
+ * return the number of decimal digits of "num"
  */
-static int _zero_padded(unsigned long num, int width)
+static int _num_digits(unsigned long num)
 {
 	int n = 1;
 	while (num /= 10L)
 		n++;
+	return n;
+}
+
+/*
+ * return the number of zeros needed to pad "num" to "width"
+ */
+static int _zero_padded(unsigned long num, int width)
+{
+	int n = _num_digits(num);
 	return (width > n) ? (width - n) : 0;
 }
 
@@ -1252,6 +1276,372 @@ static size_t hostrange_numstr(hostrange_t hr, size_t n, char *buf, int width)
 }
 
 
+/* ----[ host span functions ]---- */
+
+/*
+ * A host span is a run of hosts from one hostrange which share a prefix and
+ * a canonical zero padding: `width' is the range width when every number in
+ * the span is printed zero padded and 0 when none is. The same host thus has
+ * the same (prefix, singlehost, width, number) key whichever range width it
+ * was written with, so sorted span arrays can be binary searched and merged.
+ */
+struct host_span {
+	char *prefix;		/* points into the source hostrange */
+	unsigned long lo, hi;
+	int width;
+	unsigned singlehost:1;
+	int pos;		/* position of `lo' in the source hostlist */
+};
+
+/* Return the lowest number not zero padded when printed with `width' */
+static unsigned long _pad_limit(int width)
+{
+	unsigned long limit = 1;
+
+	if (width <= 1)
+		return 0;
+	while (--width > 0) {
+		if (limit > (ULONG_MAX / 10))
+			return ULONG_MAX;
+		limit *= 10;
+	}
+	return limit;
+}
+
+static struct host_span *_spans_alloc(int cnt)
+{
+	struct host_span *span = malloc(sizeof(struct host_span) * cnt);
+	if (!span)
+		out_of_memory("host spans");
+	return span;
+}
+
+/* Fill span[] with the (at most two) host spans of hr, return their count */
+static int _hostrange_spans(hostrange_t hr, int dims, int pos,
+			    struct host_span *span)
+{
+	unsigned long limit;
+	int n = 0;
+
+	span[0].prefix = hr->prefix;
+	span[0].singlehost = hr->singlehost;
+	span[0].pos = pos;
+	if (hr->singlehost || (dims > 1)) {
+		span[0].lo = hr->singlehost ? 0 : hr->lo;
+		span[0].hi = hr->singlehost ? 0 : hr->hi;
+		span[0].width = hr->singlehost ? 0 : hr->width;
+		return 1;
+	}
+
+	limit = _pad_limit(hr->width);
+	if (hr->lo < limit) {
+		span[n].prefix = hr->prefix;
+		span[n].singlehost = 0;
+		span[n].pos = pos;
+		span[n].lo = hr->lo;
+		span[n].hi = MIN(hr->hi, limit - 1);
+		span[n].width = hr->width;
+		n++;
+	}
+	if (hr->hi >= limit) {
+		span[n].prefix = hr->prefix;
+		span[n].singlehost = 0;
+		span[n].lo = MAX(hr->lo, limit);
+		span[n].pos = pos + (span[n].lo - hr->lo);
+		span[n].hi = hr->hi;
+		span[n].width = 0;
+		n++;
+	}
+	return n;
+}
+
+/* Fill span with the single host key of hn, return 0 if hn has no key */
+static int _hostname_span(hostname_t hn, int dims, struct host_span *span)
+{
+	int width;
+
+	span->pos = 0;
+	if (!hostname_suffix_is_valid(hn)) {
+		span->prefix = hn->hostname;
+		span->singlehost = 1;
+		span->lo = span->hi = 0;
+		span->width = 0;
+		return 1;
+	}
+	if (!hn->prefix)
+		return 0;
+	width = hostname_suffix_width(hn);
+	span->prefix = hn->prefix;
+	span->singlehost = 0;
+	span->lo = span->hi = hn->num;
+	if (dims > 1)
+		span->width = width;
+	else
+		span->width = (width > _num_digits(hn->num)) ? width : 0;
+	return 1;
+}
+
+static int _span_key_cmp(const struct host_span *a, const struct host_span *b)
+{
+	int rc;
+
+	if ((rc = strcmp(a->prefix, b->prefix)))
+		return rc;
+	if (a->singlehost != b->singlehost)
+		return a->singlehost ? 1 : -1;
+	return a->width - b->width;
+}
+
+static int _span_cmp(const void *x, const void *y)
+{
+	const struct host_span *a = x, *b = y;
+	int rc;
+
+	if ((rc = _span_key_cmp(a, b)))
+		return rc;
+	if (a->lo != b->lo)
+		return (a->lo < b->lo) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Return a sorted array of the host spans of hl in *cnt, and set *overlap
+ * if any host appears in more than one span (the list has duplicates).
+ * Caller must hold the hl lock and free() the array.
+ */
+static struct host_span *_hostlist_spans(hostlist_t hl, int dims, int *cnt,
+					 int *overlap)
+{
+	struct host_span *span;
+	int i, n = 0, pos = 0;
+
+	span = _spans_alloc(2 * hl->nranges + 1);
+	for (i = 0; i < hl->nranges; i++) {
+		n += _hostrange_spans(hl->hr[i], dims, pos, span + n);
+		pos += hostrange_count(hl->hr[i]);
+	}
+	qsort(span, n, sizeof(struct host_span), _span_cmp);
+
+	if (overlap) {
+		*overlap = 0;
+		for (i = 1; i < n; i++) {
+			if (!_span_key_cmp(&span[i - 1], &span[i]) &&
+			    (span[i].lo <= span[i - 1].hi)) {
+				*overlap = 1;
+				break;
+			}
+		}
+	}
+	*cnt = n;
+	return span;
+}
+
+/* Merge overlapping and adjacent spans of a sorted array, return new count */
+static int _spans_merge(struct host_span *span, int cnt)
+{
+	int i, j = 0;
+
+	for (i = 1; i < cnt; i++) {
+		if (!_span_key_cmp(&span[j], &span[i]) &&
+		    ((span[i].lo <= span[j].hi) ||
+		     (span[i].lo - 1 == span[j].hi))) {
+			span[j].hi = MAX(span[j].hi, span[i].hi);
+		} else
+			span[++j] = span[i];
+	}
+	return cnt ? j + 1 : 0;
+}
+
+/*
+ * Return the index of the first span of a sorted array of disjoint spans
+ * which is not wholly ordered before the host(s) of key.
+ */
+static int _spans_lower_bound(struct host_span *span, int cnt,
+			      struct host_span *key)
+{
+	int lo = 0, hi = cnt, mid, rc;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		rc = _span_key_cmp(&span[mid], key);
+		if ((rc < 0) || (!rc && (span[mid].hi < key->lo)))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ * Find the span of a sorted array of disjoint spans holding the host of key,
+ * return its index or -1.
+ */
+static int _spans_find(struct host_span *span, int cnt, struct host_span *key)
+{
+	int i = _spans_lower_bound(span, cnt, key);
+
+	if ((i < cnt) && !_span_key_cmp(&span[i], key) &&
+	    (span[i].lo <= key->lo))
+		return i;
+	return -1;
+}
+
+/*
+ * Intersection (op 0), union (op 1) or difference (op 2) of two sorted
+ * merged span arrays, written sorted and merged to out[] (which has room
+ * for na + nb spans). Return the output count, or with `stop' set just
+ * whether the output would be non-empty.
+ */
+static int _spans_op(struct host_span *a, int na, struct host_span *b, int nb,
+		     int op, struct host_span *out, int stop)
+{
+	int i = 0, j = 0, k, n = 0, rc;
+	unsigned long lo;
+
+	if (op == 1) {
+		while ((i < na) || (j < nb)) {
+			if ((j >= nb) || ((i < na) && (_span_cmp(&a[i], &b[j]) <= 0)))
+				out[n++] = a[i++];
+			else
+				out[n++] = b[j++];
+		}
+		return _spans_merge(out, n);
+	}
+
+	if (op == 0) {
+		while ((i < na) && (j < nb)) {
+			if ((rc = _span_key_cmp(&a[i], &b[j])) < 0)
+				i++;
+			else if (rc > 0)
+				j++;
+			else {
+				lo = MAX(a[i].lo, b[j].lo);
+				if (lo <= MIN(a[i].hi, b[j].hi)) {
+					if (stop)
+						return 1;
+					out[n] = a[i];
+					out[n].lo = lo;
+					out[n++].hi = MIN(a[i].hi, b[j].hi);
+				}
+				if (a[i].hi < b[j].hi)
+					i++;
+				else
+					j++;
+			}
+		}
+		return n;
+	}
+
+	for (i = 0; i < na; i++) {
+		while ((j < nb) && (((rc = _span_key_cmp(&b[j], &a[i])) < 0) ||
+				    (!rc && (b[j].hi < a[i].lo))))
+			j++;
+		lo = a[i].lo;
+		for (k = j; (k < nb) && !_span_key_cmp(&b[k], &a[i]) &&
+			     (b[k].lo <= a[i].hi); k++) {
+			if (b[k].lo > lo) {
+				if (stop)
+					return 1;
+				out[n] = a[i];
+				out[n].lo = lo;
+				out[n++].hi = b[k].lo - 1;
+			}
+			if (b[k].hi >= a[i].hi)
+				break;
+			lo = MAX(lo, b[k].hi + 1);
+		}
+		if ((k >= nb) || _span_key_cmp(&b[k], &a[i]) ||
+		    (b[k].lo > a[i].hi)) {
+			if (stop)
+				return 1;
+			out[n] = a[i];
+			out[n++].lo = lo;
+		}
+	}
+	return n;
+}
+
+/* Append the hosts of span to hl */
+static void _hostlist_push_span(hostlist_t hl, struct host_span *span)
+{
+	hostrange_t hr;
+
+	if (span->singlehost) {
+		hr = hostrange_create_single(span->prefix);
+		hostlist_push_range(hl, hr);
+		hostrange_destroy(hr);
+	} else {
+		hostlist_push_hr(hl, span->prefix, span->lo, span->hi,
+				 span->width ? span->width :
+				 _num_digits(span->lo));
+	}
+}
+
+/*
+ * Remove from hl every host of the sorted, merged spans del[], keeping the
+ * order of the remaining hosts. Return the number of hosts removed.
+ * Caller must hold the hl lock.
+ */
+static int _hostlist_delete_spans(hostlist_t hl, int dims,
+				  struct host_span *del, int nd)
+{
+	struct host_span piece[2], *keep;
+	hostrange_t *hr, last;
+	hostlist_iterator_t hli;
+	unsigned long count, kept;
+	int i, j, np, nk, start, size, nr = 0, removed = 0;
+
+	size = 2 * hl->nranges + nd + HOSTLIST_CHUNK;
+	if (!(hr = malloc(size * sizeof(hostrange_t))))
+		seterrno_ret(ENOMEM, 0);
+	keep = _spans_alloc(nd + 2);
+
+	for (i = 0; i < hl->nranges; i++) {
+		np = _hostrange_spans(hl->hr[i], dims, 0, piece);
+		for (j = 0, nk = 0; j < np; j++) {
+			start = _spans_lower_bound(del, nd, &piece[j]);
+			nk += _spans_op(&piece[j], 1, del + start, nd - start,
+					2, keep + nk, 0);
+		}
+		count = hostrange_count(hl->hr[i]);
+		for (j = 0, kept = 0; j < nk; j++)
+			kept += keep[j].hi - keep[j].lo + 1;
+		if (kept == count) {
+			hr[nr++] = hl->hr[i];
+			continue;
+		}
+
+		removed += count - kept;
+		for (j = 0, last = NULL; j < nk; j++) {
+			if (keep[j].singlehost)
+				hr[nr++] = hostrange_copy(hl->hr[i]);
+			else if (last && (last->hi + 1 == keep[j].lo))
+				last->hi = keep[j].hi;
+			else {
+				last = hostrange_create(hl->hr[i]->prefix,
+							keep[j].lo, keep[j].hi,
+							hl->hr[i]->width);
+				hr[nr++] = last;
+			}
+		}
+		hostrange_destroy(hl->hr[i]);
+	}
+	for (i = nr; i < size; i++)
+		hr[i] = NULL;
+
+	free(keep);
+	free(hl->hr);
+	hl->hr = hr;
+	hl->size = size;
+	hl->nranges = nr;
+	hl->nhosts -= removed;
+
+	for (hli = hl->ilist; hli; hli = hli->next)
+		hostlist_iterator_reset(hli);
+
+	return removed;
+}
+
 /* ----[ hostlist functions ]---- */
 
 /* Create a new hostlist object.
@@ -2214,6 +2604,38 @@ int hostlist_pop_range_values(
 	return 1;
 }
 
+int hostlist_get_range_values(hostlist_t hl, int n, const char **prefix,
+			      unsigned long *lo, unsigned long *hi, int *width)
+{
+	hostrange_t hr;
+	int rc = -1;
+
+	if (!hl || !prefix || !lo || !hi || !width)
+		return -1;
+
+	LOCK_HOSTLIST(hl);
+	if ((n >= 0) && (n < hl->nranges)) {
+		hr = hl->hr[n];
+		*prefix = hr->prefix;
+		*lo = hr->lo;
+		*hi = hr->hi;
+		*width = hr->width;
+		rc = hr->singlehost ? 0 : 1;
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return rc;
+}
+
+int hostlist_push_range_values(hostlist_t hl, const char *prefix,
+			       unsigned long lo, unsigned long hi, int width)
+{
+	if (!hl || !prefix || (lo > hi))
+		return 0;
+
+	return hostlist_push_hr(hl, (char *) prefix, lo, hi, width);
+}
+
 char *hostlist_shift_range(hostlist_t hl)
 {
 	int i;
@@ -2258,22 +2680,73 @@ char *hostlist_shift_range(hostlist_t hl)
 	return buf;
 }
 
-/* XXX: Note: efficiency improvements needed */
+/* Return true if some hostrange prefix of hl ends in a digit */
+static int _hostlist_digit_prefix(hostlist_t hl)
+{
+	int i, len;
+
+	for (i = 0; i < hl->nranges; i++) {
+		len = strlen(hl->hr[i]->prefix);
+		if (len && isdigit((int) hl->hr[i]->prefix[len - 1]))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Hosts are removed range by range against a sorted span array of `hosts'.
+ * When either list holds duplicates this falls back to deleting one host at
+ * a time, which removes only the first occurrence of each one. Hosts not
+ * found by span are retried one at a time if hostrange_hn_within() could
+ * still match them by moving suffix digits into the prefix.
+ */
 int hostlist_delete(hostlist_t hl, const char *hosts)
 {
-	int n = 0;
+	int n = 0, nd, nh, nl = 0, overlap, dims;
 	char *hostname = NULL;
-	hostlist_t hltmp;
+	hostlist_t hltmp, hlleft;
+	struct host_span *del, *hspan, *left = NULL;
+
 	if (!hl)
 		return -1;
 
 	if (!(hltmp = hostlist_create(hosts)))
 		seterrno_ret(EINVAL, 0);
 
-	while ((hostname = hostlist_pop(hltmp)) != NULL) {
-		n += hostlist_delete_host(hl, hostname);
-		free(hostname);
+	dims = slurmdb_setup_cluster_name_dims();
+	del = _hostlist_spans(hltmp, dims, &nd, &overlap);
+	if (!overlap) {
+		LOCK_HOSTLIST(hl);
+		hspan = _hostlist_spans(hl, dims, &nh, &overlap);
+		if (!overlap) {
+			nd = _spans_merge(del, nd);
+			if ((dims == 1) && _hostlist_digit_prefix(hl)) {
+				left = _spans_alloc(nd + nh + 1);
+				nl = _spans_op(del, nd, hspan, nh, 2, left, 0);
+			}
+			n = _hostlist_delete_spans(hl, dims, del, nd);
+		}
+		UNLOCK_HOSTLIST(hl);
+		free(hspan);
+	}
+
+	if (overlap) {
+		while ((hostname = hostlist_pop(hltmp)) != NULL) {
+			n += hostlist_delete_host(hl, hostname);
+			free(hostname);
+		}
+	} else if (nl) {
+		hlleft = hostlist_new();
+		for (nh = 0; nh < nl; nh++)
+			_hostlist_push_span(hlleft, &left[nh]);
+		while ((hostname = hostlist_pop(hlleft)) != NULL) {
+			n += hostlist_delete_host(hl, hostname);
+			free(hostname);
+		}
+		hostlist_destroy(hlleft);
 	}
+	free(left);
+	free(del);
 	hostlist_destroy(hltmp);
 
 	return n;
@@ -2571,7 +3044,7 @@ static int _attempt_range_join(hostlist_t hl, int loc)
 
 void hostlist_uniq(hostlist_t hl)
 {
-	int i = 1;
+	int i, j = 0, ndup;
 	hostlist_iterator_t hli;
 	LOCK_HOSTLIST(hl);
 	if (hl->nranges <= 1) {
@@ -2580,10 +3053,21 @@ void hostlist_uniq(hostlist_t hl)
 	}
 	qsort(hl->hr, hl->nranges, sizeof(hostrange_t), &_cmp);
 
-	while (i < hl->nranges) {
-		if (_attempt_range_join(hl, i) < 0) /* No range join occurred */
-			i++;
+	/*
+	 * Compact in place: join each range into the last kept one or keep
+	 * it, rather than deleting joined ranges one at a time (which shifts
+	 * the rest of the array every time).
+	 */
+	for (i = 1; i < hl->nranges; i++) {
+		if ((ndup = hostrange_join(hl->hr[j], hl->hr[i])) >= 0) {
+			hl->nhosts -= ndup;
+			hostrange_destroy(hl->hr[i]);
+		} else
+			hl->hr[++j] = hl->hr[i];
+		if (i > j)
+			hl->hr[i] = NULL;
 	}
+	hl->nranges = j + 1;
 
 	/* reset all iterators */
 	for (hli = hl->ilist; hli; hli = hli->next)
@@ -3523,39 +4007,73 @@ int hostlist_remove(hostlist_iterator_t i)
 
 /* ----[ hostset functions ]---- */
 
-hostset_t hostset_create(const char *hostlist)
+/* allocate a hostset without an index around hostlist hl
+ */
+static hostset_t hostset_new(hostlist_t hl)
 {
 	hostset_t new;
 
-	if (!(new = (hostset_t) malloc(sizeof(*new)))) {
-		out_of_memory("hostset_create");
-		return NULL;
-	}
+	if (!(new = (hostset_t) malloc(sizeof(*new))))
+		out_of_memory("hostset_new");
+
+	new->hl = hl;
+	new->span = NULL;
+	new->span_cnt = 0;
+	return new;
+}
+
+/* drop the span index of set after a change to set->hl
+ */
+static void hostset_unindex(hostset_t set)
+{
+	free(set->span);
+	set->span = NULL;
+}
+
+/*
+ * Build the span index of set->hl unless it is still current. Inserts drop
+ * the index; every removal of hosts changes the hostlist range array or
+ * host count checked here.
+ * Caller must hold the set->hl lock.
+ */
+static void _hostset_index(hostset_t set, int dims)
+{
+	hostlist_t hl = set->hl;
+
+	if (set->span && (set->span_hr == hl->hr) &&
+	    (set->span_nranges == hl->nranges) &&
+	    (set->span_nhosts == hl->nhosts))
+		return;
+
+	free(set->span);
+	set->span = _hostlist_spans(hl, dims, &set->span_cnt,
+				    &set->span_overlap);
+	set->span_digit = (dims == 1) && _hostlist_digit_prefix(hl);
+	set->span_hr = hl->hr;
+	set->span_nranges = hl->nranges;
+	set->span_nhosts = hl->nhosts;
+}
+
+hostset_t hostset_create(const char *hostlist)
+{
+	hostlist_t hl;
 
-	if (!(new->hl = hostlist_create(hostlist))) {
-		free(new);
+	if (!(hl = hostlist_create(hostlist)))
 		return NULL;
-	}
 
-	hostlist_uniq(new->hl);
-	return new;
+	hostlist_uniq(hl);
+	return hostset_new(hl);
 }
 
 hostset_t hostset_copy(const hostset_t set)
 {
-	hostset_t new;
-	if (!(new = (hostset_t) malloc(sizeof(*new))))
-		goto error1;
-
-	if (!(new->hl = hostlist_copy(set->hl)))
-		goto error2;
+	hostlist_t hl;
 
-	return new;
-error2:
-	free(new);
-error1:
-	out_of_memory("hostset_copy");
-	return NULL;
+	if (!(hl = hostlist_copy(set->hl))) {
+		out_of_memory("hostset_copy");
+		return NULL;
+	}
+	return hostset_new(hl);
 }
 
 void hostset_destroy(hostset_t set)
@@ -3563,6 +4081,7 @@ void hostset_destroy(hostset_t set)
 	if (set == NULL)
 		return;
 	hostlist_destroy(set->hl);
+	free(set->span);
 	free(set);
 }
 
@@ -3631,6 +4150,7 @@ int hostset_insert(hostset_t set, const char *hosts)
 
 	hostlist_uniq(hl);
 	LOCK_HOSTLIST(set->hl);
+	hostset_unindex(set);
 	for (i = 0; i < hl->nranges; i++)
 		n += hostset_insert_range(set, hl->hr[i]);
 	UNLOCK_HOSTLIST(set->hl);
@@ -3639,15 +4159,26 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
+/* binary search of the span index for hostname "host", falling back to
+ * a linear search through N ranges where the index cannot answer
  * */
 static int hostset_find_host(hostset_t set, const char *host)
 {
 	int i;
 	int retval = 0;
+	int dims = slurmdb_setup_cluster_name_dims();
+	struct host_span key;
 	hostname_t hn;
 	LOCK_HOSTLIST(set->hl);
+	_hostset_index(set, dims);
 	hn = hostname_create(host);
+	if (!set->span_overlap && _hostname_span(hn, dims, &key) &&
+	    (_spans_find(set->span, set->span_cnt, &key) >= 0)) {
+		retval = 1;
+		goto done;
+	}
+	if (!set->span_overlap && !set->span_digit)
+		goto done;
 	for (i = 0; i < set->hl->nranges; i++) {
 		/*
 		 * FIXME: THIS WILL NOT ALWAYS WORK CORRECTLY IF CALLED FROM A
@@ -3665,6 +4196,33 @@ done:
 	return retval;
 }
 
+/*
+ * Test the hosts of hl against set by span: op 0 returns true if any host
+ * of hl is in set, op 2 true if some host of hl is not. Returns -1 if only
+ * a host by host search can tell.
+ */
+static int _hostset_test_spans(hostset_t set, hostlist_t hl, int op)
+{
+	struct host_span *span;
+	int cnt, retval, dims = slurmdb_setup_cluster_name_dims();
+
+	span = _hostlist_spans(hl, dims, &cnt, NULL);
+	cnt = _spans_merge(span, cnt);
+	LOCK_HOSTLIST(set->hl);
+	_hostset_index(set, dims);
+	if (set->span_overlap)
+		retval = -1;
+	else {
+		retval = _spans_op(span, cnt, set->span, set->span_cnt, op,
+				   NULL, 1);
+		if ((retval == (op != 0)) && set->span_digit)
+			retval = -1;
+	}
+	UNLOCK_HOSTLIST(set->hl);
+	free(span);
+	return retval;
+}
+
 int hostset_intersects(hostset_t set, const char *hosts)
 {
 	int retval = 0;
@@ -3673,7 +4231,14 @@ int hostset_intersects(hostset_t set, const char *hosts)
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
-	hl = hostlist_create(hosts);
+	if (!(hl = hostlist_create(hosts)))
+		return 0;
+	if ((retval = _hostset_test_spans(set, hl, 0)) >= 0) {
+		hostlist_destroy(hl);
+		return retval;
+	}
+
+	retval = 0;
 	while ((hostname = hostlist_pop(hl)) != NULL) {
 		retval += hostset_find_host(set, hostname);
 		free(hostname);
@@ -3696,6 +4261,10 @@ int hostset_within(hostset_t set, const char *hosts)
 
 	if (!(hl = hostlist_create(hosts)))
 		return (0);
+	if ((nfound = _hostset_test_spans(set, hl, 2)) >= 0) {
+		hostlist_destroy(hl);
+		return !nfound;
+	}
 	nhosts = hostlist_count(hl);
 	nfound = 0;
 
@@ -3761,7 +4330,84 @@ char * hostset_nth(hostset_t set, int n)
 
 int hostset_find(hostset_t set, const char *hostname)
 {
-	return hostlist_find(set->hl, hostname);
+	int i, retval = -1, fallback;
+	int dims = slurmdb_setup_cluster_name_dims();
+	struct host_span key;
+	hostname_t hn;
+
+	if (!hostname)
+		return -1;
+
+	hn = hostname_create(hostname);
+	LOCK_HOSTLIST(set->hl);
+	_hostset_index(set, dims);
+	if (!set->span_overlap && _hostname_span(hn, dims, &key) &&
+	    ((i = _spans_find(set->span, set->span_cnt, &key)) >= 0))
+		retval = set->span[i].pos + (key.lo - set->span[i].lo);
+	fallback = set->span_overlap || set->span_digit;
+	UNLOCK_HOSTLIST(set->hl);
+	hostname_destroy(hn);
+
+	if ((retval < 0) && fallback)
+		retval = hostlist_find(set->hl, hostname);
+	return retval;
+}
+
+/*
+ * Apply span operation op of _spans_op() to set1 and set2, returning the
+ * result as a new hostset.
+ */
+static hostset_t _hostset_op(hostset_t set1, hostset_t set2, int op)
+{
+	struct host_span *a, *b, *out;
+	int i, na, nb, n, dims = slurmdb_setup_cluster_name_dims();
+	hostset_t first = set1, second = set2, new;
+
+	/* lock in a fixed order so concurrent ops on both sets can't
+	 * deadlock */
+	if (first > second) {
+		first = set2;
+		second = set1;
+	}
+	LOCK_HOSTLIST(first->hl);
+	if (second != first)
+		LOCK_HOSTLIST(second->hl);
+
+	a = _hostlist_spans(set1->hl, dims, &na, NULL);
+	na = _spans_merge(a, na);
+	b = _hostlist_spans(set2->hl, dims, &nb, NULL);
+	nb = _spans_merge(b, nb);
+	out = _spans_alloc(na + nb + 1);
+	n = _spans_op(a, na, b, nb, op, out, 0);
+
+	new = hostset_new(hostlist_new());
+	for (i = 0; i < n; i++)
+		_hostlist_push_span(new->hl, &out[i]);
+	hostlist_uniq(new->hl);
+
+	if (second != first)
+		UNLOCK_HOSTLIST(second->hl);
+	UNLOCK_HOSTLIST(first->hl);
+
+	free(out);
+	free(b);
+	free(a);
+	return new;
+}
+
+hostset_t hostset_union(hostset_t set1, hostset_t set2)
+{
+	return _hostset_op(set1, set2, 1);
+}
+
+hostset_t hostset_intersection(hostset_t set1, hostset_t set2)
+{
+	return _hostset_op(set1, set2, 0);
+}
+
+hostset_t hostset_difference(hostset_t set1, hostset_t set2)
+{
+	return _hostset_op(set1, set2, 2);
 }
 
 #if TEST_MAIN
@@ -262,6 +262,27 @@ char * hostlist_pop_range(hostlist_t hl);
 int hostlist_pop_range_values(
 	hostlist_t hl, unsigned long *lo, unsigned long *hi);
 
+/* hostlist_get_range_values():
+ *
+ * Fill in the components of the n'th range of hostlist hl, whose hosts are
+ * prefix followed by the numbers lo through hi zero padded to width digits.
+ * prefix points into hl and is only valid until hl is next modified.
+ * Returns -1 if hl has no n'th range, 0 if the range is a single host
+ * without numeric suffix (whose name is prefix), 1 otherwise.
+ */
+int hostlist_get_range_values(hostlist_t hl, int n, const char **prefix,
+			      unsigned long *lo, unsigned long *hi, int *width);
+
+/* hostlist_push_range_values():
+ *
+ * Push the hosts prefix followed by the numbers lo through hi, zero padded
+ * to width digits, onto the hostlist hl without building their names.
+ * Returns the number of hosts in hl after the push, 0 on invalid input or
+ * -1 on failure.
+ */
+int hostlist_push_range_values(hostlist_t hl, const char *prefix,
+			       unsigned long lo, unsigned long hi, int width);
+
 /* hostlist_shift_range():
  *
  * Shift the first bracketed hostlist (improperly: range) off the
@@ -522,6 +543,15 @@ int hostset_intersects(hostset_t set, const char *hosts);
  */
 int hostset_within(hostset_t set, const char *hosts);
 
+/* hostset_union(), hostset_intersection(), hostset_difference():
+ * Return a new hostset holding the hosts in either, in both, or in set1 but
+ * not in set2. Work is linear in the number of ranges of the two sets after
+ * sorting them. Returned set must be freed with hostset_destroy().
+ */
+hostset_t hostset_union(hostset_t set1, hostset_t set2);
+hostset_t hostset_intersection(hostset_t set1, hostset_t set2);
+hostset_t hostset_difference(hostset_t set1, hostset_t set2);
+
 /* hostset_shift():
  * hostset equivalent to hostlist_shift()
  */
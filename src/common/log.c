@@ -57,6 +57,7 @@
 #include <errno.h>
 #include <poll.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -73,6 +74,7 @@
 #include "src/common/safeopen.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_time.h"
+#include "src/common/strlcpy.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -132,6 +134,59 @@ static pthread_mutex_t  log_lock = PTHREAD_MUTEX_INITIALIZER;
 static log_t            *log = NULL;
 static log_t            *sched_log = NULL;
 
+/*
+ * Asynchronous logging: messages are formatted by the calling thread and
+ * queued to a bounded ring drained by a dedicated writer thread, so callers
+ * never wait on log_lock or on file and syslog I/O. Producers reserve slots
+ * without locking using per-slot sequence numbers; the writer (or a thread
+ * flushing the queue under async_lock) is the only consumer. Messages which
+ * do not fit are dropped and counted.
+ */
+#define LOG_ASYNC_MAX_DEPTH	(1 << 20)
+#define LOG_ASYNC_MSG_BYTES	1024	/* byte budget per slot */
+#define LOG_ASYNC_WAIT_USEC	100000
+
+typedef struct {
+	volatile uint32_t seq;	/* slot sequence number */
+	log_level_t level;
+	bool sched;		/* "sched: " message */
+	uint32_t size;		/* bytes accounted in async_bytes */
+	char *stamp;		/* "%M" expanded by the caller */
+	char idbuf[64];		/* set_idbuf() of the caller, if used */
+	char *buf;		/* formatted message */
+} log_async_msg_t;
+
+static pthread_mutex_t  async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t        async_thread;
+static log_async_msg_t  *async_ring = NULL;
+static uint32_t         async_depth = 0;
+static uint32_t         async_mask = 0;
+static volatile uint32_t async_enq_pos = 0;
+static uint32_t         async_deq_pos = 0;
+static volatile uint32_t async_bytes = 0;
+static uint32_t         async_max_bytes = 0;
+static volatile uint32_t async_dropped = 0;
+static volatile uint32_t async_users = 0;
+static volatile bool    async_running = false;
+static volatile bool    async_sleeping = false;
+static bool             async_stop = false;
+
+/*
+ * The options of "log" which producers need, copied under log_lock by
+ * _log_async_opts_set() whenever they change. Producers do not take
+ * log_lock, so they copy them in turn through async_opts_seq, which is odd
+ * while an update is in progress.
+ */
+typedef struct {
+	bool initialized;
+	log_options_t opt;
+	uint16_t fmt;
+} log_async_opts_t;
+
+static log_async_opts_t async_opts;
+static volatile uint32_t async_opts_seq = 0;
+
 #define LOG_INITIALIZED ((log != NULL) && (log->initialized))
 #define SCHED_LOG_INITIALIZED ((sched_log != NULL) && (sched_log->initialized))
 /* define a default argv0 */
@@ -150,7 +205,13 @@ extern char * program_invocation_name;
  */
 static void _atfork_prep()   { slurm_mutex_lock(&log_lock);   }
 static void _atfork_parent() { slurm_mutex_unlock(&log_lock); }
-static void _atfork_child()  { slurm_mutex_unlock(&log_lock); }
+static void _atfork_child()
+{
+	/* The writer thread does not exist in the child */
+	async_running = false;
+	slurm_mutex_init(&async_lock);
+	slurm_mutex_unlock(&log_lock);
+}
 static bool at_forked = false;
 #define atfork_install_handlers()					\
 	while (!at_forked) {						\
@@ -159,6 +220,8 @@ static bool at_forked = false;
 	}
 
 static void _log_flush(log_t *log);
+static void _log_async_opts_set(void);
+static void _log_async_stop(void);
 
 
 /* Write the current local time into the provided buffer. Returns the
@@ -344,6 +407,7 @@ _log_init(char *prog, log_options_t opt, log_facility_t fac, char *logfile )
 
 	log->initialized = 1;
  out:
+	_log_async_opts_set();
 	return rc;
 }
 
@@ -455,6 +519,7 @@ void log_fini(void)
 	if (!log)
 		return;
 
+	_log_async_stop();
 	slurm_mutex_lock(&log_lock);
 	_log_flush(log);
 	xfree(log->argv0);
@@ -466,6 +531,7 @@ void log_fini(void)
 	if (log->logfp)
 		fclose(log->logfp);
 	xfree(log);
+	_log_async_opts_set();
 	xfree(slurm_prog_name);
 	slurm_mutex_unlock(&log_lock);
 }
@@ -630,6 +696,7 @@ void log_set_timefmt(unsigned fmtflag)
 	if (log) {
 		slurm_mutex_lock(&log_lock);
 		log->fmt = fmtflag;
+		_log_async_opts_set();
 		slurm_mutex_unlock(&log_lock);
 	} else {
 		fprintf(stderr, "%s:%d: %s Slurm log not initialized\n",
@@ -666,6 +733,57 @@ set_idbuf(char *idbuf)
 		(void *)pthread_self());
 }
 
+/*
+ * Return the "%M" time stamp for time format "fmt", either xmalloc()ed or
+ * written to stack_buf as told by *should_xfree
+ */
+static char *_log_time_str(unsigned fmt, char *stack_buf, size_t size,
+			   int *should_xfree)
+{
+	char *substitute = NULL;
+
+	*should_xfree = 1;
+	switch (fmt) {
+	case LOG_FMT_ISO8601_MS:
+		/* "%M" => "yyyy-mm-ddThh:mm:ss.fff"  */
+		xiso8601timecat(substitute, true);
+		break;
+	case LOG_FMT_ISO8601:
+		/* "%M" => "yyyy-mm-ddThh:mm:ss.fff"  */
+		xiso8601timecat(substitute, false);
+		break;
+	case LOG_FMT_RFC5424_MS:
+		/* "%M" => "yyyy-mm-ddThh:mm:ss.fff(+/-)hh:mm" */
+		xrfc5424timecat(substitute, true);
+		break;
+	case LOG_FMT_RFC5424:
+		/* "%M" => "yyyy-mm-ddThh:mm:ss.fff(+/-)hh:mm" */
+		xrfc5424timecat(substitute, false);
+		break;
+	case LOG_FMT_CLOCK:
+		/* "%M" => "usec" */
+#if defined(__FreeBSD__)
+		snprintf(stack_buf, size, "%d", clock());
+#else
+		snprintf(stack_buf, size, "%ld", clock());
+#endif
+		substitute = stack_buf;
+		*should_xfree = 0;
+		break;
+	case LOG_FMT_SHORT:
+		/* "%M" => "Mon DD hh:mm:ss" */
+		xstrftimecat(substitute, "%b %d %T");
+		break;
+	case LOG_FMT_THREAD_ID:
+		set_idbuf(stack_buf);
+		substitute = stack_buf;
+		*should_xfree = 0;
+		break;
+	}
+
+	return substitute;
+}
+
 /*
  * return a heap allocated string formed from fmt and ap arglist
  * returned string is allocated with xmalloc, so must free with xfree.
@@ -748,51 +866,11 @@ static char *vxstrfmt(const char *fmt, va_list ap)
 					     "%a, %d %b %Y %H:%M:%S %z");
 				break;
 			case 'M':
-				if (!log) {
-					xiso8601timecat(substitute, true);
-					break;
-				}
-				switch (log->fmt) {
-				case LOG_FMT_ISO8601_MS:
-					/* "%M" => "yyyy-mm-ddThh:mm:ss.fff"  */
-					xiso8601timecat(substitute, true);
-					break;
-				case LOG_FMT_ISO8601:
-					/* "%M" => "yyyy-mm-ddThh:mm:ss.fff"  */
-					xiso8601timecat(substitute, false);
-					break;
-				case LOG_FMT_RFC5424_MS:
-					/* "%M" => "yyyy-mm-ddThh:mm:ss.fff(+/-)hh:mm" */
-					xrfc5424timecat(substitute, true);
-					break;
-				case LOG_FMT_RFC5424:
-					/* "%M" => "yyyy-mm-ddThh:mm:ss.fff(+/-)hh:mm" */
-					xrfc5424timecat(substitute, false);
-					break;
-				case LOG_FMT_CLOCK:
-					/* "%M" => "usec" */
-#if defined(__FreeBSD__)
-					snprintf(substitute_on_stack,
-						 sizeof(substitute_on_stack),
-						 "%d", clock());
-#else
-					snprintf(substitute_on_stack,
-						 sizeof(substitute_on_stack),
-						 "%ld", clock());
-#endif
-					substitute = substitute_on_stack;
-					should_xfree = 0;
-					break;
-				case LOG_FMT_SHORT:
-					/* "%M" => "Mon DD hh:mm:ss" */
-					xstrftimecat(substitute, "%b %d %T");
-					break;
-				case LOG_FMT_THREAD_ID:
-					set_idbuf(substitute_on_stack);
-					substitute = substitute_on_stack;
-					should_xfree = 0;
-					break;
-				}
+				substitute = _log_time_str(
+					log ? log->fmt : LOG_FMT_ISO8601_MS,
+					substitute_on_stack,
+					sizeof(substitute_on_stack),
+					&should_xfree);
 				break;
 			}
 			fmt++;
@@ -942,6 +1020,387 @@ _log_printf(log_t *log, cbuf_t cb, FILE *stream, const char *fmt, ...)
 
 }
 
+/* Return the message prefix and syslog priority of a log level */
+static char *_log_prefix(log_level_t level, int *priority)
+{
+	switch (level) {
+	case LOG_LEVEL_FATAL:
+		*priority = LOG_CRIT;
+		return "fatal: ";
+
+	case LOG_LEVEL_ERROR:
+		*priority = LOG_ERR;
+		return "error: ";
+
+	case LOG_LEVEL_INFO:
+	case LOG_LEVEL_VERBOSE:
+		*priority = LOG_INFO;
+		return "";
+
+	case LOG_LEVEL_DEBUG:
+		*priority = LOG_DEBUG;
+		return "debug:  ";
+
+	case LOG_LEVEL_DEBUG2:
+		*priority = LOG_DEBUG;
+		return "debug2: ";
+
+	case LOG_LEVEL_DEBUG3:
+		*priority = LOG_DEBUG;
+		return "debug3: ";
+
+	case LOG_LEVEL_DEBUG4:
+		*priority = LOG_DEBUG;
+		return "debug4: ";
+
+	case LOG_LEVEL_DEBUG5:
+		*priority = LOG_DEBUG;
+		return "debug5: ";
+
+	default:
+		*priority = LOG_ERR;
+		return "internal error: ";
+	}
+
+}
+
+/* Return true if "level" is not logged by any facility of "opt" */
+static bool _log_level_skip(log_options_t *opt, log_level_t level)
+{
+	return ((level > opt->syslog_level)  &&
+		(level > opt->logfile_level) &&
+		(level > opt->stderr_level));
+}
+
+/* Publish the options of "log" to producers. NOTE: Caller must hold log_lock */
+static void _log_async_opts_set(void)
+{
+	async_opts_seq++;
+	__sync_synchronize();
+	async_opts.initialized = LOG_INITIALIZED;
+	if (async_opts.initialized) {
+		async_opts.opt = log->opt;
+		async_opts.fmt = log->fmt;
+	}
+	__sync_synchronize();
+	async_opts_seq++;
+}
+
+/* Get a consistent copy of the options published by _log_async_opts_set() */
+static void _log_async_opts_get(log_async_opts_t *opts)
+{
+	uint32_t seq;
+
+	do {
+		while ((seq = async_opts_seq) & 1)
+			sched_yield();
+		__sync_synchronize();
+		memcpy(opts, &async_opts, sizeof(*opts));
+		__sync_synchronize();
+	} while (seq != async_opts_seq);
+}
+
+/*
+ * Write a message queued by _log_async_msg() the way log_msg() would have.
+ * NOTE: Caller must hold log_lock
+ */
+static void _log_async_write(log_async_msg_t *msg)
+{
+	log_level_t level = msg->level;
+	char *pfx = "";
+	char *msgbuf = NULL;
+	int priority = LOG_INFO;
+
+	if (msg->sched && SCHED_LOG_INITIALIZED &&
+	    (sched_log->opt.logfile_level > LOG_LEVEL_QUIET)) {
+		xstrfmtcat(msgbuf, "[%s] %s%s", msg->stamp, sched_log->fpfx,
+			   msg->buf);
+		_log_printf(sched_log, sched_log->fbuf, sched_log->logfp,
+			    "%s\n", msgbuf);
+		xfree(msgbuf);
+	}
+
+	if (!LOG_INITIALIZED || _log_level_skip(&log->opt, level))
+		return;
+
+	if (log->opt.prefix_level || (log->opt.syslog_level > level))
+		pfx = _log_prefix(level, &priority);
+
+	if (level <= log->opt.stderr_level) {
+		if (msg->idbuf[0]) {
+			_log_printf(log, log->buf, stderr, "%s: %s%s\n",
+				    msg->idbuf, pfx, msg->buf);
+		} else {
+			_log_printf(log, log->buf, stderr, "%s: %s%s\n",
+				    log->argv0, pfx, msg->buf);
+		}
+	}
+
+	if ((level <= log->opt.logfile_level) && (log->logfp != NULL)) {
+		xstrfmtcat(msgbuf, "[%s] %s%s%s", msg->stamp, log->fpfx, pfx,
+			   msg->buf);
+		_log_printf(log, log->fbuf, log->logfp, "%s\n", msgbuf);
+		xfree(msgbuf);
+	}
+
+	if (level <= log->opt.syslog_level) {
+		/* Avoid changing errno if syslog fails */
+		int orig_errno = slurm_get_errno();
+		xstrfmtcat(msgbuf, "%s%s", pfx, msg->buf);
+		openlog(log->argv0, LOG_PID, log->facility);
+		syslog(priority, "%.500s", msgbuf);
+		closelog();
+		slurm_seterrno(orig_errno);
+		xfree(msgbuf);
+	}
+}
+
+/*
+ * Write out all messages currently queued. The whole batch is written under
+ * log_lock, so it sees one consistent set of options and log files even if
+ * log_alter() or log_fini() is called meanwhile.
+ * NOTE: Caller must hold async_lock
+ * RET number of messages written
+ */
+static int _log_async_drain(void)
+{
+	log_async_msg_t *msg;
+	int cnt = 0;
+
+	slurm_mutex_lock(&log_lock);
+	while (cnt <= async_mask) {
+		msg = &async_ring[async_deq_pos & async_mask];
+		if ((int32_t) (msg->seq - (async_deq_pos + 1)) < 0)
+			break;	/* empty */
+		__sync_synchronize();
+		_log_async_write(msg);
+		__sync_sub_and_fetch(&async_bytes, msg->size);
+		xfree(msg->stamp);
+		xfree(msg->buf);
+		__sync_synchronize();
+		msg->seq = async_deq_pos + async_mask + 1;
+		async_deq_pos++;
+		cnt++;
+	}
+	if (cnt) {
+		if (SCHED_LOG_INITIALIZED && sched_log->logfp)
+			fflush(sched_log->logfp);
+		if (LOG_INITIALIZED && log->logfp)
+			fflush(log->logfp);
+		fflush(stderr);
+	}
+	slurm_mutex_unlock(&log_lock);
+
+	return cnt;
+}
+
+/* Log that "cnt" messages were dropped, bypassing the queue */
+static void _log_async_report_drops(uint32_t cnt)
+{
+	log_async_msg_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.level = LOG_LEVEL_ERROR;
+	xlogfmtcat(&msg.stamp, "%M");
+	xstrfmtcat(msg.buf, "log: asynchronous queue full, %u messages dropped",
+		   cnt);
+	slurm_mutex_lock(&log_lock);
+	_log_async_write(&msg);
+	slurm_mutex_unlock(&log_lock);
+	xfree(msg.stamp);
+	xfree(msg.buf);
+}
+
+static void *_log_async_writer(void *arg)
+{
+	struct timeval now;
+	struct timespec ts;
+	uint32_t dropped, reported = 0;
+
+	slurm_mutex_lock(&async_lock);
+	while (!async_stop) {
+		if (_log_async_drain())
+			continue;
+		if ((dropped = async_dropped) != reported) {
+			_log_async_report_drops(dropped - reported);
+			reported = dropped;
+		}
+
+		/* Producers only signal when they see us sleeping, so a
+		 * missed wake up delays output by LOG_ASYNC_WAIT_USEC */
+		async_sleeping = true;
+		__sync_synchronize();
+		gettimeofday(&now, NULL);
+		now.tv_usec += LOG_ASYNC_WAIT_USEC;
+		ts.tv_sec  = now.tv_sec + (now.tv_usec / 1000000);
+		ts.tv_nsec = (now.tv_usec % 1000000) * 1000;
+		slurm_cond_timedwait(&async_cond, &async_lock, &ts);
+		async_sleeping = false;
+	}
+	(void) _log_async_drain();
+	slurm_mutex_unlock(&async_lock);
+
+	return NULL;
+}
+
+/*
+ * Queue a message for the writer thread.
+ * RET false if asynchronous logging is not usable and the message must be
+ *	logged synchronously (in which case "args" has not been consumed)
+ */
+static bool _log_async_msg(log_level_t level, const char *fmt, va_list args)
+{
+	log_async_msg_t *msg;
+	log_async_opts_t opts;
+	char *buf, *stamp = NULL, stamp_buf[256];
+	char idbuf[64] = "";
+	uint32_t pos, size;
+	int32_t diff;
+	int stamp_xfree;
+	bool sched, rc = true;
+
+	__sync_add_and_fetch(&async_users, 1);
+	if (!async_running) {
+		rc = false;
+		goto fini;
+	}
+	/* "log" may be altered meanwhile, only use the published options */
+	_log_async_opts_get(&opts);
+	if (!opts.initialized) {
+		rc = false;
+		goto fini;
+	}
+
+	sched = !xstrncmp(fmt, "sched: ", 7);
+	if (!sched && _log_level_skip(&opts.opt, level))
+		goto fini;
+
+	buf = vxstrfmt(fmt, args);
+	stamp = _log_time_str(opts.fmt, stamp_buf, sizeof(stamp_buf),
+			      &stamp_xfree);
+	if (!stamp_xfree || !stamp)
+		stamp = xstrdup(stamp ? stamp : "");
+	if ((opts.fmt == LOG_FMT_THREAD_ID) &&
+	    (level <= opts.opt.stderr_level))
+		set_idbuf(idbuf);
+
+	size = strlen(buf) + sizeof(log_async_msg_t);
+	if (__sync_add_and_fetch(&async_bytes, size) > async_max_bytes)
+		goto drop;
+
+	pos = async_enq_pos;
+	while (1) {
+		msg = &async_ring[pos & async_mask];
+		diff = (int32_t) (msg->seq - pos);
+		if (diff == 0) {
+			if (__sync_bool_compare_and_swap(&async_enq_pos,
+							 pos, pos + 1))
+				break;
+		} else if (diff < 0) {
+			goto drop;	/* full */
+		}
+		pos = async_enq_pos;
+	}
+	__sync_synchronize();
+	msg->level = level;
+	msg->sched = sched;
+	msg->size = size;
+	msg->stamp = stamp;
+	msg->buf = buf;
+	strlcpy(msg->idbuf, idbuf, sizeof(msg->idbuf));
+	__sync_synchronize();
+	msg->seq = pos + 1;
+
+	if (async_sleeping)
+		slurm_cond_signal(&async_cond);
+	goto fini;
+
+drop:
+	__sync_sub_and_fetch(&async_bytes, size);
+	__sync_add_and_fetch(&async_dropped, 1);
+	xfree(stamp);
+	xfree(buf);
+fini:
+	__sync_sub_and_fetch(&async_users, 1);
+	return rc;
+}
+
+/* Write out queued messages from the calling thread, e.g. before exiting */
+static void _log_async_flush(void)
+{
+	__sync_add_and_fetch(&async_users, 1);
+	if (async_running && !pthread_equal(pthread_self(), async_thread)) {
+		slurm_mutex_lock(&async_lock);
+		(void) _log_async_drain();
+		slurm_mutex_unlock(&async_lock);
+	}
+	__sync_sub_and_fetch(&async_users, 1);
+}
+
+static void _log_async_stop(void)
+{
+	if (!async_running) {
+		/* e.g. ring inherited over fork() without its writer */
+		xfree(async_ring);
+		return;
+	}
+
+	async_running = false;
+	__sync_synchronize();
+	while (async_users)
+		sched_yield();
+
+	slurm_mutex_lock(&async_lock);
+	async_stop = true;
+	slurm_cond_signal(&async_cond);
+	slurm_mutex_unlock(&async_lock);
+	pthread_join(async_thread, NULL);
+
+	xfree(async_ring);
+	async_depth = 0;
+}
+
+/*
+ * Start logging asynchronously through a queue of "depth" messages, or
+ * stop doing so if depth is zero. Not safe to call from several threads at
+ * once.
+ */
+extern void log_set_async(uint32_t depth)
+{
+	uint32_t i, size = 1;
+
+	depth = MIN(depth, LOG_ASYNC_MAX_DEPTH);
+	if (async_running && (depth == async_depth))
+		return;
+
+	_log_async_stop();
+	if (!depth)
+		return;
+
+	while (size < depth)
+		size <<= 1;
+	async_ring = xmalloc(sizeof(log_async_msg_t) * size);
+	for (i = 0; i < size; i++)
+		async_ring[i].seq = i;
+	async_depth = depth;
+	async_mask = size - 1;
+	async_enq_pos = 0;
+	async_deq_pos = 0;
+	async_bytes = 0;
+	async_max_bytes = size * LOG_ASYNC_MSG_BYTES;
+	async_stop = false;
+	slurm_thread_create(&async_thread, _log_async_writer, NULL);
+
+	__sync_synchronize();
+	async_running = true;
+}
+
+/* Return the number of messages dropped by asynchronous logging */
+extern uint32_t log_async_dropped(void)
+{
+	return async_dropped;
+}
+
 /*
  * log a message at the specified level to facilities that have been
  * configured to receive messages at that level
@@ -953,6 +1412,13 @@ static void log_msg(log_level_t level, const char *fmt, va_list args)
 	char *msgbuf = NULL;
 	int priority = LOG_INFO;
 
+	if (async_running) {
+		if (level == LOG_LEVEL_FATAL)
+			_log_async_flush();	/* keep messages in order */
+		else if (_log_async_msg(level, fmt, args))
+			return;
+	}
+
 	slurm_mutex_lock(&log_lock);
 
 	if (!LOG_INITIALIZED) {
@@ -970,63 +1436,14 @@ static void log_msg(log_level_t level, const char *fmt, va_list args)
 		fflush(sched_log->logfp);
 		xfree(msgbuf);
 	}
-	if ((level > log->opt.syslog_level)  &&
-	    (level > log->opt.logfile_level) &&
-	    (level > log->opt.stderr_level)) {
+	if (_log_level_skip(&log->opt, level)) {
 		slurm_mutex_unlock(&log_lock);
 		xfree(buf);
 		return;
 	}
 
-	if (log->opt.prefix_level || (log->opt.syslog_level > level)) {
-		switch (level) {
-		case LOG_LEVEL_FATAL:
-			priority = LOG_CRIT;
-			pfx = "fatal: ";
-			break;
-
-		case LOG_LEVEL_ERROR:
-			priority = LOG_ERR;
-			pfx = "error: ";
-			break;
-
-		case LOG_LEVEL_INFO:
-		case LOG_LEVEL_VERBOSE:
-			priority = LOG_INFO;
-			break;
-
-		case LOG_LEVEL_DEBUG:
-			priority = LOG_DEBUG;
-			pfx = "debug:  ";
-			break;
-
-		case LOG_LEVEL_DEBUG2:
-			priority = LOG_DEBUG;
-			pfx = "debug2: ";
-			break;
-
-		case LOG_LEVEL_DEBUG3:
-			priority = LOG_DEBUG;
-			pfx = "debug3: ";
-			break;
-
-		case LOG_LEVEL_DEBUG4:
-			priority = LOG_DEBUG;
-			pfx = "debug4: ";
-			break;
-
-		case LOG_LEVEL_DEBUG5:
-			priority = LOG_DEBUG;
-			pfx = "debug5: ";
-			break;
-
-		default:
-			priority = LOG_ERR;
-			pfx = "internal error: ";
-			break;
-		}
-
-	}
+	if (log->opt.prefix_level || (log->opt.syslog_level > level))
+		pfx = _log_prefix(level, &priority);
 
 	if (!buf) {
 		/* format the basic message,
@@ -1102,6 +1519,7 @@ _log_flush(log_t *log)
 void
 log_flush()
 {
+	_log_async_flush();
 	slurm_mutex_lock(&log_lock);
 	_log_flush(log);
 	slurm_mutex_unlock(&log_lock);
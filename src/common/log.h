@@ -46,6 +46,7 @@
 #ifndef _LOG_H
 #define _LOG_H
 
+#include <inttypes.h>
 #include <syslog.h>
 #include <stdio.h>
 
@@ -223,6 +224,18 @@ bool log_has_data(void);
  */
 void log_flush(void);
 
+/*
+ * log_set_async() starts writing log messages from a separate thread,
+ * through a bounded queue of "depth" messages, so that callers never block
+ * on log I/O. Messages which do not fit in the queue are dropped and
+ * counted. Fatal messages, log_flush() and log_fini() write out the queue
+ * first. A depth of zero returns to synchronous logging.
+ */
+extern void log_set_async(uint32_t depth);
+
+/* Return the number of messages dropped by asynchronous logging */
+extern uint32_t log_async_dropped(void);
+
 /* log_set_debug_flags()
  * Set or reset the debug flags based on the configuration
  * file or the scontrol command.
@@ -53,12 +53,25 @@
 #include "src/common/xstring.h"
 #include "src/slurmd/slurmd/slurmd.h"
 
+/*
+ * The collection window adapts to the arrival rate: the composite message is
+ * sent once no other message is expected within MSG_AGGR_IDLE_GAPS times the
+ * average gap between messages, but never before window / MSG_AGGR_MIN_DIV
+ * nor after the full window.
+ */
+#define MSG_AGGR_IDLE_GAPS	4
+#define MSG_AGGR_MIN_DIV	10
+
 typedef struct {
 	pthread_mutex_t	aggr_mutex;
 	pthread_cond_t	cond;
 	uint32_t        debug_flags;
+	uint64_t        gap_avg;	/* usec between messages, average */
+	uint64_t        last_arrival;	/* usec, time of last message */
 	bool		max_msgs;
 	uint64_t        max_msg_cnt;
+	uint64_t        msg_cnt;	/* messages in msg_list, counting those
+					 * in children's composite messages */
 	List            msg_aggr_list;
 	List            msg_list;
 	pthread_mutex_t	mutex;
@@ -181,6 +194,37 @@ static int _send_to_next_collector(slurm_msg_t *msg)
 	return rc;
 }
 
+static uint64_t _now_usec(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((uint64_t) now.tv_sec * 1000000) + now.tv_usec;
+}
+
+static void _usec2timespec(uint64_t usec, struct timespec *ts)
+{
+	ts->tv_sec = usec / 1000000;
+	ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+/*
+ * Return how long to wait after the last message for another one, in usec.
+ * Call with msg_collection.mutex locked.
+ */
+static uint64_t _idle_timeout(void)
+{
+	uint64_t window = msg_collection.window * 1000;
+	uint64_t min_wait = window / MSG_AGGR_MIN_DIV;
+	uint64_t wait = msg_collection.gap_avg * MSG_AGGR_IDLE_GAPS;
+
+	/* no other message is expected soon, don't hold this one back */
+	if (!msg_collection.gap_avg || (wait > window))
+		return min_wait;
+
+	return MAX(wait, min_wait);
+}
+
 /*
  * _msg_aggregation_sender()
  *
@@ -190,36 +234,47 @@ static int _send_to_next_collector(slurm_msg_t *msg)
  */
 static void * _msg_aggregation_sender(void *arg)
 {
-	struct timeval now;
 	struct timespec timeout;
 	slurm_msg_t msg;
 	composite_msg_t cmp;
+	uint64_t start, end, now;
 
 	slurm_mutex_lock(&msg_collection.mutex);
 
 	while (msg_collection.running) {
 		/* Wait for a new msg to be collected */
-		slurm_cond_wait(&msg_collection.cond, &msg_collection.mutex);
-
-
-		if (!msg_collection.running &&
-		    !list_count(msg_collection.msg_list))
-			break;
-
-		/* A msg has been collected; start new window */
-		gettimeofday(&now, NULL);
-		timeout.tv_sec = now.tv_sec + (msg_collection.window / 1000);
-		timeout.tv_nsec = (now.tv_usec * 1000) +
-			(1000000 * (msg_collection.window % 1000));
-		timeout.tv_sec += timeout.tv_nsec / 1000000000;
-		timeout.tv_nsec %= 1000000000;
+		if (!list_count(msg_collection.msg_list))
+			slurm_cond_wait(&msg_collection.cond,
+					&msg_collection.mutex);
+
+		if (!list_count(msg_collection.msg_list)) {
+			if (!msg_collection.running)
+				break;
+			continue;
+		}
 
-		slurm_cond_timedwait(&msg_collection.cond,
-				     &msg_collection.mutex, &timeout);
+		/*
+		 * A msg has been collected; start new window and keep it
+		 * open while more messages are expected
+		 */
+		start = _now_usec();
+		while (msg_collection.running && !msg_collection.max_msgs) {
+			end = msg_collection.last_arrival + _idle_timeout();
+			end = MIN(end, start + (msg_collection.window * 1000));
+			if ((now = _now_usec()) >= end)
+				break;
+			_usec2timespec(end, &timeout);
+			slurm_cond_timedwait(&msg_collection.cond,
+					     &msg_collection.mutex, &timeout);
+		}
 
-		if (!msg_collection.running &&
-		    !list_count(msg_collection.msg_list))
-			break;
+		if (msg_collection.debug_flags & DEBUG_FLAG_ROUTE) {
+			info("msg aggr: sending %"PRIu64" msgs after %"PRIu64
+			     " usec (window %"PRIu64" msec, average gap %"
+			     PRIu64" usec)", msg_collection.msg_cnt,
+			     _now_usec() - start, msg_collection.window,
+			     msg_collection.gap_avg);
+		}
 
 		msg_collection.max_msgs = true;
 
@@ -234,6 +289,7 @@ static void * _msg_aggregation_sender(void *arg)
 
 		msg_collection.msg_list =
 			list_create(slurm_free_comp_msg_list);
+		msg_collection.msg_cnt = 0;
 		msg_collection.max_msgs = false;
 
 		slurm_msg_t_init(&msg);
@@ -321,12 +377,16 @@ extern void msg_aggr_sender_fini(void)
 	slurm_mutex_destroy(&msg_collection.mutex);
 }
 
-extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
-			     void (*resp_callback) (slurm_msg_t *msg))
+/*
+ * Add msg to the collection, msg_cnt is the number of messages it carries
+ * (more than one for a composite message from a child collector)
+ */
+static void _add_msg(slurm_msg_t *msg, uint32_t msg_cnt, bool wait,
+		     void (*resp_callback) (slurm_msg_t *msg))
 {
-	int count;
 	static uint16_t msg_index = 1;
 	static uint32_t wait_count = 0;
+	uint64_t now, gap;
 
 	if (!msg_collection.running)
 		return;
@@ -338,18 +398,29 @@ extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
 
 	msg->msg_index = msg_index++;
 
+	/* Track the arrival rate, a long idle period counts as one window */
+	now = _now_usec();
+	if (msg_collection.last_arrival) {
+		gap = MIN(now - msg_collection.last_arrival,
+			  msg_collection.window * 1000);
+		if (msg_collection.gap_avg)
+			msg_collection.gap_avg = (msg_collection.gap_avg * 7 +
+						  gap) / 8;
+		else
+			msg_collection.gap_avg = gap;
+	}
+	msg_collection.last_arrival = now;
+
 	/* Add msg to message collection */
 	list_append(msg_collection.msg_list, msg);
-
-	count = list_count(msg_collection.msg_list);
-
+	msg_collection.msg_cnt += msg_cnt;
 
 	/* First msg in collection; initiate new window */
-	if (count == 1)
+	if (list_count(msg_collection.msg_list) == 1)
 		slurm_cond_signal(&msg_collection.cond);
 
 	/* Max msgs reached; terminate window */
-	if (count >= msg_collection.max_msg_cnt) {
+	if (msg_collection.msg_cnt >= msg_collection.max_msg_cnt) {
 		msg_collection.max_msgs = true;
 		slurm_cond_signal(&msg_collection.cond);
 	}
@@ -388,9 +459,16 @@ extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
 	}
 }
 
+extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
+			     void (*resp_callback) (slurm_msg_t *msg))
+{
+	_add_msg(msg, 1, wait, resp_callback);
+}
+
 extern void msg_aggr_add_comp(Buf buffer, void *auth_cred, header_t *header)
 {
 	slurm_msg_t *msg;
+	uint32_t msg_cnt = 0;
 
 	if (!msg_collection.running)
 		return;
@@ -407,7 +485,16 @@ extern void msg_aggr_add_comp(Buf buffer, void *auth_cred, header_t *header)
 	msg->data = buffer;
 	msg->data_size = remaining_buf(buffer);
 
-	msg_aggr_add_msg(msg, 0, NULL);
+	/* The packed composite message starts with its message count */
+	if (remaining_buf(buffer) >= sizeof(uint32_t)) {
+		memcpy(&msg_cnt, get_buf_data(buffer) + get_buf_offset(buffer),
+		       sizeof(uint32_t));
+		msg_cnt = ntohl(msg_cnt);
+	}
+	if (!msg_cnt || (msg_cnt == NO_VAL))
+		msg_cnt = 1;
+
+	_add_msg(msg, msg_cnt, 0, NULL);
 }
 
 extern void msg_aggr_resp(slurm_msg_t *msg)
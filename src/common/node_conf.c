@@ -67,6 +67,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -83,6 +84,37 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/*
+ * Node name index: runs of consecutive node records named <prefix><number>
+ * with consecutive numbers, so that hostlist ranges map directly to bitmap
+ * ranges (and back) without building and hashing every host name.
+ */
+#define NODE_NAME_MAX_DIGITS 9
+
+typedef struct {
+	char *prefix;
+	unsigned long lo, hi;	/* numeric suffix range */
+	int width_min;		/* zero padding widths which print */
+	int width_max;		/* the names of this run */
+	int first_inx;		/* node record index of "lo" */
+} node_name_run_t;
+
+typedef struct {
+	char *prefix;
+	int run_cnt;
+	int *run_inx;		/* node_name_runs indexes sorted by lo */
+	bool overlap;		/* same numbers with other widths */
+} node_name_prefix_t;
+
+static pthread_mutex_t node_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool node_index_valid = false;
+static struct node_record *node_index_table = NULL;
+static int node_index_count = 0;
+static node_name_run_t *node_name_runs = NULL;
+static int node_name_run_cnt = 0;
+static int *node_name_run_map = NULL;	/* node index to run, or -1 */
+static xhash_t *node_prefix_hash = NULL;
+
 /* Local function defiitions */
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
@@ -95,6 +127,7 @@ static struct node_record *
 static void	_list_delete_config (void *config_entry);
 static int	_list_find_config (void *config_entry, void *key);
 static const char* _node_record_hash_identity (void* item);
+static void	_node_name_index_invalidate(void);
 
 /*
  * _build_single_nodeline_info - From the slurm.conf reader, build table,
@@ -355,6 +388,304 @@ static const char* _node_record_hash_identity (void* item)
 	return node_ptr->name;
 }
 
+static const char *_node_prefix_hash_identity(void *item)
+{
+	node_name_prefix_t *pfx = (node_name_prefix_t *) item;
+	return pfx->prefix;
+}
+
+static void _node_prefix_free(void *item)
+{
+	node_name_prefix_t *pfx = (node_name_prefix_t *) item;
+
+	xfree(pfx->run_inx);
+	xfree(pfx);
+}
+
+static int _node_run_lo_cmp(const void *x, const void *y)
+{
+	node_name_run_t *run1 = &node_name_runs[*(int *) x];
+	node_name_run_t *run2 = &node_name_runs[*(int *) y];
+
+	if (run1->lo < run2->lo)
+		return -1;
+	if (run1->lo > run2->lo)
+		return 1;
+	return 0;
+}
+
+/*
+ * Split a node name into a prefix and a numeric suffix.
+ * OUT prefix_len - length of the prefix
+ * OUT num - value of the numeric suffix
+ * OUT width_min, width_max - zero padding widths printing that suffix
+ * RET false if the name has no (usable) numeric suffix
+ */
+static bool _split_node_name(char *name, int *prefix_len, unsigned long *num,
+			     int *width_min, int *width_max)
+{
+	int len = strlen(name), digits = 0;
+	char *suffix;
+
+	while ((digits < len) && isdigit((int) name[len - digits - 1]))
+		digits++;
+	if ((digits == 0) || (digits > NODE_NAME_MAX_DIGITS))
+		return false;
+
+	suffix = name + len - digits;
+	*prefix_len = len - digits;
+	*num = strtoul(suffix, NULL, 10);
+	if ((digits > 1) && (suffix[0] == '0')) {
+		/* Zero padded, only printed at exactly this width */
+		*width_min = digits;
+	} else {
+		*width_min = 0;
+	}
+	*width_max = digits;
+
+	return true;
+}
+
+static void _node_name_index_free(void)
+{
+	int i;
+
+	for (i = 0; i < node_name_run_cnt; i++)
+		xfree(node_name_runs[i].prefix);
+	xfree(node_name_runs);
+	node_name_run_cnt = 0;
+	xfree(node_name_run_map);
+	xhash_free(node_prefix_hash);
+	node_index_table = NULL;
+	node_index_count = 0;
+}
+
+static void _node_name_index_invalidate(void)
+{
+	slurm_mutex_lock(&node_index_mutex);
+	node_index_valid = false;
+	slurm_mutex_unlock(&node_index_mutex);
+}
+
+static void _node_name_index_build(void)
+{
+	struct node_record *node_ptr = node_record_table_ptr;
+	node_name_run_t *run = NULL;
+	node_name_prefix_t *pfx;
+	unsigned long num;
+	int i, j, prefix_len, width_min, width_max, run_size = 0;
+
+	_node_name_index_free();
+	node_index_table = node_record_table_ptr;
+	node_index_count = node_record_count;
+	node_name_run_map = xmalloc(sizeof(int) * (node_record_count + 1));
+	node_prefix_hash = xhash_init(_node_prefix_hash_identity,
+				      _node_prefix_free, NULL, 0);
+
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		node_name_run_map[i] = -1;
+		if (!node_ptr->name || !node_ptr->name[0] ||
+		    !_split_node_name(node_ptr->name, &prefix_len, &num,
+				      &width_min, &width_max)) {
+			run = NULL;
+			continue;
+		}
+		if (run && (run->hi + 1 == num) &&
+		    (run->first_inx + (run->hi - run->lo) + 1 == i) &&
+		    (strlen(run->prefix) == prefix_len) &&
+		    !strncmp(run->prefix, node_ptr->name, prefix_len) &&
+		    (MAX(run->width_min, width_min) <=
+		     MIN(run->width_max, width_max))) {
+			run->hi = num;
+			run->width_min = MAX(run->width_min, width_min);
+			run->width_max = MIN(run->width_max, width_max);
+		} else {
+			if (node_name_run_cnt >= run_size) {
+				run_size = MAX(run_size * 2, 64);
+				xrealloc(node_name_runs,
+					 sizeof(node_name_run_t) * run_size);
+			}
+			run = &node_name_runs[node_name_run_cnt++];
+			run->prefix = xstrndup(node_ptr->name, prefix_len);
+			run->lo = run->hi = num;
+			run->width_min = width_min;
+			run->width_max = width_max;
+			run->first_inx = i;
+		}
+		node_name_run_map[i] = node_name_run_cnt - 1;
+	}
+
+	for (i = 0; i < node_name_run_cnt; i++) {
+		run = &node_name_runs[i];
+		if (!(pfx = xhash_get(node_prefix_hash, run->prefix))) {
+			pfx = xmalloc(sizeof(node_name_prefix_t));
+			pfx->prefix = run->prefix;
+			xhash_add(node_prefix_hash, pfx);
+		}
+		xrealloc(pfx->run_inx, sizeof(int) * (pfx->run_cnt + 1));
+		pfx->run_inx[pfx->run_cnt++] = i;
+	}
+	for (i = 0; i < node_name_run_cnt; i++) {
+		pfx = xhash_get(node_prefix_hash, node_name_runs[i].prefix);
+		if ((pfx->run_inx[0] != i) || (pfx->run_cnt < 2))
+			continue;	/* sort each prefix only once */
+		qsort(pfx->run_inx, pfx->run_cnt, sizeof(int),
+		      _node_run_lo_cmp);
+		for (j = 1; j < pfx->run_cnt; j++) {
+			if (node_name_runs[pfx->run_inx[j - 1]].hi >=
+			    node_name_runs[pfx->run_inx[j]].lo)
+				pfx->overlap = true;
+		}
+	}
+
+	node_index_valid = true;
+}
+
+/*
+ * Make sure the node name index matches the node table.
+ * RET false if the index can not be used
+ */
+static bool _node_name_index_ready(void)
+{
+	/* Multi-dimensional names use a different numbering */
+	if (slurmdb_setup_cluster_name_dims() > 1)
+		return false;
+
+	slurm_mutex_lock(&node_index_mutex);
+	if (!node_index_valid ||
+	    (node_index_table != node_record_table_ptr) ||
+	    (node_index_count != node_record_count))
+		_node_name_index_build();
+	slurm_mutex_unlock(&node_index_mutex);
+
+	return true;
+}
+
+/* Set the bit of one node, logging invalid names like node_name2bitmap */
+static void _host2bitmap(char *name, bool best_effort, bitstr_t *bitmap,
+			 const char *caller, int *rc)
+{
+	struct node_record *node_ptr;
+
+	node_ptr = _find_node_record(name, best_effort, true);
+	if (node_ptr) {
+		bit_set(bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+	} else {
+		error("%s: invalid node specified %s", caller, name);
+		if (!best_effort)
+			*rc = EINVAL;
+	}
+}
+
+/* Set the bits of hosts prefix[lo-hi] one host at a time */
+static void _hosts2bitmap(const char *prefix, unsigned long lo,
+			  unsigned long hi, int width, bool best_effort,
+			  bitstr_t *bitmap, const char *caller, int *rc)
+{
+	unsigned long num;
+	char *name;
+
+	for (num = lo; ; num++) {
+		name = xstrdup_printf("%s%0*lu", prefix, width, num);
+		_host2bitmap(name, best_effort, bitmap, caller, rc);
+		xfree(name);
+		if (num == hi)
+			break;
+	}
+}
+
+/*
+ * Set the bits of hosts prefix[lo-hi], using the node name index for the
+ * numbers which it covers.
+ */
+static void _range2bitmap(const char *prefix, unsigned long lo,
+			  unsigned long hi, int width, bool best_effort,
+			  bitstr_t *bitmap, const char *caller, int *rc)
+{
+	node_name_prefix_t *pfx;
+	node_name_run_t *run;
+	unsigned long cur = lo, end;
+	int first, last, mid;
+
+	pfx = xhash_get(node_prefix_hash, prefix);
+	if (!pfx || pfx->overlap) {
+		_hosts2bitmap(prefix, lo, hi, width, best_effort, bitmap,
+			      caller, rc);
+		return;
+	}
+
+	/* Find the first run ending at or after lo */
+	first = 0;
+	last = pfx->run_cnt;
+	while (first < last) {
+		mid = (first + last) / 2;
+		if (node_name_runs[pfx->run_inx[mid]].hi < lo)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	for ( ; ; first++) {
+		if ((first >= pfx->run_cnt) ||
+		    (node_name_runs[pfx->run_inx[first]].lo > hi)) {
+			_hosts2bitmap(prefix, cur, hi, width, best_effort,
+				      bitmap, caller, rc);
+			return;
+		}
+		run = &node_name_runs[pfx->run_inx[first]];
+		if (run->lo > cur) {
+			_hosts2bitmap(prefix, cur, run->lo - 1, width,
+				      best_effort, bitmap, caller, rc);
+			cur = run->lo;
+		}
+		end = MIN(hi, run->hi);
+		if ((width >= run->width_min) && (width <= run->width_max)) {
+			bit_nset(bitmap, run->first_inx + (cur - run->lo),
+				 run->first_inx + (end - run->lo));
+		} else {
+			_hosts2bitmap(prefix, cur, end, width, best_effort,
+				      bitmap, caller, rc);
+		}
+		if (end == hi)
+			return;
+		cur = end + 1;
+	}
+}
+
+/* Set the bits of all hosts in a hostlist */
+static int _hostlist2bitmap(hostlist_t hl, bool best_effort,
+			    bitstr_t *bitmap, const char *caller)
+{
+	int rc = SLURM_SUCCESS;
+	const char *prefix;
+	unsigned long lo, hi;
+	int i, type, width;
+	hostlist_iterator_t hi_itr;
+	char *name;
+
+	if (!_node_name_index_ready()) {
+		hi_itr = hostlist_iterator_create(hl);
+		while ((name = hostlist_next(hi_itr))) {
+			_host2bitmap(name, best_effort, bitmap, caller, &rc);
+			free(name);
+		}
+		hostlist_iterator_destroy(hi_itr);
+		return rc;
+	}
+
+	for (i = 0; (type = hostlist_get_range_values(hl, i, &prefix, &lo, &hi,
+						       &width)) >= 0; i++) {
+		if (type == 0)
+			_host2bitmap((char *) prefix, best_effort, bitmap,
+				     caller, &rc);
+		else
+			_range2bitmap(prefix, lo, hi, width, best_effort,
+				      bitmap, caller, &rc);
+	}
+
+	return rc;
+}
+
 /*
  * bitmap2hostlist - given a bitmap, build a hostlist
  * IN bitmap - bitmap pointer
@@ -364,7 +695,8 @@ static const char* _node_record_hash_identity (void* item)
  */
 hostlist_t bitmap2hostlist (bitstr_t *bitmap)
 {
-	int i, first, last;
+	int i, first, last, run_end;
+	node_name_run_t *run;
 	hostlist_t hl;
 
 	if (bitmap == NULL)
@@ -376,13 +708,36 @@ hostlist_t bitmap2hostlist (bitstr_t *bitmap)
 
 	last  = bit_fls(bitmap);
 	hl = hostlist_create(NULL);
+	if (!_node_name_index_ready()) {
+		for (i = first; i <= last; i++) {
+			if (bit_test(bitmap, i) == 0)
+				continue;
+			hostlist_push_host(hl, node_record_table_ptr[i].name);
+		}
+		return hl;
+	}
+
 	for (i = first; i <= last; i++) {
 		if (bit_test(bitmap, i) == 0)
 			continue;
-		hostlist_push_host(hl, node_record_table_ptr[i].name);
+		if (node_name_run_map[i] == -1) {
+			hostlist_push_host(hl, node_record_table_ptr[i].name);
+			continue;
+		}
+		/* Push the set bits of this run as one range */
+		run = &node_name_runs[node_name_run_map[i]];
+		run_end = i;
+		while ((run_end < last) &&
+		       (node_name_run_map[run_end + 1] == node_name_run_map[i]) &&
+		       bit_test(bitmap, run_end + 1))
+			run_end++;
+		hostlist_push_range_values(hl, run->prefix,
+					   run->lo + (i - run->first_inx),
+					   run->lo + (run_end - run->first_inx),
+					   run->width_max);
+		i = run_end;
 	}
 	return hl;
-
 }
 
 /*
@@ -652,6 +1007,7 @@ extern struct node_record *create_node_record (
 	}
 	node_ptr = node_record_table_ptr + (node_record_count++);
 	node_ptr->name = xstrdup(node_name);
+	_node_name_index_invalidate();
 	if (!node_hash_table)
 		node_hash_table = xhash_init(_node_record_hash_identity,
 					     NULL, NULL, 0);
@@ -789,6 +1145,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_node_name_index_invalidate();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -819,6 +1176,11 @@ extern void node_fini2 (void)
 
 	xfree(node_record_table_ptr);
 	node_record_count = 0;
+
+	slurm_mutex_lock(&node_index_mutex);
+	_node_name_index_free();
+	node_index_valid = false;
+	slurm_mutex_unlock(&node_index_mutex);
 }
 
 
@@ -835,7 +1197,6 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
 
@@ -855,20 +1216,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		struct node_record *node_ptr;
-		node_ptr = _find_node_record(this_node_name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("node_name2bitmap: invalid node specified %s",
-			       this_node_name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (this_node_name);
-	}
+	rc = _hostlist2bitmap(host_list, best_effort, my_bitmap, __func__);
 	hostlist_destroy (host_list);
 
 	return rc;
@@ -883,34 +1231,13 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
  */
 extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 {
-	int rc = SLURM_SUCCESS;
 	bitstr_t *my_bitmap;
-	char *name;
-	hostlist_iterator_t hi;
 
 	FREE_NULL_BITMAP(*bitmap);
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
 
-	hi = hostlist_iterator_create(hl);
-	while ((name = hostlist_next(hi)) != NULL) {
-		struct node_record *node_ptr;
-		node_ptr = _find_node_record(name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("hostlist2bitmap: invalid node specified %s",
-			       name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (name);
-	}
-
-	hostlist_iterator_destroy(hi);
-	return rc;
-
+	return _hostlist2bitmap(hl, best_effort, my_bitmap, __func__);
 }
 
 /* Purge the contents of a node record */
@@ -951,6 +1278,7 @@ extern void rehash_node (void)
 	xhash_free (node_hash_table);
 	node_hash_table = xhash_init(_node_record_hash_identity,
 				     NULL, NULL, 0);
+	_node_name_index_invalidate();
 	for (i = 0; i < node_record_count; i++, node_ptr++) {
 		if ((node_ptr->name == NULL) ||
 		    (node_ptr->name[0] == '\0'))
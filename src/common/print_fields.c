@@ -36,14 +36,131 @@
  *  with Slurm; if not, write to the Free Software Foundation, Inc.,
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
+#include <stdarg.h>
+
 #include "src/common/print_fields.h"
 #include "src/common/parse_time.h"
 #include "src/common/read_config.h"
 
 int print_fields_parsable_print = 0;
 int print_fields_have_header = 1;
+int print_fields_binary = 0;
 char *fields_delimiter = NULL;
 
+/* columnar dump of the fields when print_fields_binary is set */
+static columnar_t *print_fields_dump = NULL;
+static print_field_t **print_fields_cols = NULL;
+static int print_fields_col_cnt = 0;
+
+/* where this thread's output goes, stdout if NULL */
+static __thread Buf print_fields_buf = NULL;
+
+extern void print_fields_set_buffer(Buf buffer)
+{
+	print_fields_buf = buffer;
+}
+
+extern void print_fields_printf(const char *fmt, ...)
+{
+	va_list ap;
+	uint32_t avail;
+	int len;
+
+	if (!print_fields_buf) {
+		va_start(ap, fmt);
+		vprintf(fmt, ap);
+		va_end(ap);
+		return;
+	}
+
+	while (1) {
+		avail = remaining_buf(print_fields_buf);
+		va_start(ap, fmt);
+		len = vsnprintf(get_buf_data(print_fields_buf) +
+				get_buf_offset(print_fields_buf),
+				avail, fmt, ap);
+		va_end(ap);
+		if (len < 0)
+			return;
+		if (len < avail) {
+			set_buf_offset(print_fields_buf,
+				       get_buf_offset(print_fields_buf) + len);
+			return;
+		}
+		grow_buf(print_fields_buf, MAX(len + 1 - avail, BUF_SIZE));
+	}
+}
+
+static uint32_t _binary_type(print_field_t *field)
+{
+	void (*routine) () = field->print_routine;
+
+	if ((routine == (void (*) ()) print_fields_uint16) ||
+	    (routine == (void (*) ()) print_fields_uint32) ||
+	    (routine == (void (*) ()) print_fields_uint64))
+		return COLUMNAR_UINT64;
+	if (routine == (void (*) ()) print_fields_double)
+		return COLUMNAR_DOUBLE;
+	if (routine == (void (*) ()) print_fields_date)
+		return COLUMNAR_TIME;
+	if ((routine == (void (*) ()) print_fields_time_from_mins) ||
+	    (routine == (void (*) ()) print_fields_time_from_secs))
+		return COLUMNAR_DURATION;
+	return COLUMNAR_STRING;
+}
+
+static void _binary_start(List print_fields_list)
+{
+	ListIterator itr;
+	print_field_t *field;
+
+	print_fields_dump = columnar_create();
+	print_fields_cols = xmalloc(sizeof(print_field_t *) *
+				    (list_count(print_fields_list) + 1));
+	itr = list_iterator_create(print_fields_list);
+	while ((field = list_next(itr))) {
+		print_fields_cols[print_fields_col_cnt++] = field;
+		columnar_add_column(print_fields_dump, field->name,
+				    _binary_type(field));
+	}
+	list_iterator_destroy(itr);
+}
+
+/* Column of the dump holding field, -1 if none */
+static int _binary_col(print_field_t *field)
+{
+	int i;
+
+	for (i = 0; i < print_fields_col_cnt; i++) {
+		if (print_fields_cols[i] == field)
+			return i;
+	}
+	return -1;
+}
+
+extern void print_fields_end_row(void)
+{
+	if (print_fields_dump)
+		columnar_end_row(print_fields_dump);
+	else
+		print_fields_printf("\n");
+}
+
+extern int print_fields_binary_write(void)
+{
+	int rc;
+
+	if (!print_fields_dump)
+		return SLURM_SUCCESS;
+
+	rc = columnar_write(print_fields_dump, stdout);
+	columnar_destroy(print_fields_dump);
+	print_fields_dump = NULL;
+	xfree(print_fields_cols);
+	print_fields_col_cnt = 0;
+	return rc;
+}
+
 extern void destroy_print_field(void *object)
 {
 	print_field_t *field = (print_field_t *)object;
@@ -61,6 +178,11 @@ extern void print_fields_header(List print_fields_list)
 	int curr_inx = 1;
 	int field_count = 0;
 
+	if (print_fields_list && print_fields_binary) {
+		_binary_start(print_fields_list);
+		return;
+	}
+
 	if (!print_fields_list || !print_fields_have_header)
 		return;
 
@@ -71,31 +193,31 @@ extern void print_fields_header(List print_fields_list)
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && (curr_inx == field_count))
-			printf("%s", field->name);
+			print_fields_printf("%s", field->name);
 		else if (print_fields_parsable_print
 			 && fields_delimiter) {
-			printf("%s%s", field->name, fields_delimiter);
+			print_fields_printf("%s%s", field->name, fields_delimiter);
 		} else if (print_fields_parsable_print
 			 && !fields_delimiter) {
-			printf("%s|", field->name);
+			print_fields_printf("%s|", field->name);
 
 		} else {
 			int abs_len = abs(field->len);
-			printf("%*.*s ", abs_len, abs_len, field->name);
+			print_fields_printf("%*.*s ", abs_len, abs_len, field->name);
 		}
 		curr_inx++;
 	}
 	list_iterator_reset(itr);
-	printf("\n");
+	print_fields_printf("\n");
 	if (print_fields_parsable_print)
 		return;
 	while ((field = list_next(itr))) {
 		int abs_len = abs(field->len);
-		printf("%*.*s ", abs_len, abs_len,
+		print_fields_printf("%*.*s ", abs_len, abs_len,
 		       "-----------------------------------------------------");
 	}
 	list_iterator_destroy(itr);
-	printf("\n");
+	print_fields_printf("\n");
 }
 
 extern void print_fields_date(print_field_t *field, time_t value, int last)
@@ -103,18 +225,25 @@ extern void print_fields_date(print_field_t *field, time_t value, int last)
 	int abs_len = abs(field->len);
 	char temp_char[abs_len+1];
 
+	if (print_fields_dump) {
+		if (value && (value != (time_t) INFINITE))
+			columnar_set_int64(print_fields_dump,
+					   _binary_col(field), value);
+		return;
+	}
+
 	slurm_make_time_str(&value, (char *)temp_char, sizeof(temp_char));
 	if (print_fields_parsable_print == PRINT_FIELDS_PARSABLE_NO_ENDING
 	   && last)
-		printf("%s", temp_char);
+		print_fields_printf("%s", temp_char);
 	else if (print_fields_parsable_print && !fields_delimiter)
-		printf("%s|", temp_char);
+		print_fields_printf("%s|", temp_char);
 	else if (print_fields_parsable_print && fields_delimiter)
-		printf("%s%s", temp_char, fields_delimiter);
+		print_fields_printf("%s%s", temp_char, fields_delimiter);
 	else if (field->len == abs_len)
-		printf("%*.*s ", abs_len, abs_len, temp_char);
+		print_fields_printf("%*.*s ", abs_len, abs_len, temp_char);
 	else
-		printf("%-*.*s ", abs_len, abs_len, temp_char);
+		print_fields_printf("%-*.*s ", abs_len, abs_len, temp_char);
 }
 
 extern void print_fields_str(print_field_t *field, char *value, int last)
@@ -122,6 +251,12 @@ extern void print_fields_str(print_field_t *field, char *value, int last)
 	int abs_len = abs(field->len);
 	char temp_char[abs_len+1];
 	char *print_this = NULL;
+
+	if (print_fields_dump) {
+		columnar_set_str(print_fields_dump, _binary_col(field), value);
+		return;
+	}
+
 	if (!value) {
 		if (print_fields_parsable_print)
 			print_this = "";
@@ -132,11 +267,11 @@ extern void print_fields_str(print_field_t *field, char *value, int last)
 
 	if (print_fields_parsable_print == PRINT_FIELDS_PARSABLE_NO_ENDING
 	   && last)
-		printf("%s", print_this);
+		print_fields_printf("%s", print_this);
 	else if (print_fields_parsable_print && !fields_delimiter)
-		printf("%s|", print_this);
+		print_fields_printf("%s|", print_this);
 	else if (print_fields_parsable_print && fields_delimiter)
-		printf("%s%s", print_this, fields_delimiter);
+		print_fields_printf("%s%s", print_this, fields_delimiter);
 	else {
 		if (value) {
 			int len = strlen(value);
@@ -148,9 +283,9 @@ extern void print_fields_str(print_field_t *field, char *value, int last)
 		}
 
 		if (field->len == abs_len)
-			printf("%*.*s ", abs_len, abs_len, print_this);
+			print_fields_printf("%*.*s ", abs_len, abs_len, print_this);
 		else
-			printf("%-*.*s ", abs_len, abs_len, print_this);
+			print_fields_printf("%-*.*s ", abs_len, abs_len, print_this);
 	}
 }
 
@@ -160,6 +295,15 @@ extern void print_fields_str(print_field_t *field, char *value, int last)
 extern void print_fields_uint16(print_field_t *field, uint32_t value, int last)
 {
 	int abs_len = abs(field->len);
+
+	if (print_fields_dump) {
+		if (((uint16_t)value != NO_VAL16) &&
+		    ((uint16_t)value != INFINITE16))
+			columnar_set_uint64(print_fields_dump,
+					    _binary_col(field),
+					    (uint16_t) value);
+		return;
+	}
 	/* (value == unset)  || (value == cleared) */
 	if (((uint16_t)value == NO_VAL16)
 	    || ((uint16_t)value == INFINITE16)) {
@@ -168,30 +312,37 @@ extern void print_fields_uint16(print_field_t *field, uint32_t value, int last)
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%u", value);
+			print_fields_printf("%u", value);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%u|", value);
+			print_fields_printf("%u|", value);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%u%s", value, fields_delimiter);
+			print_fields_printf("%u%s", value, fields_delimiter);
 		else if (field->len == abs_len)
-			printf("%*u ", abs_len, value);
+			print_fields_printf("%*u ", abs_len, value);
 		else
-			printf("%-*u ", abs_len, value);
+			print_fields_printf("%-*u ", abs_len, value);
 	}
 }
 
 extern void print_fields_uint32(print_field_t *field, uint32_t value, int last)
 {
 	int abs_len = abs(field->len);
+
+	if (print_fields_dump) {
+		if ((value != NO_VAL) && (value != INFINITE))
+			columnar_set_uint64(print_fields_dump,
+					    _binary_col(field), value);
+		return;
+	}
 	/* (value == unset)  || (value == cleared) */
 	if ((value == NO_VAL) || (value == INFINITE)) {
 		if (print_fields_parsable_print
@@ -199,24 +350,24 @@ extern void print_fields_uint32(print_field_t *field, uint32_t value, int last)
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%u", value);
+			print_fields_printf("%u", value);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%u|", value);
+			print_fields_printf("%u|", value);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%u%s", value, fields_delimiter);
+			print_fields_printf("%u%s", value, fields_delimiter);
 		else if (field->len == abs_len)
-			printf("%*u ", abs_len, value);
+			print_fields_printf("%*u ", abs_len, value);
 		else
-			printf("%-*u ", abs_len, value);
+			print_fields_printf("%-*u ", abs_len, value);
 	}
 }
 
@@ -224,6 +375,13 @@ extern void print_fields_uint64(print_field_t *field, uint64_t value, int last)
 {
 	int abs_len = abs(field->len);
 
+	if (print_fields_dump) {
+		if ((value != NO_VAL64) && (value != INFINITE64))
+			columnar_set_uint64(print_fields_dump,
+					    _binary_col(field), value);
+		return;
+	}
+
 	/* (value == unset)  || (value == cleared) */
 	if ((value == NO_VAL64) || (value == INFINITE64)) {
 		if (print_fields_parsable_print
@@ -231,31 +389,41 @@ extern void print_fields_uint64(print_field_t *field, uint64_t value, int last)
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%llu", (long long unsigned) value);
+			print_fields_printf("%llu", (long long unsigned) value);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%llu|", (long long unsigned) value);
+			print_fields_printf("%llu|", (long long unsigned) value);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%llu%s", (long long unsigned) value,
+			print_fields_printf("%llu%s", (long long unsigned) value,
 				fields_delimiter);
 		else if (field->len == abs_len)
-			printf("%*llu ", abs_len, (long long unsigned) value);
+			print_fields_printf("%*llu ", abs_len, (long long unsigned) value);
 		else
-			printf("%-*llu ", abs_len, (long long unsigned) value);
+			print_fields_printf("%-*llu ", abs_len, (long long unsigned) value);
 	}
 }
 
 extern void print_fields_double(print_field_t *field, double value, int last)
 {
 	int abs_len = abs(field->len);
+
+	if (print_fields_dump) {
+		if ((value != NO_VAL64) && (value != INFINITE64) &&
+		    (value != (uint64_t)NO_VAL) &&
+		    (value != (uint64_t)INFINITE))
+			columnar_set_double(print_fields_dump,
+					    _binary_col(field), value);
+		return;
+	}
+
 	/* (value == unset)  || (value == cleared) */
 	if ((value == NO_VAL64) || (value == INFINITE64) ||
 	    (value == (uint64_t)NO_VAL) || (value == (uint64_t)INFINITE)) {
@@ -264,20 +432,20 @@ extern void print_fields_double(print_field_t *field, double value, int last)
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%f", value);
+			print_fields_printf("%f", value);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%f|", value);
+			print_fields_printf("%f|", value);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%f%s", value, fields_delimiter);
+			print_fields_printf("%f%s", value, fields_delimiter);
 		else {
 			int length, width = abs_len;
 			char *tmp = xmalloc(width + 10);
@@ -289,14 +457,14 @@ extern void print_fields_double(print_field_t *field, double value, int last)
 				if (length > width)
 					width -= length - width;
 				if (field->len == abs_len)
-					printf("%*.*e ", width, width, value);
+					print_fields_printf("%*.*e ", width, width, value);
 				else
-					printf("%-*.*e ", width, width, value);
+					print_fields_printf("%-*.*e ", width, width, value);
 			} else {
 				if (field->len == abs_len)
-					printf("%*f ", width, value);
+					print_fields_printf("%*f ", width, value);
 				else
-					printf("%-*f ", width, value);
+					print_fields_printf("%-*f ", width, value);
 			}
 			xfree(tmp);
 		}
@@ -306,6 +474,14 @@ extern void print_fields_double(print_field_t *field, double value, int last)
 extern void print_fields_time(print_field_t *field, uint32_t value, int last)
 {
 	int abs_len = abs(field->len);
+
+	if (print_fields_dump) {
+		if ((value != NO_VAL) && (value != INFINITE))
+			columnar_set_int64(print_fields_dump,
+					   _binary_col(field),
+					   (int64_t) value * 60);
+		return;
+	}
 	/* (value == unset)  || (value == cleared) */
 	if ((value == NO_VAL) || (value == INFINITE)) {
 		if (print_fields_parsable_print
@@ -313,26 +489,26 @@ extern void print_fields_time(print_field_t *field, uint32_t value, int last)
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		char time_buf[32];
 		mins2time_str((time_t) value, time_buf, sizeof(time_buf));
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%s", time_buf);
+			print_fields_printf("%s", time_buf);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%s|", time_buf);
+			print_fields_printf("%s|", time_buf);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s%s", time_buf, fields_delimiter);
+			print_fields_printf("%s%s", time_buf, fields_delimiter);
 		else if (field->len == abs_len)
-			printf("%*s ", abs_len, time_buf);
+			print_fields_printf("%*s ", abs_len, time_buf);
 		else
-			printf("%-*s ", abs_len, time_buf);
+			print_fields_printf("%-*s ", abs_len, time_buf);
 	}
 }
 
@@ -340,6 +516,13 @@ extern void print_fields_time_from_secs(print_field_t *field,
 					uint64_t value, int last)
 {
 	int abs_len = abs(field->len);
+
+	if (print_fields_dump) {
+		if ((value != NO_VAL64) && (value != INFINITE64))
+			columnar_set_int64(print_fields_dump,
+					   _binary_col(field), value);
+		return;
+	}
 	/* (value == unset)  || (value == cleared) */
 	if ((value == NO_VAL64) || (value == INFINITE64)) {
 		if (print_fields_parsable_print
@@ -347,26 +530,26 @@ extern void print_fields_time_from_secs(print_field_t *field,
 		   && last)
 			;
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("|");
+			print_fields_printf("|");
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s", fields_delimiter);
+			print_fields_printf("%s", fields_delimiter);
 		else
-			printf("%*s ", field->len, " ");
+			print_fields_printf("%*s ", field->len, " ");
 	} else {
 		char time_buf[32];
 		secs2time_str((time_t) value, time_buf, sizeof(time_buf));
 		if (print_fields_parsable_print
 		   == PRINT_FIELDS_PARSABLE_NO_ENDING
 		   && last)
-			printf("%s", time_buf);
+			print_fields_printf("%s", time_buf);
 		else if (print_fields_parsable_print && !fields_delimiter)
-			printf("%s|", time_buf);
+			print_fields_printf("%s|", time_buf);
 		else if (print_fields_parsable_print && fields_delimiter)
-			printf("%s%s", time_buf, fields_delimiter);
+			print_fields_printf("%s%s", time_buf, fields_delimiter);
 		else if (field->len == abs_len)
-			printf("%*s ", abs_len, time_buf);
+			print_fields_printf("%*s ", abs_len, time_buf);
 		else
-			printf("%-*s ", abs_len, time_buf);
+			print_fields_printf("%-*s ", abs_len, time_buf);
 	}
 }
 
@@ -375,6 +558,16 @@ extern void print_fields_char_list(print_field_t *field, List value, int last)
 	int abs_len = abs(field->len);
 	char *print_this = NULL;
 
+	if (print_fields_dump) {
+		if (value && list_count(value)) {
+			print_this = slurm_char_list_to_xstr(value);
+			columnar_set_str(print_fields_dump, _binary_col(field),
+					 print_this);
+			xfree(print_this);
+		}
+		return;
+	}
+
 	if (!value || !list_count(value)) {
 		if (print_fields_parsable_print)
 			print_this = xstrdup("");
@@ -386,19 +579,19 @@ extern void print_fields_char_list(print_field_t *field, List value, int last)
 
 	if (print_fields_parsable_print == PRINT_FIELDS_PARSABLE_NO_ENDING
 	   && last)
-		printf("%s", print_this);
+		print_fields_printf("%s", print_this);
 	else if (print_fields_parsable_print && !fields_delimiter)
-		printf("%s|", print_this);
+		print_fields_printf("%s|", print_this);
 	else if (print_fields_parsable_print && fields_delimiter)
-		printf("%s%s", print_this, fields_delimiter);
+		print_fields_printf("%s%s", print_this, fields_delimiter);
 	else if (print_this) {
 		if (strlen(print_this) > abs_len)
 			print_this[abs_len-1] = '+';
 
 		if (field->len == abs_len)
-			printf("%*.*s ", abs_len, abs_len, print_this);
+			print_fields_printf("%*.*s ", abs_len, abs_len, print_this);
 		else
-			printf("%-*.*s ", abs_len, abs_len, print_this);
+			print_fields_printf("%-*.*s ", abs_len, abs_len, print_this);
 	}
 	xfree(print_this);
 }
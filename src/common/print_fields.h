@@ -53,6 +53,8 @@
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/common/list.h"
+#include "src/common/pack.h"
+#include "src/common/columnar.h"
 
 typedef struct {
 	int len;  /* what is the width of the print */
@@ -69,8 +71,28 @@ enum {
 
 extern int print_fields_parsable_print;
 extern int print_fields_have_header;
+extern int print_fields_binary;
 extern char *fields_delimiter;
 
+/*
+ * Send the output of the print_fields functions called by this thread to
+ * the end of buffer instead of stdout. Pass NULL to go back to stdout.
+ */
+extern void print_fields_set_buffer(Buf buffer);
+/* printf() to the current output of this thread */
+extern void print_fields_printf(const char *fmt, ...)
+	__attribute__ ((format (printf, 1, 2)));
+
+/*
+ * With print_fields_binary set, print_fields_header() starts a columnar dump
+ * of the fields listed and the print_fields_* functions set their values
+ * in the current row of the dump rather than printing them.
+ */
+/* End the row printed, with a newline or in the columnar dump */
+extern void print_fields_end_row(void);
+/* Write the columnar dump to stdout and free it, if there is one */
+extern int print_fields_binary_write(void);
+
 extern void destroy_print_field(void *object);
 extern void print_fields_header(List print_fields_list);
 extern void print_fields_date(print_field_t *field, time_t value, int last);
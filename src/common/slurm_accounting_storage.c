@@ -193,6 +193,7 @@ typedef struct slurm_acct_storage_ops {
 				    struct job_record *job_ptr);
 	int  (*step_start)         (void *db_conn,
 				    struct step_record *step_ptr);
+	int  (*step_start_flush)   (void *db_conn);
 	int  (*step_complete)      (void *db_conn,
 				    struct step_record *step_ptr);
 	int  (*job_suspend)        (void *db_conn,
@@ -280,6 +281,7 @@ static const char *syms[] = {
 	"jobacct_storage_p_job_start",
 	"jobacct_storage_p_job_complete",
 	"jobacct_storage_p_step_start",
+	"jobacct_storage_p_step_start_flush",
 	"jobacct_storage_p_step_complete",
 	"jobacct_storage_p_suspend",
 	"jobacct_storage_p_get_jobs_cond",
@@ -971,6 +973,18 @@ extern int jobacct_storage_g_step_start(void *db_conn,
 	return (*(ops.step_start))(db_conn, step_ptr);
 }
 
+/*
+ * send the job step starts db_conn may still hold to the storage
+ */
+extern int jobacct_storage_g_step_start_flush(void *db_conn)
+{
+	if (slurm_acct_storage_init(NULL) < 0)
+		return SLURM_ERROR;
+	if (enforce & ACCOUNTING_ENFORCE_NO_STEPS)
+		return SLURM_SUCCESS;
+	return (*(ops.step_start_flush))(db_conn);
+}
+
 /*
  * load into the storage the end of a job step
  */
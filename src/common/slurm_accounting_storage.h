@@ -624,6 +624,13 @@ extern int jobacct_storage_g_job_complete(void *db_conn,
 extern int jobacct_storage_g_step_start(void *db_conn,
 					struct step_record *step_ptr);
 
+/*
+ * send the job step starts db_conn may still hold to the storage,
+ * must succeed before they are acknowledged
+ * RET SLURM_SUCCESS, or an error if any of them was lost
+ */
+extern int jobacct_storage_g_step_start_flush(void *db_conn);
+
 /*
  * load into the storage the end of a job step
  */
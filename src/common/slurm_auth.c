@@ -70,6 +70,9 @@ typedef struct slurm_auth_ops {
         int          (*print)     ( void *cred, FILE *fp );
         int          (*sa_errno)  ( void *cred );
         const char * (*sa_errstr) ( int slurm_errno );
+	int          (*bind)      (void *cred, char *peer, uid_t peer_uid,
+				   char *data, uint32_t len);
+	void         (*forget)    (char *peer);
 } slurm_auth_ops_t;
 /*
  * These strings must be kept in the same order as the fields
@@ -85,7 +88,9 @@ static const char *syms[] = {
 	"slurm_auth_unpack",
 	"slurm_auth_print",
 	"slurm_auth_errno",
-	"slurm_auth_errstr"
+	"slurm_auth_errstr",
+	"slurm_auth_bind",
+	"slurm_auth_forget"
 };
 
 /*
@@ -267,3 +272,20 @@ const char *g_slurm_auth_errstr(int slurm_errno)
 
         return (*(ops.sa_errstr))(slurm_errno);
 }
+
+int g_slurm_auth_bind(void *cred, char *peer, uid_t peer_uid, char *data,
+		      uint32_t len)
+{
+	if (slurm_auth_init(NULL) < 0)
+		return SLURM_ERROR;
+
+	return (*(ops.bind))(cred, peer, peer_uid, data, len);
+}
+
+void g_slurm_auth_forget(char *peer)
+{
+	if (slurm_auth_init(NULL) < 0)
+		return;
+
+	(*(ops.forget))(peer);
+}
@@ -149,4 +149,20 @@ int	g_slurm_auth_print( void *cred, FILE *fp );
 int	g_slurm_auth_errno( void *cred );
 const char *g_slurm_auth_errstr( int slurm_errno );
 
+/*
+ * Tie a credential to one message: the len bytes of its packed body and
+ * its recipient peer ("address:port"), which runs as peer_uid (NO_VAL if
+ * not known). A sender calls this before packing the credential, a
+ * receiver before verifying it, with its own address and effective uid.
+ * Mechanisms which need not know return SLURM_SUCCESS.
+ */
+extern int	g_slurm_auth_bind(void *cred, char *peer, uid_t peer_uid,
+				  char *data, uint32_t len);
+
+/*
+ * Forget anything kept to make credentials for recipient peer, e.g. after
+ * it did not answer a message.
+ */
+extern void	g_slurm_auth_forget(char *peer);
+
 #endif /*__SLURM_AUTHENTICATION_H__*/
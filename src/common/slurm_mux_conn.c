@@ -0,0 +1,394 @@
+/*****************************************************************************\
+ *  slurm_mux_conn.c - requests multiplexed on a persistent connection to the
+ *	slurmctld
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "slurm/slurm_errno.h"
+#include "src/common/fd.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_mux_conn.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define MUX_SLOTS	256	/* requests outstanding per process */
+#define MUX_CLIENT_IDLE	60	/* reconnect after this many idle seconds,
+				 * well below the slurmctld's idle limit */
+
+/* A request waiting for its reply, req_id == 0 if the slot is free */
+typedef struct {
+	slurm_mux_conn_t *conn;
+	bool done;
+	uint16_t req_id;	/* (sequence << 8) | slot */
+	slurm_msg_t *resp;
+	int rc;
+} mux_wait_t;
+
+static __thread slurm_mux_conn_t *mux_current = NULL;
+static __thread uint16_t mux_current_id = 0;
+
+static pthread_mutex_t mux_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mux_cond = PTHREAD_COND_INITIALIZER;
+static slurm_mux_conn_t *client_conn = NULL;
+static mux_wait_t mux_wait[MUX_SLOTS];
+static int mux_wait_cnt = 0;
+static uint8_t mux_seq = 0;
+static bool atfork_set = false;
+
+extern slurm_mux_conn_t *slurm_mux_conn_create(int fd)
+{
+	slurm_mux_conn_t *mux = xmalloc(sizeof(slurm_mux_conn_t));
+
+	mux->fd = fd;
+	mux->last_active = time(NULL);
+	slurm_mutex_init(&mux->lock);
+	mux->refcnt = 1;
+
+	return mux;
+}
+
+extern void slurm_mux_conn_get(slurm_mux_conn_t *mux)
+{
+	slurm_mutex_lock(&mux->lock);
+	mux->refcnt++;
+	mux->last_active = time(NULL);
+	slurm_mutex_unlock(&mux->lock);
+}
+
+extern void slurm_mux_conn_put(slurm_mux_conn_t *mux)
+{
+	bool last;
+
+	slurm_mutex_lock(&mux->lock);
+	last = (--mux->refcnt == 0);
+	mux->last_active = time(NULL);
+	slurm_mutex_unlock(&mux->lock);
+
+	if (!last)
+		return;
+
+	if ((mux->fd >= 0) && (close(mux->fd) < 0))
+		error("%s: close(%d): %m", __func__, mux->fd);
+	slurm_mutex_destroy(&mux->lock);
+	xfree(mux);
+}
+
+extern bool slurm_mux_conn_idle(slurm_mux_conn_t *mux, int secs)
+{
+	bool idle;
+
+	slurm_mutex_lock(&mux->lock);
+	idle = ((mux->refcnt == 1) &&
+		(difftime(time(NULL), mux->last_active) >= secs));
+	slurm_mutex_unlock(&mux->lock);
+
+	return idle;
+}
+
+extern void slurm_mux_conn_set_current(slurm_mux_conn_t *mux, uint16_t req_id)
+{
+	mux_current = mux;
+	mux_current_id = req_id;
+}
+
+extern slurm_mux_conn_t *slurm_mux_conn_current(int fd, uint16_t *req_id)
+{
+	if (!mux_current || (mux_current->fd != fd))
+		return NULL;
+
+	*req_id = mux_current_id;
+	return mux_current;
+}
+
+extern bool slurm_mux_conn_enabled(void)
+{
+	static int enabled = -1;
+
+	if (enabled == -1) {
+		char *comm_params = slurm_get_comm_parameters();
+
+		/* The slurmctld's own RPCs to a peer keep their own path */
+		enabled = (xstrcasestr(comm_params, "CtldMultiplex") &&
+			   !run_in_daemon("slurmctld"));
+		xfree(comm_params);
+	}
+
+	return enabled;
+}
+
+/*
+ * A child does not inherit the reader thread, forget the parent's connection
+ * and its waiters (whose threads did not come along either).
+ */
+static void _atfork_child(void)
+{
+	slurm_mutex_init(&mux_lock);
+	slurm_cond_init(&mux_cond, NULL);
+	if (client_conn)
+		(void) close(client_conn->fd);
+	client_conn = NULL;
+	memset(mux_wait, 0, sizeof(mux_wait));
+	mux_wait_cnt = 0;
+}
+
+/* Return how many requests wait on conn. Call with mux_lock held. */
+static int _conn_waiters(slurm_mux_conn_t *conn)
+{
+	int i, cnt = 0;
+
+	for (i = 0; i < MUX_SLOTS; i++) {
+		if (mux_wait[i].req_id && (mux_wait[i].conn == conn))
+			cnt++;
+	}
+
+	return cnt;
+}
+
+/*
+ * Stop sending on client_conn. Its reader exits once the requests sent on it
+ * are answered. Call with mux_lock held.
+ */
+static void _client_detach(void)
+{
+	slurm_mux_conn_t *conn = client_conn;
+
+	if (!conn)
+		return;
+
+	client_conn = NULL;
+	if (!_conn_waiters(conn))
+		(void) shutdown(conn->fd, SHUT_RDWR);
+}
+
+/* Hand a reply to its waiter or drop it if nobody waits for it anymore */
+static void _client_deliver(slurm_mux_conn_t *conn, slurm_msg_t *msg, int rc)
+{
+	mux_wait_t *wait = &mux_wait[msg->msg_index % MUX_SLOTS];
+
+	slurm_mutex_lock(&mux_lock);
+	if (!msg->msg_index || (wait->req_id != msg->msg_index) ||
+	    (wait->conn != conn) || wait->done) {
+		slurm_mutex_unlock(&mux_lock);
+		debug("%s: dropping reply to request %hu, nobody waits for it",
+		      __func__, msg->msg_index);
+		slurm_free_msg_members(msg);
+		return;
+	}
+
+	if (rc == SLURM_SUCCESS)
+		memcpy(wait->resp, msg, sizeof(slurm_msg_t));
+	else
+		slurm_free_msg_members(msg);
+	wait->rc = rc;
+	wait->done = true;
+	slurm_cond_broadcast(&mux_cond);
+	slurm_mutex_unlock(&mux_lock);
+}
+
+/* Fail the requests still waiting on conn, which is gone */
+static void _client_fail(slurm_mux_conn_t *conn)
+{
+	int i;
+
+	slurm_mutex_lock(&mux_lock);
+	if (client_conn == conn)
+		client_conn = NULL;
+	for (i = 0; i < MUX_SLOTS; i++) {
+		if (!mux_wait[i].req_id || (mux_wait[i].conn != conn) ||
+		    mux_wait[i].done)
+			continue;
+		mux_wait[i].rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+		mux_wait[i].done = true;
+	}
+	slurm_cond_broadcast(&mux_cond);
+	slurm_mutex_unlock(&mux_lock);
+}
+
+static void *_client_reader(void *arg)
+{
+	slurm_mux_conn_t *conn = arg;
+	int timeout = slurm_get_msg_timeout() * 1000;
+	struct pollfd pfd;
+
+	pfd.fd = conn->fd;
+	pfd.events = POLLIN;
+
+	while (1) {
+		char *buf = NULL;
+		size_t buflen = 0;
+		Buf buffer;
+		slurm_msg_t msg;
+		int rc;
+
+		if (poll(&pfd, 1, -1) < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			error("%s: poll: %m", __func__);
+			break;
+		}
+		if (slurm_msg_recvfrom_timeout(conn->fd, &buf, &buflen, 0,
+					       timeout) < 0)
+			break;	/* closed by either end */
+
+		slurm_msg_t_init(&msg);
+		buffer = create_buf(buf, buflen);
+		if (slurm_unpack_received_msg(&msg, conn->fd, buffer))
+			rc = slurm_get_errno();
+		else
+			rc = SLURM_SUCCESS;
+		free_buf(buffer);
+		_client_deliver(conn, &msg, rc);
+	}
+
+	_client_fail(conn);
+	slurm_mux_conn_put(conn);
+
+	return NULL;
+}
+
+/* Open client_conn and start its reader. Call with mux_lock held. */
+static int _client_connect(bool *use_backup)
+{
+	slurm_addr_t addr;
+	int fd;
+
+	if ((fd = slurm_open_controller_conn(&addr, use_backup, NULL)) < 0)
+		return SLURM_ERROR;
+	fd_set_nonblocking(fd);
+
+	if (!atfork_set) {
+		if (pthread_atfork(NULL, NULL, _atfork_child))
+			error("%s: pthread_atfork: %m", __func__);
+		atfork_set = true;
+	}
+
+	/* This reference belongs to the reader */
+	client_conn = slurm_mux_conn_create(fd);
+	slurm_thread_create_detached(NULL, _client_reader, client_conn);
+
+	return SLURM_SUCCESS;
+}
+
+extern int slurm_mux_conn_send_recv(slurm_msg_t *req, slurm_msg_t *resp,
+				    bool *use_backup)
+{
+	slurm_mux_conn_t *conn;
+	mux_wait_t *wait = NULL;
+	int i, rc;
+	time_t deadline;
+	struct timespec ts = {0, 0};
+
+	slurm_msg_t_init(resp);
+
+	slurm_mutex_lock(&mux_lock);
+	while (!wait) {
+		if (client_conn && slurm_mux_conn_idle(client_conn,
+						       MUX_CLIENT_IDLE))
+			_client_detach();
+		if (!client_conn && _client_connect(use_backup)) {
+			slurm_mutex_unlock(&mux_lock);
+			return -1;
+		}
+		if (mux_wait_cnt >= MUX_SLOTS) {
+			slurm_cond_wait(&mux_cond, &mux_lock);
+			continue;
+		}
+		for (i = 0; i < MUX_SLOTS; i++) {
+			if (!mux_wait[i].req_id)
+				break;
+		}
+		wait = &mux_wait[i];
+		if (!++mux_seq)
+			mux_seq = 1;
+		wait->req_id = (mux_seq << 8) | i;
+	}
+	conn = wait->conn = client_conn;
+	slurm_mux_conn_get(conn);
+	wait->done = false;
+	wait->resp = resp;
+	wait->rc = SLURM_SUCCESS;
+	mux_wait_cnt++;
+	slurm_mutex_unlock(&mux_lock);
+
+	slurm_mux_conn_set_current(conn, wait->req_id);
+	rc = slurm_send_node_msg(conn->fd, req);
+	slurm_mux_conn_set_current(NULL, 0);
+
+	slurm_mutex_lock(&mux_lock);
+	if (rc < 0) {
+		rc = slurm_get_errno();
+	} else {
+		deadline = time(NULL) + slurm_get_msg_timeout();
+		ts.tv_sec = deadline;
+		while (!wait->done && (time(NULL) < deadline))
+			slurm_cond_timedwait(&mux_cond, &mux_lock, &ts);
+		if (wait->done)
+			rc = wait->rc;
+		else
+			rc = SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT;
+	}
+	wait->conn = NULL;
+	wait->req_id = 0;
+	wait->resp = NULL;
+	mux_wait_cnt--;
+	/* A detached connection closes after its last reply */
+	if ((conn != client_conn) && !_conn_waiters(conn))
+		(void) shutdown(conn->fd, SHUT_RDWR);
+	slurm_cond_broadcast(&mux_cond);
+	slurm_mutex_unlock(&mux_lock);
+	slurm_mux_conn_put(conn);
+
+	if (rc != SLURM_SUCCESS) {
+		slurm_seterrno(rc);
+		return -1;
+	}
+	return 0;
+}
+
+extern void slurm_mux_conn_close(void)
+{
+	slurm_mutex_lock(&mux_lock);
+	_client_detach();
+	slurm_mutex_unlock(&mux_lock);
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************\
+ *  slurm_mux_conn.h - requests multiplexed on a persistent connection to the
+ *	slurmctld
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURM_MUX_CONN_H
+#define _SLURM_MUX_CONN_H
+
+#include <pthread.h>
+#include <time.h>
+
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * With CommunicationParameters=CtldMultiplex, a client process keeps one
+ * connection to the slurmctld open and sends all of its controller RPCs over
+ * it. Requests carry SLURM_MSG_MUX in their header flags and a request id in
+ * msg_index. The slurmctld processes each request in its own thread and tags
+ * the reply with the same msg_index, so replies may come back in any order.
+ * A reader thread in the client hands each reply to the thread waiting on it.
+ */
+
+/* One multiplexed connection, used on both ends */
+typedef struct {
+	int fd;
+	time_t last_active;	/* last time a reference was taken or dropped */
+	pthread_mutex_t lock;	/* serializes writes to fd, protects refcnt */
+	int refcnt;		/* fd is closed when this drops to zero */
+} slurm_mux_conn_t;
+
+/* Wrap fd, returning a connection with one reference */
+extern slurm_mux_conn_t *slurm_mux_conn_create(int fd);
+
+/* Take or drop a reference to a connection */
+extern void slurm_mux_conn_get(slurm_mux_conn_t *mux);
+extern void slurm_mux_conn_put(slurm_mux_conn_t *mux);
+
+/*
+ * Return true if only one reference is held and no other was taken or
+ * dropped for at least secs seconds.
+ */
+extern bool slurm_mux_conn_idle(slurm_mux_conn_t *mux, int secs);
+
+/*
+ * Make messages this thread sends on mux->fd carry req_id and SLURM_MSG_MUX,
+ * writing them whole under mux->lock. Clear with mux == NULL.
+ */
+extern void slurm_mux_conn_set_current(slurm_mux_conn_t *mux, uint16_t req_id);
+
+/*
+ * Return the connection set by slurm_mux_conn_set_current() if it uses fd,
+ * and set req_id to the request id to send. Return NULL otherwise.
+ */
+extern slurm_mux_conn_t *slurm_mux_conn_current(int fd, uint16_t *req_id);
+
+/* Return true if controller RPCs of this process should be multiplexed */
+extern bool slurm_mux_conn_enabled(void);
+
+/*
+ * Send req to the slurmctld over this process's multiplexed connection,
+ * opening it if needed, and wait up to MessageTimeout for the reply.
+ * IN/OUT use_backup - as for slurm_open_controller_conn()
+ * RET 0 on success, -1 on failure and sets errno
+ */
+extern int slurm_mux_conn_send_recv(slurm_msg_t *req, slurm_msg_t *resp,
+				    bool *use_backup);
+
+/*
+ * Stop using the current multiplexed connection, the next request opens a
+ * new one. Requests already sent on the old one still get their replies.
+ */
+extern void slurm_mux_conn_close(void);
+
+#endif
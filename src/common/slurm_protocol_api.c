@@ -65,6 +65,7 @@
 #include "src/common/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_auth.h"
+#include "src/common/slurm_mux_conn.h"
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_common.h"
@@ -97,6 +98,8 @@ static char *_global_auth_key(void);
 static void  _remap_slurmctld_errno(void);
 static int   _unpack_msg_uid(Buf buffer);
 static bool  _is_port_ok(int, uint16_t, bool);
+static int   _send_recv_msg(int fd, slurm_msg_t *req, slurm_msg_t *resp,
+			    int timeout, bool request);
 
 #if _DEBUG
 static void _print_data(char *data, int len);
@@ -3209,6 +3212,27 @@ fini:	_slurm_api_free_comm_config(proto_conf);
 	return rc;
 }
 
+/*
+ * Tie a received credential to the message body following it in buffer
+ * and to the address the message was sent to, for authentication
+ * mechanisms which sign them
+ */
+static int _auth_bind_received(void *auth_cred, int fd, Buf buffer,
+			       uint32_t body_length)
+{
+	slurm_addr_t addr;
+	char addr_str[32];
+
+	/* Credentials which needed the address are then rejected */
+	if (slurm_get_stream_addr(fd, &addr) || (addr.sin_family != AF_INET))
+		return SLURM_SUCCESS;
+
+	slurm_print_slurm_addr(&addr, addr_str, sizeof(addr_str));
+	return g_slurm_auth_bind(auth_cred, addr_str, geteuid(),
+				 &buffer->head[buffer->processed],
+				 MIN(body_length, remaining_buf(buffer)));
+}
+
 extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 {
 	header_t header;
@@ -3219,6 +3243,8 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
 		goto total_return;
 	}
+	/* Matches a reply on a multiplexed connection to its request */
+	msg->msg_index = header.msg_index;
 
 	if (check_header_version(&header) < 0) {
 		slurm_addr_t resp_addr;
@@ -3260,7 +3286,9 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
+	if (_auth_bind_received(auth_cred, fd, buffer, header.body_length)) {
+		rc = SLURM_ERROR;
+	} else if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = g_slurm_auth_verify(auth_cred, _global_auth_key());
 	} else {
 		char *auth_info = slurm_get_auth_info();
@@ -3532,7 +3560,9 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
+	if (_auth_bind_received(auth_cred, fd, buffer, header.body_length)) {
+		rc = SLURM_ERROR;
+	} else if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = g_slurm_auth_verify(auth_cred, _global_auth_key());
 	} else {
 		char *auth_info = slurm_get_auth_info();
@@ -3766,7 +3796,9 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
+	if (_auth_bind_received(auth_cred, fd, buffer, header.body_length)) {
+		rc = SLURM_ERROR;
+	} else if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = g_slurm_auth_verify(auth_cred, _global_auth_key());
 	} else {
 		char *auth_info = slurm_get_auth_info();
@@ -3831,15 +3863,24 @@ total_return:
 
 /*
  *  Do the wonderful stuff that needs be done to pack msg
- *  and hdr into buffer
+ *  and hdr into buffer, copying the body from body if it was packed
+ *  already
  */
 static void
-_pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
+_pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer, Buf body)
 {
 	unsigned int tmplen, msglen;
 
 	tmplen = get_buf_offset(buffer);
-	pack_msg(msg, buffer);
+	if (body) {
+		msglen = get_buf_offset(body);
+		if (remaining_buf(buffer) < msglen)
+			grow_buf(buffer, msglen);
+		memcpy(&buffer->head[buffer->processed], get_buf_data(body),
+		       msglen);
+		buffer->processed += msglen;
+	} else
+		pack_msg(msg, buffer);
 	msglen = get_buf_offset(buffer) - tmplen;
 
 	/* update header with correct cred and msg lengths */
@@ -3853,16 +3894,58 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 }
 
 /*
- *  Send a slurm message over an open file descriptor `fd'
+ * Return the uid the daemon listening on the port of addr runs as, for the
+ * slurmctld and slurmd ports of this cluster, NO_VAL for any other port
+ */
+static uid_t _peer_uid(slurm_addr_t *addr)
+{
+	slurm_ctl_conf_t *conf;
+	uint16_t port = ntohs(addr->sin_port);
+	uid_t uid = (uid_t) NO_VAL;
+
+	conf = slurm_conf_lock();
+	if ((port >= conf->slurmctld_port) &&
+	    (port < (conf->slurmctld_port + conf->slurmctld_port_count)))
+		uid = conf->slurm_user_id;
+	else if (port == conf->slurmd_port)
+		uid = conf->slurmd_user_id;
+	slurm_conf_unlock();
+
+	return uid;
+}
+
+/*
+ * Have the next request to the peer of fd start a new authentication
+ * session, if the authentication mechanism keeps them
+ */
+static void _auth_forget_peer(int fd)
+{
+	slurm_addr_t addr;
+	char addr_str[32];
+
+	if (slurm_get_peer_addr(fd, &addr) || (addr.sin_family != AF_INET))
+		return;
+
+	slurm_print_slurm_addr(&addr, addr_str, sizeof(addr_str));
+	g_slurm_auth_forget(addr_str);
+}
+
+/*
+ *  Send a slurm message over an open file descriptor `fd'.
+ *    If request is set, fd was connected to the message's only recipient,
+ *    so its credential may be tied to that recipient.
  *    Returns the size of the message sent in bytes, or -1 on failure.
  */
-int slurm_send_node_msg(int fd, slurm_msg_t * msg)
+static int _send_node_msg(int fd, slurm_msg_t *msg, bool request)
 {
 	header_t header;
-	Buf      buffer;
+	Buf      buffer, body = NULL;
 	int      rc;
 	void *   auth_cred;
 	time_t   start_time = time(NULL);
+	slurm_mux_conn_t *mux;
+	slurm_addr_t peer_addr;
+	char     peer_str[32];
 
 	if (msg->conn) {
 		persist_msg_t persist_msg;
@@ -3940,6 +4023,30 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	}
 
 	init_header(&header, msg, msg->flags);
+	if ((mux = slurm_mux_conn_current(fd, &header.msg_index)))
+		header.flags |= SLURM_MSG_MUX;
+
+	/*
+	 * A request to a single recipient may have its credential tied to
+	 * its body and that recipient, so pack the body first
+	 */
+	if (request && !msg->forward.cnt &&
+	    !slurm_get_peer_addr(fd, &peer_addr) &&
+	    (peer_addr.sin_family == AF_INET)) {
+		body = init_buf(BUF_SIZE);
+		pack_msg(msg, body);
+		slurm_print_slurm_addr(&peer_addr, peer_str, sizeof(peer_str));
+		if (g_slurm_auth_bind(auth_cred, peer_str,
+				      _peer_uid(&peer_addr),
+				      get_buf_data(body),
+				      get_buf_offset(body))) {
+			error("authentication: %s",
+			      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
+			(void) g_slurm_auth_destroy(auth_cred);
+			free_buf(body);
+			slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		}
+	}
 
 	/*
 	 * Pack header into buffer for transmission
@@ -3956,23 +4063,31 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
 		free_buf(buffer);
+		if (body)
+			free_buf(body);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
 	/*
 	 * Pack message into buffer
 	 */
-	_pack_msg(msg, &header, buffer);
+	_pack_msg(msg, &header, buffer, body);
+	if (body)
+		free_buf(body);
 
 #if	_DEBUG
 	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
 #endif
 	/*
-	 * Send message
+	 * Send message, whole if other threads share the connection
 	 */
+	if (mux)
+		slurm_mutex_lock(&mux->lock);
 	rc = slurm_msg_sendto( fd, get_buf_data(buffer),
 			       get_buf_offset(buffer),
 			       SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
+	if (mux)
+		slurm_mutex_unlock(&mux->lock);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -3999,6 +4114,15 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	return rc;
 }
 
+/*
+ *  Send a slurm message over an open file descriptor `fd'
+ *    Returns the size of the message sent in bytes, or -1 on failure.
+ */
+int slurm_send_node_msg(int fd, slurm_msg_t * msg)
+{
+	return _send_node_msg(fd, msg, false);
+}
+
 /**********************************************************************\
  * stream functions
 \**********************************************************************/
@@ -4341,6 +4465,15 @@ int slurm_send_reroute_msg(slurm_msg_t *msg, slurmdb_cluster_rec_t *cluster_rec)
  */
 extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 			       slurm_msg_t *resp, int timeout)
+{
+	return _send_recv_msg(fd, req, resp, timeout, false);
+}
+
+/*
+ * As slurm_send_recv_msg(), request as for _send_node_msg()
+ */
+static int _send_recv_msg(int fd, slurm_msg_t *req, slurm_msg_t *resp,
+			  int timeout, bool request)
 {
 	int rc = -1;
 	slurm_msg_t_init(resp);
@@ -4354,7 +4487,7 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 		resp->conn = req->conn;
 	}
 
-	if (slurm_send_node_msg(fd, req) >= 0) {
+	if (_send_node_msg(fd, req, request) >= 0) {
 		/* no need to adjust and timeouts here since we are not
 		   forwarding or expecting anything other than 1 message
 		   and the regular timeout will be altered in
@@ -4379,7 +4512,11 @@ _send_and_recv_msg(int fd, slurm_msg_t *req,
 		   slurm_msg_t *resp, int timeout)
 {
 	int retry = 0;
-	int rc = slurm_send_recv_msg(fd, req, resp, timeout);
+	int rc = _send_recv_msg(fd, req, resp, timeout, true);
+
+	/* The peer may have restarted and reject our credentials */
+	if (rc < 0)
+		_auth_forget_peer(fd);
 
 	/*
 	 *  Attempt to close an open connection
@@ -4416,7 +4553,7 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 			timeout = slurm_get_msg_timeout() * 1000;
 		req->forward.timeout = timeout;
 	}
-	if (slurm_send_node_msg(fd, req) >= 0) {
+	if (_send_node_msg(fd, req, true) >= 0) {
 		if (req->forward.cnt > 0) {
 			/* figure out where we are in the tree and set
 			 * the timeout for to wait for our children
@@ -4439,7 +4576,8 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 		}
 		ret_list = slurm_receive_msgs(fd, steps, timeout);
 	}
-
+	if (!ret_list)
+		_auth_forget_peer(fd);
 
 	/*
 	 *  Attempt to close an open connection
@@ -4456,7 +4594,9 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 /*
  * slurm_send_recv_controller_msg
  * opens a connection to the controller, sends the controller a message,
- * listens for the response, then closes the connection
+ * listens for the response, then closes the connection. With
+ * CommunicationParameters=CtldMultiplex the message goes over this process's
+ * persistent connection to the controller instead (see slurm_mux_conn.h).
  * IN request_msg	- slurm_msg request
  * OUT response_msg	- slurm_msg response
  * IN comm_cluster_rec	- Communication record (host/port/version)/
@@ -4476,6 +4616,7 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	slurm_addr_t ctrl_addr;
 	static bool use_backup = false;
 	slurmdb_cluster_rec_t *save_comm_cluster_rec = comm_cluster_rec;
+	bool use_mux;
 
 	/*
 	 * Just in case the caller didn't initialize his slurm_msg_t, and
@@ -4491,8 +4632,12 @@ tryagain:
 	if (comm_cluster_rec)
 		request_msg->flags |= SLURM_GLOBAL_AUTH_KEY;
 
-	if ((fd = slurm_open_controller_conn(&ctrl_addr, &use_backup,
-					     comm_cluster_rec)) < 0) {
+	/* Other clusters are always reached on a connection of their own */
+	use_mux = (!comm_cluster_rec && slurm_mux_conn_enabled());
+
+	if (!use_mux &&
+	    ((fd = slurm_open_controller_conn(&ctrl_addr, &use_backup,
+					      comm_cluster_rec)) < 0)) {
 		rc = -1;
 		goto cleanup;
 	}
@@ -4508,7 +4653,13 @@ tryagain:
 		 * control, we sleep and retry later
 		 */
 		retry = 0;
-		rc = _send_and_recv_msg(fd, request_msg, response_msg, 0);
+		if (use_mux)
+			rc = slurm_mux_conn_send_recv(request_msg,
+						      response_msg,
+						      &use_backup);
+		else
+			rc = _send_and_recv_msg(fd, request_msg,
+						response_msg, 0);
 		if (response_msg->auth_cred)
 			g_slurm_auth_destroy(response_msg->auth_cred);
 		else
@@ -4527,10 +4678,13 @@ tryagain:
 			slurm_free_return_code_msg(response_msg->data);
 			sleep(slurmctld_timeout / 2);
 			use_backup = false;
-			if ((fd = slurm_open_controller_conn(&ctrl_addr,
-							     &use_backup,
-							     comm_cluster_rec))
-			    < 0) {
+			if (use_mux) {
+				/* Reconnect, maybe to another controller */
+				slurm_mux_conn_close();
+				retry = 1;
+			} else if ((fd = slurm_open_controller_conn(
+					    &ctrl_addr, &use_backup,
+					    comm_cluster_rec)) < 0) {
 				rc = -1;
 			} else {
 				retry = 1;
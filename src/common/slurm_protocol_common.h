@@ -108,6 +108,8 @@
 #define SLURMDBD_CONNECTION     0x0002
 #define SLURM_MSG_KEEP_BUFFER   0x0004
 #define SLURM_DROP_PRIV		0x0008
+#define SLURM_MSG_MUX		0x0010	/* request on a multiplexed connection,
+					 * see slurm_mux_conn.h */
 
 #include "src/common/slurm_protocol_socket_common.h"
 
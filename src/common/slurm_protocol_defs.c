@@ -1536,6 +1536,7 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 		xfree(msg->rpc_user_id);
 		xfree(msg->rpc_user_cnt);
 		xfree(msg->rpc_user_time);
+		xfree(msg->aggr_comp_cnt);
 		xfree(msg);
 	}
 }
@@ -4017,6 +4018,20 @@ extern void slurm_free_network_callerid_resp(network_callerid_resp_t *resp)
 	}
 }
 
+extern void slurm_free_step_list_request_msg(step_list_request_msg_t *msg)
+{
+	xfree(msg);
+}
+
+extern void slurm_free_step_list_response_msg(step_list_response_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->job_id);
+		xfree(msg->step_id);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_block_job_info(void *object)
 {
 	block_job_info_t *block_job_info = (block_job_info_t *)object;
@@ -4423,6 +4438,12 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_TOP_JOB:
 		slurm_free_top_job_msg(data);
 		break;
+	case REQUEST_STEP_LIST:
+		slurm_free_step_list_request_msg(data);
+		break;
+	case RESPONSE_STEP_LIST:
+		slurm_free_step_list_response_msg(data);
+		break;
 	case REQUEST_JOB_REQUEUE:
 		slurm_free_requeue_msg(data);
 		break;
@@ -5116,6 +5137,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_STEP_COMPLETE_AGGR";
 	case REQUEST_TOP_JOB:
 		return "REQUEST_TOP_JOB";
+	case REQUEST_STEP_LIST:
+		return "REQUEST_STEP_LIST";
+	case RESPONSE_STEP_LIST:
+		return "RESPONSE_STEP_LIST";
 
 	case REQUEST_LAUNCH_TASKS:				/* 6001 */
 		return "REQUEST_LAUNCH_TASKS";
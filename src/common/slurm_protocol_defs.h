@@ -365,6 +365,8 @@ typedef enum {
 	RESPONSE_NETWORK_CALLERID,
 	REQUEST_STEP_COMPLETE_AGGR,
 	REQUEST_TOP_JOB,		/* 5038 */
+	REQUEST_STEP_LIST,
+	RESPONSE_STEP_LIST,
 
 	REQUEST_LAUNCH_TASKS = 6001,
 	RESPONSE_LAUNCH_TASKS,
@@ -916,6 +918,17 @@ typedef struct network_callerid_resp {
 	char *node_name;
 } network_callerid_resp_t;
 
+typedef struct step_list_request_msg {
+	uint32_t job_id;	/* NO_VAL for every job */
+	uint32_t uid;		/* NO_VAL for every user */
+} step_list_request_msg_t;
+
+typedef struct step_list_response_msg {
+	uint32_t step_cnt;
+	uint32_t *job_id;
+	uint32_t *step_id;
+} step_list_response_msg_t;
+
 typedef struct composite_msg {
 	slurm_addr_t sender;	/* address of sending node/port */
 	List	 msg_list;
@@ -1510,6 +1523,8 @@ extern void slurm_free_license_info_request_msg(license_info_request_msg_t *msg)
 extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data);
 extern void slurm_free_network_callerid_msg(network_callerid_msg_t *mesg);
 extern void slurm_free_network_callerid_resp(network_callerid_resp_t *resp);
+extern void slurm_free_step_list_request_msg(step_list_request_msg_t *msg);
+extern void slurm_free_step_list_response_msg(step_list_response_msg_t *msg);
 extern void slurm_free_set_fs_dampening_factor_msg(
 	set_fs_dampening_factor_msg_t *msg);
 extern void slurm_free_control_status_msg(control_status_msg_t *msg);
@@ -579,6 +579,18 @@ static void _pack_top_job_msg(top_job_msg_t *msg, Buf buffer,
 static int  _unpack_top_job_msg(top_job_msg_t **msg_ptr, Buf buffer,
 				uint16_t protocol_version);
 
+static void _pack_step_list_request_msg(step_list_request_msg_t *msg,
+					Buf buffer, uint16_t protocol_version);
+static int  _unpack_step_list_request_msg(step_list_request_msg_t **msg_ptr,
+					  Buf buffer,
+					  uint16_t protocol_version);
+static void _pack_step_list_response_msg(step_list_response_msg_t *msg,
+					 Buf buffer,
+					 uint16_t protocol_version);
+static int  _unpack_step_list_response_msg(step_list_response_msg_t **msg_ptr,
+					   Buf buffer,
+					   uint16_t protocol_version);
+
 static void _pack_buffer_msg(slurm_msg_t * msg, Buf buffer);
 
 static void _pack_kvs_host_rec(struct kvs_hosts *msg_ptr, Buf buffer,
@@ -1375,6 +1387,16 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		_pack_top_job_msg((top_job_msg_t *)msg->data, buffer,
 				  msg->protocol_version);
 		break;
+	case REQUEST_STEP_LIST:
+		_pack_step_list_request_msg(
+			(step_list_request_msg_t *)msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_STEP_LIST:
+		_pack_step_list_response_msg(
+			(step_list_response_msg_t *)msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case REQUEST_BATCH_SCRIPT:
 	case REQUEST_JOB_READY:
 	case REQUEST_JOB_INFO_SINGLE:
@@ -2117,6 +2139,16 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		rc = _unpack_top_job_msg((top_job_msg_t **) &msg->data, buffer,
 					 msg->protocol_version);
 		break;
+	case REQUEST_STEP_LIST:
+		rc = _unpack_step_list_request_msg(
+			(step_list_request_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_STEP_LIST:
+		rc = _unpack_step_list_response_msg(
+			(step_list_response_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case REQUEST_BATCH_SCRIPT:
 	case REQUEST_JOB_READY:
 	case REQUEST_JOB_INFO_SINGLE:
@@ -13457,6 +13489,96 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_step_list_request_msg(step_list_request_msg_t *msg,
+					Buf buffer, uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	if (protocol_version >= SLURM_18_08_PROTOCOL_VERSION) {
+		pack32(msg->job_id, buffer);
+		pack32(msg->uid, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+	}
+}
+
+static int  _unpack_step_list_request_msg(step_list_request_msg_t **msg_ptr,
+					  Buf buffer,
+					  uint16_t protocol_version)
+{
+	step_list_request_msg_t *msg;
+	xassert(msg_ptr != NULL);
+
+	msg = xmalloc(sizeof(step_list_request_msg_t));
+	*msg_ptr = msg;
+
+	if (protocol_version >= SLURM_18_08_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->job_id, buffer);
+		safe_unpack32(&msg->uid, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	*msg_ptr = NULL;
+	slurm_free_step_list_request_msg(msg);
+	return SLURM_ERROR;
+}
+
+static void _pack_step_list_response_msg(step_list_response_msg_t *msg,
+					 Buf buffer,
+					 uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	if (protocol_version >= SLURM_18_08_PROTOCOL_VERSION) {
+		pack32(msg->step_cnt, buffer);
+		pack32_array(msg->job_id, msg->step_cnt, buffer);
+		pack32_array(msg->step_id, msg->step_cnt, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+	}
+}
+
+static int  _unpack_step_list_response_msg(step_list_response_msg_t **msg_ptr,
+					   Buf buffer,
+					   uint16_t protocol_version)
+{
+	step_list_response_msg_t *msg;
+	uint32_t uint32_tmp;
+	xassert(msg_ptr != NULL);
+
+	msg = xmalloc(sizeof(step_list_response_msg_t));
+	*msg_ptr = msg;
+
+	if (protocol_version >= SLURM_18_08_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->step_cnt, buffer);
+		safe_unpack32_array(&msg->job_id, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->step_cnt)
+			goto unpack_error;
+		safe_unpack32_array(&msg->step_id, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->step_cnt)
+			goto unpack_error;
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	*msg_ptr = NULL;
+	slurm_free_step_list_response_msg(msg);
+	return SLURM_ERROR;
+}
+
 static void _pack_forward_data_msg(forward_data_msg_t *msg,
 				   Buf buffer, uint16_t protocol_version)
 {
@@ -14602,6 +14724,10 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_pack_jobs, buffer);
+
+			safe_unpack32(&msg->aggr_msg_cnt,	buffer);
+			safe_unpack32_array(&msg->aggr_comp_cnt,
+					    &msg->aggr_level_cnt, buffer);
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
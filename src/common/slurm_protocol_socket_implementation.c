@@ -256,7 +256,7 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			goto done;
 		}
 		if ((ufds.revents & POLLHUP) || (ufds.revents & POLLNVAL) ||
-		    (recv(fd, &temp, 1, flags) == 0)) {
+		    (recv(fd, &temp, 1, flags | MSG_PEEK) == 0)) {
 			debug2("slurm_send_timeout: Socket no longer there");
 			slurm_seterrno(ENOTCONN);
 			sent = SLURM_ERROR;
@@ -156,9 +156,12 @@
 #define	hostset_create		slurm_hostset_create
 #define	hostset_delete		slurm_hostset_delete
 #define	hostset_destroy		slurm_hostset_destroy
+#define	hostset_difference	slurm_hostset_difference
 #define	hostset_insert		slurm_hostset_insert
+#define	hostset_intersection	slurm_hostset_intersection
 #define	hostset_shift		slurm_hostset_shift
 #define	hostset_shift_range	slurm_hostset_shift_range
+#define	hostset_union		slurm_hostset_union
 #define	hostset_within		slurm_hostset_within
 
 /* gres.[ch] functions */
@@ -442,10 +445,18 @@
 #define stepd_add_extern_pid		slurm_stepd_add_extern_pid
 #define stepd_get_x11_display		slurm_stepd_get_x11_display
 
+/* auth_session.[ch] functions */
+#define auth_session_sign		slurm_auth_session_sign
+#define auth_session_verify		slurm_auth_session_verify
+#define auth_session_forget		slurm_auth_session_forget
+#define auth_session_token_free		slurm_auth_session_token_free
+#define auth_session_fini		slurm_auth_session_fini
+
 
 #endif /* USE_ALIAS */
 
 /* Include the function definitions after redefining their names. */
+#include "src/common/auth_session.h"
 #include "src/common/bitstring.h"
 #include "src/common/callerid.h"
 #include "src/common/eio.h"
@@ -629,6 +629,103 @@ done:
 	return l;
 }
 
+static int _step_loc_mismatch(void *x, void *key)
+{
+	step_loc_t *loc = (step_loc_t *) x;
+	uint32_t job_id = *(uint32_t *) key;
+
+	return (loc->jobid != job_id);
+}
+
+/*
+ * Ask the slurmd of "nodename" for the steps of the given job and user from
+ * its registry of running slurmstepds.
+ * RET a List of step_loc_t or NULL if slurmd could not be queried
+ */
+static List _stepd_list_from_slurmd(const char *directory,
+				    const char *nodename,
+				    uint32_t job_id, uint32_t uid)
+{
+	slurm_msg_t req_msg, resp_msg;
+	step_list_request_msg_t req;
+	step_list_response_msg_t *resp;
+	step_loc_t *loc;
+	List l = NULL;
+	int i;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	if (slurm_conf_get_addr(nodename, &req_msg.address) != SLURM_SUCCESS)
+		return NULL;
+
+	req.job_id = job_id;
+	req.uid = uid;
+	req_msg.msg_type = REQUEST_STEP_LIST;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_node_msg(&req_msg, &resp_msg, 0) < 0)
+		return NULL;
+
+	if (resp_msg.msg_type == RESPONSE_STEP_LIST) {
+		resp = (step_list_response_msg_t *) resp_msg.data;
+		l = list_create((ListDelF) _free_step_loc_t);
+		for (i = 0; i < resp->step_cnt; i++) {
+			loc = xmalloc(sizeof(step_loc_t));
+			loc->directory = xstrdup(directory);
+			loc->nodename = xstrdup(nodename);
+			loc->jobid = resp->job_id[i];
+			loc->stepid = resp->step_id[i];
+			list_append(l, loc);
+		}
+	} else {
+		/* Most likely an older slurmd */
+		debug2("%s: unexpected response %s", __func__,
+		       rpc_num2string(resp_msg.msg_type));
+	}
+	slurm_free_msg_data(resp_msg.msg_type, resp_msg.data);
+
+	return l;
+}
+
+/*
+ * Return a List of step_loc_t for the slurmstepds of job "job_id" owned by
+ * user "uid" (NO_VAL matches any job or user) on "nodename", as known to
+ * the local slurmd. Unlike stepd_available() this neither scans the spool
+ * directory nor requires connecting to the slurmstepds of other jobs. Falls
+ * back to stepd_available() filtered by job_id (but not by uid) if the
+ * slurmd can not be queried.
+ */
+extern List stepd_available_filter(const char *directory,
+				   const char *nodename,
+				   uint32_t job_id, uint32_t uid)
+{
+	char *local_nodename = NULL, *local_directory = NULL;
+	List l;
+
+	if (nodename == NULL) {
+		if (!(local_nodename = _guess_nodename()))
+			return NULL;
+		nodename = local_nodename;
+	}
+	if (directory == NULL) {
+		slurm_ctl_conf_t *cf;
+
+		cf = slurm_conf_lock();
+		local_directory = slurm_conf_expand_slurmd_path(
+			cf->slurmd_spooldir, nodename);
+		slurm_conf_unlock();
+		directory = local_directory;
+	}
+
+	if (!(l = _stepd_list_from_slurmd(directory, nodename, job_id, uid)) &&
+	    (l = stepd_available(directory, nodename)) && (job_id != NO_VAL))
+		(void) list_delete_all(l, _step_loc_mismatch, &job_id);
+
+	xfree(local_directory);
+	xfree(local_nodename);
+	return l;
+}
+
 /*
  * Send the termination signal to all of the unix domain socket files
  * for a given directory and nodename, and then unlink the files.
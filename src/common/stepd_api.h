@@ -192,6 +192,17 @@ int stepd_attach(int fd, uint16_t protocol_version,
  */
 extern List stepd_available(const char *directory, const char *nodename);
 
+/*
+ * Return a List of step_loc_t for the slurmstepds of job "job_id" owned by
+ * user "uid" on "nodename", as known to its slurmd. NO_VAL matches any job
+ * or user. "directory" and "nodename" may be NULL as for stepd_available(),
+ * which is also used if the slurmd can not be queried (in which case the
+ * uid filter is not applied).
+ */
+extern List stepd_available_filter(const char *directory,
+				   const char *nodename,
+				   uint32_t job_id, uint32_t uid);
+
 /*
  * Return true if the process with process ID "pid" is found in
  * the proctrack container of the slurmstepd "step".
@@ -301,6 +301,23 @@ gid_from_string (char *name, gid_t *gidp)
 	return 0;
 }
 
+/*
+ * Convert a gid to an xmalloc'd string, NULL on error.
+ * Caller must free eventually.
+ */
+char *gid_to_string_or_null(gid_t gid)
+{
+	struct group grp, *result;
+	char buffer[PW_BUF_SIZE];
+	char *gstring = NULL;
+	int rc;
+
+	rc = _getgrgid_r(gid, &grp, buffer, PW_BUF_SIZE, &result);
+	if (rc == 0 && result)
+		gstring = xstrdup(result->gr_name);
+	return gstring;
+}
+
 char *
 gid_to_string (gid_t gid)
 {
@@ -106,6 +106,12 @@ extern char *uid_to_string_cached(uid_t uid);
  */
 char *gid_to_string (gid_t gid);
 
+/*
+ * Same as uid_to_string_or_null, but for group name.
+ * NOTE: xfree the return value
+ */
+char *gid_to_string_or_null(gid_t gid);
+
 /* slurm_find_group_user()
  *
  * Find the user entry in the group gid. As groups could
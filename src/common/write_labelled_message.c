@@ -120,6 +120,38 @@ done:
 		return rc;
 }
 
+extern int write_unlabelled_iov(int fd, struct iovec *iov, int iovcnt)
+{
+	ssize_t n;
+	int written = 0;
+
+	while (iovcnt > 0) {
+		if (iov->iov_len == 0) {
+			iov++;
+			iovcnt--;
+			continue;
+		}
+		if ((n = writev(fd, iov, iovcnt)) < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN) ||
+			    (errno == EWOULDBLOCK))
+				continue;
+			return -1;
+		}
+		written += n;
+		while ((iovcnt > 0) && (n >= iov->iov_len)) {
+			n -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (n) {
+			iov->iov_base += n;
+			iov->iov_len -= n;
+		}
+	}
+
+	return written;
+}
+
 /*
  * Build line label. Call xfree() to release returned memory
  */
@@ -39,6 +39,8 @@
 #ifndef _HAVE_WRITE_LABELLED_MESSAGE
 #define _HAVE_WRITE_LABELLED_MESSAGE
 
+#include <sys/uio.h>
+
 #include "slurm/slurm.h"
 
 /*
@@ -64,4 +66,16 @@ extern int write_labelled_message(int fd, void *buf, int len, int task_id,
 				  uint32_t pack_offset, uint32_t task_offset,
 				  bool label, int task_id_width);
 
+/*
+ * fd             is the file descriptor to write to
+ * iov            is an array of unlabelled message buffers
+ * iovcnt         is the number of buffers in iov
+ *
+ * Write the buffers with as few writev() calls as possible, blocking
+ * like write_labelled_message() until all are written. Entries of iov are
+ * consumed as they are written. Return the number of bytes written, or -1
+ * on error.
+ */
+extern int write_unlabelled_iov(int fd, struct iovec *iov, int iovcnt);
+
 #endif
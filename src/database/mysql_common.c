@@ -48,6 +48,10 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/read_config.h"
 
+/* Limits of a statement built by mysql_db_batch_insert() */
+#define MYSQL_BATCH_ROWS 500
+#define MYSQL_BATCH_SIZE (512 * 1024)
+
 static char *table_defs_table = "table_defs_table";
 
 typedef struct {
@@ -131,6 +135,15 @@ static MYSQL_RES *_get_last_result(MYSQL *db_conn)
 	return last_result;
 }
 
+/* Drop the rows queued by mysql_db_batch_insert() */
+static void _batch_clear(mysql_conn_t *mysql_conn)
+{
+	xfree(mysql_conn->batch_head);
+	xfree(mysql_conn->batch_query);
+	xfree(mysql_conn->batch_tail);
+	mysql_conn->batch_rows = 0;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is set on function entry */
 static int _mysql_query_internal(MYSQL *db_conn, char *query)
 {
@@ -181,6 +194,27 @@ end_it:
 	return rc;
 }
 
+/*
+ * Send the rows queued by mysql_db_batch_insert(). A failure is kept in
+ * mysql_conn->batch_rc for mysql_db_batch_flush() to return, since the
+ * statement about to be sent has nothing to do with the lost rows.
+ * NOTE: Ensure that mysql_conn->lock is set on function entry
+ */
+static void _batch_flush(mysql_conn_t *mysql_conn)
+{
+	if (!mysql_conn->batch_query)
+		return;
+
+	xstrfmtcat(mysql_conn->batch_query, " %s", mysql_conn->batch_tail);
+	if (_mysql_query_internal(mysql_conn->db_conn,
+				  mysql_conn->batch_query) != SLURM_SUCCESS) {
+		error("%s: lost %d queued rows", __func__,
+		      mysql_conn->batch_rows);
+		mysql_conn->batch_rc = SLURM_ERROR;
+	}
+	_batch_clear(mysql_conn);
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -617,6 +651,7 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 {
 	if (mysql_conn) {
 		mysql_db_close_db_connection(mysql_conn);
+		_batch_clear(mysql_conn);
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
 		slurm_mutex_destroy(&mysql_conn->lock);
@@ -749,6 +784,9 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
 	slurm_mutex_lock(&mysql_conn->lock);
+	if (mysql_conn->batch_query)
+		mysql_conn->batch_rc = SLURM_ERROR;
+	_batch_clear(mysql_conn);
 	if (mysql_conn && mysql_conn->db_conn) {
 		if (mysql_thread_safe())
 			mysql_thread_end();
@@ -781,6 +819,7 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
 	rc = _mysql_query_internal(mysql_conn->db_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -799,6 +838,7 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
 	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
 		rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
@@ -834,6 +874,7 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_commit(mysql_conn->db_conn)) {
@@ -855,6 +896,9 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	if (mysql_conn->batch_query)
+		mysql_conn->batch_rc = SLURM_ERROR;
+	_batch_clear(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_rollback(mysql_conn->db_conn)) {
@@ -881,6 +925,7 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
@@ -905,13 +950,38 @@ fini:
 	return result;
 }
 
+extern MYSQL_RES *mysql_db_query_use(mysql_conn_t *mysql_conn, char *query)
+{
+	MYSQL_RES *result = NULL;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
+	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR) {
+		result = mysql_use_result(mysql_conn->db_conn);
+		/*
+		 * Starting in MariaDB 10.2 many of the api commands started
+		 * setting errno erroneously.
+		 */
+		errno = 0;
+		if (!result && mysql_field_count(mysql_conn->db_conn)) {
+			/* should have returned data */
+			error("We should have gotten a result: '%m' '%s'",
+			      mysql_error(mysql_conn->db_conn));
+		}
+	}
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return result;
+}
+
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 {
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if ((rc = _mysql_query_internal(
-		     mysql_conn->db_conn, query)) != SLURM_ERROR)
+	_batch_flush(mysql_conn);
+	if ((rc = _mysql_query_internal(mysql_conn->db_conn, query)) !=
+	    SLURM_ERROR)
 		rc = _clear_results(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -922,7 +992,8 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	uint64_t new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	_batch_flush(mysql_conn);
+	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR) {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
 			/* should have new id */
@@ -935,6 +1006,42 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+extern void mysql_db_batch_insert(mysql_conn_t *mysql_conn, char *head,
+				  char *row, char *tail)
+{
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (mysql_conn->batch_query &&
+	    (xstrcmp(mysql_conn->batch_head, head) ||
+	     xstrcmp(mysql_conn->batch_tail, tail)))
+		_batch_flush(mysql_conn);
+
+	if (!mysql_conn->batch_query) {
+		mysql_conn->batch_head = xstrdup(head);
+		mysql_conn->batch_tail = xstrdup(tail);
+		mysql_conn->batch_query = xstrdup_printf("%s %s", head, row);
+	} else
+		xstrfmtcat(mysql_conn->batch_query, ", %s", row);
+	mysql_conn->batch_rows++;
+
+	if ((mysql_conn->batch_rows >= MYSQL_BATCH_ROWS) ||
+	    (strlen(mysql_conn->batch_query) >= MYSQL_BATCH_SIZE))
+		_batch_flush(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+}
+
+extern int mysql_db_batch_flush(mysql_conn_t *mysql_conn)
+{
+	int rc;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_flush(mysql_conn);
+	rc = mysql_conn->batch_rc;
+	mysql_conn->batch_rc = SLURM_SUCCESS;
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
@@ -59,6 +59,11 @@ typedef enum {
 } slurm_mysql_plugin_type_t;
 
 typedef struct {
+	char *batch_head;	/* "insert into ... values" of batch_query */
+	char *batch_query;	/* rows queued by mysql_db_batch_insert() */
+	int batch_rc;		/* SLURM_ERROR once queued rows are lost */
+	int batch_rows;
+	char *batch_tail;	/* "on duplicate key update ..." */
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
@@ -100,10 +105,33 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn);
 
 extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 				     char *query, bool last);
+/*
+ * Like mysql_db_query_ret(), but the rows are read from the server as they
+ * are fetched instead of all at once. The result must be freed before
+ * anything else is sent on mysql_conn.
+ */
+extern MYSQL_RES *mysql_db_query_use(mysql_conn_t *mysql_conn, char *query);
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
 extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Queue row, e.g. "(1, 'a')", of the statement "<head> <row>, ... <tail>".
+ * Queued rows with the same head and tail are sent as one statement once
+ * enough of them are queued, before any other statement is sent on
+ * mysql_conn and on commit. A rollback drops them.
+ * Call mysql_db_batch_flush() before acknowledging the records queued.
+ */
+extern void mysql_db_batch_insert(mysql_conn_t *mysql_conn, char *head,
+				  char *row, char *tail);
+
+/*
+ * Send the rows queued by mysql_db_batch_insert() now.
+ * RET SLURM_SUCCESS, or SLURM_ERROR if any row queued since the last call
+ * was lost, however it was sent or dropped.
+ */
+extern int mysql_db_batch_flush(mysql_conn_t *mysql_conn);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
@@ -873,68 +873,116 @@ static char *_make_archive_name(time_t period_start, time_t period_end,
 			      start_char, end_char);
 }
 
-extern int archive_write_file(Buf buffer, char *cluster_name,
-			      time_t period_start, time_t period_end,
-			      char *arch_dir, char *arch_type,
-			      uint32_t archive_period)
-{
-	int fd = 0;
-	int rc = SLURM_SUCCESS;
-	char *old_file = NULL, *new_file = NULL, *reg_file = NULL;
-	static int high_buffer_size = (1024 * 1024);
-	static pthread_mutex_t local_file_lock = PTHREAD_MUTEX_INITIALIZER;
+struct archive_file {
+	int fd;
+	char *new_file;
+	char *reg_file;
+};
 
-	xassert(buffer);
+static pthread_mutex_t local_file_lock = PTHREAD_MUTEX_INITIALIZER;
 
-	slurm_mutex_lock(&local_file_lock);
+extern archive_file_t *archive_file_create(char *cluster_name,
+					   time_t period_start,
+					   time_t period_end,
+					   char *arch_dir, char *arch_type,
+					   uint32_t archive_period)
+{
+	archive_file_t *file = xmalloc(sizeof(archive_file_t));
 
-	/* write the buffer to file */
-	reg_file = _make_archive_name(period_start, period_end,
-				      cluster_name, arch_dir,
-				      arch_type, archive_period);
+	/* Released in archive_file_close() */
+	slurm_mutex_lock(&local_file_lock);
 
+	file->reg_file = _make_archive_name(period_start, period_end,
+					    cluster_name, arch_dir,
+					    arch_type, archive_period);
 	debug("Storing %s archive for %s at %s",
-	      arch_type, cluster_name, reg_file);
-	old_file = xstrdup_printf("%s.old", reg_file);
-	new_file = xstrdup_printf("%s.new", reg_file);
+	      arch_type, cluster_name, file->reg_file);
+	file->new_file = xstrdup_printf("%s.new", file->reg_file);
 
-	fd = creat(new_file, 0600);
-	if (fd < 0) {
-		error("Can't save archive, create file %s error %m", new_file);
-		rc = SLURM_ERROR;
-	} else {
-		int pos = 0, nwrite = get_buf_offset(buffer), amount;
-		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				rc = SLURM_ERROR;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
+	file->fd = creat(file->new_file, 0600);
+	if (file->fd < 0) {
+		error("Can't save archive, create file %s error %m",
+		      file->new_file);
+		xfree(file->new_file);
+		xfree(file->reg_file);
+		xfree(file);
+		slurm_mutex_unlock(&local_file_lock);
+		return NULL;
+	}
+
+	return file;
+}
+
+extern int archive_file_write(archive_file_t *file, Buf buffer,
+			      off_t offset)
+{
+	int pos = 0, nwrite = get_buf_offset(buffer), amount;
+	char *data = (char *)get_buf_data(buffer);
+
+	while (nwrite > 0) {
+		if (offset < 0)
+			amount = write(file->fd, &data[pos], nwrite);
+		else
+			amount = pwrite(file->fd, &data[pos], nwrite,
+					offset + pos);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file->new_file);
+			return SLURM_ERROR;
 		}
-		fsync(fd);
-		close(fd);
+		nwrite -= amount;
+		pos    += amount;
 	}
 
+	return SLURM_SUCCESS;
+}
+
+extern int archive_file_close(archive_file_t *file, int rc)
+{
+	char *old_file;
+
+	if (!rc && fsync(file->fd)) {
+		error("Error syncing file %s, %m", file->new_file);
+		rc = SLURM_ERROR;
+	}
+	close(file->fd);
+
 	if (rc)
-		(void) unlink(new_file);
+		(void) unlink(file->new_file);
 	else {			/* file shuffle */
+		old_file = xstrdup_printf("%s.old", file->reg_file);
 		(void) unlink(old_file);
-		if (link(reg_file, old_file))
-			debug4("Link(%s, %s): %m", reg_file, old_file);
-		(void) unlink(reg_file);
-		if (link(new_file, reg_file))
-			debug4("Link(%s, %s): %m", new_file, reg_file);
-		(void) unlink(new_file);
-	}
-	xfree(old_file);
-	xfree(reg_file);
-	xfree(new_file);
+		if (link(file->reg_file, old_file))
+			debug4("Link(%s, %s): %m", file->reg_file, old_file);
+		(void) unlink(file->reg_file);
+		if (link(file->new_file, file->reg_file))
+			debug4("Link(%s, %s): %m",
+			       file->new_file, file->reg_file);
+		(void) unlink(file->new_file);
+		xfree(old_file);
+	}
+	xfree(file->new_file);
+	xfree(file->reg_file);
+	xfree(file);
 	slurm_mutex_unlock(&local_file_lock);
 
 	return rc;
 }
+
+extern int archive_write_file(Buf buffer, char *cluster_name,
+			      time_t period_start, time_t period_end,
+			      char *arch_dir, char *arch_type,
+			      uint32_t archive_period)
+{
+	archive_file_t *file;
+
+	xassert(buffer);
+
+	if (!(file = archive_file_create(cluster_name, period_start,
+					 period_end, arch_dir, arch_type,
+					 archive_period)))
+		return SLURM_ERROR;
+
+	return archive_file_close(file, archive_file_write(file, buffer, -1));
+}
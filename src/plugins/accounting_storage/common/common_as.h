@@ -85,4 +85,22 @@ extern int archive_write_file(Buf buffer, char *cluster_name,
 			      char *arch_dir, char *arch_type,
 			      uint32_t archive_period);
 
+/*
+ * An archive file written a piece at a time, so the records of a period do
+ * not all have to be in memory at once. It only replaces the archive of the
+ * same name once archive_file_close() is called without error.
+ */
+typedef struct archive_file archive_file_t;
+
+extern archive_file_t *archive_file_create(char *cluster_name,
+					   time_t period_start,
+					   time_t period_end,
+					   char *arch_dir, char *arch_type,
+					   uint32_t archive_period);
+/* Write buffer at offset of the file, or after the end if offset < 0 */
+extern int archive_file_write(archive_file_t *file, Buf buffer,
+			      off_t offset);
+/* Keep the file if rc is SLURM_SUCCESS, else remove it. Returns rc or error */
+extern int archive_file_close(archive_file_t *file, int rc);
+
 #endif
@@ -847,6 +847,14 @@ extern int jobacct_storage_p_step_start(void *db_conn,
 	return rc;
 }
 
+/*
+ * send the job step starts this connection may still hold to the storage
+ */
+extern int jobacct_storage_p_step_start_flush(void *db_conn)
+{
+	return SLURM_SUCCESS;
+}
+
 /*
  * load into the storage the end of a job step
  */
@@ -1570,6 +1570,7 @@ extern int remove_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 		return SLURM_SUCCESS;
 	}
 	mysql_free_result(result);
+	as_mysql_job_cache_clear(cluster_name);
 	xstrfmtcat(mysql_conn->pre_commit_query,
 		   "drop table \"%s_%s\", \"%s_%s\", \"%s_%s\", "
 		   "\"%s_%s\", \"%s_%s\", \"%s_%s\", \"%s_%s\", "
@@ -2550,7 +2551,10 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 
 	debug4("got %d commits", list_count(mysql_conn->update_list));
 
+	rc = SLURM_SUCCESS;
 	if (mysql_conn->rollback) {
+		bool committed = false;
+
 		if (!commit) {
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
@@ -2575,8 +2579,13 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			} else {
 				if (mysql_db_commit(mysql_conn))
 					error("commit failed");
+				else
+					committed = true;
 			}
 		}
+		as_mysql_job_cache_commit(mysql_conn, committed);
+		if (commit && !committed)
+			rc = SLURM_ERROR;
 	}
 
 	if (commit && list_count(mysql_conn->update_list)) {
@@ -2642,7 +2651,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	list_flush(mysql_conn->update_list);
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
@@ -3123,6 +3132,14 @@ extern int jobacct_storage_p_step_start(mysql_conn_t *mysql_conn,
 	return as_mysql_step_start(mysql_conn, step_ptr);
 }
 
+/*
+ * send the job step starts this connection may still hold to the storage
+ */
+extern int jobacct_storage_p_step_start_flush(mysql_conn_t *mysql_conn)
+{
+	return as_mysql_step_start_flush(mysql_conn);
+}
+
 /*
  * load into the storage the end of a job step
  */
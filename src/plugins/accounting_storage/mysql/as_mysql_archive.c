@@ -43,6 +43,7 @@
 #include <unistd.h>
 
 #include "as_mysql_archive.h"
+#include "as_mysql_job.h"
 #include "src/common/env.h"
 #include "src/common/slurm_time.h"
 #include "src/common/slurmdbd_defs.h"
@@ -65,6 +66,11 @@
 #define MAX_ARCHIVE_AGE (60 * 60 * 24 * 60) /* If archive data is older than
 					       this then archive by month to
 					       handle large datasets. */
+#define MAX_ARCHIVE_CHUNK (1024 * 1024) /* Bytes of records packed before
+					   they are written to the archive
+					   file. */
+#define MAX_ARCHIVE_LOAD 10000 /* Number of records loaded from an archive
+				  per insert. */
 
 typedef struct {
 	char *cluster_nodes;
@@ -2177,22 +2183,16 @@ static char *_get_archive_columns(purge_type_t type)
 }
 
 
-static Buf _pack_archive_events(MYSQL_RES *result, char *cluster_name,
-				uint32_t cnt, uint32_t usage_info,
-				time_t *period_start)
+static uint32_t _pack_archive_events(MYSQL_RES *result, Buf buffer,
+				     time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_event_t event;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_EVENTS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[EVENT_REQ_START]);
 
@@ -2210,7 +2210,7 @@ static Buf _pack_archive_events(MYSQL_RES *result, char *cluster_name,
 		_pack_local_event(&event, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -2265,22 +2265,16 @@ _load_events(uint16_t rpc_version, Buf buffer, char *cluster_name,
 	return insert;
 }
 
-static Buf _pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
-			      uint32_t cnt, uint32_t usage_info,
-			      time_t *period_start)
+static uint32_t _pack_archive_jobs(MYSQL_RES *result, Buf buffer,
+				   time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_job_t job;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_JOBS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[JOB_REQ_SUBMIT]);
 
@@ -2328,7 +2322,7 @@ static Buf _pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 		_pack_local_job(&job, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -2413,22 +2407,16 @@ static char *_load_jobs(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
-			       uint32_t cnt, uint32_t usage_info,
-			       time_t *period_start)
+static uint32_t _pack_archive_resvs(MYSQL_RES *result, Buf buffer,
+				    time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_resv_t resv;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_RESVS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[RESV_REQ_START]);
 
@@ -2448,7 +2436,7 @@ static Buf _pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
 		_pack_local_resv(&resv, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -2503,22 +2491,16 @@ static char *_load_resvs(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_steps(MYSQL_RES *result, char *cluster_name,
-			       uint32_t cnt, uint32_t usage_info,
-			       time_t *period_start)
+static uint32_t _pack_archive_steps(MYSQL_RES *result, Buf buffer,
+				    time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_step_t step;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_STEP_START, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[STEP_REQ_START]);
 
@@ -2576,7 +2558,7 @@ static Buf _pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 		_pack_local_step(&step, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -2675,22 +2657,16 @@ static char *_load_steps(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
-				  uint32_t cnt, uint32_t usage_info,
-				  time_t *period_start)
+static uint32_t _pack_archive_suspends(MYSQL_RES *result, Buf buffer,
+				       time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_suspend_t suspend;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_JOB_SUSPEND, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[SUSPEND_REQ_START]);
 
@@ -2704,7 +2680,7 @@ static Buf _pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
 		_pack_local_suspend(&suspend, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 
@@ -2751,22 +2727,16 @@ static char *_load_suspend(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_txns(MYSQL_RES *result, char *cluster_name,
-			      uint32_t cnt, uint32_t usage_info,
-			      time_t *period_start)
+static uint32_t _pack_archive_txns(MYSQL_RES *result, Buf buffer,
+				   time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_txn_t txn;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_TXN, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[TXN_REQ_TS]);
 
@@ -2783,7 +2753,7 @@ static Buf _pack_archive_txns(MYSQL_RES *result, char *cluster_name,
 		_pack_local_txn(&txn, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 
@@ -2837,25 +2807,16 @@ static char *_load_txn(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_usage(MYSQL_RES *result, char *cluster_name,
-			       uint32_t cnt, uint32_t usage_info,
-			       time_t *period_start)
+static uint32_t _pack_archive_usage(MYSQL_RES *result, Buf buffer,
+				    time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_usage_t usage;
-	uint16_t type = usage_info & 0x0000ffff;
-	uint16_t period = usage_info >> 16;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(type, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-	pack16(period, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[USAGE_START]);
 
@@ -2869,7 +2830,7 @@ static Buf _pack_archive_usage(MYSQL_RES *result, char *cluster_name,
 		_pack_local_usage(&usage, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -2957,24 +2918,16 @@ static char *_load_usage(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
-static Buf _pack_archive_cluster_usage(MYSQL_RES *result, char *cluster_name,
-				       uint32_t cnt, uint32_t usage_info,
-				       time_t *period_start)
+static uint32_t _pack_archive_cluster_usage(MYSQL_RES *result, Buf buffer,
+					    time_t *period_start)
 {
 	MYSQL_ROW row;
-	Buf buffer;
+	uint32_t cnt = 0;
 	local_cluster_usage_t usage;
-	uint16_t period = usage_info >> 16;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_CLUSTER_USAGE, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-	pack16(period, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
+	while ((get_buf_offset(buffer) < MAX_ARCHIVE_CHUNK) &&
+	       (row = mysql_fetch_row(result))) {
+		cnt++;
 		if (period_start && !*period_start)
 			*period_start = slurm_atoul(row[CLUSTER_START]);
 
@@ -2994,7 +2947,7 @@ static Buf _pack_archive_cluster_usage(MYSQL_RES *result, char *cluster_name,
 			&usage, SLURM_PROTOCOL_VERSION, buffer);
 	}
 
-	return buffer;
+	return cnt;
 }
 
 /* returns sql statement from archived data or NULL on error */
@@ -3063,6 +3016,57 @@ static char *_load_cluster_usage(uint16_t rpc_version, Buf buffer,
 }
 
 /* returns count of events archived or SLURM_ERROR on error */
+/*
+ * Pack the header of an archive file of type into buffer.
+ * Returns the offset of the record count, which is left 0.
+ */
+static uint32_t _pack_archive_header(purge_type_t type, char *cluster_name,
+				     uint32_t usage_info, Buf buffer)
+{
+	uint16_t msg_type = 0;
+	uint32_t cnt_offset;
+
+	switch (type) {
+	case PURGE_EVENT:
+		msg_type = DBD_GOT_EVENTS;
+		break;
+	case PURGE_SUSPEND:
+		msg_type = DBD_JOB_SUSPEND;
+		break;
+	case PURGE_RESV:
+		msg_type = DBD_GOT_RESVS;
+		break;
+	case PURGE_JOB:
+		msg_type = DBD_GOT_JOBS;
+		break;
+	case PURGE_STEP:
+		msg_type = DBD_STEP_START;
+		break;
+	case PURGE_TXN:
+		msg_type = DBD_GOT_TXN;
+		break;
+	case PURGE_USAGE:
+		msg_type = usage_info & 0x0000ffff;
+		break;
+	case PURGE_CLUSTER_USAGE:
+		msg_type = DBD_GOT_CLUSTER_USAGE;
+		break;
+	default:
+		fatal("Unknown purge type: %d", type);
+	}
+
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack_time(time(NULL), buffer);
+	pack16(msg_type, buffer);
+	packstr(cluster_name, buffer);
+	cnt_offset = get_buf_offset(buffer);
+	pack32(0, buffer);
+	if ((type == PURGE_USAGE) || (type == PURGE_CLUSTER_USAGE))
+		pack16(usage_info >> 16, buffer);
+
+	return cnt_offset;
+}
+
 static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 			       char *cluster_name, time_t period_end,
 			       char *arch_dir, uint32_t archive_period,
@@ -3071,12 +3075,12 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 	char *cols = NULL, *query = NULL;
 	time_t period_start = 0;
-	uint32_t cnt = 0;
+	uint32_t cnt = 0, chunk_cnt, cnt_offset;
 	Buf buffer;
+	archive_file_t *file = NULL;
 	int error_code = 0;
-	Buf (*pack_func)(MYSQL_RES *result, char *cluster_name,
-			 uint32_t cnt, uint32_t usage_info,
-			 time_t *period_start);
+	uint32_t (*pack_func)(MYSQL_RES *result, Buf buffer,
+			      time_t *period_start);
 
 	cols = _get_archive_columns(type);
 
@@ -3146,26 +3150,47 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 
 	if (debug_flags & DEBUG_FLAG_DB_ARCHIVE)
 		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+	/* Stream the rows so only MAX_ARCHIVE_CHUNK of them are in memory */
+	if (!(result = mysql_db_query_use(mysql_conn, query))) {
 		xfree(query);
 		return SLURM_ERROR;
 	}
 	xfree(query);
 
-	if (!(cnt = mysql_num_rows(result))) {
-		mysql_free_result(result);
-		return 0;
+	buffer = init_buf(high_buffer_size);
+	cnt_offset = _pack_archive_header(type, cluster_name, usage_info,
+					  buffer);
+	while ((chunk_cnt = (*pack_func)(result, buffer, &period_start))) {
+		cnt += chunk_cnt;
+		/* The file is named after the first record */
+		if (!file &&
+		    !(file = archive_file_create(cluster_name, period_start,
+						 period_end, arch_dir,
+						 sql_table, archive_period))) {
+			error_code = SLURM_ERROR;
+			break;
+		}
+		if ((error_code = archive_file_write(file, buffer, -1)))
+			break;
+		set_buf_offset(buffer, 0);
+	}
+	if (!error_code && mysql_errno(mysql_conn->db_conn)) {
+		error("Couldn't read %s_%s records to archive: %s",
+		      cluster_name, sql_table,
+		      mysql_error(mysql_conn->db_conn));
+		error_code = SLURM_ERROR;
 	}
-
-	buffer = (*pack_func)(result, cluster_name, cnt, usage_info,
-			      &period_start);
 	mysql_free_result(result);
 
-	error_code = archive_write_file(buffer, cluster_name,
-					period_start, period_end,
-					arch_dir, sql_table,
-					archive_period);
+	/* Now that we know it, fill in the record count of the header */
+	if (file && !error_code) {
+		set_buf_offset(buffer, 0);
+		pack32(cnt, buffer);
+		error_code = archive_file_write(file, buffer, cnt_offset);
+	}
 	free_buf(buffer);
+	if (file)
+		error_code = archive_file_close(file, error_code);
 
 	if (error_code != SLURM_SUCCESS)
 		return error_code;
@@ -3457,6 +3482,9 @@ static int _archive_purge_table(purge_type_t purge_type, uint32_t usage_info,
 		}
 
 		xfree(query);
+		/* cached db_index lookups may point at purged jobs */
+		if (purge_type == PURGE_JOB)
+			as_mysql_job_cache_clear(cluster_name);
 		if (rc != SLURM_SUCCESS) {
 			error("Couldn't remove old data from %s table",
 			      sql_table);
@@ -3706,42 +3734,64 @@ extern int as_mysql_jobacct_process_archive_load(
 		goto got_sql;
 	}
 
-	switch (type) {
-	case DBD_GOT_EVENTS:
-		data = _load_events(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_GOT_JOBS:
-		data = _load_jobs(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_GOT_RESVS:
-		data = _load_resvs(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_STEP_START:
-		data = _load_steps(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_JOB_SUSPEND:
-		data = _load_suspend(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_GOT_TXN:
-		data = _load_txn(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_GOT_ASSOC_USAGE:
-	case DBD_GOT_WCKEY_USAGE:
+	if ((type == DBD_GOT_ASSOC_USAGE) || (type == DBD_GOT_WCKEY_USAGE) ||
+	    (type == DBD_GOT_CLUSTER_USAGE))
 		safe_unpack16(&period, buffer);
-		data = _load_usage(ver, buffer, cluster_name, type, period,
-				   rec_cnt);
-		break;
-	case DBD_GOT_CLUSTER_USAGE:
-		safe_unpack16(&period, buffer);
-		data = _load_cluster_usage(ver, buffer, cluster_name, period,
-					   rec_cnt);
-		break;
-	default:
-		error("Unknown type '%u' to load from archive", type);
-		break;
+
+	/* Insert the records a bounded number at a time */
+	while (rec_cnt) {
+		uint32_t cnt = MIN(rec_cnt, MAX_ARCHIVE_LOAD);
+
+		switch (type) {
+		case DBD_GOT_EVENTS:
+			data = _load_events(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_GOT_JOBS:
+			data = _load_jobs(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_GOT_RESVS:
+			data = _load_resvs(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_STEP_START:
+			data = _load_steps(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_JOB_SUSPEND:
+			data = _load_suspend(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_GOT_TXN:
+			data = _load_txn(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_GOT_ASSOC_USAGE:
+		case DBD_GOT_WCKEY_USAGE:
+			data = _load_usage(ver, buffer, cluster_name, type,
+					   period, cnt);
+			break;
+		case DBD_GOT_CLUSTER_USAGE:
+			data = _load_cluster_usage(ver, buffer, cluster_name,
+						   period, cnt);
+			break;
+		default:
+			error("Unknown type '%u' to load from archive", type);
+			break;
+		}
+		rec_cnt -= cnt;
+
+		if (!data) {
+			error("No data to load");
+			FREE_NULL_BUFFER(buffer);
+			return SLURM_ERROR;
+		}
+		if (debug_flags & DEBUG_FLAG_DB_ARCHIVE)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", data);
+		error_code = mysql_db_query_check_after(mysql_conn, data);
+		xfree(data);
+		if (error_code != SLURM_SUCCESS)
+			goto unpack_error;
 	}
 	FREE_NULL_BUFFER(buffer);
 
+	return SLURM_SUCCESS;
+
 got_sql:
 	if (!data) {
 		error("No data to load");
@@ -3757,6 +3807,8 @@ unpack_error:
 		FREE_NULL_BUFFER(buffer);
 		return SLURM_ERROR;
 	}
+	/* the loaded sql may have replaced or deleted any job */
+	as_mysql_job_cache_clear(NULL);
 
 	return SLURM_SUCCESS;
 }
@@ -2256,7 +2256,7 @@ static int _cluster_get_assocs(mysql_conn_t *mysql_conn,
 		get_usage_for_list(mysql_conn, DBD_GET_ASSOC_USAGE,
 				   assoc_list, cluster_name,
 				   assoc_cond->usage_start,
-				   assoc_cond->usage_end);
+				   assoc_cond->usage_end, with_usage);
 
 	list_transfer(sent_list, assoc_list);
 	FREE_NULL_LIST(assoc_list);
@@ -50,6 +50,17 @@
 
 #define BUFFER_SIZE 4096
 
+/* Update of a step row already there when its start is sent again */
+static char *step_dup_update =
+	"on duplicate key update "
+	"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+	"time_end=0, state=VALUES(state), "
+	"nodelist=VALUES(nodelist), node_inx=VALUES(node_inx), "
+	"task_dist=VALUES(task_dist), req_cpufreq=VALUES(req_cpufreq), "
+	"req_cpufreq_min=VALUES(req_cpufreq_min), "
+	"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+	"tres_alloc=VALUES(tres_alloc);";
+
 static char *_average_tres_usage(uint32_t *tres_ids, uint64_t *tres_cnts,
 				 int tres_cnt, int tasks)
 {
@@ -70,6 +81,193 @@ static char *_average_tres_usage(uint32_t *tres_ids, uint64_t *tres_cnts,
 	return ret_str;
 }
 
+/*
+ * Direct mapped caches of the lookups done while recording jobs and steps
+ * whose controller has no db_index (e.g. the database was down), so bursts
+ * of such records do not cost a select each. A colliding entry just
+ * replaces the older one.
+ */
+#define JOB_CACHE_SIZE 4096
+
+typedef struct {
+	char *cluster;
+	uint64_t db_index;
+	uint32_t job_id;
+	time_t submit;
+} db_index_cache_t;
+
+/* A db_index found by a connection whose transaction is not committed */
+typedef struct {
+	db_index_cache_t entry;
+	mysql_conn_t *mysql_conn;
+} db_index_pending_t;
+
+typedef struct {
+	uint32_t assoc_id;
+	char *cluster;
+	char *user;
+} assoc_user_cache_t;
+
+static pthread_mutex_t job_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static db_index_cache_t db_index_cache[JOB_CACHE_SIZE];
+static List db_index_pending = NULL;
+static assoc_user_cache_t assoc_user_cache[JOB_CACHE_SIZE];
+
+static void _destroy_db_index_pending(void *arg)
+{
+	db_index_pending_t *pending = (db_index_pending_t *)arg;
+
+	xfree(pending->entry.cluster);
+	xfree(pending);
+}
+
+static uint64_t _db_index_cache_get(char *cluster, time_t submit,
+				    uint32_t jobid)
+{
+	db_index_cache_t *entry;
+	uint64_t db_index = 0;
+
+	slurm_mutex_lock(&job_cache_lock);
+	entry = &db_index_cache[jobid % JOB_CACHE_SIZE];
+	if ((entry->job_id == jobid) && (entry->submit == submit) &&
+	    !xstrcmp(entry->cluster, cluster))
+		db_index = entry->db_index;
+	slurm_mutex_unlock(&job_cache_lock);
+
+	return db_index;
+}
+
+/* NOTE: Ensure that job_cache_lock is set on function entry */
+static void _db_index_cache_put(char *cluster, time_t submit, uint32_t jobid,
+				uint64_t db_index)
+{
+	db_index_cache_t *entry = &db_index_cache[jobid % JOB_CACHE_SIZE];
+
+	if (xstrcmp(entry->cluster, cluster)) {
+		xfree(entry->cluster);
+		entry->cluster = xstrdup(cluster);
+	}
+	entry->db_index = db_index;
+	entry->job_id = jobid;
+	entry->submit = submit;
+}
+
+/*
+ * Cache the db_index mysql_conn found. Until mysql_conn commits, the row
+ * may still be rolled back, so only as_mysql_job_cache_commit() puts it in
+ * the cache other connections read.
+ */
+static void _db_index_cache_set(mysql_conn_t *mysql_conn, time_t submit,
+				uint32_t jobid, uint64_t db_index)
+{
+	db_index_pending_t *pending;
+
+	slurm_mutex_lock(&job_cache_lock);
+	if (!mysql_conn->rollback) {
+		_db_index_cache_put(mysql_conn->cluster_name, submit, jobid,
+				    db_index);
+	} else {
+		if (!db_index_pending)
+			db_index_pending =
+				list_create(_destroy_db_index_pending);
+		pending = xmalloc(sizeof(db_index_pending_t));
+		pending->entry.cluster = xstrdup(mysql_conn->cluster_name);
+		pending->entry.db_index = db_index;
+		pending->entry.job_id = jobid;
+		pending->entry.submit = submit;
+		pending->mysql_conn = mysql_conn;
+		list_append(db_index_pending, pending);
+	}
+	slurm_mutex_unlock(&job_cache_lock);
+}
+
+extern void as_mysql_job_cache_commit(mysql_conn_t *mysql_conn,
+				      bool committed)
+{
+	ListIterator itr;
+	db_index_pending_t *pending;
+
+	slurm_mutex_lock(&job_cache_lock);
+	if (db_index_pending) {
+		itr = list_iterator_create(db_index_pending);
+		while ((pending = list_next(itr))) {
+			if (pending->mysql_conn != mysql_conn)
+				continue;
+			if (committed)
+				_db_index_cache_put(pending->entry.cluster,
+						    pending->entry.submit,
+						    pending->entry.job_id,
+						    pending->entry.db_index);
+			list_delete_item(itr);
+		}
+		list_iterator_destroy(itr);
+	}
+	slurm_mutex_unlock(&job_cache_lock);
+}
+
+static char *_assoc_user_cache_get(char *cluster, uint32_t associd)
+{
+	assoc_user_cache_t *entry;
+	char *user = NULL;
+
+	slurm_mutex_lock(&job_cache_lock);
+	entry = &assoc_user_cache[associd % JOB_CACHE_SIZE];
+	if (entry->user && (entry->assoc_id == associd) &&
+	    !xstrcmp(entry->cluster, cluster))
+		user = xstrdup(entry->user);
+	slurm_mutex_unlock(&job_cache_lock);
+
+	return user;
+}
+
+static void _assoc_user_cache_set(char *cluster, uint32_t associd,
+				  char *user)
+{
+	assoc_user_cache_t *entry;
+
+	slurm_mutex_lock(&job_cache_lock);
+	entry = &assoc_user_cache[associd % JOB_CACHE_SIZE];
+	if (xstrcmp(entry->cluster, cluster)) {
+		xfree(entry->cluster);
+		entry->cluster = xstrdup(cluster);
+	}
+	xfree(entry->user);
+	entry->user = xstrdup(user);
+	entry->assoc_id = associd;
+	slurm_mutex_unlock(&job_cache_lock);
+}
+
+static int _find_db_index_pending(void *x, void *key)
+{
+	db_index_pending_t *pending = (db_index_pending_t *)x;
+
+	return (!key || !xstrcmp(pending->entry.cluster, (char *)key));
+}
+
+extern void as_mysql_job_cache_clear(char *cluster_name)
+{
+	int i;
+
+	slurm_mutex_lock(&job_cache_lock);
+	if (db_index_pending)
+		list_delete_all(db_index_pending, _find_db_index_pending,
+				cluster_name);
+	for (i = 0; i < JOB_CACHE_SIZE; i++) {
+		if (!cluster_name ||
+		    !xstrcmp(db_index_cache[i].cluster, cluster_name)) {
+			xfree(db_index_cache[i].cluster);
+			memset(&db_index_cache[i], 0, sizeof(db_index_cache_t));
+		}
+		if (!cluster_name ||
+		    !xstrcmp(assoc_user_cache[i].cluster, cluster_name)) {
+			xfree(assoc_user_cache[i].cluster);
+			xfree(assoc_user_cache[i].user);
+			assoc_user_cache[i].assoc_id = 0;
+		}
+	}
+	slurm_mutex_unlock(&job_cache_lock);
+}
+
 /* Used in job functions for getting the database index based off the
  * submit time and job.  0 is returned if none is found
  */
@@ -79,7 +277,13 @@ static uint64_t _get_db_index(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
 	uint64_t db_index = 0;
-	char *query = xstrdup_printf("select job_db_inx from \"%s_%s\" where "
+	char *query;
+
+	if ((db_index = _db_index_cache_get(mysql_conn->cluster_name,
+					    submit, jobid)))
+		return db_index;
+
+	query = xstrdup_printf("select job_db_inx from \"%s_%s\" where "
 				     "time_submit=%d and id_job=%u",
 				     mysql_conn->cluster_name, job_table,
 				     (int)submit, jobid);
@@ -102,6 +306,7 @@ static uint64_t _get_db_index(mysql_conn_t *mysql_conn,
 	}
 	db_index = slurm_atoull(row[0]);
 	mysql_free_result(result);
+	_db_index_cache_set(mysql_conn, submit, jobid, db_index);
 
 	return db_index;
 }
@@ -114,13 +319,13 @@ static char *_get_user_from_associd(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
 
-	/* Just so we don't have to keep a
-	   cache of the associations around we
-	   will just query the db for the user
-	   name of the association id.  Since
-	   this should sort of be a rare case
-	   this isn't too bad.
-	*/
+	/*
+	 * The user of an association never changes, so remember what the
+	 * db told us instead of keeping all the associations around.
+	 */
+	if ((user = _assoc_user_cache_get(cluster, associd)))
+		return user;
+
 	query = xstrdup_printf("select user from \"%s_%s\" where id_assoc=%u",
 			       cluster, assoc_table, associd);
 
@@ -133,8 +338,10 @@ static char *_get_user_from_associd(mysql_conn_t *mysql_conn,
 	}
 	xfree(query);
 
-	if ((row = mysql_fetch_row(result)) && row[0][0])
+	if ((row = mysql_fetch_row(result)) && row[0][0]) {
 		user = xstrdup(row[0]);
+		_assoc_user_cache_set(cluster, associd, user);
+	}
 
 	mysql_free_result(result);
 
@@ -703,7 +910,10 @@ no_rollup_change:
 				goto try_again;
 			} else
 				rc = SLURM_ERROR;
-		}
+		} else
+			_db_index_cache_set(mysql_conn, submit_time,
+					    job_ptr->job_id,
+					    job_ptr->db_index);
 	} else {
 		query = xstrdup_printf("update \"%s_%s\" set nodelist='%s', ",
 				       mysql_conn->cluster_name,
@@ -1079,7 +1289,7 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char node_list[BUFFER_SIZE];
 	char *node_inx = NULL;
 	time_t start_time, submit_time;
-	char *query = NULL;
+	char *query = NULL, *head = NULL;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1196,40 +1406,48 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* we want to print a -1 for the requid so leave it a
-	   %d */
-	/* The stepid could be -2 so use %d not %u */
-	query = xstrdup_printf(
+	/*
+	 * Steps of many jobs start at once, so queue the row and let
+	 * mysql_common send the rows of several steps as one statement.
+	 * The caller must get as_mysql_step_start_flush() to succeed before
+	 * acknowledging the step.
+	 */
+	head = xstrdup_printf(
 		"insert into \"%s_%s\" (job_db_inx, id_step, time_start, "
 		"step_name, state, tres_alloc, "
 		"nodes_alloc, task_cnt, nodelist, node_inx, "
 		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov) "
-		"values (%"PRIu64", %d, %d, '%s', %d, '%s', %d, %d, "
-		"'%s', '%s', %d, %u, %u, %u) "
-		"on duplicate key update "
-		"nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		"nodelist='%s', node_inx='%s', task_dist=%d, "
-		"req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		"tres_alloc='%s';",
-		mysql_conn->cluster_name, step_table,
+		"values",
+		mysql_conn->cluster_name, step_table);
+	/* The stepid could be -2 so use %d not %u */
+	query = xstrdup_printf(
+		"(%"PRIu64", %d, %d, '%s', %d, '%s', %d, %d, "
+		"'%s', '%s', %d, %u, %u, %u)",
 		step_ptr->job_ptr->db_index,
 		step_ptr->step_id,
 		(int)start_time, step_ptr->name,
 		JOB_RUNNING, step_ptr->tres_alloc_str,
 		nodes, tasks, node_list, node_inx, task_dist,
 		step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
-		step_ptr->cpu_freq_gov, nodes, tasks, JOB_RUNNING,
-		node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		step_ptr->tres_alloc_str);
+		step_ptr->cpu_freq_gov);
 	if (debug_flags & DEBUG_FLAG_DB_STEP)
-		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+		DB_DEBUG(mysql_conn->conn, "query\n%s %s", head, query);
+	mysql_db_batch_insert(mysql_conn, head, query, step_dup_update);
+	xfree(head);
 	xfree(query);
 
 	return rc;
 }
 
+extern int as_mysql_step_start_flush(mysql_conn_t *mysql_conn)
+{
+	/* no check_connection(), a reconnect only drops the rows */
+	if (!mysql_conn)
+		return ESLURM_DB_CONNECTION;
+
+	return mysql_db_batch_flush(mysql_conn);
+}
+
 extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 				  struct step_record *step_ptr)
 {
@@ -55,6 +55,9 @@ extern int as_mysql_job_complete(mysql_conn_t *mysql_conn,
 extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 			    struct step_record *step_ptr);
 
+/* Send the step starts queued on mysql_conn, RET SLURM_ERROR if any is lost */
+extern int as_mysql_step_start_flush(mysql_conn_t *mysql_conn);
+
 extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 			       struct step_record *step_ptr);
 
@@ -63,4 +66,17 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn, uint64_t old_db_inx,
 
 extern int as_mysql_flush_jobs_on_cluster(
 	mysql_conn_t *mysql_conn, time_t event_time);
+
+/*
+ * Publish the db_index lookups mysql_conn cached during its transaction if
+ * committed, else forget them.
+ */
+extern void as_mysql_job_cache_commit(mysql_conn_t *mysql_conn,
+				      bool committed);
+
+/*
+ * Forget the db_index and user lookups cached for cluster_name, or for
+ * every cluster if NULL
+ */
+extern void as_mysql_job_cache_clear(char *cluster_name);
 #endif
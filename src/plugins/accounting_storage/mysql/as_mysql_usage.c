@@ -413,13 +413,14 @@ end_it:
 static int _get_object_usage(mysql_conn_t *mysql_conn,
 			     slurmdbd_msg_type_t type, char *my_usage_table,
 			     char *cluster_name, char *id_str,
-			     time_t start, time_t end, List *usage_list)
+			     time_t start, time_t end, bool summed,
+			     List *usage_list)
 {
 	char *tmp = NULL;
 	int i = 0;
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
-	char *query = NULL;
+	char *query = NULL, *group_by = NULL;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
 
@@ -440,6 +441,17 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 	if (type == DBD_GET_WCKEY_USAGE)
 		usage_req_inx[0] = "t1.id";
 
+	/*
+	 * Summed, the rows of every period and, for associations, of every
+	 * child are added up here rather than sent for the client to add.
+	 */
+	if (summed) {
+		usage_req_inx[USAGE_START] = "min(t1.time_start)";
+		usage_req_inx[USAGE_ALLOC] = "sum(t1.alloc_secs)";
+		xstrfmtcat(group_by, "group by %s, t1.id_tres ",
+			   usage_req_inx[USAGE_ID]);
+	}
+
 	xstrfmtcat(tmp, "%s", usage_req_inx[i]);
 	for (i=1; i<USAGE_COUNT; i++) {
 		xstrfmtcat(tmp, ", %s", usage_req_inx[i]);
@@ -453,24 +465,29 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 			"where (t1.time_start < %ld && t1.time_start >= %ld) "
 			"&& t1.id=t2.id_assoc && (%s) && "
 			"t2.lft between t3.lft and t3.rgt "
-			"order by t3.id_assoc, time_start;",
+			"%sorder by t3.id_assoc%s;",
 			tmp, cluster_name, my_usage_table,
 			cluster_name, assoc_table, cluster_name, assoc_table,
-			end, start, id_str);
+			end, start, id_str, group_by ? group_by : "",
+			summed ? "" : ", time_start");
 		break;
 	case DBD_GET_WCKEY_USAGE:
 		query = xstrdup_printf(
 			"select %s from \"%s_%s\" as t1 "
 			"where (time_start < %ld && time_start >= %ld) "
-			"&& (%s) order by id, time_start;",
-			tmp, cluster_name, my_usage_table, end, start, id_str);
+			"&& (%s) %sorder by id%s;",
+			tmp, cluster_name, my_usage_table, end, start, id_str,
+			group_by ? group_by : "",
+			summed ? "" : ", time_start");
 		break;
 	default:
 		error("Unknown usage type %d", type);
+		xfree(group_by);
 		xfree(tmp);
 		return SLURM_ERROR;
 		break;
 	}
+	xfree(group_by);
 	xfree(tmp);
 
 	if (debug_flags & DEBUG_FLAG_DB_USAGE)
@@ -628,7 +645,8 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 */
 extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 			      slurmdbd_msg_type_t type, List object_list,
-			      char *cluster_name, time_t start, time_t end)
+			      char *cluster_name, time_t start, time_t end,
+			      uint16_t with_usage)
 {
 	int rc = SLURM_SUCCESS;
 	char *my_usage_table = NULL;
@@ -716,7 +734,9 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 	}
 
 	if (_get_object_usage(mysql_conn, type, my_usage_table, cluster_name,
-			      id_str, start, end, &usage_list)
+			      id_str, start, end,
+			      (with_usage == SLURMDB_USAGE_SUMMED),
+			      &usage_list)
 	    != SLURM_SUCCESS) {
 		xfree(id_str);
 		return SLURM_ERROR;
@@ -908,7 +928,7 @@ is_user:
 	}
 
 	_get_object_usage(mysql_conn, type, my_usage_table, cluster_name,
-			  id_str, start, end, my_list);
+			  id_str, start, end, false, my_list);
 	xfree(id_str);
 
 	return rc;
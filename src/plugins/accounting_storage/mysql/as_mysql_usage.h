@@ -46,9 +46,15 @@ extern time_t global_last_rollup;
 extern pthread_mutex_t rollup_lock;
 extern pthread_mutex_t usage_rollup_lock;
 
+/*
+ * Fill in the accounting_list of the associations or wckeys of object_list.
+ * with_usage is the with_usage of their condition, SLURMDB_USAGE_SUMMED
+ * to get one record per TRES for the whole time range.
+ */
 extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 			      slurmdbd_msg_type_t type, List object_list,
-			      char *cluster_name, time_t start, time_t end);
+			      char *cluster_name, time_t start, time_t end,
+			      uint16_t with_usage);
 extern int as_mysql_get_usage(mysql_conn_t *mysql_conn, uid_t uid,
 			  void *in, slurmdbd_msg_type_t type,
 			  time_t start, time_t end);
@@ -48,6 +48,12 @@
 #include <time.h>
 #include <unistd.h>
 
+#ifdef HAVE_OPENSSL
+#  include <openssl/evp.h>
+#  include <openssl/hmac.h>
+#  include <openssl/sha.h>
+#endif
+
 #include "slurm/slurm_errno.h"
 #include "src/common/slurm_xlator.h"
 #include "src/common/slurm_time.h"
@@ -56,6 +62,9 @@
 #define RETRY_COUNT		20
 #define RETRY_USEC		100000
 
+/* Set in the packed version of credentials carrying a session token */
+#define SESSION_VERSION_FLAG	0x80000000
+
 /*
  * These variables are required by the generic plugin interface.  If they
  * are not found in the plugin, the plugin loader will ignore it.
@@ -108,6 +117,12 @@ typedef struct _slurm_auth_credential {
 	uid_t   uid;       /* UID. valid only if verified == true            */
 	gid_t   gid;       /* GID. valid only if verified == true            */
 	int cr_errno;
+	bool    session;   /* true if token is used rather than m_str        */
+	auth_session_token_t token;
+	int     lifetime;  /* of sessions, when sending                      */
+	char   *socket;    /* munge socket, when sending                     */
+	char   *peer;      /* recipient, set by slurm_auth_bind()            */
+	unsigned char digest[AUTH_SESSION_DIGEST_LEN]; /* of message body    */
 } slurm_auth_credential_t;
 
 /*
@@ -126,12 +141,25 @@ typedef struct munge_info {
  */
 
 static char *         _auth_opts_to_socket(char *opts);
+static int            _auth_opts_to_session_lifetime(char *opts);
 static munge_info_t * cred_info_alloc(void);
 static munge_info_t * cred_info_create(munge_ctx_t ctx);
 static void           cred_info_destroy(munge_info_t *);
 static void           _print_cred_info(munge_info_t *mi);
 static void           _print_cred(munge_ctx_t ctx);
+static int            _encode_cred(slurm_auth_credential_t *c, char *socket);
 static int            _decode_cred(slurm_auth_credential_t *c, char *socket);
+static int            _verify_cred(slurm_auth_credential_t *c, char *opts);
+static char *         _session_encode(void *payload, int len, int ttl,
+				      uid_t restrict_uid, void *arg);
+static void           _session_mac(const unsigned char *key, int key_len,
+				   const unsigned char *data, int data_len,
+				   unsigned char *mac);
+static void           _session_digest(char *data, uint32_t len,
+				      unsigned char *digest);
+static int            _session_decode(char *m_str, void *payload, int *len,
+				      auth_session_cred_info_t *info,
+				      void *arg);
 
 /*
  *  Munge plugin initialization
@@ -148,6 +176,12 @@ int init ( void )
 	return SLURM_SUCCESS;
 }
 
+int fini ( void )
+{
+	auth_session_fini();
+	return SLURM_SUCCESS;
+}
+
 
 /*
  * Allocate a credential.  This function should return NULL if it cannot
@@ -156,45 +190,10 @@ int init ( void )
  */
 slurm_auth_credential_t *slurm_auth_create(char *opts)
 {
-	int rc, retry = RETRY_COUNT, auth_ttl;
+	int lifetime;
 	slurm_auth_credential_t *cred = NULL;
-	munge_err_t err = EMUNGE_SUCCESS;
-	munge_ctx_t ctx = munge_ctx_create();
-	SigFunc *ohandler;
 	char *socket;
 
-	if (ctx == NULL) {
-		error("munge_ctx_create failure");
-		return NULL;
-	}
-
-#if 0
-	/* This logic can be used to determine what socket is used by default.
-	 * A typical name is "/var/run/munge/munge.socket.2" */
-{
-	char *old_socket;
-	if (munge_ctx_get(ctx, MUNGE_OPT_SOCKET, &old_socket) != EMUNGE_SUCCESS)
-		error("munge_ctx_get failure");
-	else
-		info("Default Munge socket is %s", old_socket);
-}
-#endif
-
-	if (opts) {
-		socket = _auth_opts_to_socket(opts);
-		rc = munge_ctx_set(ctx, MUNGE_OPT_SOCKET, socket);
-		xfree(socket);
-		if (rc != EMUNGE_SUCCESS) {
-			error("munge_ctx_set failure");
-			munge_ctx_destroy(ctx);
-			return NULL;
-		}
-	}
-
-	auth_ttl = slurm_get_auth_ttl();
-	if (auth_ttl)
-		(void) munge_ctx_set(ctx, MUNGE_OPT_TTL, auth_ttl);
-
 	cred = xmalloc(sizeof(*cred));
 	cred->verified = false;
 	cred->m_str    = NULL;
@@ -205,36 +204,25 @@ slurm_auth_credential_t *slurm_auth_create(char *opts)
 	xassert((cred->magic = MUNGE_MAGIC));
 
 	/*
-	 *  Temporarily block SIGALARM to avoid misleading
-	 *    "Munged communication error" from libmunge if we
-	 *    happen to time out the connection in this secion of
-	 *    code. FreeBSD needs this cast.
+	 * With a session lifetime, one munge credential per recipient carries
+	 * a session key and each message only carries a MAC made with it.
+	 * The MAC is made by slurm_auth_bind() once the message body, its
+	 * recipient and the uid of the recipient are known, else
+	 * slurm_auth_pack() falls back to a munge credential of its own.
 	 */
-	ohandler = xsignal(SIGALRM, (SigFunc *)SIG_BLOCK);
+	if ((lifetime = _auth_opts_to_session_lifetime(opts)) > 0) {
+		cred->session = true;
+		cred->lifetime = lifetime;
+		cred->socket = _auth_opts_to_socket(opts);
+		return cred;
+	}
 
-again:
-	err = munge_encode(&cred->m_str, ctx, cred->buf, cred->len);
-	if (err != EMUNGE_SUCCESS) {
-		if ((err == EMUNGE_SOCKET) && retry--) {
-			debug("Munge encode failed: %s (retrying ...)",
-			      munge_ctx_strerror(ctx));
-			usleep(RETRY_USEC);	/* Likely munged too busy */
-			goto again;
-		}
-		if (err == EMUNGE_SOCKET)
-			error("If munged is up, restart with --num-threads=10");
-		error("Munge encode failed: %s", munge_ctx_strerror(ctx));
-		xfree( cred );
+	socket = _auth_opts_to_socket(opts);
+	if (_encode_cred(cred, socket) < 0) {
+		xfree(cred);
 		cred = NULL;
-		plugin_errno = err + MUNGE_ERRNO_OFFSET;
-	} else if ((bad_cred_test > 0) && cred->m_str) {
-		int i = ((int) time(NULL)) % strlen(cred->m_str);
-		cred->m_str[i]++;	/* random position in credential */
 	}
-
-	xsignal(SIGALRM, ohandler);
-
-	munge_ctx_destroy(ctx);
+	xfree(socket);
 
 	return cred;
 }
@@ -260,6 +248,9 @@ slurm_auth_destroy( slurm_auth_credential_t *cred )
 		free(cred->m_str);
 	if (cred->buf)
 		free(cred->buf);
+	auth_session_token_free(&cred->token);
+	xfree(cred->socket);
+	xfree(cred->peer);
 
 	xfree(cred);
 	return SLURM_SUCCESS;
@@ -273,9 +264,6 @@ slurm_auth_destroy( slurm_auth_credential_t *cred )
 int
 slurm_auth_verify( slurm_auth_credential_t *c, char *opts )
 {
-	int rc;
-	char *socket;
-
 	if (!c) {
 		plugin_errno = SLURM_AUTH_BADARG;
 		return SLURM_ERROR;
@@ -283,13 +271,7 @@ slurm_auth_verify( slurm_auth_credential_t *c, char *opts )
 
 	xassert(c->magic == MUNGE_MAGIC);
 
-	if (c->verified)
-		return SLURM_SUCCESS;
-
-	socket = _auth_opts_to_socket(opts);
-	rc = _decode_cred(c, socket);
-	xfree(socket);
-	if (rc < 0)
+	if (_verify_cred(c, opts) < 0)
 		return SLURM_ERROR;
 
 	return SLURM_SUCCESS;
@@ -307,15 +289,9 @@ slurm_auth_get_uid( slurm_auth_credential_t *cred, char *opts )
 		return SLURM_AUTH_NOBODY;
 	}
 
-	if (!cred->verified) {
-		int rc;
-		char *socket = _auth_opts_to_socket(opts);
-		rc = _decode_cred(cred, socket);
-		xfree(socket);
-		if (rc < 0) {
-			cred->cr_errno = SLURM_AUTH_INVALID;
-			return SLURM_AUTH_NOBODY;
-		}
+	if (_verify_cred(cred, opts) < 0) {
+		cred->cr_errno = SLURM_AUTH_INVALID;
+		return SLURM_AUTH_NOBODY;
 	}
 
 	xassert(cred->magic == MUNGE_MAGIC);
@@ -335,15 +311,9 @@ slurm_auth_get_gid( slurm_auth_credential_t *cred, char *opts )
 		return SLURM_AUTH_NOBODY;
 	}
 
-	if (!cred->verified) {
-		int rc;
-		char *socket = _auth_opts_to_socket(opts);
-		rc = _decode_cred(cred, socket);
-		xfree(socket);
-		if (rc < 0) {
-			cred->cr_errno = SLURM_AUTH_INVALID;
-			return SLURM_AUTH_NOBODY;
-		}
+	if (_verify_cred(cred, opts) < 0) {
+		cred->cr_errno = SLURM_AUTH_INVALID;
+		return SLURM_AUTH_NOBODY;
 	}
 
 	xassert(cred->magic == MUNGE_MAGIC);
@@ -369,11 +339,28 @@ slurm_auth_pack( slurm_auth_credential_t *cred, Buf buf )
 
 	xassert(cred->magic == MUNGE_MAGIC);
 
+	/* Not bound to a message, so it needs a munge credential of its own */
+	if (cred->session && !cred->token.cred) {
+		if (_encode_cred(cred, cred->socket) < 0) {
+			cred->cr_errno = plugin_errno;
+			return SLURM_ERROR;
+		}
+		cred->session = false;
+	}
+
 	/*
 	 * Prefix the credential with a description of the credential
 	 * type so that it can be sanity-checked at the receiving end.
 	 */
 	packstr( (char *) plugin_type, buf );
+	if (cred->session) {
+		pack32(plugin_version | SESSION_VERSION_FLAG, buf);
+		packstr(cred->token.cred, buf);
+		pack32(cred->token.seq, buf);
+		pack_time(cred->token.time, buf);
+		packmem((char *) cred->token.mac, AUTH_SESSION_MAC_LEN, buf);
+		return SLURM_SUCCESS;
+	}
 	pack32( plugin_version, buf );
 	/*
 	 * Pack the data.
@@ -424,11 +411,27 @@ slurm_auth_unpack( Buf buf )
 
 	xassert((cred->magic = MUNGE_MAGIC));
 
+	if (version & SESSION_VERSION_FLAG) {
+		char *mac;
+
+		cred->session = true;
+		safe_unpackstr_xmalloc(&cred->token.cred, &size, buf);
+		safe_unpack32(&cred->token.seq, buf);
+		safe_unpack_time(&cred->token.time, buf);
+		safe_unpackmem_ptr(&mac, &size, buf);
+		if (size != AUTH_SESSION_MAC_LEN)
+			goto unpack_error;
+		memcpy(cred->token.mac, mac, AUTH_SESSION_MAC_LEN);
+		return cred;
+	}
+
 	safe_unpackstr_malloc(&cred->m_str, &size, buf);
 	return cred;
 
  unpack_error:
 	plugin_errno = SLURM_AUTH_UNPACK;
+	if (cred)
+		auth_session_token_free(&cred->token);
 	xfree( cred );
 	return NULL;
 }
@@ -451,11 +454,64 @@ slurm_auth_print( slurm_auth_credential_t *cred, FILE *fp )
 	}
 
 	fprintf(fp, "BEGIN SLURM MUNGE AUTHENTICATION CREDENTIAL\n" );
-	fprintf(fp, "%s\n", cred->m_str );
+	if (cred->session)
+		fprintf(fp, "%s session message %u\n", cred->token.cred,
+			cred->token.seq);
+	else
+		fprintf(fp, "%s\n", cred->m_str );
 	fprintf(fp, "END SLURM MUNGE AUTHENTICATION CREDENTIAL\n" );
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Tie a credential to a message: the len bytes of its packed body and its
+ * recipient, run as peer_uid. A credential being sent gets its session
+ * token here, one received records what slurm_auth_verify() checks its
+ * token against.
+ */
+int
+slurm_auth_bind(slurm_auth_credential_t *cred, char *peer, uid_t peer_uid,
+		char *data, uint32_t len)
+{
+	int rc;
+
+	if (!cred || !peer) {
+		plugin_errno = SLURM_AUTH_BADARG;
+		return SLURM_ERROR;
+	}
+
+	xassert(cred->magic == MUNGE_MAGIC);
+
+	if (!cred->session)
+		return SLURM_SUCCESS;
+
+	_session_digest(data, len, cred->digest);
+	if (cred->token.cred) {
+		xfree(cred->peer);
+		cred->peer = xstrdup(peer);
+		return SLURM_SUCCESS;
+	}
+
+	rc = auth_session_sign(&cred->token, cred->socket, peer, peer_uid,
+			       cred->digest, cred->lifetime, _session_encode,
+			       _session_mac, cred->socket);
+	if (rc != SLURM_SUCCESS) {
+		/* slurm_auth_pack() makes a plain munge credential instead */
+		debug("%s: no session for %s", __func__, peer);
+	}
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Forget the sessions made for recipient peer, so the next message to it
+ * starts a new one (e.g. it restarted and rejects the old session).
+ */
+void
+slurm_auth_forget(char *peer)
+{
+	auth_session_forget(peer);
+}
+
 int
 slurm_auth_errno( slurm_auth_credential_t *cred )
 {
@@ -491,6 +547,85 @@ slurm_auth_errstr( int slurm_errno )
 }
 
 
+/*
+ * Encode a munge credential into `c->m_str', using munge socket `socket'
+ * (NULL for the default)
+ */
+static int
+_encode_cred(slurm_auth_credential_t *c, char *socket)
+{
+	int rc, retry = RETRY_COUNT, auth_ttl;
+	munge_err_t err = EMUNGE_SUCCESS;
+	munge_ctx_t ctx = munge_ctx_create();
+	SigFunc *ohandler;
+
+	if (ctx == NULL) {
+		error("munge_ctx_create failure");
+		return SLURM_ERROR;
+	}
+
+#if 0
+	/* This logic can be used to determine what socket is used by default.
+	 * A typical name is "/var/run/munge/munge.socket.2" */
+{
+	char *old_socket;
+	if (munge_ctx_get(ctx, MUNGE_OPT_SOCKET, &old_socket) != EMUNGE_SUCCESS)
+		error("munge_ctx_get failure");
+	else
+		info("Default Munge socket is %s", old_socket);
+}
+#endif
+
+	if (socket) {
+		rc = munge_ctx_set(ctx, MUNGE_OPT_SOCKET, socket);
+		if (rc != EMUNGE_SUCCESS) {
+			error("munge_ctx_set failure");
+			munge_ctx_destroy(ctx);
+			return SLURM_ERROR;
+		}
+	}
+
+	auth_ttl = slurm_get_auth_ttl();
+	if (auth_ttl)
+		(void) munge_ctx_set(ctx, MUNGE_OPT_TTL, auth_ttl);
+
+	/*
+	 *  Temporarily block SIGALARM to avoid misleading
+	 *    "Munged communication error" from libmunge if we
+	 *    happen to time out the connection in this secion of
+	 *    code. FreeBSD needs this cast.
+	 */
+	ohandler = xsignal(SIGALRM, (SigFunc *)SIG_BLOCK);
+
+again:
+	err = munge_encode(&c->m_str, ctx, c->buf, c->len);
+	if (err != EMUNGE_SUCCESS) {
+		if ((err == EMUNGE_SOCKET) && retry--) {
+			debug("Munge encode failed: %s (retrying ...)",
+			      munge_ctx_strerror(ctx));
+			usleep(RETRY_USEC);	/* Likely munged too busy */
+			goto again;
+		}
+		if (err == EMUNGE_SOCKET)
+			error("If munged is up, restart with --num-threads=10");
+		error("Munge encode failed: %s", munge_ctx_strerror(ctx));
+		plugin_errno = err + MUNGE_ERRNO_OFFSET;
+		rc = SLURM_ERROR;
+	} else {
+		if ((bad_cred_test > 0) && c->m_str) {
+			int i = ((int) time(NULL)) % strlen(c->m_str);
+			c->m_str[i]++;	/* random position in credential */
+		}
+		rc = SLURM_SUCCESS;
+	}
+
+	xsignal(SIGALRM, ohandler);
+
+	munge_ctx_destroy(ctx);
+
+	return rc;
+}
+
 /*
  * Decode the munge encoded credential `m_str' placing results, if validated,
  * into slurm credential `c'
@@ -575,6 +710,190 @@ _decode_cred(slurm_auth_credential_t *c, char *socket)
 
 
 
+/*
+ * Verify credential `c', either its munge string or its session token
+ */
+static int _verify_cred(slurm_auth_credential_t *c, char *opts)
+{
+	int rc;
+	char *socket;
+
+	if (c->verified)
+		return SLURM_SUCCESS;
+
+	socket = _auth_opts_to_socket(opts);
+	if (c->session && !c->peer) {
+		/* The token only means something for a given message */
+		error("Munge session token not bound to a message");
+		c->cr_errno = SLURM_AUTH_INVALID;
+		rc = SLURM_ERROR;
+	} else if (c->session) {
+#ifdef HAVE_OPENSSL
+		rc = auth_session_verify(&c->token, c->peer, c->digest,
+					 _session_decode, _session_mac, socket,
+					 &c->uid, &c->gid);
+#else
+		error("Munge session tokens need Slurm built with OpenSSL");
+		rc = SLURM_AUTH_INVALID;
+#endif
+		if (rc != SLURM_SUCCESS) {
+			c->cr_errno = rc;
+			rc = SLURM_ERROR;
+		} else
+			c->verified = true;
+	} else
+		rc = _decode_cred(c, socket);
+	xfree(socket);
+
+	return rc;
+}
+
+/*
+ * Create the munge credential of a new session, valid for ttl seconds and
+ * only decoded by restrict_uid. arg is the munge socket, NULL for the
+ * default.
+ */
+static char *_session_encode(void *payload, int len, int ttl,
+			     uid_t restrict_uid, void *arg)
+{
+	int retry = RETRY_COUNT;
+	munge_err_t err;
+	munge_ctx_t ctx;
+	SigFunc *ohandler;
+	char *m_str = NULL, *session_cred = NULL;
+
+	if ((ctx = munge_ctx_create()) == NULL) {
+		error("munge_ctx_create failure");
+		return NULL;
+	}
+	if (arg && (munge_ctx_set(ctx, MUNGE_OPT_SOCKET, (char *) arg) !=
+		    EMUNGE_SUCCESS)) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return NULL;
+	}
+	(void) munge_ctx_set(ctx, MUNGE_OPT_TTL, ttl);
+	/* Anyone else able to decode it would learn the session key */
+	if (munge_ctx_set(ctx, MUNGE_OPT_UID_RESTRICTION, restrict_uid) !=
+	    EMUNGE_SUCCESS) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return NULL;
+	}
+
+	ohandler = xsignal(SIGALRM, (SigFunc *)SIG_BLOCK);
+again:
+	err = munge_encode(&m_str, ctx, payload, len);
+	if (err != EMUNGE_SUCCESS) {
+		if ((err == EMUNGE_SOCKET) && retry--) {
+			debug("Munge encode failed: %s (retrying ...)",
+			      munge_ctx_strerror(ctx));
+			usleep(RETRY_USEC);	/* Likely munged too busy */
+			goto again;
+		}
+		error("Munge encode failed: %s", munge_ctx_strerror(ctx));
+		plugin_errno = err + MUNGE_ERRNO_OFFSET;
+	} else {
+		session_cred = xstrdup(m_str);
+	}
+	xsignal(SIGALRM, ohandler);
+
+	if (m_str)
+		free(m_str);
+	munge_ctx_destroy(ctx);
+
+	return session_cred;
+}
+
+/*
+ * Decode the munge credential of a session. A credential already decoded
+ * on this host is still decoded, and reported as replayed in info.
+ */
+static int _session_decode(char *m_str, void *payload, int *len,
+			   auth_session_cred_info_t *info, void *arg)
+{
+	int retry = RETRY_COUNT, buf_len = 0, rc = SLURM_SUCCESS;
+	munge_err_t err;
+	munge_ctx_t ctx;
+	void *buf = NULL;
+
+	if ((ctx = munge_ctx_create()) == NULL) {
+		error("munge_ctx_create failure");
+		return SLURM_ERROR;
+	}
+	if (arg && (munge_ctx_set(ctx, MUNGE_OPT_SOCKET, (char *) arg) !=
+		    EMUNGE_SUCCESS)) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return SLURM_ERROR;
+	}
+
+again:
+	err = munge_decode(m_str, ctx, &buf, &buf_len, &info->uid,
+			   &info->gid);
+	if ((err != EMUNGE_SUCCESS) && (err != EMUNGE_CRED_REPLAYED)) {
+		if (buf) {
+			free(buf);
+			buf = NULL;
+		}
+		if ((err == EMUNGE_SOCKET) && retry--) {
+			debug("Munge decode failed: %s (retrying ...)",
+			      munge_ctx_strerror(ctx));
+			usleep(RETRY_USEC);	/* Likely munged too busy */
+			goto again;
+		}
+		error("Munge decode failed: %s", munge_ctx_strerror(ctx));
+		_print_cred(ctx);
+		if (err == EMUNGE_CRED_REWOUND)
+			error("Check for out of sync clocks");
+		rc = err + MUNGE_ERRNO_OFFSET;
+	} else if (!buf || (buf_len > *len) ||
+		   (munge_ctx_get(ctx, MUNGE_OPT_ENCODE_TIME, &info->encoded) !=
+		    EMUNGE_SUCCESS) ||
+		   (munge_ctx_get(ctx, MUNGE_OPT_TTL, &info->ttl) !=
+		    EMUNGE_SUCCESS) ||
+		   (munge_ctx_get(ctx, MUNGE_OPT_UID_RESTRICTION,
+				  &info->restrict_uid) != EMUNGE_SUCCESS)) {
+		rc = SLURM_AUTH_INVALID;
+	} else {
+		memcpy(payload, buf, buf_len);
+		*len = buf_len;
+		info->replayed = (err == EMUNGE_CRED_REPLAYED);
+	}
+
+	if (buf) {
+		memset(buf, 0, buf_len);
+		free(buf);
+	}
+	munge_ctx_destroy(ctx);
+	return rc;
+}
+
+/* HMAC-SHA256 of data with key, the MAC of session tokens */
+static void _session_mac(const unsigned char *key, int key_len,
+			 const unsigned char *data, int data_len,
+			 unsigned char *mac)
+{
+#ifdef HAVE_OPENSSL
+	unsigned int mac_len = AUTH_SESSION_MAC_LEN;
+
+	if (!HMAC(EVP_sha256(), key, key_len, data, data_len, mac, &mac_len))
+		memset(mac, 0, AUTH_SESSION_MAC_LEN);
+#else
+	memset(mac, 0, AUTH_SESSION_MAC_LEN);
+#endif
+}
+
+/* SHA-256 of the len bytes of a message body */
+static void _session_digest(char *data, uint32_t len, unsigned char *digest)
+{
+#ifdef HAVE_OPENSSL
+	SHA256((unsigned char *) data, len, digest);
+#else
+	memset(digest, 0, AUTH_SESSION_DIGEST_LEN);
+#endif
+}
+
 /*
  *  Allocate space for Munge credential info structure
  */
@@ -688,3 +1007,32 @@ static char *_auth_opts_to_socket(char *opts)
 
 	return socket;
 }
+
+/*
+ * Get the session lifetime from AuthInfo, "session_lifetime=<seconds>".
+ * RET lifetime in seconds, 0 if sessions are not used
+ */
+static int _auth_opts_to_session_lifetime(char *opts)
+{
+	char *tmp;
+	int lifetime;
+
+	if (!opts || !(tmp = strstr(opts, "session_lifetime=")))
+		return 0;
+#ifndef HAVE_OPENSSL
+	{
+		static bool logged = false;
+		if (!logged) {
+			error("AuthInfo session_lifetime needs Slurm built "
+			      "with OpenSSL, ignored");
+			logged = true;
+		}
+		return 0;
+	}
+#endif
+
+	lifetime = atoi(tmp + 17);
+	if (lifetime < 0)
+		lifetime = 0;
+	return lifetime;
+}
@@ -358,3 +358,21 @@ slurm_auth_errstr( int slurm_errno )
 		if ( tbl[ i ].err == slurm_errno ) return tbl[ i ].msg;
 	}
 }
+
+/*
+ * Tie a credential to a message body and recipient, nothing to do here.
+ */
+int
+slurm_auth_bind( slurm_auth_credential_t *cred, char *peer, uid_t peer_uid,
+		 char *data, uint32_t len )
+{
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Forget what is kept for a recipient, nothing to do here.
+ */
+void
+slurm_auth_forget( char *peer )
+{
+}
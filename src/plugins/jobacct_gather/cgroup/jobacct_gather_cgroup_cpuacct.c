@@ -116,7 +116,7 @@ jobacct_gather_cgroup_cpuacct_fini(slurm_cgroup_conf_t *slurm_cgroup_conf)
 	 * reverse order in which the cgroups were created.
 	 */
 	for (cc = 0; cc <= max_task_id; cc++) {
-		xcgroup_t cgroup;
+		xcgroup_t cgroup = {NULL, NULL, NULL, 0, 0, 0, -1};
 		char buf[PATH_MAX];
 
 		/* rmdir all tasks this running slurmstepd
@@ -125,7 +125,7 @@ jobacct_gather_cgroup_memory_fini(slurm_cgroup_conf_t *slurm_cgroup_conf)
 	 * will clean it up, eventually the release_agent.
 	 */
 	for (cc = 0; cc <= max_task_id; cc++) {
-		xcgroup_t cgroup;
+		xcgroup_t cgroup = {NULL, NULL, NULL, 0, 0, 0, -1};
 		char buf[PATH_MAX];
 
 		/* rmdir all tasks this running slurmstepd
@@ -39,6 +39,7 @@
 #include <unistd.h>
 
 #include "kvs.h"
+#include "kvs_table.h"
 #include "setup.h"
 #include "tree.h"
 #include "pmi.h"
@@ -52,55 +53,26 @@ int kvs_seq = 1; /* starting from 1 */
 int waiting_kvs_resp = 0;
 
 
-/* bucket of key-value pairs */
-typedef struct kvs_bucket {
-	char **pairs;
-	uint32_t count;
-	uint32_t size;
-} kvs_bucket_t;
+static kvs_table_t *kvs_table = NULL;
 
-static kvs_bucket_t *kvs_hash = NULL;
-static uint32_t hash_size = 0;
-
-static char *temp_kvs_buf = NULL;
-static int temp_kvs_cnt = 0;
-static int temp_kvs_size = 0;
-
-static int no_dup_keys = 0;
+/*
+ * Pairs put since the last fence, packed directly in tree message format.
+ * The buffer is reused across fences so that it only grows once.
+ */
+static Buf temp_kvs_buf = NULL;
 
-#define TASKS_PER_BUCKET 8
 #define TEMP_KVS_SIZE_INC 2048
 
-#define KEY_INDEX(i) (i * 2)
-#define VAL_INDEX(i) (i * 2 + 1)
-#define HASH(key) ( _hash(key) % hash_size)
-
-inline static uint32_t
-_hash(char *key)
-{
-	int len, i;
-	uint32_t hash = 0;
-	uint8_t shift;
-
-	len = strlen(key);
-	for (i = 0; i < len; i ++) {
-		shift = (uint8_t)(hash >> 24);
-		hash = (hash << 8) | (uint32_t)(shift ^ (uint8_t)key[i]);
-	}
-	return hash;
-}
-
 extern int
 temp_kvs_init(void)
 {
 	uint16_t cmd;
-	uint32_t nodeid, num_children, size;
-	Buf buf = NULL;
+	uint32_t nodeid, num_children;
 
-	xfree(temp_kvs_buf);
-	temp_kvs_cnt = 0;
-	temp_kvs_size = TEMP_KVS_SIZE_INC;
-	temp_kvs_buf = xmalloc(temp_kvs_size);
+	if (temp_kvs_buf)
+		set_buf_offset(temp_kvs_buf, 0);
+	else
+		temp_kvs_buf = init_buf(TEMP_KVS_SIZE_INC);
 
 	/* put the tree cmd here to simplify message sending */
 	if (in_stepd()) {
@@ -109,28 +81,19 @@ temp_kvs_init(void)
 		cmd = TREE_CMD_KVS_FENCE_RESP;
 	}
 
-	buf = init_buf(1024);
-	pack16(cmd, buf);
+	pack16(cmd, temp_kvs_buf);
 	if (in_stepd()) {
 		nodeid = job_info.nodeid;
 		/* XXX: TBC */
 		num_children = tree_info.num_children + 1;
 
-		pack32(nodeid, buf); /* from_nodeid */
-		packstr(tree_info.this_node, buf); /* from_node */
-		pack32(num_children, buf); /* num_children */
-		pack32(kvs_seq, buf);
+		pack32(nodeid, temp_kvs_buf); /* from_nodeid */
+		packstr(tree_info.this_node, temp_kvs_buf); /* from_node */
+		pack32(num_children, temp_kvs_buf); /* num_children */
+		pack32(kvs_seq, temp_kvs_buf);
 	} else {
-		pack32(kvs_seq, buf);
+		pack32(kvs_seq, temp_kvs_buf);
 	}
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
 
 	tasks_to_wait = 0;
 	children_to_wait = 0;
@@ -141,23 +104,11 @@ temp_kvs_init(void)
 extern int
 temp_kvs_add(char *key, char *val)
 {
-	Buf buf;
-	uint32_t size;
-
 	if ( key == NULL || val == NULL )
 		return SLURM_SUCCESS;
 
-	buf = init_buf(PMI2_MAX_KEYLEN + PMI2_MAX_VALLEN + 2 * sizeof(uint32_t));
-	packstr(key, buf);
-	packstr(val, buf);
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
+	packstr(key, temp_kvs_buf);
+	packstr(val, temp_kvs_buf);
 
 	return SLURM_SUCCESS;
 }
@@ -165,22 +116,19 @@ temp_kvs_add(char *key, char *val)
 extern int
 temp_kvs_merge(Buf buf)
 {
-	char *data;
 	uint32_t offset, size;
 
 	size = remaining_buf(buf);
 	if (size == 0) {
 		return SLURM_SUCCESS;
 	}
-	data = get_buf_data(buf);
-	offset = get_buf_offset(buf);
 
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += size;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], &data[offset], size);
-	temp_kvs_cnt += size;
+	if (remaining_buf(temp_kvs_buf) < size)
+		grow_buf(temp_kvs_buf, size);
+	offset = get_buf_offset(temp_kvs_buf);
+	memcpy(get_buf_data(temp_kvs_buf) + offset,
+	       get_buf_data(buf) + get_buf_offset(buf), size);
+	set_buf_offset(temp_kvs_buf, offset + size);
 
 	return SLURM_SUCCESS;
 }
@@ -208,10 +156,11 @@ temp_kvs_send(void)
 			/* srun or non-first-level stepds */
 			rc = slurm_forward_data(&nodelist,
 						tree_sock_addr,
-						temp_kvs_cnt,
-						temp_kvs_buf);
+						get_buf_offset(temp_kvs_buf),
+						get_buf_data(temp_kvs_buf));
 		else		/* first level stepds */
-			rc = tree_msg_to_srun(temp_kvs_cnt, temp_kvs_buf);
+			rc = tree_msg_to_srun(get_buf_offset(temp_kvs_buf),
+					      get_buf_data(temp_kvs_buf));
 
 		if (rc == SLURM_SUCCESS)
 			break;
@@ -234,14 +183,14 @@ temp_kvs_send(void)
 extern int
 kvs_init(void)
 {
-	debug3("mpi/pmi2: in kvs_init");
+	uint32_t size_hint;
 
-	hash_size = ((job_info.ntasks + TASKS_PER_BUCKET - 1) / TASKS_PER_BUCKET);
-
-	kvs_hash = xmalloc(hash_size * sizeof(kvs_bucket_t));
+	debug3("mpi/pmi2: in kvs_init");
 
-	if (getenv(PMI2_KVS_NO_DUP_KEYS_ENV))
-		no_dup_keys = 1;
+	/* most MPI implementations put a couple of keys per task */
+	size_hint = job_info.ntasks * 2;
+	kvs_table = kvs_table_create(size_hint,
+				     getenv(PMI2_KVS_NO_DUP_KEYS_ENV) != NULL);
 
 	return SLURM_SUCCESS;
 }
@@ -252,21 +201,11 @@ kvs_init(void)
 extern char *
 kvs_get(char *key)
 {
-	kvs_bucket_t *bucket;
-	char *val = NULL;
-	int i;
+	char *val;
 
 	debug3("mpi/pmi2: in kvs_get, key=%s", key);
 
-	bucket = &kvs_hash[HASH(key)];
-	if (bucket->count > 0) {
-		for(i = 0; i < bucket->count; i ++) {
-			if (! xstrcmp(key, bucket->pairs[KEY_INDEX(i)])) {
-				val = bucket->pairs[VAL_INDEX(i)];
-				break;
-			}
-		}
-	}
+	val = kvs_table_get(kvs_table, key);
 
 	debug3("mpi/pmi2: out kvs_get, val=%s", val);
 
@@ -276,33 +215,9 @@ kvs_get(char *key)
 extern int
 kvs_put(char *key, char *val)
 {
-	kvs_bucket_t *bucket;
-	int i;
-
 	debug3("mpi/pmi2: in kvs_put");
 
-	bucket = &kvs_hash[HASH(key)];
-
-	if (! no_dup_keys) {
-		for (i = 0; i < bucket->count; i ++) {
-			if (! xstrcmp(key, bucket->pairs[KEY_INDEX(i)])) {
-				/* replace the k-v pair */
-				xfree(bucket->pairs[VAL_INDEX(i)]);
-				bucket->pairs[VAL_INDEX(i)] = xstrdup(val);
-				debug("mpi/pmi2: put kvs %s=%s", key, val);
-				return SLURM_SUCCESS;
-			}
-		}
-	}
-	if (bucket->count * 2 >= bucket->size) {
-		bucket->size += (TASKS_PER_BUCKET * 2);
-		xrealloc(bucket->pairs, bucket->size * sizeof(char *));
-	}
-	/* add the k-v pair */
-	i = bucket->count;
-	bucket->pairs[KEY_INDEX(i)] = xstrdup(key);
-	bucket->pairs[VAL_INDEX(i)] = xstrdup(val);
-	bucket->count ++;
+	kvs_table_put(kvs_table, key, val);
 
 	debug3("mpi/pmi2: put kvs %s=%s", key, val);
 	return SLURM_SUCCESS;
@@ -311,17 +226,8 @@ kvs_put(char *key, char *val)
 extern int
 kvs_clear(void)
 {
-	kvs_bucket_t *bucket;
-	int i, j;
-
-	for (i = 0; i < hash_size; i ++){
-		bucket = &kvs_hash[i];
-		for (j = 0; j < bucket->count; j ++) {
-			xfree (bucket->pairs[KEY_INDEX(j)]);
-			xfree (bucket->pairs[VAL_INDEX(j)]);
-		}
-	}
-	xfree(kvs_hash);
+	kvs_table_destroy(kvs_table);
+	kvs_table = NULL;
 
 	return SLURM_SUCCESS;
 }
@@ -0,0 +1,143 @@
+/*****************************************************************************\
+ *  kvs_bench.c - measure put/get/fence throughput of the pmi2 KVS table
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Build with "make kvs_bench" (or "make check") in this directory.
+ *
+ * Usage: kvs_bench [ntasks [keys_per_task]]
+ *
+ * The fence phase packs every pair the way stepd packs its temporary KVS
+ * and then loads the message into a fresh table the way a KVS_FENCE_RESP
+ * is processed, so it approximates the per-node cost of one fence.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/log.h"
+#include "src/common/pack.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "kvs_table.h"
+
+#define VAL_LEN 64
+
+static void _report(const char *phase, uint32_t cnt, long usec)
+{
+	double rate = usec ? ((double) cnt * 1000000.0 / usec) : 0.0;
+
+	printf("%-8s %10u ops %10ld usec %12.0f ops/sec\n",
+	       phase, cnt, usec, rate);
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t opts = LOG_OPTS_STDERR_ONLY;
+	uint32_t ntasks = 100000, keys_per_task = 1, npairs, i, len;
+	char **keys, val[VAL_LEN + 1], *key, *value;
+	kvs_table_t *table;
+	Buf buf;
+	DEF_TIMERS;
+
+	log_init(argv[0], opts, 0, NULL);
+	if (argc > 1)
+		ntasks = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		keys_per_task = strtoul(argv[2], NULL, 10);
+	npairs = ntasks * keys_per_task;
+	if (!npairs) {
+		fprintf(stderr, "usage: %s [ntasks [keys_per_task]]\n",
+			argv[0]);
+		exit(1);
+	}
+
+	/* key names modelled on MPICH's per-rank business cards */
+	keys = xmalloc(sizeof(char *) * npairs);
+	for (i = 0; i < npairs; i++)
+		keys[i] = xstrdup_printf("P%u-businesscard-%u",
+					 i / keys_per_task,
+					 i % keys_per_task);
+	memset(val, 'v', VAL_LEN);
+	val[VAL_LEN] = '\0';
+
+	table = kvs_table_create(ntasks * 2, false);
+	START_TIMER;
+	for (i = 0; i < npairs; i++)
+		kvs_table_put(table, keys[i], val);
+	END_TIMER;
+	_report("put", npairs, DELTA_TIMER);
+
+	START_TIMER;
+	for (i = 0; i < npairs; i++) {
+		if (!kvs_table_get(table, keys[i]))
+			fatal("key %s not found", keys[i]);
+	}
+	END_TIMER;
+	_report("get", npairs, DELTA_TIMER);
+	kvs_table_destroy(table);
+
+	START_TIMER;
+	buf = init_buf(2048);
+	for (i = 0; i < npairs; i++) {
+		packstr(keys[i], buf);
+		packstr(val, buf);
+	}
+	set_buf_offset(buf, 0);
+	table = kvs_table_create(ntasks * 2, false);
+	for (i = 0; i < npairs; i++) {
+		if (unpackmem_ptr(&key, &len, buf) ||
+		    unpackmem_ptr(&value, &len, buf))
+			fatal("unpack error");
+		kvs_table_put(table, key, value);
+	}
+	END_TIMER;
+	_report("fence", npairs, DELTA_TIMER);
+	if (kvs_table_count(table) != npairs)
+		fatal("expected %u pairs, found %u", npairs,
+		      kvs_table_count(table));
+
+	kvs_table_destroy(table);
+	free_buf(buf);
+	for (i = 0; i < npairs; i++)
+		xfree(keys[i]);
+	xfree(keys);
+	log_fini();
+
+	return 0;
+}
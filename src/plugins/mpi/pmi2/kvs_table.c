@@ -0,0 +1,238 @@
+/*****************************************************************************\
+ *  kvs_table.c - open-addressed key-value table used by the pmi2 KVS
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <string.h>
+
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "kvs_table.h"
+
+/*
+ * Keys and values are copied into large arena blocks that are only released
+ * when the table is destroyed, so a fence with N new pairs costs a handful of
+ * allocations rather than 2 * N. The slots array holds only the hash and two
+ * pointers, and is probed linearly so that a lookup touches few cache lines.
+ */
+
+#define KVS_ARENA_BLOCK_SIZE	(64 * 1024)
+#define KVS_TABLE_MIN_SIZE	64
+
+typedef struct kvs_arena_block {
+	struct kvs_arena_block *next;
+	uint32_t size;
+	uint32_t used;
+	char data[];
+} kvs_arena_block_t;
+
+typedef struct kvs_slot {
+	uint64_t hash;
+	char *key;		/* NULL if the slot is empty */
+	char *val;
+} kvs_slot_t;
+
+struct kvs_table {
+	kvs_arena_block_t *arena;
+	uint32_t count;
+	bool no_dup_keys;
+	uint32_t size;		/* always a power of two */
+	kvs_slot_t *slots;
+};
+
+/*
+ * FNV-1a over the key followed by the MurmurHash3 64-bit finalizer, which
+ * spreads the FNV output so the low bits used for the slot index are mixed.
+ * Returns the key length through len to spare the caller a strlen().
+ */
+static inline uint64_t _hash(const char *key, size_t *len)
+{
+	const unsigned char *p = (const unsigned char *) key;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	while (*p) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+	*len = (const char *) p - key;
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+static char *_arena_copy(kvs_table_t *table, const char *str, size_t len)
+{
+	kvs_arena_block_t *blk = table->arena;
+	char *ptr;
+
+	if (!str)
+		return NULL;
+
+	len++;	/* include the terminating NUL */
+	if (!blk || ((blk->size - blk->used) < len)) {
+		uint32_t size = MAX(KVS_ARENA_BLOCK_SIZE, len);
+
+		blk = xmalloc_nz(sizeof(kvs_arena_block_t) + size);
+		blk->size = size;
+		blk->used = 0;
+		if (table->arena && (len > (KVS_ARENA_BLOCK_SIZE / 4))) {
+			/* keep filling the current block after a big value */
+			blk->next = table->arena->next;
+			table->arena->next = blk;
+		} else {
+			blk->next = table->arena;
+			table->arena = blk;
+		}
+	}
+	ptr = blk->data + blk->used;
+	memcpy(ptr, str, len);
+	blk->used += len;
+
+	return ptr;
+}
+
+static void _grow(kvs_table_t *table)
+{
+	kvs_slot_t *old_slots = table->slots;
+	uint32_t old_size = table->size, mask, i, j;
+
+	table->size *= 2;
+	table->slots = xmalloc(sizeof(kvs_slot_t) * table->size);
+	mask = table->size - 1;
+
+	for (i = 0; i < old_size; i++) {
+		if (!old_slots[i].key)
+			continue;
+		j = old_slots[i].hash & mask;
+		while (table->slots[j].key)
+			j = (j + 1) & mask;
+		table->slots[j] = old_slots[i];
+	}
+	xfree(old_slots);
+}
+
+extern kvs_table_t *kvs_table_create(uint32_t size_hint, bool no_dup_keys)
+{
+	kvs_table_t *table = xmalloc(sizeof(kvs_table_t));
+
+	/* keep the load factor under 3/4 for size_hint pairs */
+	table->size = KVS_TABLE_MIN_SIZE;
+	while (((uint64_t) table->size * 3) < ((uint64_t) size_hint * 4))
+		table->size *= 2;
+	table->slots = xmalloc(sizeof(kvs_slot_t) * table->size);
+	table->no_dup_keys = no_dup_keys;
+
+	return table;
+}
+
+extern void kvs_table_destroy(kvs_table_t *table)
+{
+	kvs_arena_block_t *blk, *next;
+
+	if (!table)
+		return;
+
+	for (blk = table->arena; blk; blk = next) {
+		next = blk->next;
+		xfree(blk);
+	}
+	xfree(table->slots);
+	xfree(table);
+}
+
+extern char *kvs_table_get(kvs_table_t *table, const char *key)
+{
+	kvs_slot_t *slot;
+	uint32_t mask = table->size - 1, i;
+	uint64_t hash;
+	size_t len;
+
+	if (!key)
+		return NULL;
+
+	hash = _hash(key, &len);
+	for (i = hash & mask; (slot = &table->slots[i])->key;
+	     i = (i + 1) & mask) {
+		if ((slot->hash == hash) && !xstrcmp(slot->key, key))
+			return slot->val;
+	}
+
+	return NULL;
+}
+
+extern void kvs_table_put(kvs_table_t *table, const char *key,
+			  const char *val)
+{
+	kvs_slot_t *slot;
+	uint32_t mask, i;
+	uint64_t hash;
+	size_t key_len, val_len = val ? strlen(val) : 0;
+
+	if (!key)
+		return;
+
+	if (((uint64_t) (table->count + 1) * 4) > ((uint64_t) table->size * 3))
+		_grow(table);
+	mask = table->size - 1;
+
+	hash = _hash(key, &key_len);
+	for (i = hash & mask; (slot = &table->slots[i])->key;
+	     i = (i + 1) & mask) {
+		if (table->no_dup_keys || (slot->hash != hash) ||
+		    xstrcmp(slot->key, key))
+			continue;
+		/* replace the value, in place if it fits */
+		if (val && slot->val && (val_len <= strlen(slot->val)))
+			memcpy(slot->val, val, val_len + 1);
+		else
+			slot->val = _arena_copy(table, val, val_len);
+		return;
+	}
+
+	slot->hash = hash;
+	slot->key = _arena_copy(table, key, key_len);
+	slot->val = _arena_copy(table, val, val_len);
+	table->count++;
+}
+
+extern uint32_t kvs_table_count(kvs_table_t *table)
+{
+	return table->count;
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************\
+ *  kvs_table.h - open-addressed key-value table used by the pmi2 KVS
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _KVS_TABLE_H
+#define _KVS_TABLE_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+typedef struct kvs_table kvs_table_t;
+
+/*
+ * Create an empty table sized to hold about size_hint pairs without growing.
+ * If no_dup_keys is set the caller guarantees every key is put only once and
+ * kvs_table_put() skips the search for an existing key.
+ */
+extern kvs_table_t *kvs_table_create(uint32_t size_hint, bool no_dup_keys);
+
+/* Free the table and every key and value stored in it */
+extern void kvs_table_destroy(kvs_table_t *table);
+
+/*
+ * Return the value stored for key, or NULL if not found.
+ * The returned value is owned by the table, do not free it.
+ */
+extern char *kvs_table_get(kvs_table_t *table, const char *key);
+
+/* Store a copy of key and val, replacing any value already stored for key */
+extern void kvs_table_put(kvs_table_t *table, const char *key,
+			  const char *val);
+
+/* Return the number of pairs stored in the table */
+extern uint32_t kvs_table_count(kvs_table_t *table);
+
+#endif	/* _KVS_TABLE_H */
@@ -199,14 +199,18 @@ _handle_kvs_fence_resp(int fd, Buf buf)
 
 	temp32 = remaining_buf(buf);
 	debug3("mpi/pmi2: buf length: %u", temp32);
-	/* put kvs into local hash */
+	/*
+	 * put kvs into local hash, the pairs are copied by kvs_put() so
+	 * point directly into the message rather than duplicating them
+	 */
 	while (remaining_buf(buf) > 0) {
-		safe_unpackstr_xmalloc(&key, &temp32, buf);
-		safe_unpackstr_xmalloc(&val, &temp32, buf);
+		safe_unpackmem_ptr(&key, &temp32, buf);
+		if (temp32 && key[temp32 - 1])
+			goto unpack_error;
+		safe_unpackmem_ptr(&val, &temp32, buf);
+		if (temp32 && val[temp32 - 1])
+			goto unpack_error;
 		kvs_put(key, val);
-		//temp32 = remaining_buf(buf);
-		xfree(key);
-		xfree(val);
 	}
 
 resp:
@@ -103,16 +103,24 @@ static pmix_status_t _fencenb_fn(const pmix_proc_t procs_v2[], size_t nprocs,
 {
 	PMIXP_DEBUG("called");
 	pmixp_coll_t *coll;
-	pmixp_coll_type_t type = PMIXP_COLL_TYPE_FENCE;
+	pmixp_coll_type_t type;
 	pmix_status_t status = PMIX_SUCCESS;
 	int ret;
 	size_t i;
+	bool collect = false;
 	pmixp_proc_t *procs = xmalloc(sizeof(*procs) * nprocs);
 
 	for (i = 0; i < nprocs; i++) {
 		procs[i].rank = procs_v2[i].rank;
 		strncpy(procs[i].nspace, procs_v2[i].nspace, PMIXP_MAX_NSLEN);
 	}
+	for (i = 0; i < ninfo; i++) {
+		if (!xstrcmp(info[i].key, PMIX_COLLECT_DATA)) {
+			collect = info[i].value.data.flag;
+			break;
+		}
+	}
+	type = pmixp_coll_fence_type(collect);
 	coll = pmixp_state_coll_get(type, procs, nprocs);
 	ret = pmixp_coll_contrib_local(coll, data, ndata, cbfunc, cbdata);
 	xfree(procs);
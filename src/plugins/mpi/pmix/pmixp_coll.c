@@ -78,7 +78,7 @@ err_exit:
 	return SLURM_ERROR;
 }
 
-static int _pack_coll_info(pmixp_coll_t *coll, Buf buf)
+int pmixp_coll_pack_info(pmixp_coll_t *coll, Buf buf)
 {
 	pmixp_proc_t *procs = coll->pset.procs;
 	size_t nprocs = coll->pset.nprocs;
@@ -100,6 +100,35 @@ static int _pack_coll_info(pmixp_coll_t *coll, Buf buf)
 	return SLURM_SUCCESS;
 }
 
+pmixp_coll_type_t pmixp_coll_fence_type(bool collect)
+{
+	uint32_t nodes;
+
+	switch (pmixp_info_srv_fence_alg()) {
+	case PMIXP_COLL_FENCE_RING:
+		return PMIXP_COLL_TYPE_FENCE_RING;
+	case PMIXP_COLL_FENCE_BRUCK:
+		return PMIXP_COLL_TYPE_FENCE_BRUCK;
+	case PMIXP_COLL_FENCE_AUTO:
+		/*
+		 * All nodes have to make the same choice, so it is based only
+		 * on the step size and on the PMIX_COLLECT_DATA flag which
+		 * is the same for every participant. A fence that doesn't
+		 * collect data is a barrier: the tree sends the fewest
+		 * messages and the root is not a bandwidth bottleneck.
+		 */
+		nodes = pmixp_info_nodes();
+		if (!collect || (nodes < PMIXP_COLL_P2P_MIN_NODES))
+			return PMIXP_COLL_TYPE_FENCE;
+		if (nodes <= PMIXP_COLL_RING_MAX_NODES)
+			return PMIXP_COLL_TYPE_FENCE_RING;
+		return PMIXP_COLL_TYPE_FENCE_BRUCK;
+	case PMIXP_COLL_FENCE_TREE:
+	default:
+		return PMIXP_COLL_TYPE_FENCE;
+	}
+}
+
 int pmixp_coll_unpack_info(Buf buf, pmixp_coll_type_t *type,
 			   int *nodeid, pmixp_proc_t **r, size_t *nr)
 {
@@ -176,7 +205,7 @@ static void _reset_coll_ufwd(pmixp_coll_t *coll)
 	memset(coll->contrib_chld, 0,
 	       sizeof(coll->contrib_chld[0]) * coll->chldrn_cnt);
 	coll->serv_offs = pmixp_server_buf_reset(coll->ufwd_buf);
-	if (SLURM_SUCCESS != _pack_coll_info(coll, coll->ufwd_buf)) {
+	if (SLURM_SUCCESS != pmixp_coll_pack_info(coll, coll->ufwd_buf)) {
 		PMIXP_ERROR("Cannot pack ranges to message header!");
 	}
 	coll->ufwd_offset = get_buf_offset(coll->ufwd_buf);
@@ -187,7 +216,7 @@ static void _reset_coll_dfwd(pmixp_coll_t *coll)
 {
 	/* downwards status */
 	(void)pmixp_server_buf_reset(coll->dfwd_buf);
-	if (SLURM_SUCCESS != _pack_coll_info(coll, coll->dfwd_buf)) {
+	if (SLURM_SUCCESS != pmixp_coll_pack_info(coll, coll->dfwd_buf)) {
 		PMIXP_ERROR("Cannot pack ranges to message header!");
 	}
 	coll->dfwd_cb_cnt = 0;
@@ -279,6 +308,19 @@ int pmixp_coll_init(pmixp_coll_t *coll, const pmixp_proc_t *procs,
 	width = slurm_get_tree_width();
 	coll->peers_cnt = hostlist_count(hl);
 	coll->my_peerid = hostlist_find(hl, pmixp_info_hostname());
+
+	if (pmixp_coll_is_p2p(coll)) {
+		/* ring and Bruck don't need the tree topology */
+		coll->seq = 0;
+		if (SLURM_SUCCESS != pmixp_coll_p2p_init(coll, hl)) {
+			hostlist_destroy(hl);
+			goto err_exit;
+		}
+		hostlist_destroy(hl);
+		slurm_mutex_init(&coll->lock);
+		return SLURM_SUCCESS;
+	}
+
 	reverse_tree_info(coll->my_peerid, coll->peers_cnt, width,
 			  &coll->prnt_peerid, &coll->chldrn_cnt, &depth,
 			  &max_depth);
@@ -361,6 +403,9 @@ err_exit:
 
 void pmixp_coll_free(pmixp_coll_t *coll)
 {
+	if (pmixp_coll_is_p2p(coll)) {
+		pmixp_coll_p2p_free(coll);
+	}
 	if (NULL != coll->pset.procs) {
 		xfree(coll->pset.procs);
 	}
@@ -384,12 +429,6 @@ void pmixp_coll_free(pmixp_coll_t *coll)
 	free_buf(coll->dfwd_buf);
 }
 
-typedef struct {
-	pmixp_coll_t *coll;
-	uint32_t seq;
-	volatile uint32_t refcntr;
-} pmixp_coll_cbdata_t;
-
 /*
  * use it for internal collective
  * performance evaluation tool.
@@ -937,6 +976,11 @@ int pmixp_coll_contrib_local(pmixp_coll_t *coll, char *data, size_t size,
 	/* sanity check */
 	pmixp_coll_sanity_check(coll);
 
+	if (pmixp_coll_is_p2p(coll)) {
+		return pmixp_coll_p2p_contrib_local(coll, data, size,
+						    cbfunc, cbdata);
+	}
+
 	/* lock the structure */
 	slurm_mutex_lock(&coll->lock);
 
@@ -1340,6 +1384,11 @@ proceed:
 
 void pmixp_coll_reset_if_to(pmixp_coll_t *coll, time_t ts)
 {
+	if (pmixp_coll_is_p2p(coll)) {
+		pmixp_coll_p2p_reset_if_to(coll, ts);
+		return;
+	}
+
 	/* lock the */
 	slurm_mutex_lock(&coll->lock);
 
@@ -99,15 +99,71 @@ pmixp_coll_sndstatus2str(pmixp_coll_sndstate_t state)
 typedef enum {
 	PMIXP_COLL_TYPE_FENCE,
 	PMIXP_COLL_TYPE_CONNECT,
-	PMIXP_COLL_TYPE_DISCONNECT
+	PMIXP_COLL_TYPE_DISCONNECT,
+	PMIXP_COLL_TYPE_FENCE_RING,
+	PMIXP_COLL_TYPE_FENCE_BRUCK
 } pmixp_coll_type_t;
 
+/*
+ * PMIXP_COLL_FENCE_AUTO thresholds: fences that collect data on at least
+ * PMIXP_COLL_P2P_MIN_NODES nodes use a ring up to PMIXP_COLL_RING_MAX_NODES
+ * nodes (bandwidth optimal, N-1 steps) and Bruck above it (log2(N) steps)
+ */
+#define PMIXP_COLL_P2P_MIN_NODES 4
+#define PMIXP_COLL_RING_MAX_NODES 32
+
 typedef enum {
 	PMIXP_COLL_REQ_PROGRESS,
 	PMIXP_COLL_REQ_SKIP,
 	PMIXP_COLL_REQ_FAILURE
 } pmixp_coll_req_state_t;
 
+/*
+ * Peer-to-peer collectives (ring and Bruck) keep no tree state: every
+ * node talks to a fixed set of peers. A context tracks one instance of the
+ * collective, and since a peer may start collective (seq + 1) before we
+ * have finished collective (seq), two contexts are kept, indexed by seq.
+ */
+#define PMIXP_COLL_P2P_CTX_NUM 2
+
+typedef struct {
+	bool in_use;
+	bool failed;
+	uint32_t seq;
+	time_t ts;
+
+	bool contrib_local;
+	/* libpmix callback data */
+	void *cbfunc;
+	void *cbdata;
+
+	/* contributions collected so far, stored back to back */
+	Buf data;
+	uint32_t blk_cnt;
+	/* Bruck: end offset of each contribution in data */
+	uint32_t *blk_end;
+
+	/* ring: contributions received, indexed by hop count */
+	bool *hop_recv;
+
+	/* Bruck: steps completed and messages that arrived early */
+	uint32_t step;
+	bool step_sent;
+	Buf *stash;
+} pmixp_coll_p2p_ctx_t;
+
+typedef struct {
+	/*
+	 * Global node ids of the peers. Ring: [0] is the right neighbor we
+	 * send to and the left neighbor we receive from. Bruck: the peers
+	 * we send to and receive from at every step.
+	 */
+	int *send_ids;
+	int *recv_ids;
+	uint32_t nsteps;
+	pmixp_coll_p2p_ctx_t ctx[PMIXP_COLL_P2P_CTX_NUM];
+} pmixp_coll_p2p_t;
+
 typedef struct {
 #ifndef NDEBUG
 #define PMIXP_COLL_STATE_MAGIC 0xC011CAFE
@@ -162,8 +218,26 @@ typedef struct {
 
 	/* timestamp for stale collectives detection */
 	time_t ts, ts_next;
+
+	/* ring and Bruck algorithms state */
+	pmixp_coll_p2p_t p2p;
 } pmixp_coll_t;
 
+/* Callback data of the sends and of the libpmix release callback */
+typedef struct {
+	pmixp_coll_t *coll;
+	uint32_t seq;
+	volatile uint32_t refcntr;
+	/* buffer to be released along with the callback data */
+	Buf buf;
+} pmixp_coll_cbdata_t;
+
+static inline bool pmixp_coll_is_p2p(pmixp_coll_t *coll)
+{
+	return ((PMIXP_COLL_TYPE_FENCE_RING == coll->type) ||
+		(PMIXP_COLL_TYPE_FENCE_BRUCK == coll->type));
+}
+
 static inline void pmixp_coll_sanity_check(pmixp_coll_t *coll)
 {
 	xassert(NULL != coll);
@@ -174,6 +248,10 @@ int pmixp_coll_init(pmixp_coll_t *coll, const pmixp_proc_t *procs,
 		    size_t nprocs, pmixp_coll_type_t type);
 void pmixp_coll_free(pmixp_coll_t *coll);
 
+/* Type of collective to use for a fence, collect is PMIX_COLLECT_DATA */
+pmixp_coll_type_t pmixp_coll_fence_type(bool collect);
+int pmixp_coll_pack_info(pmixp_coll_t *coll, Buf buf);
+
 pmixp_coll_t *pmixp_coll_from_cbdata(void *cbdata);
 
 /*
@@ -261,4 +339,13 @@ int pmixp_coll_belong_chk(pmixp_coll_type_t type,
 			  const pmixp_proc_t *procs, size_t nprocs);
 void pmixp_coll_reset_if_to(pmixp_coll_t *coll, time_t ts);
 
+/* Ring and Bruck collectives, see pmixp_coll_p2p.c */
+int pmixp_coll_p2p_init(pmixp_coll_t *coll, hostlist_t hl);
+void pmixp_coll_p2p_free(pmixp_coll_t *coll);
+int pmixp_coll_p2p_contrib_local(pmixp_coll_t *coll, char *data,
+				 size_t size, void *cbfunc, void *cbdata);
+int pmixp_coll_p2p_contrib_peer(pmixp_coll_t *coll, uint32_t peerid,
+				uint32_t seq, Buf buf);
+void pmixp_coll_p2p_reset_if_to(pmixp_coll_t *coll, time_t ts);
+
 #endif /* PMIXP_COLL_H */
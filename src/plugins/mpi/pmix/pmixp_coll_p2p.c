@@ -0,0 +1,607 @@
+/*****************************************************************************\
+ *  pmixp_coll_p2p.c - PMIx ring and Bruck collectives
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+ \*****************************************************************************/
+
+#include "pmixp_common.h"
+#include "src/common/slurm_protocol_api.h"
+#include "pmixp_coll.h"
+#include "pmixp_nspaces.h"
+#include "pmixp_server.h"
+#include "pmixp_client.h"
+
+/*
+ * Both algorithms gather the same thing as the tree: the concatenation of
+ * the local contributions of all peers, delivered to libpmix on each node.
+ * Instead of funnelling all of the data through the root, every node only
+ * exchanges messages with a fixed set of peers:
+ *
+ * Ring: each node sends its contribution to its right neighbor, and every
+ * contribution received from the left neighbor is forwarded to the right
+ * until it has visited all N nodes. Forwarding doesn't depend on the local
+ * contribution so the ring is naturally pipelined, every link carries
+ * (N - 1) contributions and the collective takes N - 1 steps.
+ *
+ * Bruck: at step s (s = 0 .. ceil(log2(N)) - 1) node i sends the first
+ * min(2^s, N - 2^s) contributions it holds to node (i - 2^s) and receives
+ * as many from node (i + 2^s). Contributions are kept in the order of their
+ * origin (i, i + 1, ...) so the prefix to send is contiguous. The
+ * collective takes ceil(log2(N)) steps.
+ *
+ * Ring messages carry the hop count of the contribution, Bruck messages
+ * carry the step number, the number of contributions and their sizes.
+ */
+
+static void _progress(pmixp_coll_t *coll);
+
+static inline pmixp_coll_p2p_ctx_t *_ctx_by_seq(pmixp_coll_t *coll,
+						uint32_t seq)
+{
+	return &coll->p2p.ctx[seq % PMIXP_COLL_P2P_CTX_NUM];
+}
+
+static inline char *_type2str(pmixp_coll_t *coll)
+{
+	return (PMIXP_COLL_TYPE_FENCE_RING == coll->type) ? "ring" : "bruck";
+}
+
+static int _peer_hostid(hostlist_t hl, int peerid)
+{
+	char *p = hostlist_nth(hl, peerid);
+	int hostid = pmixp_info_job_hostid(p);
+
+	free(p);
+	return hostid;
+}
+
+int pmixp_coll_p2p_init(pmixp_coll_t *coll, hostlist_t hl)
+{
+	pmixp_coll_p2p_t *p2p = &coll->p2p;
+	int i, npeers = coll->peers_cnt, me = coll->my_peerid;
+
+	if (0 > me) {
+		PMIXP_ERROR("%p: this node is not in the collective", coll);
+		return SLURM_ERROR;
+	}
+
+	if (PMIXP_COLL_TYPE_FENCE_RING == coll->type) {
+		p2p->nsteps = npeers - 1;
+		p2p->send_ids = xmalloc(sizeof(int));
+		p2p->recv_ids = xmalloc(sizeof(int));
+		p2p->send_ids[0] = _peer_hostid(hl, (me + 1) % npeers);
+		p2p->recv_ids[0] = _peer_hostid(hl, (me + npeers - 1) % npeers);
+	} else {
+		p2p->nsteps = 0;
+		while ((1 << p2p->nsteps) < npeers)
+			p2p->nsteps++;
+		p2p->send_ids = xmalloc(sizeof(int) * (p2p->nsteps + 1));
+		p2p->recv_ids = xmalloc(sizeof(int) * (p2p->nsteps + 1));
+		for (i = 0; i < p2p->nsteps; i++) {
+			int dist = 1 << i;
+			p2p->send_ids[i] =
+				_peer_hostid(hl, (me + npeers - dist) % npeers);
+			p2p->recv_ids[i] = _peer_hostid(hl, (me + dist) % npeers);
+		}
+	}
+
+	for (i = 0; i < PMIXP_COLL_P2P_CTX_NUM; i++) {
+		pmixp_coll_p2p_ctx_t *ctx = &p2p->ctx[i];
+		if (PMIXP_COLL_TYPE_FENCE_RING == coll->type) {
+			ctx->hop_recv = xmalloc(sizeof(bool) * npeers);
+		} else {
+			ctx->blk_end = xmalloc(sizeof(uint32_t) * npeers);
+			ctx->stash = xmalloc(sizeof(Buf) * (p2p->nsteps + 1));
+		}
+	}
+
+#ifdef PMIXP_COLL_DEBUG
+	PMIXP_DEBUG("%p: %s collective, peers=%d, me=%d, steps=%u",
+		    coll, _type2str(coll), npeers, me, p2p->nsteps);
+#endif
+	return SLURM_SUCCESS;
+}
+
+static void _ctx_reset(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx)
+{
+	int i;
+
+	ctx->in_use = false;
+	ctx->failed = false;
+	ctx->contrib_local = false;
+	ctx->cbfunc = NULL;
+	ctx->cbdata = NULL;
+	if (ctx->data)
+		set_buf_offset(ctx->data, 0);
+	ctx->blk_cnt = 0;
+	ctx->step = 0;
+	ctx->step_sent = false;
+	if (ctx->hop_recv)
+		memset(ctx->hop_recv, 0, sizeof(bool) * coll->peers_cnt);
+	if (ctx->stash) {
+		for (i = 0; i < coll->p2p.nsteps; i++) {
+			free_buf(ctx->stash[i]);
+			ctx->stash[i] = NULL;
+		}
+	}
+}
+
+void pmixp_coll_p2p_free(pmixp_coll_t *coll)
+{
+	pmixp_coll_p2p_t *p2p = &coll->p2p;
+	int i;
+
+	for (i = 0; i < PMIXP_COLL_P2P_CTX_NUM; i++) {
+		pmixp_coll_p2p_ctx_t *ctx = &p2p->ctx[i];
+		_ctx_reset(coll, ctx);
+		free_buf(ctx->data);
+		xfree(ctx->hop_recv);
+		xfree(ctx->blk_end);
+		xfree(ctx->stash);
+	}
+	xfree(p2p->send_ids);
+	xfree(p2p->recv_ids);
+}
+
+/*
+ * Return the context of collective seq, starting it if needed.
+ * Only the current and the next collective may be in progress.
+ */
+static pmixp_coll_p2p_ctx_t *_ctx_get(pmixp_coll_t *coll, uint32_t seq)
+{
+	pmixp_coll_p2p_ctx_t *ctx = _ctx_by_seq(coll, seq);
+
+	if ((seq != coll->seq) && (seq != (coll->seq + 1)))
+		return NULL;
+	if (!ctx->in_use) {
+		ctx->in_use = true;
+		ctx->seq = seq;
+		ctx->ts = time(NULL);
+		if (!ctx->data)
+			ctx->data = init_buf(BUF_SIZE);
+	} else if (ctx->seq != seq) {
+		return NULL;
+	}
+	return ctx;
+}
+
+static void _ctx_append(pmixp_coll_p2p_ctx_t *ctx, char *data, uint32_t size)
+{
+	uint32_t offset = get_buf_offset(ctx->data);
+
+	pmixp_server_buf_reserve(ctx->data, size);
+	memcpy(get_buf_data(ctx->data) + offset, data, size);
+	set_buf_offset(ctx->data, offset + size);
+	if (ctx->blk_end)
+		ctx->blk_end[ctx->blk_cnt] = offset + size;
+	ctx->blk_cnt++;
+}
+
+static void _sent_cb(int rc, pmixp_p2p_ctx_t p2p_ctx, void *_vcbdata)
+{
+	pmixp_coll_cbdata_t *cbdata = (pmixp_coll_cbdata_t *)_vcbdata;
+	pmixp_coll_t *coll = cbdata->coll;
+	pmixp_coll_p2p_ctx_t *ctx;
+
+	if (PMIXP_P2P_REGULAR == p2p_ctx) {
+		/* lock the collective */
+		slurm_mutex_lock(&coll->lock);
+	}
+
+	ctx = _ctx_by_seq(coll, cbdata->seq);
+	if (SLURM_SUCCESS != rc) {
+		PMIXP_ERROR("%p: %s send failed, seq=%u",
+			    coll, _type2str(coll), cbdata->seq);
+		if (ctx->in_use && (ctx->seq == cbdata->seq))
+			ctx->failed = true;
+	}
+	free_buf(cbdata->buf);
+	xfree(cbdata);
+
+	if (PMIXP_P2P_REGULAR == p2p_ctx) {
+		/* report the failure, in the inline case the caller will */
+		_progress(coll);
+		/* unlock the collective */
+		slurm_mutex_unlock(&coll->lock);
+	}
+}
+
+static int _send(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx, int nodeid,
+		 Buf buf)
+{
+	pmixp_coll_cbdata_t *cbdata;
+	pmixp_ep_t ep = {0};
+	int rc;
+
+	ep.type = PMIXP_EP_NOIDEID;
+	ep.ep.nodeid = nodeid;
+
+	cbdata = xmalloc(sizeof(pmixp_coll_cbdata_t));
+	cbdata->coll = coll;
+	cbdata->seq = ctx->seq;
+	cbdata->refcntr = 1;
+	cbdata->buf = buf;
+
+	rc = pmixp_server_send_nb(&ep, PMIXP_MSG_COLL_P2P, ctx->seq, buf,
+				  _sent_cb, cbdata);
+	if (SLURM_SUCCESS != rc) {
+		char *nodename = pmixp_info_job_host(nodeid);
+		PMIXP_ERROR("%p: cannot send data (size = %u) to %s:%d",
+			    coll, get_buf_offset(buf), nodename, nodeid);
+		xfree(nodename);
+		ctx->failed = true;
+	}
+	return rc;
+}
+
+static Buf _msg_new(pmixp_coll_t *coll)
+{
+	Buf buf = pmixp_server_buf_new();
+
+	if (SLURM_SUCCESS != pmixp_coll_pack_info(coll, buf)) {
+		PMIXP_ERROR("Cannot pack ranges to message header!");
+	}
+	return buf;
+}
+
+static void _ring_send(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx,
+		       uint32_t hop, char *data, uint32_t size)
+{
+	Buf buf = _msg_new(coll);
+
+	pack32(hop, buf);
+	pmixp_server_buf_reserve(buf, size);
+	memcpy(get_buf_data(buf) + get_buf_offset(buf), data, size);
+	set_buf_offset(buf, get_buf_offset(buf) + size);
+	_send(coll, ctx, coll->p2p.send_ids[0], buf);
+}
+
+/* Run the Bruck steps for which the incoming message is available */
+static void _bruck_progress(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx)
+{
+	pmixp_coll_p2p_t *p2p = &coll->p2p;
+	uint32_t dist, cnt, i, size, offset;
+	char *data;
+	Buf buf;
+
+	while (ctx->contrib_local && !ctx->failed &&
+	       (ctx->step < p2p->nsteps)) {
+		dist = 1 << ctx->step;
+		cnt = MIN(dist, coll->peers_cnt - dist);
+		if (!ctx->step_sent) {
+			/* send the first cnt contributions we have */
+			buf = _msg_new(coll);
+			pack32(ctx->step, buf);
+			pack32(cnt, buf);
+			for (i = 0, offset = 0; i < cnt; i++) {
+				pack32(ctx->blk_end[i] - offset, buf);
+				offset = ctx->blk_end[i];
+			}
+			pmixp_server_buf_reserve(buf, offset);
+			memcpy(get_buf_data(buf) + get_buf_offset(buf),
+			       get_buf_data(ctx->data), offset);
+			set_buf_offset(buf, get_buf_offset(buf) + offset);
+			ctx->step_sent = true;
+			_send(coll, ctx, p2p->send_ids[ctx->step], buf);
+			continue;
+		}
+
+		if (!(buf = ctx->stash[ctx->step])) {
+			/* wait for the peer */
+			break;
+		}
+		/* the stash was validated on receive: sizes, then data */
+		set_buf_offset(buf, 0);
+		data = get_buf_data(buf) + cnt * sizeof(uint32_t);
+		for (i = 0; i < cnt; i++) {
+			unpack32(&size, buf);
+			_ctx_append(ctx, data, size);
+			data += size;
+		}
+		free_buf(buf);
+		ctx->stash[ctx->step] = NULL;
+		ctx->step++;
+		ctx->step_sent = false;
+	}
+}
+
+static void _libpmix_cb(void *_vcbdata)
+{
+	pmixp_coll_cbdata_t *cbdata = (pmixp_coll_cbdata_t *)_vcbdata;
+
+	/* the collective itself was already reset */
+	free_buf(cbdata->buf);
+	xfree(cbdata);
+}
+
+static void _progress(pmixp_coll_t *coll)
+{
+	pmixp_coll_p2p_ctx_t *ctx;
+	pmixp_coll_cbdata_t *cbdata;
+	char *data;
+	size_t size;
+
+	while (1) {
+		ctx = _ctx_by_seq(coll, coll->seq);
+		if (!ctx->in_use || (ctx->seq != coll->seq))
+			break;
+
+		if ((PMIXP_COLL_TYPE_FENCE_BRUCK == coll->type) &&
+		    !ctx->failed) {
+			_bruck_progress(coll, ctx);
+		}
+
+		if (ctx->failed) {
+			/* report the error once libpmix is waiting for it */
+			if (!ctx->contrib_local)
+				break;
+			PMIXP_ERROR("%p: failed to send, abort collective",
+				    coll);
+			if (ctx->cbfunc) {
+				pmixp_lib_modex_invoke(ctx->cbfunc, SLURM_ERROR,
+						       NULL, 0, ctx->cbdata,
+						       NULL, NULL);
+			}
+			_ctx_reset(coll, ctx);
+			coll->seq++;
+			continue;
+		}
+
+		if (!ctx->contrib_local || (ctx->blk_cnt != coll->peers_cnt))
+			break;
+
+#ifdef PMIXP_COLL_DEBUG
+		PMIXP_DEBUG("%p: %s collective seq=%u is DONE, size=%u",
+			    coll, _type2str(coll), ctx->seq,
+			    get_buf_offset(ctx->data));
+#endif
+		/* hand the data over to libpmix, it will be released in
+		 * the callback so the context can be reused right away */
+		cbdata = xmalloc(sizeof(pmixp_coll_cbdata_t));
+		cbdata->coll = coll;
+		cbdata->seq = ctx->seq;
+		cbdata->refcntr = 1;
+		cbdata->buf = ctx->data;
+		ctx->data = NULL;
+		if (ctx->cbfunc) {
+			data = get_buf_data(cbdata->buf);
+			size = get_buf_offset(cbdata->buf);
+			pmixp_lib_modex_invoke(ctx->cbfunc, SLURM_SUCCESS,
+					       data, size, ctx->cbdata,
+					       _libpmix_cb, (void *)cbdata);
+		} else {
+			_libpmix_cb(cbdata);
+		}
+		_ctx_reset(coll, ctx);
+		coll->seq++;
+	}
+}
+
+int pmixp_coll_p2p_contrib_local(pmixp_coll_t *coll, char *data,
+				 size_t size, void *cbfunc, void *cbdata)
+{
+	pmixp_coll_p2p_ctx_t *ctx;
+	int ret = SLURM_SUCCESS;
+
+	/* lock the structure */
+	slurm_mutex_lock(&coll->lock);
+
+#ifdef PMIXP_COLL_DEBUG
+	PMIXP_DEBUG("%p: %s contrib/loc: seqnum=%u, size=%zd",
+		    coll, _type2str(coll), coll->seq, size);
+#endif
+
+	ctx = _ctx_get(coll, coll->seq);
+	if (!ctx || ctx->contrib_local) {
+		/* the previous collective is not finished yet */
+		PMIXP_DEBUG("%p: contrib/loc: before prev coll is finished!",
+			    coll);
+		ret = SLURM_ERROR;
+		goto exit;
+	}
+
+	ctx->contrib_local = true;
+	ctx->cbfunc = cbfunc;
+	ctx->cbdata = cbdata;
+
+	if (PMIXP_COLL_TYPE_FENCE_BRUCK == coll->type) {
+		/* our own contribution has to come first */
+		xassert(0 == ctx->blk_cnt);
+		_ctx_append(ctx, data, size);
+	} else {
+		_ctx_append(ctx, data, size);
+		if (1 < coll->peers_cnt)
+			_ring_send(coll, ctx, 0, data, size);
+	}
+
+	_progress(coll);
+
+exit:
+	/* unlock the structure */
+	slurm_mutex_unlock(&coll->lock);
+	return ret;
+}
+
+static int _ring_contrib(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx,
+			 uint32_t peerid, Buf buf)
+{
+	uint32_t hop, size;
+	char *data;
+
+	if (SLURM_SUCCESS != unpack32(&hop, buf)) {
+		PMIXP_ERROR("%p: cannot unpack ring message", coll);
+		return SLURM_ERROR;
+	}
+	if (hop >= (coll->peers_cnt - 1)) {
+		PMIXP_ERROR("%p: bad ring hop %u from nodeid=%u",
+			    coll, hop, peerid);
+		return SLURM_ERROR;
+	}
+	if (ctx->hop_recv[hop]) {
+		/* retransmission after a false negative, skip */
+		PMIXP_DEBUG("%p: multiple ring contribs, hop=%u, seq=%u",
+			    coll, hop, ctx->seq);
+		return SLURM_SUCCESS;
+	}
+	ctx->hop_recv[hop] = true;
+
+	data = get_buf_data(buf) + get_buf_offset(buf);
+	size = remaining_buf(buf);
+	/* pass it on unless the right neighbor is its origin */
+	if ((hop + 1) < (coll->peers_cnt - 1))
+		_ring_send(coll, ctx, hop + 1, data, size);
+	_ctx_append(ctx, data, size);
+
+	return SLURM_SUCCESS;
+}
+
+static int _bruck_contrib(pmixp_coll_t *coll, pmixp_coll_p2p_ctx_t *ctx,
+			  uint32_t peerid, Buf buf)
+{
+	uint32_t step, cnt, i, size, total = 0;
+	char *data;
+
+	if ((SLURM_SUCCESS != unpack32(&step, buf)) ||
+	    (SLURM_SUCCESS != unpack32(&cnt, buf))) {
+		PMIXP_ERROR("%p: cannot unpack bruck message", coll);
+		return SLURM_ERROR;
+	}
+	if ((step >= coll->p2p.nsteps) ||
+	    (peerid != coll->p2p.recv_ids[step]) ||
+	    (cnt != MIN(1 << step, coll->peers_cnt - (1 << step)))) {
+		PMIXP_ERROR("%p: bad bruck message from nodeid=%u, step=%u, "
+			    "cnt=%u", coll, peerid, step, cnt);
+		return SLURM_ERROR;
+	}
+	if ((step < ctx->step) || ctx->stash[step]) {
+		/* retransmission after a false negative, skip */
+		PMIXP_DEBUG("%p: multiple bruck contribs, step=%u, seq=%u",
+			    coll, step, ctx->seq);
+		return SLURM_SUCCESS;
+	}
+	for (i = 0; i < cnt; i++) {
+		if (SLURM_SUCCESS != unpack32(&size, buf)) {
+			PMIXP_ERROR("%p: cannot unpack bruck message", coll);
+			return SLURM_ERROR;
+		}
+		total += size;
+	}
+	if (total != remaining_buf(buf)) {
+		PMIXP_ERROR("%p: bad bruck message size %u, expect %u",
+			    coll, remaining_buf(buf), total);
+		return SLURM_ERROR;
+	}
+
+	/* keep the sizes and the data until the step is reached */
+	size = remaining_buf(buf) + (cnt * sizeof(uint32_t));
+	data = get_buf_data(buf) + get_buf_offset(buf) -
+		(cnt * sizeof(uint32_t));
+	ctx->stash[step] = create_buf(xmalloc(size), size);
+	memcpy(get_buf_data(ctx->stash[step]), data, size);
+
+	return SLURM_SUCCESS;
+}
+
+int pmixp_coll_p2p_contrib_peer(pmixp_coll_t *coll, uint32_t peerid,
+				uint32_t seq, Buf buf)
+{
+	pmixp_coll_p2p_ctx_t *ctx;
+	int rc;
+
+	/* lock the structure */
+	slurm_mutex_lock(&coll->lock);
+	pmixp_coll_sanity_check(coll);
+
+#ifdef PMIXP_COLL_DEBUG
+	PMIXP_DEBUG("%p: %s contrib/rem from nodeid=%u: seq=%u, "
+		    "coll->seq=%u, size=%u",
+		    coll, _type2str(coll), peerid, seq, coll->seq,
+		    remaining_buf(buf));
+#endif
+
+	if (!(ctx = _ctx_get(coll, seq))) {
+		PMIXP_ERROR("%p: unexpected %s contrib from nodeid=%u: "
+			    "seq=%u, coll->seq=%u",
+			    coll, _type2str(coll), peerid, seq, coll->seq);
+		rc = SLURM_ERROR;
+		goto exit;
+	}
+
+	if (PMIXP_COLL_TYPE_FENCE_RING == coll->type) {
+		if (peerid != coll->p2p.recv_ids[0]) {
+			PMIXP_ERROR("%p: ring contrib from bad nodeid=%u, "
+				    "expect=%d",
+				    coll, peerid, coll->p2p.recv_ids[0]);
+			rc = SLURM_ERROR;
+			goto exit;
+		}
+		rc = _ring_contrib(coll, ctx, peerid, buf);
+	} else {
+		rc = _bruck_contrib(coll, ctx, peerid, buf);
+	}
+	_progress(coll);
+
+exit:
+	/* unlock the structure */
+	slurm_mutex_unlock(&coll->lock);
+	return rc;
+}
+
+void pmixp_coll_p2p_reset_if_to(pmixp_coll_t *coll, time_t ts)
+{
+	pmixp_coll_p2p_ctx_t *ctx;
+
+	/* lock the structure */
+	slurm_mutex_lock(&coll->lock);
+
+	ctx = _ctx_by_seq(coll, coll->seq);
+	if (!ctx->in_use || (ctx->seq != coll->seq))
+		goto unlock;
+
+	if (ts - ctx->ts > pmixp_info_timeout()) {
+		/* respond to the libpmix */
+		if (ctx->contrib_local && ctx->cbfunc) {
+			pmixp_lib_modex_invoke(ctx->cbfunc, PMIXP_ERR_TIMEOUT,
+					       NULL, 0, ctx->cbdata,
+					       NULL, NULL);
+		}
+		/* drop the collective */
+		_ctx_reset(coll, ctx);
+		coll->seq++;
+		/* report the timeout event */
+		PMIXP_ERROR("%p: %s collective timeout, seq=%u",
+			    coll, _type2str(coll), ctx->seq);
+	}
+unlock:
+	/* unlock the structure */
+	slurm_mutex_unlock(&coll->lock);
+}
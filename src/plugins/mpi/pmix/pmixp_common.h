@@ -101,6 +101,8 @@
  * part of libPMIx */
 #define PMIXP_DEBUG_LIB "SLURM_PMIX_SRV_DEBUG"
 #define PMIXP_DIRECT_CONN_EARLY "SLURM_PMIX_DIRECT_CONN_EARLY"
+/* Fence algorithm: "tree" (default), "ring", "bruck" or "auto" */
+#define PMIXP_COLL_FENCE "SLURM_PMIX_FENCE"
 
 /* ----------------------------------------------------------
  * This is libPMIx variable that we need to control it
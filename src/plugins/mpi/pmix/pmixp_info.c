@@ -46,6 +46,7 @@ static int _srv_usock_fd = -1;
 static bool _srv_use_direct_conn = true;
 static bool _srv_use_direct_conn_early = false;
 static bool _srv_same_arch = true;
+static pmixp_coll_fence_alg_t _srv_fence_alg = PMIXP_COLL_FENCE_TREE;
 #ifdef HAVE_UCX
 static bool _srv_use_direct_conn_ucx = true;
 #else
@@ -95,6 +96,10 @@ bool pmixp_info_srv_direct_conn_ucx(void){
 	return _srv_use_direct_conn_ucx && _srv_use_direct_conn;
 }
 
+pmixp_coll_fence_alg_t pmixp_info_srv_fence_alg(void){
+	return _srv_fence_alg;
+}
+
 /* Job information */
 int pmixp_info_set(const stepd_step_rec_t *job, char ***env)
 {
@@ -445,6 +450,23 @@ static int _env_set(char ***env)
 		}
 	}
 
+	/*------------- Fence algorithm ----------*/
+	p = getenvp(*env, PMIXP_COLL_FENCE);
+	if (p) {
+		if (!xstrcasecmp("tree", p)) {
+			_srv_fence_alg = PMIXP_COLL_FENCE_TREE;
+		} else if (!xstrcasecmp("ring", p)) {
+			_srv_fence_alg = PMIXP_COLL_FENCE_RING;
+		} else if (!xstrcasecmp("bruck", p)) {
+			_srv_fence_alg = PMIXP_COLL_FENCE_BRUCK;
+		} else if (!xstrcasecmp("auto", p)) {
+			_srv_fence_alg = PMIXP_COLL_FENCE_AUTO;
+		} else {
+			PMIXP_ERROR("Unknown %s value \"%s\", using \"tree\"",
+				    PMIXP_COLL_FENCE, p);
+		}
+	}
+
 #ifdef HAVE_UCX
 	p = getenvp(*env, PMIXP_DIRECT_CONN_UCX);
 	if (p) {
@@ -86,6 +86,16 @@ bool pmixp_info_srv_direct_conn(void);
 bool pmixp_info_srv_direct_conn_early(void);
 bool pmixp_info_srv_direct_conn_ucx(void);
 
+/* Fence algorithms that can be requested through PMIXP_COLL_FENCE */
+typedef enum {
+	PMIXP_COLL_FENCE_TREE,
+	PMIXP_COLL_FENCE_RING,
+	PMIXP_COLL_FENCE_BRUCK,
+	PMIXP_COLL_FENCE_AUTO
+} pmixp_coll_fence_alg_t;
+
+pmixp_coll_fence_alg_t pmixp_info_srv_fence_alg(void);
+
 
 static inline int pmixp_info_timeout(void)
 {
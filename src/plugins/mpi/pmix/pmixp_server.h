@@ -46,6 +46,7 @@ typedef enum {
 	PMIXP_MSG_FAN_OUT,
 	PMIXP_MSG_DMDX,
 	PMIXP_MSG_INIT_DIRECT,
+	PMIXP_MSG_COLL_P2P,
 #ifndef NDEBUG
 	PMIXP_MSG_PINGPONG
 #endif
@@ -77,6 +77,11 @@
 #define CHECK_FOR_PREEMPTOR_OVERALLOC 1
 #define CHECK_FOR_ACCOUNT_UNDERALLOC  1
 
+typedef struct {
+	struct job_record *preemptor;
+	List list;
+} _candidates_t;
+
 const char  plugin_name[]   = "Preempt by Job Priority and Runtime";
 const char  plugin_type[]   = "preempt/job_prio";
 const uint32_t  plugin_version  = SLURM_VERSION_NUMBER;
@@ -726,11 +731,36 @@ extern void fini(void)
 	/* Empty. */
 }
 
+/* Append a running job to the candidate list if the preemptor can preempt
+ * it, called by running_job_foreach() */
+static void _add_candidate(struct job_record *preemptee_job_ptr, void *arg)
+{
+	_candidates_t *cand = (_candidates_t *) arg;
+	struct job_record *preemptor_job_ptr = cand->preemptor;
+
+	if (!_job_prio_preemptable(preemptor_job_ptr, preemptee_job_ptr))
+		return;
+
+	if (preemptor_job_ptr->details &&
+	    (preemptor_job_ptr->details->expanding_jobid ==
+	     preemptee_job_ptr->job_id))
+		return;
+
+	if (CHECK_FOR_PREEMPTOR_OVERALLOC &&
+	    !_account_preemptable(preemptor_job_ptr, preemptee_job_ptr))
+		return;
+
+	/* This job is a valid preemption candidate and should be added
+	 * to the list. Create the list as needed. */
+	if (cand->list == NULL)
+		cand->list = list_create(NULL);
+	list_append(cand->list, preemptee_job_ptr);
+}
+
 extern List find_preemptable_jobs(struct job_record *job_ptr)
 {
-	ListIterator preemptee_candidate_iterator;
-	struct job_record *preemptee_job_ptr;
 	struct job_record *preemptor_job_ptr = job_ptr;
+	_candidates_t cand = { job_ptr, NULL };
 	List preemptee_job_list = NULL;
 	uint32_t preemptor_grace_time, remaining_time;
 	time_t now = time(NULL), wait_time;
@@ -784,38 +814,11 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		     plugin_type, preemptor_job_ptr->job_id);
 	}
 
-	/* Build an array of pointers to preemption candidates */
-	preemptee_candidate_iterator = list_iterator_create(job_list);
-	while ((preemptee_job_ptr = (struct job_record *)
-				    list_next(preemptee_candidate_iterator))) {
-		if (!IS_JOB_RUNNING(preemptee_job_ptr) &&
-		    !IS_JOB_SUSPENDED(preemptee_job_ptr))
-			continue;
-
-		if (!_job_prio_preemptable(preemptor_job_ptr,preemptee_job_ptr))
-			continue;
-
-		if ((preemptee_job_ptr->node_bitmap == NULL) ||
-		   (bit_overlap(preemptee_job_ptr->node_bitmap,
-				preemptor_job_ptr->part_ptr->node_bitmap) == 0))
-			continue;
-
-		if (preemptor_job_ptr->details &&
-		    (preemptor_job_ptr->details->expanding_jobid ==
-		     preemptee_job_ptr->job_id))
-			continue;
-
-		if (CHECK_FOR_PREEMPTOR_OVERALLOC &&
-		    !_account_preemptable(preemptor_job_ptr, preemptee_job_ptr))
-			continue;
-
-		/* This job is a valid preemption candidate and should be added
-		 * to the list. Create the list as needed. */
-		if (preemptee_job_list == NULL)
-			preemptee_job_list = list_create(NULL);
-		list_append(preemptee_job_list, preemptee_job_ptr);
-	}
-	list_iterator_destroy(preemptee_candidate_iterator);
+	/* Build a list of pointers to preemption candidates, only jobs
+	 * on nodes of the preemptor's partition are visited */
+	running_job_foreach(NULL, preemptor_job_ptr->part_ptr->node_bitmap,
+			    _add_candidate, &cand);
+	preemptee_job_list = cand.list;
 
 	if (preemptee_job_list) {
 		list_sort(preemptee_job_list, _sort_by_job_prio);
@@ -50,6 +50,11 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/job_scheduler.h"
 
+typedef struct {
+	struct job_record *preemptor;
+	List list;
+} _candidates_t;
+
 const char	plugin_name[]	= "Preempt by partition priority plugin";
 const char	plugin_type[]	= "preempt/partition_prio";
 const uint32_t	plugin_version	= SLURM_VERSION_NUMBER;
@@ -76,10 +81,31 @@ extern void fini(void)
 	/* Empty. */
 }
 
+/* Append a running job to the candidate list if the preemptor can preempt
+ * it, called by running_job_foreach() */
+static void _add_candidate(struct job_record *job_p, void *arg)
+{
+	_candidates_t *cand = (_candidates_t *) arg;
+	struct job_record *job_ptr = cand->preemptor;
+
+	if ((job_p->part_ptr == NULL) ||
+	    (job_p->part_ptr->priority_tier >=
+	     job_ptr->part_ptr->priority_tier) ||
+	    (job_p->part_ptr->preempt_mode == PREEMPT_MODE_OFF))
+		return;
+	if (job_ptr->details &&
+	    (job_ptr->details->expanding_jobid == job_p->job_id))
+		return;
+
+	/* This job is a preemption candidate */
+	if (cand->list == NULL)
+		cand->list = list_create(NULL);
+	list_append(cand->list, job_p);
+}
+
 extern List find_preemptable_jobs(struct job_record *job_ptr)
 {
-	ListIterator job_iterator;
-	struct job_record *job_p;
+	_candidates_t cand = { job_ptr, NULL };
 	List preemptee_job_list = NULL;
 
 	/* Validate the preemptor job */
@@ -103,31 +129,11 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		return preemptee_job_list;
 	}
 
-	/* Build an array of pointers to preemption candidates */
-	job_iterator = list_iterator_create(job_list);
-	while ((job_p = (struct job_record *) list_next(job_iterator))) {
-		if (!IS_JOB_RUNNING(job_p) && !IS_JOB_SUSPENDED(job_p))
-			continue;
-		if ((job_p->part_ptr == NULL) ||
-		    (job_p->part_ptr->priority_tier >=
-		     job_ptr->part_ptr->priority_tier) ||
-		    (job_p->part_ptr->preempt_mode == PREEMPT_MODE_OFF))
-			continue;
-		if ((job_p->node_bitmap == NULL) ||
-		    (bit_overlap(job_p->node_bitmap,
-				 job_ptr->part_ptr->node_bitmap) == 0))
-			continue;
-		if (job_ptr->details &&
-		    (job_ptr->details->expanding_jobid == job_p->job_id))
-			continue;
-
-		/* This job is a preemption candidate */
-		if (preemptee_job_list == NULL) {
-			preemptee_job_list = list_create(NULL);
-		}
-		list_append(preemptee_job_list, job_p);
-	}
-	list_iterator_destroy(job_iterator);
+	/* Build a list of pointers to preemption candidates, only jobs
+	 * on nodes of the preemptor's partition are visited */
+	running_job_foreach(NULL, job_ptr->part_ptr->node_bitmap,
+			    _add_candidate, &cand);
+	preemptee_job_list = cand.list;
 
 	if (preemptee_job_list && youngest_order)
 		list_sort(preemptee_job_list, _sort_by_youngest);
@@ -67,9 +67,7 @@ extern void fair_tree_decay(List jobs, time_t start)
 	assoc_mgr_unlock(&locks);
 
 	/* assign job priorities */
-	lock_slurmctld(job_write_lock);
-	list_for_each(jobs, (ListForF) decay_apply_weighted_factors, &start);
-	unlock_slurmctld(job_write_lock);
+	decay_apply_priorities(jobs, start, NULL, 0);
 }
 
 
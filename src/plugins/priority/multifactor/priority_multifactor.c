@@ -55,6 +55,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "slurm/slurm_errno.h"
 
@@ -149,10 +150,65 @@ static uint32_t prevflags;    /* Priority Flags before _internal_setup() resets
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
+/* Inputs, then weighted factors, of the jobs whose priority the decay
+ * thread recalculates, one array per factor. See decay_apply_priorities() */
+typedef struct {
+	int cnt;
+	time_t start_time;
+	struct job_record **job_ptr;
+	uint32_t *job_id;
+	uint32_t *skip;		/* sorted ids of jobs not to recalculate */
+	int skip_cnt;
+	bool *full;		/* use decay_apply_weighted_factors() */
+	/* inputs checked again before storing, see _prio_calc_changed() */
+	slurmdb_assoc_rec_t **assoc_ptr;
+	struct job_details **details;
+	struct part_record **part_ptr;
+	slurmdb_qos_rec_t **qos_ptr;
+	uint64_t **tres_in;	/* job TRES counts used */
+	time_t *begin_time;
+	time_t *submit_time;
+	uint32_t *time_limit;
+	double *age;		/* seconds eligible, -1 if none */
+	double *fs;
+	double *js;
+	uint32_t *js_nodes;
+	uint32_t *js_cpus;
+	uint32_t *js_time;	/* time limit in minutes */
+	double *part;
+	double *qos;
+	uint32_t *nice;
+	int tres_cnt;
+	double *tres;		/* tres_cnt factors per job, NULL if unused */
+	double *tres_weights;
+	double *tres_sum;
+	double *prio;
+} prio_calc_t;
+
+/* Jobs [begin, end) of a prio_calc_t computed by one thread */
+typedef struct {
+	prio_calc_t *calc;
+	int begin;
+	int end;
+} prio_calc_range_t;
+
+/* Ids of the jobs decay_apply_new_usage() has no more use for */
+typedef struct {
+	time_t start_time;
+	uint32_t *job_id;
+	int cnt;
+	int size;
+} new_usage_skip_t;
+
+/* Jobs per thread computing priorities, and most threads used */
+#define PRIO_CALC_CHUNK		8192
+#define PRIO_CALC_MAX_THREADS	8
+
 /* variables defined in prirority_multifactor.h */
 bool priority_debug = 0;
 
 static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc);
+static double _get_fairshare_priority_locked(struct job_record *job_ptr);
 static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc);
 
 /*
@@ -435,9 +491,7 @@ static int _set_children_usage_efctv(List children_list)
  */
 static double _get_fairshare_priority(struct job_record *job_ptr)
 {
-	slurmdb_assoc_rec_t *job_assoc;
-	slurmdb_assoc_rec_t *fs_assoc = NULL;
-	double priority_fs = 0.0;
+	double priority_fs;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -445,11 +499,22 @@ static double _get_fairshare_priority(struct job_record *job_ptr)
 		return 0;
 
 	assoc_mgr_lock(&locks);
+	priority_fs = _get_fairshare_priority_locked(job_ptr);
+	assoc_mgr_unlock(&locks);
+
+	return priority_fs;
+}
+
+/* As _get_fairshare_priority(), with the assoc_mgr assoc read lock held */
+static double _get_fairshare_priority_locked(struct job_record *job_ptr)
+{
+	slurmdb_assoc_rec_t *job_assoc;
+	slurmdb_assoc_rec_t *fs_assoc = NULL;
+	double priority_fs = 0.0;
 
 	job_assoc = job_ptr->assoc_ptr;
 
 	if (!job_assoc) {
-		assoc_mgr_unlock(&locks);
 		error("Job %u has no association.  Unable to "
 		      "compute fairshare.", job_ptr->job_id);
 		return 0;
@@ -485,7 +550,6 @@ static double _get_fairshare_priority(struct job_record *job_ptr)
 			     fs_assoc->usage->shares_norm, priority_fs);
 		}
 	}
-	assoc_mgr_unlock(&locks);
 
 	return priority_fs;
 }
@@ -1128,21 +1192,523 @@ static int _apply_new_usage(struct job_record *job_ptr,
 }
 
 
-static int _decay_apply_new_usage_and_weighted_factors(
-	struct job_record *job_ptr,
-	time_t *start_time_ptr)
+static int _decay_apply_new_usage(struct job_record *job_ptr,
+				  new_usage_skip_t *skip)
 {
 	/* Always return SUCCESS so that list_for_each will
 	 * continue processing list of jobs. */
 
-	if (!decay_apply_new_usage(job_ptr, start_time_ptr))
+	/* no priority recalculation, see decay_apply_priorities() */
+	if (!decay_apply_new_usage(job_ptr, &skip->start_time)) {
+		if (skip->cnt >= skip->size) {
+			skip->size = MAX(skip->size * 2, 64);
+			xrealloc(skip->job_id,
+				 sizeof(uint32_t) * skip->size);
+		}
+		skip->job_id[skip->cnt++] = job_ptr->job_id;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _cmp_job_id(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	return (x < y) ? -1 : (x > y);
+}
+
+/* Apply the new usage of the jobs, then recalculate their priorities */
+static void _decay_apply_jobs(List jobs, time_t start_time)
+{
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	new_usage_skip_t skip;
+
+	memset(&skip, 0, sizeof(new_usage_skip_t));
+	skip.start_time = start_time;
+	lock_slurmctld(job_write_lock);
+	list_for_each(jobs, (ListForF) _decay_apply_new_usage, &skip);
+	unlock_slurmctld(job_write_lock);
+	decay_apply_priorities(jobs, start_time, skip.job_id, skip.cnt);
+	xfree(skip.job_id);
+}
+
+/* Return true if decay_apply_weighted_factors() would recalculate the job */
+static bool _prio_calc_test(struct job_record *job_ptr)
+{
+	if (IS_JOB_FINISHED(job_ptr) || IS_JOB_COMPLETING(job_ptr))
+		return false;
+	if ((job_ptr->priority == 0) || IS_JOB_POWER_UP_NODE(job_ptr))
+		return false;
+	if (!IS_JOB_PENDING(job_ptr) &&
+	    !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING))
+		return false;
+	return true;
+}
+
+/* Return true if the job needs decay_apply_weighted_factors() itself */
+static bool _prio_calc_full(struct job_record *job_ptr)
+{
+	return ((job_ptr->direct_set_prio && (job_ptr->priority > 0)) ||
+		!job_ptr->details || job_ptr->part_ptr_list);
+}
+
+/* TRES counts of the job used for its TRES factors */
+static uint64_t *_prio_calc_tres_cnt(struct job_record *job_ptr)
+{
+	if (job_ptr->tres_alloc_cnt)
+		return job_ptr->tres_alloc_cnt;
+	return job_ptr->tres_req_cnt;
+}
+
+/* Inputs of the job size factor */
+static void _prio_calc_js_inputs(struct job_record *job_ptr,
+				 uint32_t *nodes, uint32_t *cpus,
+				 uint32_t *time_limit)
+{
+	if (job_ptr->total_cpus)
+		*cpus = job_ptr->total_cpus;
+	else if (job_ptr->details->max_cpus != NO_VAL)
+		*cpus = job_ptr->details->max_cpus;
+	else
+		*cpus = job_ptr->details->min_cpus;
+	*nodes = job_ptr->details->min_nodes;
+	if (job_ptr->time_limit != NO_VAL)
+		*time_limit = job_ptr->time_limit;
+	else if (job_ptr->part_ptr)
+		*time_limit = job_ptr->part_ptr->max_time;
+	else
+		*time_limit = 1;
+}
+
+/* Copy the priority inputs of each job to recalculate into calc */
+static int _prio_calc_snapshot(struct job_record *job_ptr, prio_calc_t *calc)
+{
+	slurmdb_qos_rec_t *qos_ptr = job_ptr->qos_ptr;
+	struct part_record *part_ptr = job_ptr->part_ptr;
+	uint64_t *tres_cnt = _prio_calc_tres_cnt(job_ptr);
+	int i = calc->cnt, t;
+
+	if (!_prio_calc_test(job_ptr))
+		return SLURM_SUCCESS;
+	if (calc->skip_cnt &&
+	    bsearch(&job_ptr->job_id, calc->skip, calc->skip_cnt,
+		    sizeof(uint32_t), _cmp_job_id))
 		return SLURM_SUCCESS;
 
-	decay_apply_weighted_factors(job_ptr, start_time_ptr);
+	calc->job_ptr[i] = job_ptr;
+	calc->job_id[i] = job_ptr->job_id;
+	calc->cnt++;
+	if ((calc->full[i] = _prio_calc_full(job_ptr)))
+		return SLURM_SUCCESS;
+
+	calc->assoc_ptr[i] = job_ptr->assoc_ptr;
+	calc->details[i] = job_ptr->details;
+	calc->part_ptr[i] = part_ptr;
+	calc->qos_ptr[i] = qos_ptr;
+	calc->tres_in[i] = tres_cnt;
+	calc->begin_time[i] = job_ptr->details->begin_time;
+	calc->submit_time[i] = job_ptr->details->submit_time;
+	calc->time_limit[i] = job_ptr->time_limit;
+
+	if (!job_ptr->details->begin_time &&
+	    !(flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)) {
+		calc->age[i] = -1.0;	/* no age priority */
+	} else if (weight_age) {
+		time_t use_time;
+
+		if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
+			use_time = job_ptr->details->submit_time;
+		else
+			use_time = job_ptr->details->begin_time;
+		if (calc->start_time > use_time)
+			calc->age[i] = (double)(uint32_t)
+				(calc->start_time - use_time);
+	}
+
+	if (job_ptr->assoc_ptr && weight_fs && calc_fairshare)
+		calc->fs[i] = _get_fairshare_priority_locked(job_ptr);
+
+	if (weight_js)
+		_prio_calc_js_inputs(job_ptr, &calc->js_nodes[i],
+				     &calc->js_cpus[i], &calc->js_time[i]);
+
+	if (part_ptr && part_ptr->priority_job_factor && weight_part)
+		calc->part[i] = part_ptr->norm_priority;
+
+	if (qos_ptr && qos_ptr->priority && weight_qos)
+		calc->qos[i] = qos_ptr->usage->norm_priority;
+
+	calc->nice[i] = job_ptr->details->nice;
+
+	if (calc->tres) {
+		double *tres_factors = calc->tres + (i * calc->tres_cnt);
+
+		for (t = 0; t < calc->tres_cnt; t++) {
+			uint64_t value = 0;
+			if (tres_cnt)
+				value = tres_cnt[t];
+
+			if (value && part_ptr && part_ptr->tres_cnt &&
+			    part_ptr->tres_cnt[t])
+				tres_factors[t] =
+					value / (double)part_ptr->tres_cnt[t];
+		}
+	}
 
 	return SLURM_SUCCESS;
 }
 
+/* Job size factor, as computed by set_priority_factors() */
+static double _prio_calc_js(uint32_t min_nodes, uint32_t cpu_cnt,
+			    uint32_t time_limit)
+{
+	double js;
+
+	if (flags & PRIORITY_FLAGS_SIZE_RELATIVE) {
+		js = (double)min_nodes * (double)cluster_cpus /
+		     (double)node_record_count;
+		if (cpu_cnt > js)
+			js = (double)cpu_cnt;
+		js /= time_limit;
+		js /= cluster_cpus;
+		if (favor_small)
+			js = (double) 1.0 - js;
+	} else if (favor_small) {
+		js = (double)(node_record_count - min_nodes) /
+		     (double)node_record_count;
+		if (cpu_cnt) {
+			js += (double)(cluster_cpus - cpu_cnt) /
+			      (double)cluster_cpus;
+			js /= 2;
+		}
+	} else {
+		js = (double)min_nodes / (double)node_record_count;
+		if (cpu_cnt) {
+			js += (double)cpu_cnt / (double)cluster_cpus;
+			js /= 2;
+		}
+	}
+	if (js < .0)
+		js = 0.0;
+	else if (js > 1.0)
+		js = 1.0;
+
+	return js;
+}
+
+/*
+ * Turn the inputs of jobs begin to end - 1 into weighted factors and
+ * priorities. Runs without locks, each array is walked separately so the
+ * compiler can vectorize the loops.
+ */
+static void _prio_calc_range(prio_calc_t *calc, int begin, int end)
+{
+	double *age = calc->age, *fs = calc->fs, *js = calc->js;
+	double *part = calc->part, *qos = calc->qos;
+	double *tres_sum = calc->tres_sum, *prio = calc->prio;
+	double max_age_d = (double) max_age;
+	int i, t;
+
+	for (i = begin; i < end; i++) {
+		if (calc->full[i] || !weight_js)
+			continue;
+		js[i] = _prio_calc_js(calc->js_nodes[i], calc->js_cpus[i],
+				      calc->js_time[i]);
+	}
+
+	for (i = begin; i < end; i++)
+		age[i] = ((age[i] < 0.0) ? 0.0 :
+			  (age[i] < max_age_d) ? (age[i] / max_age_d) : 1.0) *
+			 (double) weight_age;
+	for (i = begin; i < end; i++)
+		fs[i] *= (double) weight_fs;
+	for (i = begin; i < end; i++)
+		js[i] *= (double) weight_js;
+	for (i = begin; i < end; i++)
+		part[i] *= (double) weight_part;
+	for (i = begin; i < end; i++)
+		qos[i] *= (double) weight_qos;
+
+	if (calc->tres) {
+		for (i = begin; i < end; i++) {
+			double *tres_factors =
+				calc->tres + (i * calc->tres_cnt);
+			double sum = 0.0;
+
+			for (t = 0; t < calc->tres_cnt; t++) {
+				tres_factors[t] *= calc->tres_weights[t];
+				sum += tres_factors[t];
+			}
+			tres_sum[i] = sum;
+		}
+	}
+
+	for (i = begin; i < end; i++) {
+		double p = age[i] + fs[i] + js[i] + part[i] + qos[i] +
+			   tres_sum[i] -
+			   (double)(((int64_t)calc->nice[i]) - NICE_OFFSET);
+		/* Priority 0 is reserved for held jobs */
+		p = (p < 1) ? 1 : p;
+		prio[i] = (p > (double) 0xffffffff) ? (double) 0xffffffff : p;
+	}
+}
+
+static void *_prio_calc_thread(void *arg)
+{
+	prio_calc_range_t *range = (prio_calc_range_t *) arg;
+
+	_prio_calc_range(range->calc, range->begin, range->end);
+
+	return NULL;
+}
+
+/* Compute the priorities of all jobs in calc, on several threads if many */
+static void _prio_calc_run(prio_calc_t *calc)
+{
+	prio_calc_range_t *ranges;
+	pthread_t *threads;
+	long thread_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+	int i, per_thread;
+
+	thread_cnt = MIN(thread_cnt, PRIO_CALC_MAX_THREADS);
+	thread_cnt = MIN(thread_cnt, calc->cnt / PRIO_CALC_CHUNK);
+	if (thread_cnt < 2) {
+		_prio_calc_range(calc, 0, calc->cnt);
+		return;
+	}
+
+	ranges = xmalloc(sizeof(prio_calc_range_t) * thread_cnt);
+	threads = xmalloc(sizeof(pthread_t) * thread_cnt);
+	per_thread = (calc->cnt + thread_cnt - 1) / thread_cnt;
+	for (i = 0; i < thread_cnt; i++) {
+		ranges[i].calc = calc;
+		ranges[i].begin = i * per_thread;
+		ranges[i].end = MIN((i + 1) * per_thread, calc->cnt);
+		slurm_thread_create(&threads[i], _prio_calc_thread,
+				    &ranges[i]);
+	}
+	for (i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+	xfree(ranges);
+}
+
+/*
+ * Return true if job i of calc was changed, e.g. by an update or a move to
+ * another partition, since its inputs were copied by _prio_calc_snapshot()
+ */
+static bool _prio_calc_changed(prio_calc_t *calc, int i)
+{
+	struct job_record *job_ptr = calc->job_ptr[i];
+	uint32_t nodes, cpus, time_limit;
+
+	if ((job_ptr->assoc_ptr != calc->assoc_ptr[i]) ||
+	    (job_ptr->details != calc->details[i]) ||
+	    (job_ptr->part_ptr != calc->part_ptr[i]) ||
+	    (job_ptr->qos_ptr != calc->qos_ptr[i]) ||
+	    (_prio_calc_tres_cnt(job_ptr) != calc->tres_in[i]) ||
+	    (job_ptr->details->begin_time != calc->begin_time[i]) ||
+	    (job_ptr->details->submit_time != calc->submit_time[i]) ||
+	    (job_ptr->details->nice != calc->nice[i]) ||
+	    (job_ptr->time_limit != calc->time_limit[i]))
+		return true;
+
+	if (weight_js) {
+		_prio_calc_js_inputs(job_ptr, &nodes, &cpus, &time_limit);
+		if ((nodes != calc->js_nodes[i]) ||
+		    (cpus != calc->js_cpus[i]) ||
+		    (time_limit != calc->js_time[i]))
+			return true;
+	}
+
+	return false;
+}
+
+/* Store the weighted factors and priority of job i of calc in its record */
+static void _prio_calc_publish(prio_calc_t *calc, int i)
+{
+	struct job_record *job_ptr = calc->job_ptr[i];
+	priority_factors_object_t *factors = job_ptr->prio_factors;
+	uint32_t new_prio = (uint32_t) calc->prio[i];
+
+	if (calc->prio[i] >= (double) 0xffffffff)
+		error("Job %u priority exceeds 32 bits", job_ptr->job_id);
+
+	if (!factors) {
+		factors = xmalloc(sizeof(priority_factors_object_t));
+		job_ptr->prio_factors = factors;
+	}
+	if (factors->tres_cnt != calc->tres_cnt) {
+		xfree(factors->tres_weights);
+		xfree(factors->priority_tres);
+		factors->tres_cnt = 0;
+	}
+	factors->priority_age  = calc->age[i];
+	factors->priority_fs   = calc->fs[i];
+	factors->priority_js   = calc->js[i];
+	factors->priority_part = calc->part[i];
+	factors->priority_qos  = calc->qos[i];
+	factors->nice          = calc->nice[i];
+	if (calc->tres) {
+		if (!factors->priority_tres) {
+			factors->priority_tres =
+				xmalloc(sizeof(double) * calc->tres_cnt);
+			factors->tres_weights =
+				xmalloc(sizeof(double) * calc->tres_cnt);
+			factors->tres_cnt = calc->tres_cnt;
+		}
+		memcpy(factors->priority_tres,
+		       calc->tres + (i * calc->tres_cnt),
+		       sizeof(double) * calc->tres_cnt);
+		memcpy(factors->tres_weights, calc->tres_weights,
+		       sizeof(double) * calc->tres_cnt);
+	}
+
+	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
+	    (job_ptr->priority < new_prio)) {
+		job_ptr->priority = new_prio;
+		last_job_update = time(NULL);
+	}
+
+	debug2("priority for job %u is now %u",
+	       job_ptr->job_id, job_ptr->priority);
+}
+
+/* decay_apply_weighted_factors() on the jobs not skipped */
+static int _prio_calc_debug(struct job_record *job_ptr, prio_calc_t *calc)
+{
+	if (calc->skip_cnt &&
+	    bsearch(&job_ptr->job_id, calc->skip, calc->skip_cnt,
+		    sizeof(uint32_t), _cmp_job_id))
+		return SLURM_SUCCESS;
+
+	return decay_apply_weighted_factors(job_ptr, &calc->start_time);
+}
+
+static void _prio_calc_free(prio_calc_t *calc)
+{
+	xfree(calc->job_ptr);
+	xfree(calc->job_id);
+	xfree(calc->full);
+	xfree(calc->assoc_ptr);
+	xfree(calc->details);
+	xfree(calc->part_ptr);
+	xfree(calc->qos_ptr);
+	xfree(calc->tres_in);
+	xfree(calc->begin_time);
+	xfree(calc->submit_time);
+	xfree(calc->time_limit);
+	xfree(calc->age);
+	xfree(calc->fs);
+	xfree(calc->js);
+	xfree(calc->js_nodes);
+	xfree(calc->js_cpus);
+	xfree(calc->js_time);
+	xfree(calc->part);
+	xfree(calc->qos);
+	xfree(calc->nice);
+	xfree(calc->tres);
+	xfree(calc->tres_weights);
+	xfree(calc->tres_sum);
+	xfree(calc->prio);
+}
+
+/*
+ * Recalculate the priority of the jobs in job_list, except those whose ids
+ * are in skip.
+ *
+ * The inputs of each job are copied under the job read lock, then the
+ * factors and priorities are computed without any lock held. The job
+ * write lock is only taken to store the results. A job whose inputs
+ * changed in between is recalculated by decay_apply_weighted_factors()
+ * with the write lock held instead.
+ */
+extern void decay_apply_priorities(List jobs, time_t start_time,
+				   uint32_t *skip, int skip_cnt)
+{
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	prio_calc_t calc;
+	struct job_record *job_ptr;
+	int i, cnt;
+
+	/* Keep the per job debug messages in order */
+	if (skip_cnt)
+		qsort(skip, skip_cnt, sizeof(uint32_t), _cmp_job_id);
+	memset(&calc, 0, sizeof(prio_calc_t));
+	calc.start_time = start_time;
+	calc.skip = skip;
+	calc.skip_cnt = skip_cnt;
+
+	if (priority_debug) {
+		lock_slurmctld(job_write_lock);
+		list_for_each(jobs, (ListForF) _prio_calc_debug, &calc);
+		unlock_slurmctld(job_write_lock);
+		return;
+	}
+
+	lock_slurmctld(job_read_lock);
+	cnt = list_count(jobs);
+	calc.job_ptr  = xmalloc(sizeof(struct job_record *) * cnt);
+	calc.job_id   = xmalloc(sizeof(uint32_t) * cnt);
+	calc.full     = xmalloc(sizeof(bool) * cnt);
+	calc.assoc_ptr   = xmalloc(sizeof(slurmdb_assoc_rec_t *) * cnt);
+	calc.details     = xmalloc(sizeof(struct job_details *) * cnt);
+	calc.part_ptr    = xmalloc(sizeof(struct part_record *) * cnt);
+	calc.qos_ptr     = xmalloc(sizeof(slurmdb_qos_rec_t *) * cnt);
+	calc.tres_in     = xmalloc(sizeof(uint64_t *) * cnt);
+	calc.begin_time  = xmalloc(sizeof(time_t) * cnt);
+	calc.submit_time = xmalloc(sizeof(time_t) * cnt);
+	calc.time_limit  = xmalloc(sizeof(uint32_t) * cnt);
+	calc.age      = xmalloc(sizeof(double) * cnt);
+	calc.fs       = xmalloc(sizeof(double) * cnt);
+	calc.js       = xmalloc(sizeof(double) * cnt);
+	calc.js_nodes = xmalloc(sizeof(uint32_t) * cnt);
+	calc.js_cpus  = xmalloc(sizeof(uint32_t) * cnt);
+	calc.js_time  = xmalloc(sizeof(uint32_t) * cnt);
+	calc.part     = xmalloc(sizeof(double) * cnt);
+	calc.qos      = xmalloc(sizeof(double) * cnt);
+	calc.nice     = xmalloc(sizeof(uint32_t) * cnt);
+	calc.tres_sum = xmalloc(sizeof(double) * cnt);
+	calc.prio     = xmalloc(sizeof(double) * cnt);
+	if (weight_tres && slurmctld_tres_cnt) {
+		calc.tres_cnt = slurmctld_tres_cnt;
+		calc.tres = xmalloc(sizeof(double) * cnt * calc.tres_cnt);
+		calc.tres_weights = xmalloc(sizeof(double) * calc.tres_cnt);
+		memcpy(calc.tres_weights, weight_tres,
+		       sizeof(double) * calc.tres_cnt);
+	}
+	assoc_mgr_lock(&locks);
+	list_for_each(jobs, (ListForF) _prio_calc_snapshot, &calc);
+	assoc_mgr_unlock(&locks);
+	unlock_slurmctld(job_read_lock);
+
+	_prio_calc_run(&calc);
+
+	lock_slurmctld(job_write_lock);
+	for (i = 0; i < calc.cnt; i++) {
+		/* The job may have been purged while no lock was held */
+		job_ptr = find_job_record(calc.job_id[i]);
+		if ((job_ptr != calc.job_ptr[i]) || !_prio_calc_test(job_ptr))
+			continue;
+		if (calc.full[i] || _prio_calc_full(job_ptr) ||
+		    (calc.tres_cnt != (weight_tres ? slurmctld_tres_cnt : 0)) ||
+		    _prio_calc_changed(&calc, i))
+			decay_apply_weighted_factors(job_ptr, &start_time);
+		else
+			_prio_calc_publish(&calc, i);
+	}
+	unlock_slurmctld(job_write_lock);
+
+	_prio_calc_free(&calc);
+}
+
 
 static void *_decay_thread(void *no_data)
 {
@@ -1157,9 +1723,6 @@ static void *_decay_thread(void *no_data)
 	struct timeval tvnow;
 	struct timespec abs;
 
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1309,20 +1872,16 @@ static void *_decay_thread(void *no_data)
 			break;
 		}
 
-		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
-			lock_slurmctld(job_write_lock);
-			list_for_each(
-				job_list,
-				(ListForF) _decay_apply_new_usage_and_weighted_factors,
-				&start_time
-				);
-			unlock_slurmctld(job_write_lock);
-		}
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE))
+			_decay_apply_jobs(job_list, start_time);
 
 	get_usage:
 		if (flags & PRIORITY_FLAGS_FAIR_TREE)
 			fair_tree_decay(job_list, start_time);
 
+		/* usage of associations and QOS grew or decayed */
+		job_time_limit_acct_changed();
+
 		g_last_ran = start_time;
 
 		_write_last_decay_ran(g_last_ran, last_reset);
@@ -1657,9 +2216,6 @@ static void _set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 int init ( void )
 {
 	char *temp = NULL;
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
 
 	/* This means we aren't running from the controller so skip setup. */
 	if (cluster_cpus == NO_VAL) {
@@ -1686,12 +2242,7 @@ int init ( void )
 		weight_fs = 0;
 
 		/* Initialize job priority factors for valid sprio output */
-		lock_slurmctld(job_write_lock);
-		list_for_each(
-			job_list,
-			(ListForF) _decay_apply_new_usage_and_weighted_factors,
-			&start_time);
-		unlock_slurmctld(job_write_lock);
+		_decay_apply_jobs(job_list, start_time);
 	} else if (assoc_mgr_root_assoc) {
 		if (!cluster_cpus)
 			fatal("We need to have a cluster cpu count "
@@ -1940,6 +2491,7 @@ extern void priority_p_job_end(struct job_record *job_ptr)
 		info("priority_p_job_end: called for job %u", job_ptr->job_id);
 
 	_apply_new_usage(job_ptr, g_last_ran, time(NULL), 1);
+	job_time_limit_acct_changed();
 }
 
 extern bool decay_apply_new_usage(struct job_record *job_ptr,
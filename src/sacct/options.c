@@ -54,9 +54,32 @@
 #define OPT_LONG_NOCONVERT 0x103
 #define OPT_LONG_UNITS     0x104
 #define OPT_LONG_FEDR      0x105
+#define OPT_LONG_BINARY    0x106
 
 #define JOB_HASH_SIZE 1000
 
+/*
+ * Jobs are formatted in chunks of LIST_CHUNK_JOBS jobs by up to
+ * LIST_MAX_THREADS threads. No more than LIST_WINDOW chunks per thread are
+ * formatted ahead of the one being written, to bound memory use.
+ */
+#define LIST_CHUNK_JOBS  256
+#define LIST_MAX_THREADS 16
+#define LIST_WINDOW      4
+
+typedef struct {
+	void **jobs;		/* records to print, in order */
+	int job_cnt;
+	int chunk_cnt;
+	Buf *chunk_out;		/* output of each formatted chunk */
+	int next_chunk;		/* next chunk to format */
+	int written;		/* chunks written to stdout so far */
+	int window;		/* max chunks formatted ahead of written */
+	bool completion;	/* job completion records */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} list_state_t;
+
 static void _help_fields_msg(void);
 static void _help_msg(void);
 static void _init_params(void);
@@ -67,7 +90,6 @@ List selected_steps = NULL;
 void *acct_db_conn = NULL;
 
 List print_fields_list = NULL;
-ListIterator print_fields_itr = NULL;
 int field_count = 0;
 List g_qos_list = NULL;
 List g_tres_list = NULL;
@@ -309,6 +331,9 @@ sacct [<OPTION>]                                                            \n \
                    to display.  By default, all accounts are selected.      \n\
      -b, --brief:                                                           \n\
 	           Equivalent to '--format=jobstep,state,error'.            \n\
+         --binary:                                                          \n\
+	           Write a binary columnar dump of the fields rather than   \n\
+	           text, see the man page for its layout.                   \n\
      -c, --completion: Use job completion instead of accounting data.       \n\
          --delimiter:                                                       \n\
 	           ASCII characters used to separate the fields when        \n\
@@ -547,15 +572,62 @@ static void _remove_duplicate_fed_jobs(List jobs)
 	xfree(hash_job);
 }
 
-extern int get_data(void)
+/*
+ * Fill in the uid of a job and aggregate the statistics of its steps.
+ * This is done by do_list() right before printing the job, so that it is
+ * spread over the threads formatting the output.
+ */
+static void _aggregate_job(slurmdb_job_rec_t *job)
 {
-	slurmdb_job_rec_t *job = NULL;
 	slurmdb_step_rec_t *step = NULL;
-	ListIterator itr = NULL;
 	ListIterator itr_step = NULL;
-	slurmdb_job_cond_t *job_cond = params.job_cond;
 	int cnt;
 	char *tmp_usage;
+	uid_t uid;
+
+	if (job->user && !uid_from_string(job->user, &uid))
+		job->uid = uid;
+
+	if (!job->steps || !(cnt = list_count(job->steps)))
+		return;
+
+	itr_step = list_iterator_create(job->steps);
+	while ((step = list_next(itr_step)) != NULL) {
+		/* now aggregate the aggregatable */
+
+		if (step->state < JOB_COMPLETE)
+			continue;
+		job->tot_cpu_sec += step->tot_cpu_sec;
+		job->tot_cpu_usec += step->tot_cpu_usec;
+		job->user_cpu_sec +=
+			step->user_cpu_sec;
+		job->user_cpu_usec +=
+			step->user_cpu_usec;
+		job->sys_cpu_sec +=
+			step->sys_cpu_sec;
+		job->sys_cpu_usec +=
+			step->sys_cpu_usec;
+
+		/* get the max for all the sacct_t struct */
+		aggregate_stats(&job->stats, &step->stats);
+	}
+
+	/* Now figure out the average of the total of averages */
+	tmp_usage = job->stats.tres_usage_in_ave;
+	job->stats.tres_usage_in_ave = slurmdb_ave_tres_usage(
+		tmp_usage, cnt);
+	xfree(tmp_usage);
+	tmp_usage = job->stats.tres_usage_out_ave;
+	job->stats.tres_usage_out_ave = slurmdb_ave_tres_usage(
+		tmp_usage, cnt);
+	xfree(tmp_usage);
+
+	list_iterator_destroy(itr_step);
+}
+
+extern int get_data(void)
+{
+	slurmdb_job_cond_t *job_cond = params.job_cond;
 
 	if (params.opt_completion) {
 		jobs = slurmdb_jobcomp_jobs_get(job_cond);
@@ -574,53 +646,6 @@ extern int get_data(void)
 	if (params.cluster_name && !(job_cond->flags & JOBCOND_FLAG_DUP))
 	    _remove_duplicate_fed_jobs(jobs);
 
-	itr = list_iterator_create(jobs);
-	while ((job = list_next(itr))) {
-
-		if (job->user) {
-			struct	passwd *pw = NULL;
-			if ((pw=getpwnam(job->user)))
-				job->uid = pw->pw_uid;
-		}
-
-		if (!job->steps || !(cnt = list_count(job->steps)))
-			continue;
-
-		itr_step = list_iterator_create(job->steps);
-		while ((step = list_next(itr_step)) != NULL) {
-			/* now aggregate the aggregatable */
-
-			if (step->state < JOB_COMPLETE)
-				continue;
-			job->tot_cpu_sec += step->tot_cpu_sec;
-			job->tot_cpu_usec += step->tot_cpu_usec;
-			job->user_cpu_sec +=
-				step->user_cpu_sec;
-			job->user_cpu_usec +=
-				step->user_cpu_usec;
-			job->sys_cpu_sec +=
-				step->sys_cpu_sec;
-			job->sys_cpu_usec +=
-				step->sys_cpu_usec;
-
-			/* get the max for all the sacct_t struct */
-			aggregate_stats(&job->stats, &step->stats);
-		}
-
-		/* Now figure out the average of the total of averages */
-		tmp_usage = job->stats.tres_usage_in_ave;
-		job->stats.tres_usage_in_ave = slurmdb_ave_tres_usage(
-			tmp_usage, cnt);
-		xfree(tmp_usage);
-		tmp_usage = job->stats.tres_usage_out_ave;
-		job->stats.tres_usage_out_ave = slurmdb_ave_tres_usage(
-			tmp_usage, cnt);
-		xfree(tmp_usage);
-
-		list_iterator_destroy(itr_step);
-	}
-	list_iterator_destroy(itr);
-
 	return SLURM_SUCCESS;
 }
 
@@ -646,6 +671,7 @@ extern void parse_command_line(int argc, char **argv)
                 {"allusers",       no_argument,       0,    'a'},
                 {"accounts",       required_argument, 0,    'A'},
                 {"allocations",    no_argument,       0,    'X'},
+                {"binary",         no_argument,       0,    OPT_LONG_BINARY},
                 {"brief",          no_argument,       0,    'b'},
                 {"completion",     no_argument,       0,    'c'},
                 {"delimiter",      required_argument, 0,    OPT_LONG_DELIMITER},
@@ -726,6 +752,9 @@ extern void parse_command_line(int argc, char **argv)
 		case 'b':
 			brief_output = true;
 			break;
+		case OPT_LONG_BINARY:
+			print_fields_binary = 1;
+			break;
 		case 'c':
 			params.opt_completion = 1;
 			break;
@@ -1318,6 +1347,163 @@ static inline bool _test_local_job(uint32_t job_id)
 	return false;
 }
 
+static void _list_job(slurmdb_job_rec_t *job)
+{
+	ListIterator itr_step = NULL;
+	slurmdb_step_rec_t *step = NULL;
+	slurmdb_job_cond_t *job_cond = params.job_cond;
+
+	if ((params.cluster_name) &&
+	    _test_local_job(job->jobid) &&
+	    xstrcmp(params.cluster_name, job->cluster))
+		return;
+
+	_aggregate_job(job);
+
+	if (job->show_full)
+		print_fields(JOB, job);
+
+	if (!(job_cond->flags & JOBCOND_FLAG_NO_STEP)
+	    && (job->track_steps || !job->show_full)) {
+		itr_step = list_iterator_create(job->steps);
+		while ((step = list_next(itr_step))) {
+			if (step->end == 0)
+				step->end = job->end;
+			print_fields(JOBSTEP, step);
+		}
+		list_iterator_destroy(itr_step);
+	}
+}
+
+static void _list_chunk(list_state_t *state, int chunk)
+{
+	int i = chunk * LIST_CHUNK_JOBS;
+	int end = MIN(i + LIST_CHUNK_JOBS, state->job_cnt);
+
+	for ( ; i < end; i++) {
+		if (state->completion)
+			print_fields(JOBCOMP, state->jobs[i]);
+		else
+			_list_job(state->jobs[i]);
+	}
+}
+
+/* Format the chunks of the job list, in order, into their own buffers */
+static void *_list_thread(void *arg)
+{
+	list_state_t *state = (list_state_t *) arg;
+	Buf buffer;
+	int chunk;
+
+	slurm_mutex_lock(&state->mutex);
+	while (state->next_chunk < state->chunk_cnt) {
+		if (state->next_chunk >= (state->written + state->window)) {
+			slurm_cond_wait(&state->cond, &state->mutex);
+			continue;
+		}
+		chunk = state->next_chunk++;
+		slurm_mutex_unlock(&state->mutex);
+
+		buffer = init_buf(BUF_SIZE);
+		print_fields_set_buffer(buffer);
+		_list_chunk(state, chunk);
+		print_fields_set_buffer(NULL);
+
+		slurm_mutex_lock(&state->mutex);
+		state->chunk_out[chunk] = buffer;
+		slurm_cond_broadcast(&state->cond);
+	}
+	slurm_mutex_unlock(&state->mutex);
+
+	return NULL;
+}
+
+static int _list_thread_cnt(int chunk_cnt)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cpus < 1)
+		cpus = 1;
+	return MIN(MIN(cpus, LIST_MAX_THREADS), chunk_cnt);
+}
+
+/*
+ * Print the records of list, formatting them on a pool of threads when
+ * there are more than a chunk of them. Chunks are written in list order as
+ * soon as they and all the ones before them are formatted.
+ */
+static void _list_records(List list, bool completion)
+{
+	list_state_t state;
+	pthread_t *threads;
+	ListIterator itr;
+	void *object;
+	int i, thread_cnt;
+	time_t now = time(NULL);
+	char time_str[32];
+	Buf buffer;
+
+	memset(&state, 0, sizeof(list_state_t));
+	state.completion = completion;
+	state.job_cnt = list_count(list);
+	state.chunk_cnt = (state.job_cnt + LIST_CHUNK_JOBS - 1) /
+			  LIST_CHUNK_JOBS;
+	thread_cnt = _list_thread_cnt(state.chunk_cnt);
+
+	state.jobs = xmalloc(sizeof(void *) * (state.job_cnt + 1));
+	i = 0;
+	itr = list_iterator_create(list);
+	while ((object = list_next(itr)))
+		state.jobs[i++] = object;
+	list_iterator_destroy(itr);
+
+	/* the columnar dump is built by a single thread */
+	if ((thread_cnt <= 1) || print_fields_binary) {
+		for (i = 0; i < state.chunk_cnt; i++)
+			_list_chunk(&state, i);
+		xfree(state.jobs);
+		return;
+	}
+
+	/* set up the lazily initialized time format before going parallel */
+	slurm_make_time_str(&now, time_str, sizeof(time_str));
+
+	state.window = thread_cnt * LIST_WINDOW;
+	state.chunk_out = xmalloc(sizeof(Buf) * state.chunk_cnt);
+	slurm_mutex_init(&state.mutex);
+	slurm_cond_init(&state.cond, NULL);
+
+	threads = xmalloc(sizeof(pthread_t) * thread_cnt);
+	for (i = 0; i < thread_cnt; i++)
+		slurm_thread_create(&threads[i], _list_thread, &state);
+
+	for (i = 0; i < state.chunk_cnt; i++) {
+		slurm_mutex_lock(&state.mutex);
+		while (!state.chunk_out[i])
+			slurm_cond_wait(&state.cond, &state.mutex);
+		buffer = state.chunk_out[i];
+		state.chunk_out[i] = NULL;
+		slurm_mutex_unlock(&state.mutex);
+
+		fwrite(get_buf_data(buffer), 1, get_buf_offset(buffer), stdout);
+		free_buf(buffer);
+
+		slurm_mutex_lock(&state.mutex);
+		state.written++;
+		slurm_cond_broadcast(&state.cond);
+		slurm_mutex_unlock(&state.mutex);
+	}
+
+	for (i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+
+	slurm_mutex_destroy(&state.mutex);
+	slurm_cond_destroy(&state.cond);
+	xfree(state.chunk_out);
+	xfree(state.jobs);
+}
+
 /* do_list() -- List the assembled data
  *
  * In:	Nothing explicit.
@@ -1328,37 +1514,10 @@ static inline bool _test_local_job(uint32_t job_id)
  */
 extern void do_list(void)
 {
-	ListIterator itr = NULL;
-	ListIterator itr_step = NULL;
-	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
-	slurmdb_job_cond_t *job_cond = params.job_cond;
-
 	if (!jobs)
 		return;
 
-	itr = list_iterator_create(jobs);
-	while ((job = list_next(itr))) {
-		if ((params.cluster_name) &&
-		    _test_local_job(job->jobid) &&
-		    xstrcmp(params.cluster_name, job->cluster))
-			continue;
-
-		if (job->show_full)
-			print_fields(JOB, job);
-
-		if (!(job_cond->flags & JOBCOND_FLAG_NO_STEP)
-		    && (job->track_steps || !job->show_full)) {
-			itr_step = list_iterator_create(job->steps);
-			while ((step = list_next(itr_step))) {
-				if (step->end == 0)
-					step->end = job->end;
-				print_fields(JOBSTEP, step);
-			}
-			list_iterator_destroy(itr_step);
-		}
-	}
-	list_iterator_destroy(itr);
+	_list_records(jobs, false);
 }
 
 /* do_list_completion() -- List the assembled data
@@ -1372,30 +1531,20 @@ extern void do_list(void)
  */
 extern void do_list_completion(void)
 {
-	ListIterator itr = NULL;
-	jobcomp_job_rec_t *job = NULL;
-
 	if (!jobs)
 		return;
 
-	itr = list_iterator_create(jobs);
-	while ((job = list_next(itr))) {
-		print_fields(JOBCOMP, job);
-	}
-	list_iterator_destroy(itr);
+	_list_records(jobs, true);
 }
 
 extern void sacct_init(void)
 {
 	_init_params();
 	print_fields_list = list_create(NULL);
-	print_fields_itr = list_iterator_create(print_fields_list);
 }
 
 extern void sacct_fini(void)
 {
-	if (print_fields_itr)
-		list_iterator_destroy(print_fields_itr);
 	FREE_NULL_LIST(print_fields_list);
 	FREE_NULL_LIST(jobs);
 	FREE_NULL_LIST(g_qos_list);
@@ -39,11 +39,16 @@
 #include "sacct.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/parse_time.h"
+#include "src/common/uid.h"
 #include "slurm.h"
 
-print_field_t *field = NULL;
-int curr_inx = 1;
-char outbuf[FORMAT_STRING_SIZE];
+/* rows may be formatted by several threads at once, see do_list() */
+static __thread print_field_t *field = NULL;
+static __thread int curr_inx = 1;
+static __thread char outbuf[FORMAT_STRING_SIZE];
+
+/* serializes the lazy loading of g_qos_list and g_tres_list */
+static pthread_mutex_t g_list_lock = PTHREAD_MUTEX_INITIALIZER;
 
 #define SACCT_TRES_AVE  0x0001
 #define SACCT_TRES_OUT  0x0002
@@ -335,12 +340,14 @@ static void _print_tres_field(char *tres_in, char *nodes, bool convert,
 {
 	char *temp = NULL;
 
+	slurm_mutex_lock(&g_list_lock);
 	if (!g_tres_list) {
 		slurmdb_tres_cond_t tres_cond;
 		memset(&tres_cond, 0, sizeof(slurmdb_tres_cond_t));
 		tres_cond.with_deleted = 1;
 		g_tres_list = slurmdb_tres_get(acct_db_conn, &tres_cond);
 	}
+	slurm_mutex_unlock(&g_list_lock);
 
 	temp = slurmdb_make_tres_string_from_simple(tres_in, g_tres_list,
 						    convert ?
@@ -361,8 +368,7 @@ extern void print_fields(type_t type, void *object)
 	slurmdb_job_rec_t *job = (slurmdb_job_rec_t *)object;
 	slurmdb_step_rec_t *step = (slurmdb_step_rec_t *)object;
 	jobcomp_job_rec_t *job_comp = (jobcomp_job_rec_t *)object;
-	struct passwd *pw = NULL;
-	struct	group *gr = NULL;
+	ListIterator itr;
 	int cpu_tres_rec_count = 0;
 	int step_cpu_tres_rec_count = 0;
 	char tmp1[128];
@@ -425,8 +431,9 @@ extern void print_fields(type_t type, void *object)
 	if ((uint64_t)step_cpu_tres_rec_count == INFINITE64)
 		step_cpu_tres_rec_count = 0;
 
-	list_iterator_reset(print_fields_itr);
-	while ((field = list_next(print_fields_itr))) {
+	curr_inx = 1;
+	itr = list_iterator_create(print_fields_list);
+	while ((field = list_next(itr))) {
 		char *tmp_char = NULL, id[FORMAT_STRING_SIZE];
 		int exit_code, tmp_int = NO_VAL, tmp_int2 = NO_VAL;
 		double tmp_dub = (double)NO_VAL; /* don't use NO_VAL64
@@ -962,13 +969,12 @@ extern void print_fields(type_t type, void *object)
 				tmp_int = NO_VAL;
 				break;
 			}
-			tmp_char = NULL;
-			if ((gr=getgrgid(tmp_int)))
-				tmp_char=gr->gr_name;
+			tmp_char = gid_to_string_or_null(tmp_int);
 
 			field->print_routine(field,
 					     tmp_char,
 					     (curr_inx == field_count));
+			xfree(tmp_char);
 			break;
 		case PRINT_JOBID:
 			if (type == JOBSTEP)
@@ -1728,6 +1734,7 @@ extern void print_fields(type_t type, void *object)
 
 				break;
 			}
+			slurm_mutex_lock(&g_list_lock);
 			if (!g_qos_list) {
 				slurmdb_qos_cond_t qos_cond;
 				memset(&qos_cond, 0,
@@ -1736,6 +1743,7 @@ extern void print_fields(type_t type, void *object)
 				g_qos_list = slurmdb_qos_get(
 					acct_db_conn, &qos_cond);
 			}
+			slurm_mutex_unlock(&g_list_lock);
 
 			tmp_char = _find_qos_name_from_list(g_qos_list,
 							    tmp_int);
@@ -2248,8 +2256,9 @@ extern void print_fields(type_t type, void *object)
 			switch(type) {
 			case JOB:
 				if (job->user) {
-					if ((pw=getpwnam(job->user)))
-						tmp_int = pw->pw_uid;
+					uid_t uid;
+					if (!uid_from_string(job->user, &uid))
+						tmp_int = uid;
 				} else
 					tmp_int = job->uid;
 				break;
@@ -2271,17 +2280,16 @@ extern void print_fields(type_t type, void *object)
 			switch(type) {
 			case JOB:
 				if (job->user)
-					tmp_char = job->user;
-				else if (job->uid != -1) {
-					if ((pw=getpwuid(job->uid)))
-						tmp_char = pw->pw_name;
-				}
+					tmp_char = xstrdup(job->user);
+				else if (job->uid != -1)
+					tmp_char = uid_to_string_or_null(
+						job->uid);
 				break;
 			case JOBSTEP:
 
 				break;
 			case JOBCOMP:
-				tmp_char = job_comp->uid_name;
+				tmp_char = xstrdup(job_comp->uid_name);
 				break;
 			default:
 
@@ -2291,6 +2299,7 @@ extern void print_fields(type_t type, void *object)
 			field->print_routine(field,
 					     tmp_char,
 					     (curr_inx == field_count));
+			xfree(tmp_char);
 			break;
 		case PRINT_USERCPU:
 			switch(type) {
@@ -2377,5 +2386,6 @@ extern void print_fields(type_t type, void *object)
 		}
 		curr_inx++;
 	}
-	printf("\n");
+	list_iterator_destroy(itr);
+	print_fields_end_row();
 }
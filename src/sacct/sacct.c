@@ -183,6 +183,10 @@ int main(int argc, char **argv)
 			do_list_completion();
 		else
 			do_list();
+		if (print_fields_binary_write() != SLURM_SUCCESS) {
+			error("unable to write binary output: %m");
+			rc = 1;
+		}
 		break;
 	case SACCT_HELP:
 		do_help();
@@ -79,6 +79,7 @@ extern void parse_command_line(int argc, char **argv)
 		{"fanout",    required_argument, 0, 'F'},
 		{"force",     no_argument,       0, 'f'},
 		{"jobid",     required_argument, 0, 'j'},
+		{"pipeline",  required_argument, 0, 'P'},
 		{"preserve",  no_argument,       0, 'p'},
 		{"size",      required_argument, 0, 's'},
 		{"timeout",   required_argument, 0, 't'},
@@ -111,6 +112,8 @@ extern void parse_command_line(int argc, char **argv)
 	params.pack_job_offset = NO_VAL;
 	params.step_id = NO_VAL;
 
+	if ((env_val = getenv("SBCAST_PIPELINE")))
+		params.pipeline = atoi(env_val);
 	if (getenv("SBCAST_PRESERVE"))
 		params.preserve = true;
 	if ( ( env_val = getenv("SBCAST_SIZE") ) )
@@ -121,7 +124,7 @@ extern void parse_command_line(int argc, char **argv)
 		params.timeout = (atoi(env_val) * 1000);
 
 	optind = 0;
-	while ((opt_char = getopt_long(argc, argv, "CfF:j:ps:t:vV",
+	while ((opt_char = getopt_long(argc, argv, "CfF:j:pP:s:t:vV",
 			long_options, &option_index)) != -1) {
 		switch (opt_char) {
 		case (int)'?':
@@ -150,6 +153,9 @@ extern void parse_command_line(int argc, char **argv)
 		case (int)'p':
 			params.preserve = true;
 			break;
+		case (int)'P':
+			params.pipeline = atoi(optarg);
+			break;
 		case (int) 's':
 			params.block_size = _map_size(optarg);
 			break;
@@ -268,6 +274,7 @@ static void _print_options( void )
 			     params.step_id);
 		}
 	}
+	info("pipeline   = %d", params.pipeline);
 	info("preserve   = %s", params.preserve ? "true" : "false");
 	info("timeout    = %d", params.timeout);
 	info("verbose    = %d", params.verbose);
@@ -279,7 +286,7 @@ static void _print_options( void )
 
 static void _usage( void )
 {
-	printf("Usage: sbcast [-CfFjpvV] SOURCE DEST\n");
+	printf("Usage: sbcast [-CfFjpPvV] SOURCE DEST\n");
 }
 
 static void _help( void )
@@ -291,6 +298,7 @@ Usage: sbcast [OPTIONS] SOURCE DEST\n\
   -F, --fanout=num      specify message fanout\n\
   -j, --jobid=#[+#][.#] specify job ID with optional pack job offset and/or step ID\n\
   -p, --preserve        preserve modes and times of source file\n\
+  -P, --pipeline=num    number of blocks to send concurrently\n\
   -s, --size=num        block size in bytes (rounded off)\n\
   -t, --timeout=secs    specify message timeout (seconds)\n\
   -v, --verbose         provide detailed event logging\n\
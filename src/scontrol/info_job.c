@@ -634,7 +634,7 @@ _list_pids_all_steps(const char *node_name, uint32_t jobid)
 	step_loc_t *stepd;
 	int count = 0;
 
-	steps = stepd_available(NULL, node_name);
+	steps = stepd_available_filter(NULL, node_name, jobid, NO_VAL);
 	if (!steps || list_count(steps) == 0) {
 		fprintf(stderr, "Job %u does not exist on this node.\n", jobid);
 		FREE_NULL_LIST(steps);
@@ -667,7 +667,7 @@ _list_pids_all_jobs(const char *node_name)
 	ListIterator itr;
 	step_loc_t *stepd;
 
-	steps = stepd_available(NULL, node_name);
+	steps = stepd_available_filter(NULL, node_name, NO_VAL, NO_VAL);
 	if (!steps || list_count(steps) == 0) {
 		fprintf(stderr, "No job steps exist on this node.\n");
 		FREE_NULL_LIST(steps);
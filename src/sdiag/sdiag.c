@@ -183,6 +183,20 @@ static int _print_stats(void)
 		       buf->bf_queue_len_sum / buf->bf_cycle_counter);
 	}
 
+	if (buf->aggr_level_cnt && buf->aggr_comp_cnt[0]) {
+		printf("\nMessage aggregation stats\n");
+		printf("\tMessages received in composites: %u\n",
+		       buf->aggr_msg_cnt);
+		for (i = 0; i < buf->aggr_level_cnt; i++) {
+			if (!buf->aggr_comp_cnt[i])
+				break;
+			printf("\tComposites received at level %d: %u\n",
+			       i + 1, buf->aggr_comp_cnt[i]);
+		}
+		printf("\tMessages per composite (fan-in reduction): %.1f\n",
+		       (double) buf->aggr_msg_cnt / buf->aggr_comp_cnt[0]);
+	}
+
 	printf("\nLatency for gettimeofday() (x1000): %d nanoseconds\n",
 	       buf->gettimeofday_latency);
 
@@ -59,6 +59,7 @@
 #define OPT_LONG_LOCAL     0x103
 #define OPT_LONG_NOCONVERT 0x104
 #define OPT_LONG_FEDR      0x105
+#define OPT_LONG_BINARY    0x106
 
 /* FUNCTIONS */
 static List  _build_state_list( char* str );
@@ -93,6 +94,7 @@ extern void parse_command_line(int argc, char **argv)
 	static struct option long_options[] = {
 		{"all",       no_argument,       0, 'a'},
 		{"bg",        no_argument,       0, 'b'},
+		{"binary",    no_argument,       0, OPT_LONG_BINARY},
 		{"dead",      no_argument,       0, 'd'},
 		{"exact",     no_argument,       0, 'e'},
 		{"federation",no_argument,       0, OPT_LONG_FEDR},
@@ -289,6 +291,9 @@ extern void parse_command_line(int argc, char **argv)
 		case (int) 'V':
 			print_slurm_version ();
 			exit(0);
+		case (int) OPT_LONG_BINARY:
+			params.binary = true;
+			break;
 		case (int) OPT_LONG_FEDR:
 			params.federation_flag = true;
 			break;
@@ -312,6 +317,17 @@ extern void parse_command_line(int argc, char **argv)
 		      "Please choose one or the other.");
 		exit(1);
 	}
+	if (params.binary &&
+	    (params.iterate || params.bg_flag || params.reservation_flag)) {
+		error("--binary is not supported with --iterate, --bg or "
+		      "--reservation");
+		exit(1);
+	}
+	if (params.binary && params.clusters &&
+	    (list_count(params.clusters) > 1)) {
+		error("--binary writes one table, specify a single cluster");
+		exit(1);
+	}
 
 	params.cluster_flags = slurmdb_setup_cluster_flags();
 
@@ -1360,7 +1376,8 @@ static void _usage( void )
 {
 	printf("\
 Usage: sinfo [-abdelNRrsTv] [-i seconds] [-t states] [-p partition] [-n nodes]\n\
-             [-S fields] [-o format] [-O Format] [--federation] [--local]\n");
+             [-S fields] [-o format] [-O Format] [--federation] [--local]\n\
+             [--binary]\n");
 }
 
 static void _help( void )
@@ -1370,6 +1387,8 @@ Usage: sinfo [OPTIONS]\n\
   -a, --all                  show all partitions (including hidden and those\n\
 			     not accessible)\n\
   -b, --bg                   show bgblocks (on Blue Gene systems)\n\
+      --binary               write a binary columnar table, see sinfo(1),\n\
+                             instead of text\n\
   -d, --dead                 show only non-responding nodes\n\
   -e, --exact                group nodes only on exact match of configuration\n\
       --federation           Report federated information if a member of one\n\
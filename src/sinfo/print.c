@@ -40,12 +40,14 @@
 \*****************************************************************************/
 
 #include <ctype.h>
+#include <stdarg.h>
 #include <time.h>
 #include <stdio.h>
 #include <string.h>
 #include <pwd.h>
 #include <sys/types.h>
 
+#include "src/common/columnar.h"
 #include "src/common/hostlist.h"
 #include "src/common/list.h"
 #include "src/common/parse_time.h"
@@ -59,6 +61,7 @@
 #define MIN_NODE_FIELD_SIZE 9
 #define MIN_PART_FIELD_SIZE 9
 
+static void  _binary_field(int inx, bool header);
 static int   _build_min_max_16_string(char *buffer, int buf_size,
 				uint16_t min, uint16_t max, bool range);
 static int   _build_min_max_32_string(char *buffer, int buf_size,
@@ -72,12 +75,20 @@ static int   _build_free_mem_min_max_64(char *buffer, int buf_size,
 					bool range);
 static void  _print_reservation(reserve_info_t *resv_ptr, int width);
 static int   _print_secs(long time, int width, bool right, bool cut_output);
+static int   _out(const char *fmt, ...)
+  __attribute__ ((format (printf, 1, 2)));
 static int   _print_str(const char *str, int width, bool right, bool cut_output);
 static int   _resv_name_width(reserve_info_t *resv_ptr);
 static void  _set_node_field_size(List sinfo_list);
 static void  _set_part_field_size(List sinfo_list);
 static char *_str_tolower(char *upper_str);
 
+/* --binary: the table being built, the text of the field being printed and
+ * the column of each format list entry (-1 for entries with no header) */
+static columnar_t *print_dump = NULL;
+static char *print_cell = NULL;
+static int *print_cols = NULL;
+
 /*****************************************************************************
  * Global Print Functions
  *****************************************************************************/
@@ -99,13 +110,28 @@ int print_sinfo_list(List sinfo_list)
 	if (params.part_field_flag)
 		_set_part_field_size(sinfo_list);
 
-	if (!params.no_header)
+	if (params.binary) {
+		print_dump = columnar_create();
+		print_cols = xmalloc(sizeof(int) *
+				     MAX(list_count(params.format_list), 1));
+		print_sinfo_entry(NULL);
+	} else if (!params.no_header)
 		print_sinfo_entry(NULL);
 
 	while ((current = list_next(i)) != NULL)
 		 print_sinfo_entry(current);
 
 	list_iterator_destroy(i);
+
+	if (print_dump) {
+		int rc = columnar_write(print_dump, stdout);
+		if (rc != SLURM_SUCCESS)
+			error("write of binary output failed: %m");
+		columnar_destroy(print_dump);
+		print_dump = NULL;
+		xfree(print_cols);
+		return rc;
+	}
 	return SLURM_SUCCESS;
 }
 
@@ -113,8 +139,17 @@ int print_sinfo_entry(sinfo_data_t *sinfo_data)
 {
 	ListIterator i = list_iterator_create(params.format_list);
 	sinfo_format_t *current;
+	int inx = 0;
 
 	while ((current = (sinfo_format_t *) list_next(i)) != NULL) {
+		if (print_dump) {
+			/* the field's own text, with no padding */
+			if (current->function(sinfo_data, 0, false, NULL) !=
+			    SLURM_SUCCESS)
+				return SLURM_ERROR;
+			_binary_field(inx++, (sinfo_data == NULL));
+			continue;
+		}
 		if (current->function(sinfo_data, current->width,
 				      current->right_justify, current->suffix)
 		    != SLURM_SUCCESS)
@@ -122,7 +157,10 @@ int print_sinfo_entry(sinfo_data_t *sinfo_data)
 	}
 	list_iterator_destroy(i);
 
-	printf("\n");
+	if (!print_dump)
+		printf("\n");
+	else if (sinfo_data)
+		columnar_end_row(print_dump);
 	return SLURM_SUCCESS;
 }
 
@@ -178,6 +216,55 @@ static void _print_reservation(reserve_info_t *resv_ptr, int width)
 	return;
 }
 
+/*
+ * Store the text printed for format list entry inx: as the column name in
+ * the header pass, else as the value of its column in the current row.
+ * Entries with no header (e.g. the %% prefix) get no column.
+ */
+static void _binary_field(int inx, bool header)
+{
+	if (header) {
+		if (print_cell && print_cell[0])
+			print_cols[inx] = columnar_add_column(
+				print_dump, print_cell, COLUMNAR_STRING);
+		else
+			print_cols[inx] = -1;
+	} else if (print_cols[inx] >= 0) {
+		columnar_set_str(print_dump, print_cols[inx], print_cell);
+	}
+	xfree(print_cell);
+}
+
+/* printf() to stdout, or to the current field's text with --binary */
+static int _out(const char *fmt, ...)
+{
+	char buf[256], *tmp;
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	if (!print_dump) {
+		len = vprintf(fmt, ap);
+		va_end(ap);
+		return len;
+	}
+	len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (len < 0)
+		return len;
+	if (len < sizeof(buf)) {
+		xstrcat(print_cell, buf);
+		return len;
+	}
+	tmp = xmalloc(len + 1);
+	va_start(ap, fmt);
+	vsnprintf(tmp, len + 1, fmt, ap);
+	va_end(ap);
+	xstrcat(print_cell, tmp);
+	xfree(tmp);
+	return len;
+}
+
 static int _print_str(const char *str, int width, bool right, bool cut_output)
 {
 	char format[64];
@@ -194,17 +281,17 @@ static int _print_str(const char *str, int width, bool right, bool cut_output)
 	}
 
 	if ((width == 0) || (cut_output == false)) {
-		if ((printed = printf(format, str)) < 0)
+		if ((printed = _out(format, str)) < 0)
 			return printed;
 	} else {
 		char temp[width + 1];
 		snprintf(temp, width + 1, format, str);
-		if ((printed = printf("%s",temp)) < 0)
+		if ((printed = _out("%s",temp)) < 0)
 			return printed;
 	}
 
 	while (printed++ < width)
-		printf(" ");
+		_out(" ");
 
 	return printed;
 }
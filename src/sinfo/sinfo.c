@@ -126,7 +126,7 @@ int main(int argc, char **argv)
 	}
 
 	while (1) {
-		if ((!params.no_header) &&
+		if (!params.no_header && !params.binary &&
 		    (params.iterate || params.verbose || params.long_output))
 			print_date();
 
@@ -157,7 +157,8 @@ static int _multi_cluster(List clusters)
 			first = false;
 		else
 			printf("\n");
-		printf("CLUSTER: %s\n", working_cluster_rec->name);
+		if (!params.binary)
+			printf("CLUSTER: %s\n", working_cluster_rec->name);
 		rc2 = _get_info(true, NULL);
 		rc = MAX(rc, rc2);
 	}
@@ -207,12 +208,12 @@ static int _get_info(bool clear_old, slurmdb_federation_rec_t *fed)
 		return SLURM_ERROR;
 
 	sort_sinfo_list(sinfo_list);
-	print_sinfo_list(sinfo_list);
+	rc = print_sinfo_list(sinfo_list);
 
 	FREE_NULL_LIST(node_info_msg_list);
 	FREE_NULL_LIST(part_info_msg_list);
 	FREE_NULL_LIST(sinfo_list);
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 /*
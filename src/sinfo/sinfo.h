@@ -159,6 +159,7 @@ struct sinfo_match_flags {
 struct sinfo_parameters {
 	bool all_flag;
 	bool bg_flag;
+	bool binary;
 	List clusters;
 	uint32_t cluster_flags;
 	uint32_t convert_flags;
@@ -4102,3 +4102,197 @@ job_failed:
 
 	return false;
 }
+
+/* Return the minutes a job with the TRES of tres_alloc_cnt can run before
+ * reaching one of the TRES minute limits of limits, INFINITE64 if none */
+static uint64_t _job_tres_mins_left(uint64_t *limits, uint64_t *tres_alloc_cnt)
+{
+	uint64_t mins = INFINITE64, tres_mins;
+	int i;
+
+	if (!limits)
+		return mins;
+
+	for (i = 0; i < slurmctld_tres_cnt; i++) {
+		if ((i == TRES_ARRAY_ENERGY) || !tres_alloc_cnt[i] ||
+		    (limits[i] == INFINITE64))
+			continue;
+		/* see job_tres_usage_mins in acct_policy_job_time_out() */
+		tres_mins = (limits[i] + tres_alloc_cnt[i] - 1) /
+			    tres_alloc_cnt[i];
+		mins = MIN(mins, tres_mins);
+	}
+
+	return mins;
+}
+
+extern time_t acct_policy_job_time_out_next(struct job_record *job_ptr)
+{
+	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
+	slurmdb_assoc_rec_t *assoc;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+				   READ_LOCK, NO_LOCK, NO_LOCK };
+	uint64_t mins = INFINITE64;
+
+	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS)
+	    || (accounting_enforce & ACCOUNTING_ENFORCE_SAFE)
+	    || !job_ptr->tres_alloc_cnt)
+		return 0;
+
+	assoc_mgr_lock(&locks);
+
+	/*
+	 * A limit of the QOS trumps that of the association, taking the
+	 * lowest of all of them can only make the job looked at too early.
+	 */
+	_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
+	if (qos_ptr_1)
+		mins = MIN(mins, _job_tres_mins_left(
+				   qos_ptr_1->max_tres_mins_pj_ctld,
+				   job_ptr->tres_alloc_cnt));
+	if (qos_ptr_2)
+		mins = MIN(mins, _job_tres_mins_left(
+				   qos_ptr_2->max_tres_mins_pj_ctld,
+				   job_ptr->tres_alloc_cnt));
+
+	assoc = job_ptr->assoc_ptr;
+	while (assoc) {
+		mins = MIN(mins, _job_tres_mins_left(assoc->max_tres_mins_ctld,
+						     job_ptr->tres_alloc_cnt));
+		assoc = assoc->usage->parent_assoc_ptr;
+		/* these limits don't apply to the root assoc */
+		if (assoc == assoc_mgr_root_assoc)
+			break;
+	}
+
+	assoc_mgr_unlock(&locks);
+
+	if (mins == INFINITE64)
+		return 0;
+	mins = MIN(mins, YEAR_MINUTES);
+
+	return job_ptr->start_time + job_ptr->tot_sus_time + (mins * 60);
+}
+
+/* Return true if the group TRES minutes or wall limit of a QOS or association
+ * is reached, the usage of both is in seconds */
+static bool _grp_time_limit_reached(uint64_t *grp_tres_mins_ctld,
+				    long double *usage_tres_raw,
+				    uint32_t grp_wall, double grp_used_wall)
+{
+	int i;
+
+	if ((grp_wall != INFINITE) && ((grp_used_wall / 60) >= grp_wall))
+		return true;
+	if (!grp_tres_mins_ctld || !usage_tres_raw)
+		return false;
+	for (i = 0; i < slurmctld_tres_cnt; i++) {
+		if ((grp_tres_mins_ctld[i] != INFINITE64) &&
+		    ((uint64_t)(usage_tres_raw[i] / 60.0) >=
+		     grp_tres_mins_ctld[i]))
+			return true;
+	}
+
+	return false;
+}
+
+extern bool acct_policy_grp_time_out_reached(bitstr_t **qos_bitmap,
+					     List *assoc_list)
+{
+	ListIterator itr;
+	slurmdb_qos_rec_t *qos_ptr;
+	slurmdb_assoc_rec_t *assoc;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	bool reached = false;
+
+	*qos_bitmap = NULL;
+	*assoc_list = NULL;
+
+	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS)
+	    || (accounting_enforce & ACCOUNTING_ENFORCE_SAFE))
+		return false;
+
+	assoc_mgr_lock(&locks);
+
+	if (assoc_mgr_qos_list) {
+		itr = list_iterator_create(assoc_mgr_qos_list);
+		while ((qos_ptr = list_next(itr))) {
+			if (!qos_ptr->usage ||
+			    !_grp_time_limit_reached(
+				    qos_ptr->grp_tres_mins_ctld,
+				    qos_ptr->usage->usage_tres_raw,
+				    qos_ptr->grp_wall,
+				    qos_ptr->usage->grp_used_wall))
+				continue;
+			if (!*qos_bitmap)
+				*qos_bitmap = bit_alloc(g_qos_count);
+			if (qos_ptr->id < bit_size(*qos_bitmap))
+				bit_set(*qos_bitmap, qos_ptr->id);
+			reached = true;
+		}
+		list_iterator_destroy(itr);
+	}
+
+	if (assoc_mgr_assoc_list) {
+		itr = list_iterator_create(assoc_mgr_assoc_list);
+		while ((assoc = list_next(itr))) {
+			/* these limits don't apply to the root assoc */
+			if ((assoc == assoc_mgr_root_assoc) || !assoc->usage ||
+			    !_grp_time_limit_reached(
+				    assoc->grp_tres_mins_ctld,
+				    assoc->usage->usage_tres_raw,
+				    assoc->grp_wall,
+				    assoc->usage->grp_used_wall))
+				continue;
+			if (!*assoc_list)
+				*assoc_list = list_create(NULL);
+			list_append(*assoc_list, assoc);
+			reached = true;
+		}
+		list_iterator_destroy(itr);
+	}
+
+	assoc_mgr_unlock(&locks);
+
+	return reached;
+}
+
+static int _find_ptr(void *x, void *key)
+{
+	return (x == key);
+}
+
+extern bool acct_policy_job_grp_reached(struct job_record *job_ptr,
+					bitstr_t *qos_bitmap, List assoc_list)
+{
+	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
+	slurmdb_assoc_rec_t *assoc;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	bool reached = false;
+
+	assoc_mgr_lock(&locks);
+
+	if (qos_bitmap) {
+		_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
+		if ((qos_ptr_1 && (qos_ptr_1->id < bit_size(qos_bitmap)) &&
+		     bit_test(qos_bitmap, qos_ptr_1->id)) ||
+		    (qos_ptr_2 && (qos_ptr_2->id < bit_size(qos_bitmap)) &&
+		     bit_test(qos_bitmap, qos_ptr_2->id)))
+			reached = true;
+	}
+
+	assoc = job_ptr->assoc_ptr;
+	while (!reached && assoc_list && assoc) {
+		if (list_find_first(assoc_list, _find_ptr, assoc))
+			reached = true;
+		assoc = assoc->usage->parent_assoc_ptr;
+		if (assoc == assoc_mgr_root_assoc)
+			break;
+	}
+
+	assoc_mgr_unlock(&locks);
+
+	return reached;
+}
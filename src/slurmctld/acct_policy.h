@@ -153,4 +153,30 @@ extern int acct_policy_update_pending_job(struct job_record *job_ptr);
  */
 extern bool acct_policy_job_time_out(struct job_record *job_ptr);
 
+/*
+ * acct_policy_job_time_out_next - Return the earliest time at which the job
+ *	could reach one of the TRES minutes per job limits of its QOS or
+ *	associations, 0 if none applies
+ */
+extern time_t acct_policy_job_time_out_next(struct job_record *job_ptr);
+
+/*
+ * acct_policy_grp_time_out_reached - Find the QOS and associations at or over
+ *	their group TRES minutes or wall limit, the only ones under which
+ *	acct_policy_job_time_out() times out jobs for the usage of the group.
+ * OUT qos_bitmap - ids of the QOS reached, NULL if none, FREE_NULL_BITMAP()
+ * OUT assoc_list - associations reached, NULL if none, FREE_NULL_LIST().
+ *	Their records are only compared, not looked at.
+ * RET true if any QOS or association reached a limit
+ */
+extern bool acct_policy_grp_time_out_reached(bitstr_t **qos_bitmap,
+					     List *assoc_list);
+
+/*
+ * acct_policy_job_grp_reached - Return true if the job runs under one of the
+ *	QOS or associations found by acct_policy_grp_time_out_reached()
+ */
+extern bool acct_policy_job_grp_reached(struct job_record *job_ptr,
+					bitstr_t *qos_bitmap, List assoc_list);
+
 #endif /* !_HAVE_ACCT_POLICY_H */
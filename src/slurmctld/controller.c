@@ -46,6 +46,7 @@
 
 #include <errno.h>
 #include <grp.h>
+#include <poll.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
@@ -80,6 +81,7 @@
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/slurm_jobcomp.h"
 #include "src/common/slurm_mcs.h"
+#include "src/common/slurm_mux_conn.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
@@ -128,6 +130,8 @@
 				 * check-in before we ping them */
 #define SHUTDOWN_WAIT     2	/* Time to wait for backup server shutdown */
 #define JOB_COUNT_INTERVAL 30   /* Time to update running job count */
+#define MUX_IDLE_TIMEOUT  300	/* Close idle multiplexed connections after
+				 * this many seconds */
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -225,6 +229,13 @@ typedef struct primary_thread_arg {
 	char *prog_type;
 } primary_thread_arg_t;
 
+/* A request read from a multiplexed connection */
+typedef struct mux_req {
+	connection_arg_t conn;
+	slurm_mux_conn_t *mux;
+	slurm_msg_t msg;
+} mux_req_t;
+
 static int          _accounting_cluster_ready();
 static int          _accounting_mark_all_nodes_down(char *reason);
 static void *       _assoc_cache_mgr(void *no_data);
@@ -237,6 +248,8 @@ static void         _init_config(void);
 static void         _init_pidfile(void);
 static int          _init_tres(void);
 static void         _kill_old_slurmctld(void);
+static void         _mux_dispatch(slurm_mux_conn_t *mux,
+				  connection_arg_t *conn, slurm_msg_t *msg);
 static void         _parse_commandline(int argc, char **argv);
 inline static int   _ping_backup_controller(void);
 static void *       _purge_files_thread(void *no_data);
@@ -245,6 +258,10 @@ static void         _remove_qos(slurmdb_qos_rec_t *rec);
 inline static int   _report_locks_set(void);
 static void         _run_primary_prog(bool primary_on);
 static void *       _service_connection(void *arg);
+static void         _service_mux_connection(connection_arg_t *conn,
+					    slurm_msg_t *msg);
+static void *       _service_mux_request(void *arg);
+static void         _set_async_logging(void);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(void);
 static void *       _slurmctld_background(void *no_data);
@@ -340,6 +357,8 @@ int main(int argc, char **argv)
 			  slurmctld_conf.slurmctld_logfile);
 		sched_log_alter(sched_log_opts, LOG_DAEMON,
 				slurmctld_conf.sched_logfile);
+		/* The log writer thread does not survive the fork */
+		_set_async_logging();
 		debug("sched: slurmctld starting");
 	} else {
 		slurmctld_config.daemonize = 0;
@@ -1266,6 +1285,7 @@ static void *_service_connection(void *arg)
 	connection_arg_t *conn = (connection_arg_t *) arg;
 	void *return_code = NULL;
 	slurm_msg_t msg;
+	bool mux = false;
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
@@ -1293,6 +1313,10 @@ static void *_service_connection(void *arg)
 			slurm_send_rc_msg(&msg, SLURM_PROTOCOL_VERSION_ERROR);
 		} else
 			info("_service_connection/slurm_receive_msg %m");
+	} else if (msg.flags & SLURM_MSG_MUX) {
+		/* our server thread count moves to msg's own thread */
+		_service_mux_connection(conn, &msg);
+		mux = true;
 	} else {
 		/* process the request */
 		slurmctld_req(&msg, conn);
@@ -1304,11 +1328,109 @@ static void *_service_connection(void *arg)
 cleanup:
 	slurm_free_msg_members(&msg);
 	xfree(arg);
-	server_thread_decr();
+	if (!mux)
+		server_thread_decr();
 
 	return return_code;
 }
 
+/* Hand msg to a new thread, which takes over the server thread count */
+static void _mux_dispatch(slurm_mux_conn_t *mux, connection_arg_t *conn,
+			  slurm_msg_t *msg)
+{
+	mux_req_t *req = xmalloc(sizeof(mux_req_t));
+
+	slurm_mux_conn_get(mux);
+	req->mux = mux;
+	req->conn.newsockfd = -1;	/* the connection is not the RPC's */
+	memcpy(&req->conn.cli_addr, &conn->cli_addr, sizeof(slurm_addr_t));
+	memcpy(&req->msg, msg, sizeof(slurm_msg_t));
+	slurm_msg_t_init(msg);
+
+	slurm_thread_create_detached(NULL, _service_mux_request, req);
+}
+
+/*
+ * _service_mux_connection - read requests multiplexed on conn, starting
+ *	with msg, until the client closes it, it is idle for MUX_IDLE_TIMEOUT
+ *	or we shut down. Each request is processed by a thread of its own,
+ *	whose replies carry the request's msg_index. The connection is closed
+ *	once the last of them is done.
+ */
+static void _service_mux_connection(connection_arg_t *conn, slurm_msg_t *msg)
+{
+	slurm_mux_conn_t *mux = slurm_mux_conn_create(conn->newsockfd);
+	struct pollfd pfd;
+	slurm_msg_t req;
+	int rc;
+
+	conn->newsockfd = -1;
+	fd_set_nonblocking(mux->fd);
+	pfd.fd = mux->fd;
+	pfd.events = POLLIN;
+
+	_mux_dispatch(mux, conn, msg);
+
+	while (!slurmctld_config.shutdown_time) {
+		if ((rc = poll(&pfd, 1, 1000)) < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			error("%s: poll: %m", __func__);
+			break;
+		}
+		if (rc == 0) {
+			if (slurm_mux_conn_idle(mux, MUX_IDLE_TIMEOUT))
+				break;
+			continue;
+		}
+
+		slurm_msg_t_init(&req);
+		req.flags |= SLURM_MSG_KEEP_BUFFER;
+		if (slurm_receive_msg(mux->fd, &req, 0) != 0) {
+			/* closed by the client or a bad message */
+			slurm_free_msg_members(&req);
+			break;
+		}
+		if (!_wait_for_server_thread()) {
+			slurm_free_msg_members(&req);
+			break;
+		}
+		_mux_dispatch(mux, conn, &req);
+	}
+
+	slurm_mux_conn_put(mux);
+}
+
+/*
+ * _service_mux_request - process one request of a multiplexed connection
+ * IN/OUT arg - a mux_req_t, freed upon completion
+ * RET - NULL
+ */
+static void *_service_mux_request(void *arg)
+{
+	mux_req_t *req = (mux_req_t *) arg;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "srvmux", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "srvmux");
+	}
+#endif
+	slurm_mux_conn_set_current(req->mux, req->msg.msg_index);
+	if (req->msg.msg_type == REQUEST_PERSIST_INIT) {
+		/* would take the connection away from the other requests */
+		slurm_send_rc_msg(&req->msg, ESLURM_NOT_SUPPORTED);
+	} else
+		slurmctld_req(&req->msg, &req->conn);
+	slurm_mux_conn_set_current(NULL, 0);
+
+	slurm_free_msg_members(&req->msg);
+	slurm_mux_conn_put(req->mux);
+	xfree(req);
+	server_thread_decr();
+
+	return NULL;
+}
+
 /* Increment slurmctld_config.server_thread_count and don't return
  * until its value is no larger than MAX_SERVER_THREADS,
  * RET true unless shutdown in progress */
@@ -1524,6 +1646,8 @@ static void _update_assoc(slurmdb_assoc_rec_t *rec)
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	job_time_limit_acct_changed();
+
 	lock_slurmctld(job_write_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
@@ -1576,6 +1700,8 @@ static void _update_qos(slurmdb_qos_rec_t *rec)
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	job_time_limit_acct_changed();
+
 	lock_slurmctld(job_write_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
@@ -2862,6 +2988,27 @@ static void _update_cred_key(void)
 				  slurmctld_conf.job_credential_private_key);
 }
 
+/*
+ * Log from a dedicated thread if SchedulerParameters=async_log_depth=# is
+ * set, so that RPC and scheduling threads never wait on log I/O.
+ * NOTE: READ lock_slurmctld config before entry
+ */
+static void _set_async_logging(void)
+{
+	char *tmp_ptr;
+	int depth = 0;
+
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.sched_params,
+				   "async_log_depth="))) {
+		depth = atoi(tmp_ptr + 16);
+		if (depth < 0) {
+			error("Invalid async_log_depth: %d", depth);
+			depth = 0;
+		}
+	}
+	log_set_async(depth);
+}
+
 /* Reset slurmctld logging based upon configuration parameters
  *   uses common slurmctld_conf data structure
  * NOTE: READ lock_slurmctld config before entry */
@@ -2920,6 +3067,8 @@ void update_logging(void)
 	sched_log_alter(sched_log_opts, LOG_DAEMON,
 			slurmctld_conf.sched_logfile);
 
+	_set_async_logging();
+
 	if (slurmctld_conf.slurmctld_logfile) {
 		rc = chown(slurmctld_conf.slurmctld_logfile,
 			   slurm_user_id, slurm_user_gid);
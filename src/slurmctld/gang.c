@@ -64,6 +64,8 @@ static pthread_cond_t  term_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t thread_flag_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t timeslicer_thread_id = (pthread_t) 0;
 static List preempt_job_list = (List) NULL;
+static List resume_job_list = (List) NULL;
+static List suspend_job_list = (List) NULL;
 
 /* timeslicer flags and structures */
 enum entity_type {
@@ -104,6 +106,8 @@ struct gs_part {
 	bitstr_t *active_resmap;
 	uint16_t *active_cpus;
 	uint16_t array_size;
+	struct gs_job **cycle_list;	/* scratch space for _cycle_job_list */
+	uint32_t cycle_list_size;
 	struct gs_part *next;
 };
 
@@ -326,6 +330,7 @@ static void _destroy_parts(void *x)
 	FREE_NULL_BITMAP(gs_part_ptr->active_resmap);
 	xfree(gs_part_ptr->active_cpus);
 	xfree(gs_part_ptr->job_list);
+	xfree(gs_part_ptr->cycle_list);
 	xfree(gs_part_ptr);
 }
 
@@ -415,7 +420,6 @@ static int _job_fits_in_active_row(struct job_record *job_ptr,
 {
 	job_resources_t *job_res = job_ptr->job_resrcs;
 	int count;
-	bitstr_t *job_map;
 	uint16_t job_gr_type;
 
 	if ((p_ptr->active_resmap == NULL) || (p_ptr->jobs_active == 0))
@@ -429,13 +433,10 @@ static int _job_fits_in_active_row(struct job_record *job_ptr,
 	}
 
 	/* job_gr_type == GS_NODE || job_gr_type == GS_CPU */
-	job_map = bit_copy(job_res->node_bitmap);
-	bit_and(job_map, p_ptr->active_resmap);
-	/* any set bits indicate contention for the same resource */
-	count = bit_set_count(job_map);
+	/* any overlapping bits indicate contention for the same resource */
+	count = bit_overlap(job_res->node_bitmap, p_ptr->active_resmap);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: _job_fits_in_active_row: %d bits conflict", count);
-	FREE_NULL_BITMAP(job_map);
 	if (count == 0)
 		return 1;
 	if (job_gr_type == GS_CPU) {
@@ -614,6 +615,34 @@ static void _preempt_job_list_del(void *x)
 	xfree(x);
 }
 
+/* Defer a gang suspend or resume until the end of the time slice, see
+ * _signal_job_dequeue() */
+static void _signal_job_queue(List signal_list, uint32_t job_id)
+{
+	uint32_t *tmp_id = xmalloc(sizeof(uint32_t));
+	*tmp_id = job_id;
+	list_append(signal_list, tmp_id);
+}
+
+/* Issue the suspend and resume requests collected during a time slice.
+ * All suspends are issued before any resume so that resources are released
+ * before being reused, regardless of which partition the jobs belong to.
+ * MUST BE CALLED OUTSIDE OF data_mutex lock */
+static void _signal_job_dequeue(bool resume)
+{
+	List signal_list = resume ? resume_job_list : suspend_job_list;
+	uint32_t *tmp_id;
+
+	xassert(signal_list);
+	while ((tmp_id = list_pop(signal_list))) {
+		if (resume)
+			_resume_job(*tmp_id);
+		else
+			(void) _suspend_job(*tmp_id);
+		xfree(tmp_id);
+	}
+}
+
 static void _preempt_job_queue(uint32_t job_id)
 {
 	uint32_t *tmp_id = xmalloc(sizeof(uint32_t));
@@ -911,6 +940,26 @@ static void _update_all_active_rows(void)
 	list_iterator_destroy(part_iterator);
 }
 
+/* rebuild the active rows affected by a change to the job set of the given
+ * partition: the partition itself plus every lower priority partition that
+ * may hold its shadows. Rows of other partitions do not depend upon p_ptr,
+ * so there is no need to rebuild them. */
+static void _update_active_rows_from(struct gs_part *p_ptr)
+{
+	ListIterator part_iterator;
+	struct gs_part *u_ptr;
+
+	/* Sort the partitions so shadows are adjusted top down */
+	list_sort(gs_part_list, _sort_partitions);
+
+	part_iterator = list_iterator_create(gs_part_list);
+	while ((u_ptr = (struct gs_part *) list_next(part_iterator))) {
+		if ((u_ptr == p_ptr) || (u_ptr->priority < p_ptr->priority))
+			_update_active_row(u_ptr, 1);
+	}
+	list_iterator_destroy(part_iterator);
+}
+
 /* remove the given job from the given partition
  * IN job_id - job to remove
  * IN p_ptr  - GS partition structure
@@ -1180,6 +1229,8 @@ extern void gs_init(void)
 	gs_fast_schedule = slurm_get_fast_schedule();
 	gr_type = _get_gr_type();
 	preempt_job_list = list_create(_preempt_job_list_del);
+	resume_job_list = list_create(_preempt_job_list_del);
+	suspend_job_list = list_create(_preempt_job_list_del);
 
 	/* load the physical resource count data */
 	_load_phys_res_cnt();
@@ -1220,6 +1271,8 @@ extern void gs_fini(void)
 	}
 
 	FREE_NULL_LIST(preempt_job_list);
+	FREE_NULL_LIST(resume_job_list);
+	FREE_NULL_LIST(suspend_job_list);
 
 	slurm_mutex_lock(&data_mutex);
 	FREE_NULL_LIST(gs_part_list);
@@ -1254,7 +1307,7 @@ extern void gs_job_start(struct job_record *job_ptr)
 		job_sig_state = _add_job_to_part(p_ptr, job_ptr);
 		/* if this job is running then check for preemption */
 		if (job_sig_state == GS_RESUME)
-			_update_all_active_rows();
+			_update_active_rows_from(p_ptr);
 	}
 	slurm_mutex_unlock(&data_mutex);
 
@@ -1322,9 +1375,9 @@ extern void gs_job_fini(struct job_record *job_ptr)
 
 	/* remove job from the partition */
 	_remove_job_from_part(job_ptr->job_id, p_ptr, true);
-	/* this job may have preempted other jobs, so
-	 * check by updating all active rows */
-	_update_all_active_rows();
+	/* this job may have preempted other jobs, so check by updating
+	 * this partition's row and those which it shadows */
+	_update_active_rows_from(p_ptr);
 	slurm_mutex_unlock(&data_mutex);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: leaving gs_job_fini");
@@ -1498,27 +1551,31 @@ static void _build_active_row(struct gs_part *p_ptr)
  */
 static void _cycle_job_list(struct gs_part *p_ptr)
 {
-	int i, j;
+	int i, j, k;
 	struct gs_job *j_ptr;
 	uint16_t preempt_mode;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: entering _cycle_job_list");
-	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
-			/* move this job to the back row and "deactivate" it */
-			j_ptr = p_ptr->job_list[i];
-			j_ptr->row_state = GS_NO_ACTIVE;
-			for (j = i; j+1 < p_ptr->num_jobs; j++) {
-				p_ptr->job_list[j] = p_ptr->job_list[j+1];
-			}
-			p_ptr->job_list[j] = j_ptr;
+	if (p_ptr->cycle_list_size < p_ptr->job_list_size) {
+		p_ptr->cycle_list_size = p_ptr->job_list_size;
+		xrealloc(p_ptr->cycle_list, p_ptr->cycle_list_size *
+			 sizeof(struct gs_job *));
+	}
+	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE.
+	 * Active jobs are moved to the back of the list in a single pass,
+	 * preserving their order among each other */
+	for (i = 0, j = 0, k = 0; i < p_ptr->num_jobs; i++) {
+		j_ptr = p_ptr->job_list[i];
+		if (j_ptr->row_state == GS_ACTIVE) {
+			p_ptr->cycle_list[k++] = j_ptr;
+		} else {
+			p_ptr->job_list[j++] = j_ptr;
 		}
-		if (p_ptr->job_list[i]->row_state == GS_FILLER)
-			p_ptr->job_list[i]->row_state = GS_NO_ACTIVE;
-
+		j_ptr->row_state = GS_NO_ACTIVE;
 	}
+	for (i = 0; i < k; i++)
+		p_ptr->job_list[j++] = p_ptr->cycle_list[i];
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: _cycle_job_list reordered job list:");
 	/* Rebuild the active row. */
@@ -1542,7 +1599,8 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 			    (preempt_mode != PREEMPT_MODE_SUSPEND)) {
 				_preempt_job_queue(j_ptr->job_id);
 			} else
-				_suspend_job(j_ptr->job_id);
+				_signal_job_queue(suspend_job_list,
+						  j_ptr->job_id);
 			j_ptr->sig_state = GS_SUSPEND;
 			_clear_shadow(j_ptr);
 		}
@@ -1558,7 +1616,7 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 		    		info("gang: _cycle_job_list: resuming job %u",
 				     j_ptr->job_id);
 			}
-			_resume_job(j_ptr->job_id);
+			_signal_job_queue(resume_job_list, j_ptr->job_id);
 			j_ptr->sig_state = GS_RESUME;
 			_cast_shadow(j_ptr, p_ptr->priority);
 		}
@@ -1619,8 +1677,12 @@ static void *_timeslicer_thread(void *arg)
 		list_iterator_destroy(part_iterator);
 		slurm_mutex_unlock(&data_mutex);
 
-		/* Preempt jobs that were formerly only suspended */
+		/* Signal the jobs cycled out of and into the active rows.
+		 * Preempt jobs that were formerly only suspended before
+		 * resuming any job which may reuse their resources */
+		_signal_job_dequeue(false); /* MUST BE OUTSIDE data_mutex lock */
 		_preempt_job_dequeue();	/* MUST BE OUTSIDE data_mutex lock */
+		_signal_job_dequeue(true); /* MUST BE OUTSIDE data_mutex lock */
 		unlock_slurmctld(job_write_lock);
 	}
 
@@ -139,6 +139,27 @@ typedef struct {
 	uid_t     uid;
 } _foreach_pack_job_info_t;
 
+/* When job_time_limit() next needs to look at a job */
+typedef struct {
+	time_t when;
+	struct job_record *job_ptr;
+} limit_timer_t;
+
+/* QOS and associations at their group limits, see _job_acct_check() */
+typedef struct {
+	bitstr_t *qos_bitmap;
+	List assoc_list;
+} acct_grp_reached_t;
+
+/* Running and suspended jobs of one QOS, see running_job_add() */
+typedef struct {
+	struct job_record **jobs;
+	int cnt;
+	int size;
+	bitstr_t *node_bitmap;	/* covers the nodes of all jobs */
+	bool nodes_stale;	/* rebuild node_bitmap before use */
+} run_bucket_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -161,6 +182,15 @@ static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
 static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
+static run_bucket_t *run_buckets = NULL;	/* by QOS id, 0 if none */
+static int      run_bucket_cnt = 0;
+static pthread_mutex_t run_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static limit_timer_t *limit_heap = NULL;	/* min-heap by check time */
+static int      limit_heap_cnt = 0;
+static int      limit_heap_size = 0;
+static bool     limit_check_all = false;
+static bool     limit_acct_changed = true;	/* usage or limits changed */
+static pthread_mutex_t limit_heap_lock = PTHREAD_MUTEX_INITIALIZER;
 static int	select_serial = -1;
 
 /* Local functions */
@@ -2407,6 +2437,8 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			       &job_ptr->gres_detail_str);
 	job_ptr->clusters     = clusters;
 	job_ptr->fed_details  = job_fed_details;
+	if (IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr))
+		running_job_add(job_ptr);
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -2923,6 +2955,161 @@ void _add_job_array_hash(struct job_record *job_ptr)
 	job_array_hash_t[inx] = job_ptr;
 }
 
+/* Remove a job from the running job index, run_index_lock must be held */
+static void _run_index_remove(struct job_record *job_ptr)
+{
+	run_bucket_t *bucket;
+	int inx;
+
+	if (!job_ptr->run_inx)
+		return;
+
+	bucket = &run_buckets[job_ptr->run_qos_id];
+	inx = job_ptr->run_inx - 1;
+	bucket->jobs[inx] = bucket->jobs[--bucket->cnt];
+	bucket->jobs[inx]->run_inx = inx + 1;
+	job_ptr->run_inx = 0;
+	bucket->nodes_stale = true;
+}
+
+/*
+ * Drop the jobs of a bucket no longer running or suspended and rebuild its
+ * node_bitmap, run_index_lock must be held
+ */
+static void _run_bucket_refresh(run_bucket_t *bucket)
+{
+	struct job_record *job_ptr;
+	int i = 0;
+
+	FREE_NULL_BITMAP(bucket->node_bitmap);
+	bucket->node_bitmap = bit_alloc(node_record_count);
+	while (i < bucket->cnt) {
+		job_ptr = bucket->jobs[i];
+		if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr)) {
+			_run_index_remove(job_ptr);
+			continue;
+		}
+		if (!job_ptr->node_bitmap)
+			;
+		else if (bit_size(job_ptr->node_bitmap) == node_record_count)
+			bit_or(bucket->node_bitmap, job_ptr->node_bitmap);
+		else	/* not rebuilt since reconfig yet */
+			bit_nset(bucket->node_bitmap, 0, node_record_count - 1);
+		i++;
+	}
+	bucket->nodes_stale = false;
+}
+
+/*
+ * Add a job that started running or was suspended, or whose QOS or nodes
+ * changed while running, to the running job index.
+ * Jobs that end are dropped lazily by running_job_foreach().
+ */
+extern void running_job_add(struct job_record *job_ptr)
+{
+	run_bucket_t *bucket;
+	uint32_t qos_id = job_ptr->qos_id;
+
+	slurm_mutex_lock(&run_index_lock);
+	if (job_ptr->run_inx && (job_ptr->run_qos_id != qos_id))
+		_run_index_remove(job_ptr);
+	if (qos_id >= run_bucket_cnt) {
+		xrealloc(run_buckets, sizeof(run_bucket_t) * (qos_id + 1));
+		run_bucket_cnt = qos_id + 1;
+	}
+	bucket = &run_buckets[qos_id];
+	if (!job_ptr->run_inx) {
+		if (bucket->cnt >= bucket->size) {
+			bucket->size = MAX(16, bucket->size * 2);
+			xrealloc(bucket->jobs,
+				 sizeof(struct job_record *) * bucket->size);
+		}
+		bucket->jobs[bucket->cnt++] = job_ptr;
+		job_ptr->run_inx = bucket->cnt;
+		job_ptr->run_qos_id = qos_id;
+	}
+	if (bucket->nodes_stale)
+		;
+	else if (job_ptr->node_bitmap && bucket->node_bitmap &&
+		 (bit_size(bucket->node_bitmap) ==
+		  bit_size(job_ptr->node_bitmap)))
+		bit_or(bucket->node_bitmap, job_ptr->node_bitmap);
+	else
+		bucket->nodes_stale = true;
+	slurm_mutex_unlock(&run_index_lock);
+	job_time_limit_check(job_ptr);
+}
+
+/* Remove a job record about to be freed from the running job index */
+extern void running_job_remove(struct job_record *job_ptr)
+{
+	slurm_mutex_lock(&run_index_lock);
+	_run_index_remove(job_ptr);
+	slurm_mutex_unlock(&run_index_lock);
+}
+
+/* Rebuild the node summaries of the running job index after the node
+ * table changed */
+extern void running_job_index_reset(void)
+{
+	int i;
+
+	slurm_mutex_lock(&run_index_lock);
+	for (i = 0; i < run_bucket_cnt; i++)
+		run_buckets[i].nodes_stale = true;
+	slurm_mutex_unlock(&run_index_lock);
+}
+
+/*
+ * Call f() for each running or suspended job
+ * qos_bitmap IN - only jobs with a QOS whose id is set in it, NULL for all
+ * node_bitmap IN - only jobs with nodes in it, NULL for all
+ * NOTE: f() must not add or remove jobs from the index
+ */
+extern void running_job_foreach(bitstr_t *qos_bitmap, bitstr_t *node_bitmap,
+				void (*f) (struct job_record *job_ptr,
+					   void *arg),
+				void *arg)
+{
+	struct job_record *job_ptr;
+	run_bucket_t *bucket;
+	int qos_id, i;
+
+	slurm_mutex_lock(&run_index_lock);
+	for (qos_id = 0; qos_id < run_bucket_cnt; qos_id++) {
+		bucket = &run_buckets[qos_id];
+		if (!bucket->cnt)
+			continue;
+		if (qos_bitmap && ((qos_id >= bit_size(qos_bitmap)) ||
+				   !bit_test(qos_bitmap, qos_id)))
+			continue;
+		if (bucket->nodes_stale || !bucket->node_bitmap ||
+		    (bit_size(bucket->node_bitmap) != node_record_count))
+			_run_bucket_refresh(bucket);
+		if (node_bitmap &&
+		    (bit_size(node_bitmap) == bit_size(bucket->node_bitmap)) &&
+		    !bit_overlap(bucket->node_bitmap, node_bitmap))
+			continue;
+
+		i = 0;
+		while (i < bucket->cnt) {
+			job_ptr = bucket->jobs[i];
+			if (!IS_JOB_RUNNING(job_ptr) &&
+			    !IS_JOB_SUSPENDED(job_ptr)) {
+				_run_index_remove(job_ptr);
+				continue;
+			}
+			i++;
+			if (node_bitmap &&
+			    (!job_ptr->node_bitmap ||
+			     !bit_overlap(job_ptr->node_bitmap, node_bitmap)))
+				continue;
+			(*f)(job_ptr, arg);
+		}
+	}
+	slurm_mutex_unlock(&run_index_lock);
+}
+
 /* For the job array data structure, build the string representation of the
  * bitmap.
  * NOTE: bit_fmt_hexmask() is far more scalable than bit_fmt(). */
@@ -4350,6 +4537,8 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	job_ptr_pend->details  = save_details;
 	job_ptr_pend->step_list = save_step_list;
 	job_ptr_pend->db_index = save_db_index;
+	job_ptr_pend->run_inx = 0;
+	job_ptr_pend->limit_inx = 0;
 
 	job_ptr_pend->prio_factors = save_prio_factors;
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
@@ -8821,8 +9010,290 @@ static bool _pack_configuring_test(struct job_record *job_ptr)
 	return result;
 }
 
+/* Move the timer at inx toward the root or leaves until the heap is valid,
+ * limit_heap_lock must be held */
+static void _limit_heap_fix(int inx)
+{
+	limit_timer_t tmp = limit_heap[inx];
+	int child;
+
+	while (inx > 0) {
+		int parent = (inx - 1) / 2;
+		if (limit_heap[parent].when <= tmp.when)
+			break;
+		limit_heap[inx] = limit_heap[parent];
+		limit_heap[inx].job_ptr->limit_inx = inx + 1;
+		inx = parent;
+	}
+	while ((child = (inx * 2) + 1) < limit_heap_cnt) {
+		if (((child + 1) < limit_heap_cnt) &&
+		    (limit_heap[child + 1].when < limit_heap[child].when))
+			child++;
+		if (tmp.when <= limit_heap[child].when)
+			break;
+		limit_heap[inx] = limit_heap[child];
+		limit_heap[inx].job_ptr->limit_inx = inx + 1;
+		inx = child;
+	}
+	limit_heap[inx] = tmp;
+	tmp.job_ptr->limit_inx = inx + 1;
+}
+
+/* Set when the job is next looked at, limit_heap_lock must be held */
+static void _limit_heap_set(struct job_record *job_ptr, time_t when)
+{
+	int inx;
+
+	if (job_ptr->limit_inx) {
+		inx = job_ptr->limit_inx - 1;
+	} else {
+		if (limit_heap_cnt >= limit_heap_size) {
+			limit_heap_size = MAX(1024, limit_heap_size * 2);
+			xrealloc(limit_heap,
+				 sizeof(limit_timer_t) * limit_heap_size);
+		}
+		inx = limit_heap_cnt++;
+		limit_heap[inx].job_ptr = job_ptr;
+	}
+	limit_heap[inx].when = when;
+	_limit_heap_fix(inx);
+}
+
+/* Remove a job from the heap, limit_heap_lock must be held */
+static void _limit_heap_remove(struct job_record *job_ptr)
+{
+	int inx;
+
+	if (!job_ptr->limit_inx)
+		return;
+	inx = job_ptr->limit_inx - 1;
+	job_ptr->limit_inx = 0;
+	if (inx == --limit_heap_cnt)
+		return;
+	limit_heap[inx] = limit_heap[limit_heap_cnt];
+	_limit_heap_fix(inx);
+}
+
+/* Return true if a job is due to be looked at by now */
+static bool _limit_heap_due(time_t now)
+{
+	bool due;
+
+	slurm_mutex_lock(&limit_heap_lock);
+	due = limit_check_all ||
+	      (limit_heap_cnt && (limit_heap[0].when <= now));
+	slurm_mutex_unlock(&limit_heap_lock);
+
+	return due;
+}
+
+/* Pop a job due to be looked at by now, NULL if none */
+static struct job_record *_limit_heap_pop(time_t now)
+{
+	struct job_record *job_ptr = NULL;
+	int i;
+
+	slurm_mutex_lock(&limit_heap_lock);
+	if (limit_check_all) {
+		for (i = 0; i < limit_heap_cnt; i++)
+			limit_heap[i].when = 0;
+		limit_check_all = false;
+	}
+	if (limit_heap_cnt && (limit_heap[0].when <= now)) {
+		job_ptr = limit_heap[0].job_ptr;
+		_limit_heap_remove(job_ptr);
+	}
+	slurm_mutex_unlock(&limit_heap_lock);
+
+	return job_ptr;
+}
+
+/*
+ * Look at a running or suspended job on the next job_time_limit() call,
+ * used when its start, end or limits change
+ */
+extern void job_time_limit_check(struct job_record *job_ptr)
+{
+	slurm_mutex_lock(&limit_heap_lock);
+	_limit_heap_set(job_ptr, 0);
+	slurm_mutex_unlock(&limit_heap_lock);
+}
+
+/*
+ * Look at all running and suspended jobs on the next job_time_limit() call,
+ * used when configuration, partitions or reservations change
+ */
+extern void job_time_limit_check_all(void)
+{
+	slurm_mutex_lock(&limit_heap_lock);
+	limit_check_all = true;
+	slurm_mutex_unlock(&limit_heap_lock);
+}
+
+/*
+ * Test the running and suspended jobs against the group limits of their
+ * associations and QOS on the next job_time_limit() call, used when the usage
+ * of associations and QOS was updated or their limits changed
+ */
+extern void job_time_limit_acct_changed(void)
+{
+	slurm_mutex_lock(&limit_heap_lock);
+	limit_acct_changed = true;
+	slurm_mutex_unlock(&limit_heap_lock);
+}
+
+/* Remove a job record about to be freed from the time limit heap */
+static void _job_time_limit_remove(struct job_record *job_ptr)
+{
+	slurm_mutex_lock(&limit_heap_lock);
+	_limit_heap_remove(job_ptr);
+	slurm_mutex_unlock(&limit_heap_lock);
+}
+
+/*
+ * Return the earliest time at which one of the tests of job_time_limit()
+ * could act on a running or suspended job, or now + 1 if it must be looked
+ * at every time. Group association and QOS limits are left to
+ * _job_acct_check().
+ */
+static time_t _job_time_limit_next(struct job_record *job_ptr, time_t now,
+				   uint32_t resv_over_run)
+{
+	time_t next = now + JOB_TIME_CHECK_MAX, acct_next;
+	ListIterator step_iterator;
+	struct step_record *step_ptr;
+
+	if (IS_JOB_CONFIGURING(job_ptr) || _pack_configuring_test(job_ptr))
+		return now + 1;		/* depends upon state */
+
+	if (job_ptr->preempt_time) {
+		if (job_ptr->warn_time && !(job_ptr->warn_flags & WARN_SENT))
+			next = MIN(next, job_ptr->end_time -
+				   job_ptr->warn_time - PERIODIC_TIMEOUT);
+		next = MIN(next, job_ptr->end_time);
+		return MAX(next, now + 1);
+	}
+
+	if ((acct_next = acct_policy_job_time_out_next(job_ptr)))
+		next = MIN(next, acct_next);
+
+	if (slurmctld_conf.inactive_limit &&
+	    (job_ptr->batch_flag == 0) && job_ptr->other_port &&
+	    job_ptr->part_ptr &&
+	    !(job_ptr->part_ptr->flags & PART_FLAG_ROOT_ONLY)) {
+		next = MIN(next, job_ptr->time_last_active +
+			   (slurmctld_conf.inactive_limit * 4 / 3) +
+			   slurmctld_conf.msg_timeout + 1);
+	}
+
+	if (job_ptr->time_limit != INFINITE) {
+		time_t limit_secs = (time_t) job_ptr->time_limit * 60;
+
+		if (job_ptr->warn_time && !(job_ptr->warn_flags & WARN_SENT))
+			next = MIN(next, job_ptr->end_time -
+				   job_ptr->warn_time - PERIODIC_TIMEOUT);
+		if (job_ptr->mail_type & MAIL_JOB_TIME50)
+			next = MIN(next, job_ptr->end_time - limit_secs / 2);
+		if (job_ptr->mail_type & MAIL_JOB_TIME80)
+			next = MIN(next, job_ptr->end_time - limit_secs / 5);
+		if (job_ptr->mail_type & MAIL_JOB_TIME90)
+			next = MIN(next, job_ptr->end_time - limit_secs / 10);
+	}
+
+	if (job_ptr->resv_ptr &&
+	    !(job_ptr->resv_ptr->flags & RESERVE_FLAG_FLEX))
+		next = MIN(next, job_ptr->resv_ptr->end_time +
+			   resv_over_run + 1);
+
+	if (job_ptr->step_list && IS_JOB_RUNNING(job_ptr)) {
+		step_iterator = list_iterator_create(job_ptr->step_list);
+		while ((step_ptr = list_next(step_iterator))) {
+			if ((step_ptr->state != JOB_RUNNING) ||
+			    (step_ptr->time_limit == INFINITE) ||
+			    (step_ptr->time_limit == NO_VAL))
+				continue;
+			next = MIN(next, step_ptr->start_time +
+				   step_ptr->tot_sus_time +
+				   ((time_t) step_ptr->time_limit * 60));
+		}
+		list_iterator_destroy(step_iterator);
+	}
+
+	/*
+	 * From here on srun is warned of the pending timeout on every call
+	 * and the job is killed once past its over time limit.
+	 */
+	next = MIN(next, job_ptr->end_time - (PERIODIC_TIMEOUT * 2));
+
+	return MAX(next, now + 1);
+}
+
+/* Make a job under a QOS or association at its group limits due */
+static void _job_acct_due(struct job_record *job_ptr, void *arg)
+{
+	acct_grp_reached_t *reached = (acct_grp_reached_t *) arg;
+
+	if (!acct_policy_job_grp_reached(job_ptr, reached->qos_bitmap,
+					 reached->assoc_list))
+		return;
+	slurm_mutex_lock(&limit_heap_lock);
+	_limit_heap_set(job_ptr, 0);
+	slurm_mutex_unlock(&limit_heap_lock);
+}
+
+static int _part_qos_reached(void *x, void *key)
+{
+	struct part_record *part_ptr = (struct part_record *) x;
+	bitstr_t *qos_bitmap = (bitstr_t *) key;
+
+	return (part_ptr->qos_ptr &&
+		(part_ptr->qos_ptr->id < bit_size(qos_bitmap)) &&
+		bit_test(qos_bitmap, part_ptr->qos_ptr->id));
+}
+
+/*
+ * Test the running and suspended jobs against the group TRES minute and wall
+ * limits of their associations and QOS, once the usage or limits changed,
+ * see job_time_limit_acct_changed(). Only the jobs under a QOS or association
+ * at one of these limits are made due, to be timed out by the loop of
+ * job_time_limit(). The TRES minute limits per job are in the heap, see
+ * _job_time_limit_next().
+ */
+static void _job_acct_check(void)
+{
+	acct_grp_reached_t reached;
+	bitstr_t *qos_filter;
+	bool changed;
+
+	slurm_mutex_lock(&limit_heap_lock);
+	changed = limit_acct_changed;
+	limit_acct_changed = false;
+	slurm_mutex_unlock(&limit_heap_lock);
+
+	if (!changed ||
+	    !acct_policy_grp_time_out_reached(&reached.qos_bitmap,
+					      &reached.assoc_list))
+		return;
+
+	/*
+	 * The running job index is by the QOS of the job, use it unless an
+	 * association or the QOS of a partition is at its limits
+	 */
+	qos_filter = reached.qos_bitmap;
+	if (reached.assoc_list ||
+	    list_find_first(part_list, _part_qos_reached, reached.qos_bitmap))
+		qos_filter = NULL;
+	running_job_foreach(qos_filter, NULL, _job_acct_due, &reached);
+
+	FREE_NULL_BITMAP(reached.qos_bitmap);
+	FREE_NULL_LIST(reached.assoc_list);
+}
+
 /*
  * job_time_limit - terminate jobs which have exceeded their time limit
+ *	Only running and suspended jobs whose next event is due are looked at,
+ *	see _job_time_limit_next(), or under a QOS or association at its
+ *	group TRES minutes or wall limit, see _job_acct_check().
  * global: job_list - pointer global job list
  *	last_job_update - time of last job table update
  */
@@ -8857,10 +9328,32 @@ void job_time_limit(void)
 	uint8_t prolog;
 #endif
 
-	job_iterator = list_iterator_create(job_list);
+	/*
+	 * Features have been changed on some node, make jobs eligible
+	 * to run and test to see if they can run now
+	 */
+	if (node_features_updated) {
+		job_iterator = list_iterator_create(job_list);
+		while ((job_ptr = list_next(job_iterator))) {
+			if ((job_ptr->state_reason == FAIL_BAD_CONSTRAINTS) &&
+			    IS_JOB_PENDING(job_ptr) &&
+			    (job_ptr->priority == 0)) {
+				job_ptr->state_reason = WAIT_NO_REASON;
+				set_job_prio(job_ptr);
+				last_job_update = now;
+			}
+		}
+		list_iterator_destroy(job_iterator);
+		node_features_updated = false;
+	}
+
+	_job_acct_check();
+
 	START_TIMER;
-	while ((job_ptr = list_next(job_iterator))) {
+	while ((job_ptr = _limit_heap_pop(now))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
+		if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))
+			continue;
 		job_test_count++;
 
 #ifndef HAVE_BG
@@ -8891,29 +9384,18 @@ void job_time_limit(void)
 		}
 #endif
 
-		/*
-		 * Features have been changed on some node, make job eligiable
-		 * to run and test to see if it can run now
-		 */
-		if (node_features_updated &&
-		    (job_ptr->state_reason == FAIL_BAD_CONSTRAINTS) &&
-		    IS_JOB_PENDING(job_ptr) && (job_ptr->priority == 0)) {
-			job_ptr->state_reason = WAIT_NO_REASON;
-			set_job_prio(job_ptr);
-			last_job_update = now;
-		}
-
 		if (_pack_configuring_test(job_ptr))
-			continue;
+			goto time_check;
 
 		if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))
 			continue;
 
 		/*
 		 * everything above here is considered "quick", and skips the
-		 * timeout at the bottom of the loop by using a continue.
-		 * everything below is considered "slow", and needs to jump to
-		 * time_check before the next job is tested
+		 * timeout at the bottom of the loop by using a continue for
+		 * jobs no longer running. everything below is considered
+		 * "slow", and needs to jump to time_check before the next job
+		 * is tested, which also sets when the job is next looked at
 		 */
 		if (job_ptr->preempt_time &&
 		    (IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr))) {
@@ -9049,9 +9531,7 @@ void job_time_limit(void)
 		    (list_count(job_ptr->step_list) > 0))
 			check_job_step_time_limit(job_ptr, now);
 
-		acct_policy_job_time_out(job_ptr);
-
-		if (job_ptr->state_reason == FAIL_TIMEOUT) {
+		if (acct_policy_job_time_out(job_ptr)) {
 			last_job_update = now;
 			_job_timed_out(job_ptr);
 			xfree(job_ptr->state_desc);
@@ -9071,14 +9551,23 @@ void job_time_limit(void)
 		 *
 		 * This test happens last, as job_ptr may be pointing to a job
 		 * that would be deleted by a separate thread when the job_write
-		 * lock is released. However, list_next itself is thread safe,
-		 * and can be used again once the locks are reacquired.
-		 * list_peek_next is used in the unlikely event the timer has
-		 * expired just as the end of the job_list is reached.
+		 * lock is released. Such a job is removed from the heap when
+		 * its record is freed, so the heap can be used again once the
+		 * locks are reacquired. _limit_heap_due is used in the
+		 * unlikely event the timer has expired just as the last due
+		 * job is tested.
 		 */
 time_check:
+		if (IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr)) {
+			time_t next = _job_time_limit_next(job_ptr, now,
+							   resv_over_run);
+			slurm_mutex_lock(&limit_heap_lock);
+			_limit_heap_set(job_ptr, next);
+			slurm_mutex_unlock(&limit_heap_lock);
+		}
+
 		/* Use a hard-coded 3 second timeout, with a 1 second sleep. */
-		if (slurm_delta_tv(&tv1) >= 3000000 && list_peek_next(job_iterator) ) {
+		if (slurm_delta_tv(&tv1) >= 3000000 && _limit_heap_due(now)) {
 			END_TIMER;
 			debug("%s: yielding locks after testing"
 			      " %d jobs, %s",
@@ -9090,8 +9579,6 @@ time_check:
 			job_test_count = 0;
 		}
 	}
-	list_iterator_destroy(job_iterator);
-	node_features_updated = false;
 }
 
 extern void job_set_req_tres(
@@ -9437,6 +9924,8 @@ static void _list_delete_job(void *job_entry)
 
 	/* Remove the record from job hash table */
 	_remove_job_hash(job_ptr, JOB_HASH_JOB);
+	running_job_remove(job_ptr);
+	_job_time_limit_remove(job_ptr);
 
 	if (job_ptr->array_recs) {
 		job_array_size = MAX(1, job_ptr->array_recs->task_cnt);
@@ -11155,6 +11644,7 @@ void reset_job_bitmaps(void)
 	bool gang_flag = false;
 	static uint32_t cr_flag = NO_VAL;
 
+	running_job_index_reset();
 	xassert(job_list);
 
 	if (cr_flag == NO_VAL) {
@@ -12513,6 +13003,8 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 		job_ptr->qos_id = new_qos_ptr->id;
 		job_ptr->qos_ptr = new_qos_ptr;
 		job_ptr->limit_set.qos = acct_policy_limit_set.qos;
+		if (job_ptr->run_inx)
+			running_job_add(job_ptr);
 
 		info("%s: setting QOS to %s for job_id %u",
 		     __func__, new_qos_ptr->name, job_ptr->job_id);
@@ -13423,6 +13915,7 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 						     orig_job_node_bitmap);
 				(void) gs_job_fini(job_ptr);
 				(void) gs_job_start(expand_job_ptr);
+				running_job_add(expand_job_ptr);
 			}
 			bit_free(orig_job_node_bitmap);
 			job_post_resize_acctg(job_ptr);
@@ -14045,6 +14538,10 @@ fini:
 	    xstrcmp(slurmctld_conf.priority_type, "priority/basic"))
 		set_job_prio(job_ptr);
 
+	/* Time limit, end time or signal/mail options may have changed */
+	if (IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr))
+		job_time_limit_check(job_ptr);
+
 	if ((error_code == SLURM_SUCCESS) &&
 	    fed_mgr_fed_rec &&
 	    job_ptr->fed_details && fed_mgr_is_origin_job(job_ptr)) {
@@ -15397,6 +15894,8 @@ void batch_requeue_fini(struct job_record  *job_ptr)
 /* job_fini - free all memory associated with job records */
 void job_fini (void)
 {
+	int i;
+
 	FREE_NULL_LIST(job_list);
 	xfree(job_hash);
 	xfree(job_array_hash_j);
@@ -15404,6 +15903,14 @@ void job_fini (void)
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
+	for (i = 0; i < run_bucket_cnt; i++) {
+		xfree(run_buckets[i].jobs);
+		FREE_NULL_BITMAP(run_buckets[i].node_bitmap);
+	}
+	xfree(run_buckets);
+	run_bucket_cnt = 0;
+	xfree(limit_heap);
+	limit_heap_cnt = limit_heap_size = 0;
 }
 
 /* Record the start of one job array task */
@@ -16175,6 +16682,7 @@ static int _job_suspend_op(struct job_record *job_ptr, uint16_t op,
 
 	job_ptr->time_last_active = now;
 	job_ptr->suspend_time = now;
+	job_time_limit_check(job_ptr);
 	jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
 
 	return rc;
@@ -1372,6 +1372,7 @@ extern int update_part(update_part_msg_t * part_desc, bool create_flag)
 	}
 
 	last_part_update = time(NULL);
+	job_time_limit_check_all();	/* OverTimeLimit may change */
 
 	if (part_desc->billing_weights_str &&
 	    set_partition_billing_weights(part_desc->billing_weights_str,
@@ -230,7 +230,7 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 				      bool *run_scheduler,
 				      List msg_list_in,
 				      struct timeval *start_tv,
-				      int timeout);
+				      int timeout, int level);
 static void  _slurm_rpc_assoc_mgr_info(slurm_msg_t * msg);
 static void  _slurm_rpc_persist_init(slurm_msg_t *msg, connection_arg_t *arg);
 
@@ -6681,7 +6681,7 @@ static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 	gettimeofday(&start_tv, NULL);
 	_slurm_rpc_comp_msg_list(comp_msg, &run_scheduler,
 				 comp_resp_msg.msg_list, &start_tv,
-				 sched_timeout);
+				 sched_timeout, 0);
 	unlock_slurmctld(job_write_lock);
 	_throttle_fini(&active_rpc_cnt);
 
@@ -6715,11 +6715,15 @@ static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 	}
 }
 
+/*
+ * level IN - nesting level of comp_msg, 0 if sent to slurmctld directly,
+ *	      only used for statistics
+ */
 static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 				      bool *run_scheduler,
 				      List msg_list_in,
 				      struct timeval *start_tv,
-				      int timeout)
+				      int timeout, int level)
 {
 	ListIterator itr;
 	slurm_msg_t *next_msg;
@@ -6733,8 +6737,13 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 
 	START_TIMER;
 
+	slurmctld_diag_stats.aggr_comp_cnt[MIN(level,
+					       DIAG_AGGR_LEVELS - 1)]++;
+
 	itr = list_iterator_create(comp_msg->msg_list);
 	while ((next_msg = list_next(itr))) {
+		if (next_msg->msg_type != MESSAGE_COMPOSITE)
+			slurmctld_diag_stats.aggr_msg_cnt++;
 		if (slurm_delta_tv(start_tv) >= timeout) {
 			END_TIMER;
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_ROUTE)
@@ -6766,7 +6775,7 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 				     list_count(ncomp_msg->msg_list) : 0);
 			_slurm_rpc_comp_msg_list(ncomp_msg, run_scheduler,
 						 comp_resp_msg->msg_list,
-						 start_tv, timeout);
+						 start_tv, timeout, level + 1);
 			if (list_count(comp_resp_msg->msg_list)) {
 				slurm_msg_t *resp_msg =
 					xmalloc_nz(sizeof(slurm_msg_t));
@@ -1384,6 +1384,7 @@ int read_slurm_conf(int recover, bool reconfig)
 	if (reconfig && (slurm_mcs_reconfig() != SLURM_SUCCESS))
 		fatal("Failed to reconfigure mcs plugin");
 
+	job_time_limit_check_all();
 	slurmctld_conf.last_update = time(NULL);
 	END_TIMER2("read_slurm_conf");
 	return error_code;
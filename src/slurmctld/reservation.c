@@ -100,6 +100,32 @@ time_t    last_resv_update = (time_t) 0;
 List      resv_list = (List) NULL;
 uint32_t  top_suffix = 0;
 
+/*
+ * Index of resv_list by name and by time, rebuilt when used after any change
+ * to the reservations. The interval array is sorted by start time and each
+ * element holds the latest end time of the subtree it is the middle of, so
+ * it forms an implicit interval tree. TIME_FLOAT reservations move with the
+ * current time and are kept apart.
+ */
+typedef struct {
+	time_t start;		/* earliest of start_time and start_time_first */
+	time_t end;
+	time_t max_end;		/* latest end in this subtree */
+	int order;		/* position in resv_list */
+} resv_interval_t;
+
+static pthread_mutex_t resv_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool resv_index_stale = true;
+static xhash_t *resv_name_hash = NULL;
+static slurmctld_resv_t **resv_order = NULL;	/* in resv_list order */
+static resv_interval_t *resv_interval = NULL;
+static int resv_interval_cnt = 0;
+static int *resv_float = NULL;			/* order of TIME_FLOAT ones */
+static int resv_float_cnt = 0;
+static time_t *resv_end_time = NULL;		/* sorted end times */
+static int resv_end_cnt = 0;
+static time_t resv_next_advance = 0;	/* first end of a repeating resv */
+
 #ifdef HAVE_BG
 uint32_t  cpu_mult = 0;
 uint32_t  cnodes_per_mp = 0;
@@ -145,7 +171,6 @@ static slurmctld_resv_t *_copy_resv(slurmctld_resv_t *resv_orig_ptr);
 static void _del_resv_rec(void *x);
 static void _dump_resv_req(resv_desc_msg_t *resv_ptr, char *mode);
 static int  _find_resv_id(void *x, void *key);
-static int  _find_resv_name(void *x, void *key);
 static void *_fork_script(void *x);
 static void _free_script_arg(resv_thread_args_t *args);
 static int  _generate_resv_id(void);
@@ -177,6 +202,7 @@ static int  _post_resv_delete(slurmctld_resv_t *resv_ptr);
 static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 			      slurmctld_resv_t *old_resv_ptr);
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
+static void _resv_index_invalidate(void);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
 static bool _resv_overlap(time_t start_time, time_t end_time,
@@ -437,6 +463,7 @@ static void _del_resv_rec(void *x)
 	if (resv_ptr) {
 		xassert(resv_ptr->magic == RESV_MAGIC);
 		resv_ptr->magic = 0;
+		_resv_index_invalidate();
 		xfree(resv_ptr->accounts);
 		for (i = 0; i < resv_ptr->account_cnt; i++)
 			xfree(resv_ptr->account_list[i]);
@@ -473,16 +500,208 @@ static int _find_resv_id(void *x, void *key)
 		return 1;	/* match */
 }
 
-static int _find_resv_name(void *x, void *key)
+/* Note that the reservations changed, the index is rebuilt on next use */
+static void _resv_index_invalidate(void)
 {
-	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *) x;
+	slurm_mutex_lock(&resv_index_lock);
+	resv_index_stale = true;
+	slurm_mutex_unlock(&resv_index_lock);
+}
 
-	xassert(resv_ptr->magic == RESV_MAGIC);
+static const char *_resv_name_id(void *item)
+{
+	return ((slurmctld_resv_t *) item)->name;
+}
+
+static int _cmp_interval_start(const void *x, const void *y)
+{
+	const resv_interval_t *a = x, *b = y;
+
+	if (a->start < b->start)
+		return -1;
+	if (a->start > b->start)
+		return 1;
+	return a->order - b->order;
+}
+
+static int _cmp_time(const void *x, const void *y)
+{
+	time_t a = *(const time_t *) x, b = *(const time_t *) y;
+
+	return (a < b) ? -1 : (a > b);
+}
+
+static int _cmp_int(const void *x, const void *y)
+{
+	return *(const int *) x - *(const int *) y;
+}
+
+/* Set max_end of the implicit tree over resv_interval[lo, hi) */
+static time_t _resv_interval_max(int lo, int hi)
+{
+	time_t left, right;
+	int mid;
 
-	if (xstrcmp(resv_ptr->name, (char *) key))
+	if (lo >= hi)
 		return 0;
+	mid = lo + (hi - lo) / 2;
+	left = _resv_interval_max(lo, mid);
+	right = _resv_interval_max(mid + 1, hi);
+	resv_interval[mid].max_end = MAX(resv_interval[mid].end,
+					 MAX(left, right));
+	return resv_interval[mid].max_end;
+}
+
+/* Rebuild the index if the reservations changed, resv_index_lock held */
+static void _resv_index_build(void)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	resv_interval_t *interval;
+	int cnt, order = 0;
+
+	if (!resv_index_stale)
+		return;
+
+	if (!resv_name_hash)
+		resv_name_hash = xhash_init(_resv_name_id, NULL, NULL, 0);
 	else
-		return 1;	/* match */
+		xhash_clear(resv_name_hash);
+	cnt = resv_list ? list_count(resv_list) : 0;
+	xrealloc(resv_order, sizeof(slurmctld_resv_t *) * (cnt + 1));
+	xrealloc(resv_interval, sizeof(resv_interval_t) * (cnt + 1));
+	xrealloc(resv_float, sizeof(int) * (cnt + 1));
+	xrealloc(resv_end_time, sizeof(time_t) * (cnt + 1));
+	resv_interval_cnt = resv_float_cnt = resv_end_cnt = 0;
+	resv_next_advance = 0;
+
+	if (resv_list) {
+		iter = list_iterator_create(resv_list);
+		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+			resv_order[order] = resv_ptr;
+			if (resv_ptr->name &&
+			    !xhash_get(resv_name_hash, resv_ptr->name))
+				xhash_add(resv_name_hash, resv_ptr);
+			resv_end_time[resv_end_cnt++] = resv_ptr->end_time;
+			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+				resv_float[resv_float_cnt++] = order++;
+				continue;
+			}
+			if ((resv_ptr->flags & (RESERVE_FLAG_DAILY |
+						RESERVE_FLAG_WEEKDAY |
+						RESERVE_FLAG_WEEKEND |
+						RESERVE_FLAG_WEEKLY)) &&
+			    (!resv_next_advance ||
+			     (resv_ptr->end_time < resv_next_advance)))
+				resv_next_advance = resv_ptr->end_time;
+			interval = &resv_interval[resv_interval_cnt++];
+			interval->start = MIN(resv_ptr->start_time,
+					      resv_ptr->start_time_first);
+			interval->end = resv_ptr->end_time;
+			interval->order = order++;
+		}
+		list_iterator_destroy(iter);
+	}
+
+	qsort(resv_interval, resv_interval_cnt, sizeof(resv_interval_t),
+	      _cmp_interval_start);
+	(void) _resv_interval_max(0, resv_interval_cnt);
+	qsort(resv_end_time, resv_end_cnt, sizeof(time_t), _cmp_time);
+	resv_index_stale = false;
+}
+
+/* Append the order of reservations in resv_interval[lo, hi) which overlap
+ * [start, end) to list */
+static void _resv_interval_find(int lo, int hi, time_t start, time_t end,
+				int *list, int *cnt)
+{
+	int mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (resv_interval[mid].max_end <= start)
+			return;
+		_resv_interval_find(lo, mid, start, end, list, cnt);
+		/* all later elements start no sooner than this one */
+		if (resv_interval[mid].start >= end)
+			return;
+		if (resv_interval[mid].end > start)
+			list[(*cnt)++] = resv_interval[mid].order;
+		lo = mid + 1;
+	}
+}
+
+/*
+ * Find the reservations which may overlap a time period. TIME_FLOAT
+ * reservations are always included as their times are relative.
+ * IN start, end - time period
+ * OUT cnt - number of reservations found
+ * RET xmalloc'ed array of reservations, in resv_list order, or NULL if none
+ */
+static slurmctld_resv_t **_find_resv_overlap(time_t start, time_t end,
+					     int *cnt)
+{
+	slurmctld_resv_t **resv_array = NULL;
+	int *found, i;
+
+	*cnt = 0;
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_build();
+	found = xmalloc(sizeof(int) * (resv_interval_cnt + resv_float_cnt + 1));
+	_resv_interval_find(0, resv_interval_cnt, start, end, found, cnt);
+	for (i = 0; i < resv_float_cnt; i++)
+		found[(*cnt)++] = resv_float[i];
+	if (*cnt) {
+		qsort(found, *cnt, sizeof(int), _cmp_int);
+		resv_array = xmalloc(sizeof(slurmctld_resv_t *) * *cnt);
+		for (i = 0; i < *cnt; i++)
+			resv_array[i] = resv_order[found[i]];
+	}
+	slurm_mutex_unlock(&resv_index_lock);
+	xfree(found);
+
+	return resv_array;
+}
+
+/* Find a reservation by name, NULL if not found */
+static slurmctld_resv_t *_find_resv(char *resv_name)
+{
+	slurmctld_resv_t *resv_ptr;
+
+	if (!resv_name)
+		return NULL;
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_build();
+	resv_ptr = xhash_get(resv_name_hash, resv_name);
+	slurm_mutex_unlock(&resv_index_lock);
+
+	return resv_ptr;
+}
+
+/*
+ * Advance the times of repeating reservations which have ended, as
+ * job_test_resv() does for the reservations it looks at, so that the index
+ * holds their next occurrence. Needs node write lock.
+ */
+static void _advance_ended_resv(time_t now)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	time_t next_advance;
+
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_build();
+	next_advance = resv_next_advance;
+	slurm_mutex_unlock(&resv_index_lock);
+	if (!next_advance || (next_advance > now))
+		return;
+
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		if (resv_ptr->end_time <= now)
+			_advance_resv_time(resv_ptr);
+	}
+	list_iterator_destroy(iter);
 }
 
 static void _dump_resv_req(resv_desc_msg_t *resv_ptr, char *mode)
@@ -2492,8 +2711,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 		goto bad_parse;
 
 	if (resv_desc_ptr->name) {
-		resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-				_find_resv_name, resv_desc_ptr->name);
+		resv_ptr = _find_resv(resv_desc_ptr->name);
 		if (resv_ptr) {
 			info("Reservation request name duplication (%s)",
 			     resv_desc_ptr->name);
@@ -2503,9 +2721,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 	} else {
 		while (1) {
 			_generate_resv_name(resv_desc_ptr);
-			resv_ptr = (slurmctld_resv_t *)
-					list_find_first (resv_list,
-					_find_resv_name, resv_desc_ptr->name);
+			resv_ptr = _find_resv(resv_desc_ptr->name);
 			if (!resv_ptr)
 				break;
 			rc = _generate_resv_id();	/* makes new suffix */
@@ -2584,6 +2800,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 
 	list_append(resv_list, resv_ptr);
 	last_resv_update = now;
+	_resv_index_invalidate();
 	schedule_resv_save();
 
 	return SLURM_SUCCESS;
@@ -2603,6 +2820,13 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 extern void resv_fini(void)
 {
 	FREE_NULL_LIST(resv_list);
+	xhash_free(resv_name_hash);
+	xfree(resv_order);
+	xfree(resv_interval);
+	xfree(resv_float);
+	xfree(resv_end_time);
+	resv_interval_cnt = resv_float_cnt = resv_end_cnt = 0;
+	resv_index_stale = true;
 }
 
 /* Update an exiting resource reservation */
@@ -2620,8 +2844,7 @@ extern int update_resv(resv_desc_msg_t *resv_desc_ptr)
 	if (!resv_desc_ptr->name)
 		return ESLURM_RESERVATION_INVALID;
 
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, resv_desc_ptr->name);
+	resv_ptr = _find_resv(resv_desc_ptr->name);
 	if (!resv_ptr)
 		return ESLURM_RESERVATION_INVALID;
 
@@ -2996,6 +3219,8 @@ extern int update_resv(resv_desc_msg_t *resv_desc_ptr)
 	_del_resv_rec(resv_backup);
 	(void) set_node_maint_mode(true);
 	last_resv_update = now;
+	_resv_index_invalidate();
+	job_time_limit_check_all();	/* end time may have changed */
 	schedule_resv_save();
 	return error_code;
 
@@ -3129,6 +3354,7 @@ extern int delete_resv(reservation_name_msg_t *resv_desc_ptr)
 
 	(void) set_node_maint_mode(true);
 	last_resv_update = time(NULL);
+	_resv_index_invalidate();
 	schedule_resv_save();
 	return rc;
 }
@@ -3136,10 +3362,7 @@ extern int delete_resv(reservation_name_msg_t *resv_desc_ptr)
 /* Return pointer to the named reservation or NULL if not found */
 extern slurmctld_resv_t *find_resv_name(char *resv_name)
 {
-	slurmctld_resv_t *resv_ptr;
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, resv_name);
-	return resv_ptr;
+	return _find_resv(resv_name);
 }
 
 /* Dump the reservation records to a buffer */
@@ -3427,6 +3650,7 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 		_set_tres_cnt(resv_ptr, &old_resv_ptr);
 		xfree(old_resv_ptr.tres_str);
 		last_resv_update = time(NULL);
+		_resv_index_invalidate();
 	} else if (resv_ptr->flags & RESERVE_FLAG_ALL_NODES) {
 		memset(&old_resv_ptr, 0, sizeof(slurmctld_resv_t));
 		FREE_NULL_BITMAP(resv_ptr->node_bitmap);
@@ -3440,6 +3664,7 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 		_set_tres_cnt(resv_ptr, &old_resv_ptr);
 		xfree(old_resv_ptr.tres_str);
 		last_resv_update = time(NULL);
+		_resv_index_invalidate();
 	} else if (resv_ptr->node_list) {	/* Change bitmap last */
 #ifdef HAVE_BG
 		int inx;
@@ -3510,10 +3735,7 @@ static void _validate_all_reservations(void)
 
 		if ((job_ptr->resv_ptr == NULL) ||
 		    (job_ptr->resv_ptr->magic != RESV_MAGIC)) {
-			job_ptr->resv_ptr = (slurmctld_resv_t *)
-					list_find_first(resv_list,
-							_find_resv_name,
-							job_ptr->resv_name);
+			job_ptr->resv_ptr = _find_resv(job_ptr->resv_name);
 		}
 		if (!job_ptr->resv_ptr) {
 			error("JobId %u linked to defunct reservation %s",
@@ -3602,6 +3824,7 @@ static void _resv_node_replace(slurmctld_resv_t *resv_ptr)
 	}
 	FREE_NULL_BITMAP(preserve_bitmap);
 	last_resv_update = time(NULL);
+	_resv_index_invalidate();
 	schedule_resv_save();
 }
 
@@ -3724,6 +3947,7 @@ extern int load_all_resv_state(int recover)
 	uint16_t protocol_version = NO_VAL16;
 
 	last_resv_update = time(NULL);
+	_resv_index_invalidate();
 	if ((recover == 0) && resv_list) {
 		_validate_all_reservations();
 		return SLURM_SUCCESS;
@@ -3799,6 +4023,7 @@ extern int load_all_resv_state(int recover)
 		list_append(resv_list, resv_ptr);
 		info("Recovered state of reservation %s", resv_ptr->name);
 	}
+	_resv_index_invalidate();
 
 	_validate_all_reservations();
 	info("Recovered state of %d reservations", list_count(resv_list));
@@ -3839,8 +4064,7 @@ extern int validate_job_resv(struct job_record *job_ptr)
 		return ESLURM_RESERVATION_INVALID;
 
 	/* Find the named reservation */
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, job_ptr->resv_name);
+	resv_ptr = _find_resv(job_ptr->resv_name);
 	rc = _valid_job_access_resv(job_ptr, resv_ptr);
 	if (rc == SLURM_SUCCESS) {
 		job_ptr->resv_id    = resv_ptr->resv_id;
@@ -4660,8 +4884,7 @@ extern int job_test_resv_now(struct job_record *job_ptr)
 	if (job_ptr->resv_name == NULL)
 		return SLURM_SUCCESS;
 
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, job_ptr->resv_name);
+	resv_ptr = _find_resv(job_ptr->resv_name);
 	job_ptr->resv_ptr = resv_ptr;
 	rc = _valid_job_access_resv(job_ptr, resv_ptr);
 	if (rc != SLURM_SUCCESS)
@@ -4701,8 +4924,7 @@ extern void job_claim_resv(struct job_record *job_ptr)
 	if (job_ptr->resv_name == NULL)
 		return;
 
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, job_ptr->resv_name);
+	resv_ptr = _find_resv(job_ptr->resv_name);
 	if (!resv_ptr ||
 	    (!resv_ptr->full_nodes && (resv_ptr->node_cnt > 1)) ||
 	    !(resv_ptr->flags & RESERVE_FLAG_REPLACE) ||
@@ -5259,12 +5481,11 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			 bitstr_t **exc_core_bitmap, bool *resv_overlap,
 			 bool reboot)
 {
-	slurmctld_resv_t *resv_ptr = NULL, *res2_ptr;
+	slurmctld_resv_t *resv_ptr = NULL, *res2_ptr, **resv_array;
 	time_t job_start_time, job_end_time, lic_resv_time;
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS, rc2;
+	int i, j, resv_cnt, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
 	job_start_time = *when;
@@ -5272,8 +5493,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	*node_bitmap = (bitstr_t *) NULL;
 
 	if (job_ptr->resv_name) {
-		resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-				_find_resv_name, job_ptr->resv_name);
+		resv_ptr = _find_resv(job_ptr->resv_name);
 		job_ptr->resv_ptr = resv_ptr;
 		rc2 = _valid_job_access_resv(job_ptr, resv_ptr);
 		if (rc2 != SLURM_SUCCESS)
@@ -5337,8 +5557,10 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 		 * if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes)
 		 */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_array = _find_resv_overlap(job_start_time, job_end_time,
+						&resv_cnt);
+		for (j = 0; j < resv_cnt; j++) {
+			res2_ptr = resv_array[j];
 			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
 			    ((resv_ptr->flags & RESERVE_FLAG_OVERLAP) &&
 			     !(res2_ptr->flags & RESERVE_FLAG_MAINT)) ||
@@ -5353,7 +5575,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
+		xfree(resv_array);
 
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -5403,11 +5625,14 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	 * Job has no reservation, try to find time when this can
 	 * run and get it's required nodes (if any)
 	 */
+	_advance_ended_resv(now);
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_array = _find_resv_overlap(job_start_time, job_end_time,
+						&resv_cnt);
+		for (j = 0; j < resv_cnt; j++) {
+			resv_ptr = resv_array[j];
 			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
 				start_relative = resv_ptr->start_time + now;
 				if (resv_ptr->duration == INFINITE)
@@ -5497,7 +5722,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				continue;
 			}
 		}
-		list_iterator_destroy(iter);
+		xfree(resv_array);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
@@ -5537,21 +5762,26 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
  */
 extern time_t find_resv_end(time_t start_time)
 {
-	ListIterator iter;
-	slurmctld_resv_t *resv_ptr;
 	time_t end_time = 0;
+	int lo = 0, hi, mid;
 
 	if (!resv_list)
 		return end_time;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if (start_time > resv_ptr->end_time)
-			continue;
-		if ((end_time == 0) || (resv_ptr->end_time < end_time))
-			end_time = resv_ptr->end_time;
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_build();
+	hi = resv_end_cnt;
+	while (lo < hi) {	/* first end time not before start_time */
+		mid = lo + (hi - lo) / 2;
+		if (resv_end_time[mid] < start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	list_iterator_destroy(iter);
+	if (lo < resv_end_cnt)
+		end_time = resv_end_time[lo];
+	slurm_mutex_unlock(&resv_index_lock);
+
 	return end_time;
 }
 
@@ -5687,6 +5917,7 @@ static void _advance_resv_time(slurmctld_resv_t *resv_ptr)
 		_advance_time(&resv_ptr->end_time, day_cnt);
 		_post_resv_create(resv_ptr);
 		last_resv_update = time(NULL);
+		_resv_index_invalidate();
 		schedule_resv_save();
 	}
 }
@@ -5817,6 +6048,7 @@ extern void job_resv_check(void)
 			_post_resv_update(resv_ptr, resv_backup); /* accounting */
 			_del_resv_rec(resv_backup);
 			last_resv_update = now;
+			_resv_index_invalidate();
 			schedule_resv_save();
 		}
 		if (!resv_ptr->run_prolog || !resv_ptr->run_epilog)
@@ -5845,6 +6077,7 @@ extern void job_resv_check(void)
 			_clear_job_resv(resv_ptr);
 			list_delete_item(iter);
 			last_resv_update = now;
+			_resv_index_invalidate();
 			schedule_resv_save();
 		}
 	}
@@ -6041,6 +6274,7 @@ extern void update_part_nodes_in_resv(struct part_record *part_ptr)
 			_set_tres_cnt(resv_ptr, &old_resv_ptr);
 			xfree(old_resv_ptr.tres_str);
 			last_resv_update = time(NULL);
+			_resv_index_invalidate();
 		}
 	}
 	list_iterator_destroy(iter);
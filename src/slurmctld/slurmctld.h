@@ -94,6 +94,12 @@
 #define	PERIODIC_TIMEOUT	30
 #endif
 
+/* Look at each running job's limits at least every JOB_TIME_CHECK_MAX
+ * seconds, even when none of its limits is near */
+#ifndef JOB_TIME_CHECK_MAX
+#define	JOB_TIME_CHECK_MAX	600
+#endif
+
 /* Attempt to purge defunct job records and resend job kill requests
  * every PURGE_JOB_INTERVAL seconds */
 #ifndef PURGE_JOB_INTERVAL
@@ -154,6 +160,10 @@ typedef struct slurmctld_config {
 	pthread_t thread_id_rpc;
 } slurmctld_config_t;
 
+/* Nesting levels of composite messages counted separately, the last one
+ * also counts all deeper levels */
+#define DIAG_AGGR_LEVELS 4
+
 /* Job scheduling statistics */
 typedef struct diag_stats {
 	int proc_req_threads;
@@ -193,6 +203,9 @@ typedef struct diag_stats {
 	uint32_t bf_active;
 
 	uint32_t latency;
+
+	uint32_t aggr_comp_cnt[DIAG_AGGR_LEVELS];
+	uint32_t aggr_msg_cnt;
 } diag_stats_t;
 
 /* This is used to point out constants that exist in the
@@ -775,6 +788,11 @@ struct job_record {
 	struct slurmctld_resv *resv_ptr;/* reservation structure pointer */
 	uint32_t requid;	    	/* requester user ID */
 	char *resp_host;		/* host for srun communications */
+	uint32_t run_inx;		/* 1 + position in running job index,
+					 * 0 if not indexed */
+	uint32_t run_qos_id;		/* QOS bucket of running job index */
+	uint32_t limit_inx;		/* 1 + position in time limit heap,
+					 * 0 if not queued */
 	char *sched_nodes;		/* list of nodes scheduled for job */
 	dynamic_plugin_data_t *select_jobinfo;/* opaque data, BlueGene */
 	char **spank_job_env;		/* environment variables for job prolog
@@ -1657,6 +1675,26 @@ extern int job_step_complete (uint32_t job_id, uint32_t job_step_id,
 int job_step_signal(uint32_t job_id, uint32_t step_id,
 		    uint16_t signal, uint16_t flags, uid_t uid);
 
+/*
+ * job_time_limit_check - look at a running or suspended job on the next
+ *	job_time_limit() call, used when its start, end or limits change
+ */
+extern void job_time_limit_check(struct job_record *job_ptr);
+
+/*
+ * job_time_limit_check_all - look at all running and suspended jobs on the
+ *	next job_time_limit() call, used when the configuration, partitions
+ *	or reservations change
+ */
+extern void job_time_limit_check_all(void);
+
+/*
+ * job_time_limit_acct_changed - test running and suspended jobs against the
+ *	group limits of their associations and QOS on the next
+ *	job_time_limit() call, used when their usage or limits change
+ */
+extern void job_time_limit_acct_changed(void);
+
 /*
  * job_time_limit - terminate jobs which have exceeded their time limit
  * global: job_list - pointer global job list
@@ -2151,6 +2189,34 @@ extern struct step_record *build_extern_step(struct job_record *job_ptr);
 /* update first assigned job id as needed on reconfigure */
 extern void reset_first_job_id(void);
 
+/*
+ * running_job_add - add a job that started running, or whose QOS or nodes
+ *	changed while running, to the index of running and suspended jobs.
+ *	Jobs that end are dropped from it lazily.
+ */
+extern void running_job_add(struct job_record *job_ptr);
+
+/*
+ * running_job_foreach - call f() for each running or suspended job whose QOS
+ *	id is set in qos_bitmap and whose nodes overlap node_bitmap.
+ *	Either bitmap may be NULL to not filter on it. Much faster than a
+ *	walk of job_list, the cost is that of the candidate jobs.
+ * NOTE: f() must not start or purge jobs
+ * NOTE: called with job read lock held
+ */
+extern void running_job_foreach(bitstr_t *qos_bitmap, bitstr_t *node_bitmap,
+				void (*f) (struct job_record *job_ptr,
+					   void *arg),
+				void *arg);
+
+/* running_job_index_reset - rebuild the running job index node summaries
+ *	after the node table changed */
+extern void running_job_index_reset(void);
+
+/* running_job_remove - remove a job record about to be freed from the
+ *	running job index */
+extern void running_job_remove(struct job_record *job_ptr);
+
 /*
  * reset_job_bitmaps - reestablish bitmaps for existing jobs.
  *	this should be called after rebuilding node information,
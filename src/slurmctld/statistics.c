@@ -131,6 +131,10 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_pack_jobs,
 			       buffer);
+
+			pack32(slurmctld_diag_stats.aggr_msg_cnt, buffer);
+			pack32_array(slurmctld_diag_stats.aggr_comp_cnt,
+				     DIAG_AGGR_LEVELS, buffer);
 		}
 	} else if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
 		parts_packed = resp;
@@ -287,5 +291,9 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
 
+	memset(slurmctld_diag_stats.aggr_comp_cnt, 0,
+	       sizeof(slurmctld_diag_stats.aggr_comp_cnt));
+	slurmctld_diag_stats.aggr_msg_cnt = 0;
+
 	last_proc_req_start = time(NULL);
 }
@@ -2711,6 +2711,7 @@ step_create(job_step_create_request_msg_t *step_specs,
 			return ESLURM_INVALID_TIME_LIMIT;
 		}
 		step_ptr->time_limit = step_specs->time_limit;
+		job_time_limit_check(job_ptr);
 	}
 
 	/* a batch script does not need switch info */
@@ -4694,8 +4695,10 @@ extern int update_step(step_update_request_msg_t *req, uid_t uid)
 			     req->job_id, req->step_id, req->time_limit);
 		}
 	}
-	if (mod_cnt)
+	if (mod_cnt) {
 		last_job_update = time(NULL);
+		job_time_limit_check(job_ptr);
+	}
 	if (new_step) {
 		/*
 		 * This was a temporary step record, never linked to the job,
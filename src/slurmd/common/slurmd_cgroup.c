@@ -56,8 +56,8 @@
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmstepd/slurmstepd_job.h"
 
-static xcgroup_t system_cpuset_cg = {NULL, NULL, NULL, 0, 0, 0};
-static xcgroup_t system_memory_cg = {NULL, NULL, NULL, 0, 0, 0};
+static xcgroup_t system_cpuset_cg = {NULL, NULL, NULL, 0, 0, 0, -1};
+static xcgroup_t system_memory_cg = {NULL, NULL, NULL, 0, 0, 0, -1};
 
 static bool cpuset_prefix_set = false;
 static char *cpuset_prefix = "";
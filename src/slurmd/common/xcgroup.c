@@ -57,12 +57,18 @@
 
 /* internal functions */
 size_t _file_getsize(int fd);
-int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb);
-int _file_write_uint32s(char* file_path, uint32_t* values, int nb);
-int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb);
-int _file_write_uint64s(char* file_path, uint64_t* values, int nb);
-int _file_read_content(char* file_path, char** content, size_t *csize);
-int _file_write_content(char* file_path, char* content, size_t csize);
+int _file_read_uint32s(int dfd, char* file_path, uint32_t** pvalues,
+		       int* pnb);
+int _file_write_uint32s(int dfd, char* file_path, uint32_t* values,
+			int nb);
+int _file_read_uint64s(int dfd, char* file_path, uint64_t** pvalues,
+		       int* pnb);
+int _file_write_uint64s(int dfd, char* file_path, uint64_t* values,
+			int nb);
+int _file_read_content(int dfd, char* file_path, char** content,
+		       size_t *csize);
+int _file_write_content(int dfd, char* file_path, char* content,
+			size_t csize);
 
 
 /*
@@ -282,7 +288,7 @@ int xcgroup_ns_find_by_pid(xcgroup_ns_t* cgns, xcgroup_t* cg, pid_t pid)
 	 * multiple lines of the form :
 	 * num_mask:subsystems:relative_path
 	 */
-	fstatus = _file_read_content(file_path, &buf, &fsize);
+	fstatus = _file_read_content(AT_FDCWD, file_path, &buf, &fsize);
 	if (fstatus == XCGROUP_SUCCESS) {
 		fstatus = XCGROUP_ERROR;
 		p = buf;
@@ -332,6 +338,57 @@ int xcgroup_ns_load(slurm_cgroup_conf_t *conf, xcgroup_ns_t *cgns, char *subsys)
  * -----------------------------------------------------------------------------
  */
 
+/*
+ * Return the directory fd of the cgroup, opening it on first use.
+ * Parameter files are then opened relative to it with openat(2),
+ * sparing the kernel a full path walk of the cgroup hierarchy on
+ * each access. Returns -1 if the directory can not be opened.
+ */
+static int _xcgroup_dir_fd(xcgroup_t *cg)
+{
+	if ((cg->dir_fd < 0) && cg->path) {
+		cg->dir_fd = open(cg->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (cg->dir_fd < 0)
+			debug3("%s: unable to open cgroup '%s' : %m",
+			       __func__, cg->path);
+	}
+	return cg->dir_fd;
+}
+
+/*
+ * Only called by xcgroup_destroy(), callers may hand xcgroup_delete() a
+ * structure of their own with just its path set
+ */
+static void _xcgroup_close_dir(xcgroup_t *cg)
+{
+	/* statically initialized cgroups have no path nor directory fd */
+	if (cg->path && (cg->dir_fd >= 0))
+		close(cg->dir_fd);
+	cg->dir_fd = -1;
+}
+
+/*
+ * Get the name to open the cgroup file param with, relative to *dfd.
+ * That is param itself when the cgroup directory fd is available,
+ * else the absolute path of the file built into file_path.
+ * Returns NULL if the path is too long.
+ */
+static char *_xcgroup_param_path(xcgroup_t *cg, char *param,
+				 char *file_path, int *dfd)
+{
+	if ((*dfd = _xcgroup_dir_fd(cg)) >= 0)
+		return param;
+
+	*dfd = AT_FDCWD;
+	if (snprintf(file_path, PATH_MAX, "%s/%s", cg->path, param)
+	    >= PATH_MAX) {
+		debug2("unable to build filepath for '%s' and"
+		       " parameter '%s' : %m", cg->path, param);
+		return NULL;
+	}
+	return file_path;
+}
+
 int xcgroup_create(xcgroup_ns_t* cgns, xcgroup_t* cg,
 		   char* uri, uid_t uid,  gid_t gid)
 {
@@ -352,12 +409,14 @@ int xcgroup_create(xcgroup_ns_t* cgns, xcgroup_t* cg,
 	cg->path = xstrdup(file_path);
 	cg->uid = uid;
 	cg->gid = gid;
+	cg->dir_fd = -1;
 
 	return XCGROUP_SUCCESS;
 }
 
 void xcgroup_destroy(xcgroup_t* cg)
 {
+	_xcgroup_close_dir(cg);
 	cg->ns = NULL;
 	xfree(cg->name);
 	xfree(cg->path);
@@ -411,6 +470,9 @@ int xcgroup_instantiate(xcgroup_t* cg)
 	char* file_path;
 	uid_t uid;
 	gid_t gid;
+	struct stat st;
+	bool exists = false;
+	uint32_t notify;
 
 	/* init variables based on input cgroup */
 	file_path = cg->path;
@@ -431,10 +493,27 @@ int xcgroup_instantiate(xcgroup_t* cg)
 		} else {
 			debug("%s: cgroup '%s' already exists",
 			      __func__, file_path);
+			exists = true;
 		}
+	} else {
+		/* drop any fd of a previous instance of the directory */
+		_xcgroup_close_dir(cg);
 	}
 	umask(omask);
 
+	/*
+	 * The uid and job levels are shared by all the steps of a job and
+	 * were already set up by the first one, skip rewriting them.
+	 */
+	if (exists && !stat(file_path, &st) &&
+	    (st.st_uid == uid) && (st.st_gid == gid)) {
+		if ((xcgroup_get_uint32_param(cg, "notify_on_release",
+					      &notify) != XCGROUP_SUCCESS) ||
+		    notify)
+			xcgroup_set_param(cg, "notify_on_release", "0");
+		return XCGROUP_SUCCESS;
+	}
+
 	/* change cgroup ownership as requested */
 	if (chown(file_path, uid, gid)) {
 		error("%s: unable to chown %d:%d cgroup '%s' : %m",
@@ -479,6 +558,7 @@ int xcgroup_load(xcgroup_ns_t* cgns, xcgroup_t* cg, char* uri)
 	cg->path = xstrdup(file_path);
 	cg->uid = buf.st_uid;
 	cg->gid = buf.st_gid;
+	cg->dir_fd = -1;
 
 	return XCGROUP_SUCCESS;
 }
@@ -499,14 +579,16 @@ int xcgroup_delete(xcgroup_t* cg)
 static char *_cgroup_procs_check (xcgroup_t *cg, int check_mode)
 {
 	struct stat st;
+	char file_path[PATH_MAX], *path;
+	int dfd;
+
 	// If possible use cgroup.procs to add the processes atomically
-	char *path = xstrdup_printf("%s/%s", cg->path, "cgroup.procs");
-	if (!((stat (path, &st) >= 0) && (st.st_mode & check_mode))) {
-		xfree(path);
-		path = xstrdup_printf("%s/%s", cg->path, "tasks");
-	}
+	path = _xcgroup_param_path(cg, "cgroup.procs", file_path, &dfd);
+	if (path && (fstatat(dfd, path, &st, 0) >= 0) &&
+	    (st.st_mode & check_mode))
+		return "cgroup.procs";
 
-	return path;
+	return "tasks";
 }
 
 static char *_cgroup_procs_readable_path (xcgroup_t *cg)
@@ -524,13 +606,17 @@ static char *_cgroup_procs_writable_path (xcgroup_t *cg)
 int xcgroup_add_pids(xcgroup_t* cg, pid_t* pids, int npids)
 {
 	int fstatus = XCGROUP_ERROR;
-	char* path = _cgroup_procs_writable_path(cg);
-
-	fstatus = _file_write_uint32s(path, (uint32_t*)pids, npids);
+	char file_path[PATH_MAX], *path;
+	int dfd;
+
+	path = _xcgroup_param_path(cg, _cgroup_procs_writable_path(cg),
+				   file_path, &dfd);
+	if (path)
+		fstatus = _file_write_uint32s(dfd, path, (uint32_t*)pids,
+					      npids);
 	if (fstatus != XCGROUP_SUCCESS)
 		debug2("%s: unable to add pids to '%s'", __func__, cg->path);
 
-	xfree(path);
 	return fstatus;
 }
 
@@ -539,39 +625,39 @@ int xcgroup_add_pids(xcgroup_t* cg, pid_t* pids, int npids)
 int xcgroup_get_pids(xcgroup_t* cg, pid_t **pids, int *npids)
 {
 	int fstatus = XCGROUP_ERROR;
-	char* path = NULL;
+	char file_path[PATH_MAX], *path;
+	int dfd;
 
 	if (pids == NULL || npids == NULL)
 		return SLURM_ERROR;
 
-	path = _cgroup_procs_readable_path(cg);
-
-	fstatus = _file_read_uint32s(path, (uint32_t**)pids, npids);
+	path = _xcgroup_param_path(cg, _cgroup_procs_readable_path(cg),
+				   file_path, &dfd);
+	if (path)
+		fstatus = _file_read_uint32s(dfd, path, (uint32_t**)pids,
+					     npids);
 	if (fstatus != XCGROUP_SUCCESS)
 		debug2("%s: unable to get pids of '%s'", __func__, cg->path);
 
-	xfree(path);
 	return fstatus;
 }
 
 int xcgroup_set_param(xcgroup_t* cg, char* param, char* content)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char* cpath = cg->path;
+	int dfd;
 
 	if (!content) {
 		debug2("%s: no content given, nothing to do.", __func__);
 		return fstatus;
 	}
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
+	if (!(path = _xcgroup_param_path(cg, param, file_path, &dfd)))
 		return fstatus;
-	}
 
-	fstatus = _file_write_content(file_path, content, strlen(content));
+	fstatus = _file_write_content(dfd, path, content, strlen(content));
 	if (fstatus != XCGROUP_SUCCESS)
 		debug2("%s: unable to set parameter '%s' to '%s' for '%s'",
 			__func__, param, content, cpath);
@@ -585,14 +671,12 @@ int xcgroup_set_param(xcgroup_t* cg, char* param, char* content)
 int xcgroup_get_param(xcgroup_t* cg, char* param, char **content, size_t *csize)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char* cpath = cg->path;
+	int dfd;
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
-	} else {
-		fstatus = _file_read_content(file_path, content, csize);
+	if ((path = _xcgroup_param_path(cg, param, file_path, &dfd))) {
+		fstatus = _file_read_content(dfd, path, content, csize);
 		if (fstatus != XCGROUP_SUCCESS)
 			debug2("%s: unable to get parameter '%s' for '%s'",
 				__func__, param, cpath);
@@ -603,16 +687,14 @@ int xcgroup_get_param(xcgroup_t* cg, char* param, char **content, size_t *csize)
 int xcgroup_set_uint32_param(xcgroup_t* cg, char* param, uint32_t value)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char* cpath = cg->path;
+	int dfd;
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
+	if (!(path = _xcgroup_param_path(cg, param, file_path, &dfd)))
 		return fstatus;
-	}
 
-	fstatus = _file_write_uint32s(file_path, &value, 1);
+	fstatus = _file_write_uint32s(dfd, path, &value, 1);
 	if (fstatus != XCGROUP_SUCCESS)
 		debug2("%s: unable to set parameter '%s' to '%u' for '%s'",
 			__func__, param, value, cpath);
@@ -626,16 +708,13 @@ int xcgroup_set_uint32_param(xcgroup_t* cg, char* param, uint32_t value)
 int xcgroup_get_uint32_param(xcgroup_t* cg, char* param, uint32_t* value)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char *cpath = cg->path;
 	uint32_t *values = NULL;
-	int vnb;
+	int vnb, dfd;
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
-	} else {
-		fstatus = _file_read_uint32s(file_path, &values, &vnb);
+	if ((path = _xcgroup_param_path(cg, param, file_path, &dfd))) {
+		fstatus = _file_read_uint32s(dfd, path, &values, &vnb);
 		if (fstatus != XCGROUP_SUCCESS) {
 			debug2("%s: unable to get parameter '%s' for '%s'",
 				__func__, param, cpath);
@@ -654,16 +733,14 @@ int xcgroup_get_uint32_param(xcgroup_t* cg, char* param, uint32_t* value)
 int xcgroup_set_uint64_param(xcgroup_t* cg, char* param, uint64_t value)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char* cpath = cg->path;
+	int dfd;
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
+	if (!(path = _xcgroup_param_path(cg, param, file_path, &dfd)))
 		return fstatus;
-	}
 
-	fstatus = _file_write_uint64s(file_path, &value, 1);
+	fstatus = _file_write_uint64s(dfd, path, &value, 1);
 	if (fstatus != XCGROUP_SUCCESS)
 		debug2("%s: unable to set parameter '%s' to '%"PRIu64"' for "
 			"'%s'", __func__, param, value, cpath);
@@ -677,17 +754,13 @@ int xcgroup_set_uint64_param(xcgroup_t* cg, char* param, uint64_t value)
 int xcgroup_get_uint64_param(xcgroup_t* cg, char* param, uint64_t* value)
 {
 	int fstatus = XCGROUP_ERROR;
-	char file_path[PATH_MAX];
+	char file_path[PATH_MAX], *path;
 	char *cpath = cg->path;
 	uint64_t *values = NULL;
-	int vnb;
+	int vnb, dfd;
 
-	if (snprintf(file_path, PATH_MAX, "%s/%s", cpath, param) >= PATH_MAX) {
-		debug2("unable to build filepath for '%s' and"
-		       " parameter '%s' : %m", cpath, param);
-	}
-	else {
-		fstatus = _file_read_uint64s(file_path, &values, &vnb);
+	if ((path = _xcgroup_param_path(cg, param, file_path, &dfd))) {
+		fstatus = _file_read_uint64s(dfd, path, &values, &vnb);
 		if (fstatus != XCGROUP_SUCCESS) {
 			debug2("%s: unable to get parameter '%s' for '%s'",
 				__func__, param, cpath);
@@ -707,7 +780,8 @@ static int cgroup_move_process_by_task (xcgroup_t *cg, pid_t pid)
 {
 	DIR *dir;
 	struct dirent *entry;
-	char path[PATH_MAX];
+	char path[PATH_MAX], file_path[PATH_MAX], *tasks;
+	int dfd, fd, rc;
 
 	if (snprintf(path, PATH_MAX, "/proc/%d/task", (int) pid) >= PATH_MAX) {
 		error("xcgroup: move_process_by_task: path overflow!");
@@ -720,23 +794,35 @@ static int cgroup_move_process_by_task (xcgroup_t *cg, pid_t pid)
 		return XCGROUP_ERROR;
 	}
 
+	/* write all the thread ids through a single open of the file */
+	tasks = _xcgroup_param_path(cg, "tasks", file_path, &dfd);
+	if (!tasks || ((fd = openat(dfd, tasks, O_WRONLY)) < 0)) {
+		error("%s: unable to open tasks of '%s' : %m",
+		      __func__, cg->path);
+		closedir(dir);
+		return XCGROUP_ERROR;
+	}
+
 	while ((entry = readdir(dir))) {
-		if (entry->d_name[0] != '.')
-			xcgroup_set_param(cg, "tasks", entry->d_name);
+		if (entry->d_name[0] == '.')
+			continue;
+		do {
+			rc = write(fd, entry->d_name, strlen(entry->d_name));
+		} while (rc < 0 && errno == EINTR);
+		if (rc < 0)
+			debug2("%s: unable to add task '%s' to '%s' : %m",
+			       __func__, entry->d_name, cg->path);
 	}
+	close(fd);
 	closedir(dir);
 	return XCGROUP_SUCCESS;
 }
 
 int xcgroup_move_process (xcgroup_t *cg, pid_t pid)
 {
-	char *path = _cgroup_procs_writable_path(cg);
-
-	if (!path)
+	if (xstrcmp(_cgroup_procs_writable_path(cg), "cgroup.procs"))
 		return cgroup_move_process_by_task (cg, pid);
 
-	xfree(path);
-
 	return xcgroup_set_uint32_param (cg, "cgroup.procs", pid);
 }
 
@@ -781,7 +867,8 @@ size_t _file_getsize(int fd)
 		return fsize;
 }
 
-int _file_write_uint64s(char* file_path, uint64_t* values, int nb)
+int _file_write_uint64s(int dfd, char* file_path, uint64_t* values,
+			int nb)
 {
 	int fstatus;
 	int rc;
@@ -791,7 +878,7 @@ int _file_write_uint64s(char* file_path, uint64_t* values, int nb)
 	int i;
 
 	/* open file for writing */
-	fd = open(file_path, O_WRONLY, 0700);
+	fd = openat(dfd, file_path, O_WRONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for writing : %m",
 			__func__, file_path);
@@ -831,7 +918,8 @@ int _file_write_uint64s(char* file_path, uint64_t* values, int nb)
 	return fstatus;
 }
 
-int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb)
+int _file_read_uint64s(int dfd, char* file_path, uint64_t** pvalues,
+		       int* pnb)
 {
 	int rc;
 	int fd;
@@ -848,7 +936,7 @@ int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb)
 		return XCGROUP_ERROR;
 
 	/* open file for reading */
-	fd = open(file_path, O_RDONLY, 0700);
+	fd = openat(dfd, file_path, O_RDONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for reading : %m",
 			__func__, file_path);
@@ -903,7 +991,8 @@ int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb)
 	return XCGROUP_SUCCESS;
 }
 
-int _file_write_uint32s(char* file_path, uint32_t* values, int nb)
+int _file_write_uint32s(int dfd, char* file_path, uint32_t* values,
+			int nb)
 {
 	int fstatus;
 	int rc;
@@ -913,7 +1002,7 @@ int _file_write_uint32s(char* file_path, uint32_t* values, int nb)
 	int i;
 
 	/* open file for writing */
-	fd = open(file_path, O_WRONLY, 0700);
+	fd = openat(dfd, file_path, O_WRONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for writing : %m",
 			__func__, file_path);
@@ -953,7 +1042,8 @@ int _file_write_uint32s(char* file_path, uint32_t* values, int nb)
 	return fstatus;
 }
 
-int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb)
+int _file_read_uint32s(int dfd, char* file_path, uint32_t** pvalues,
+		       int* pnb)
 {
 	int rc;
 	int fd;
@@ -970,7 +1060,7 @@ int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb)
 		return XCGROUP_ERROR;
 
 	/* open file for reading */
-	fd = open(file_path, O_RDONLY, 0700);
+	fd = openat(dfd, file_path, O_RDONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for reading : %m",
 			__func__, file_path);
@@ -1024,14 +1114,15 @@ int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb)
 	return XCGROUP_SUCCESS;
 }
 
-int _file_write_content(char* file_path, char* content, size_t csize)
+int _file_write_content(int dfd, char* file_path, char* content,
+			size_t csize)
 {
 	int fstatus;
 	int rc;
 	int fd;
 
 	/* open file for writing */
-	fd = open(file_path, O_WRONLY, 0700);
+	fd = openat(dfd, file_path, O_WRONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for writing : %m",
 			__func__, file_path);
@@ -1057,7 +1148,8 @@ int _file_write_content(char* file_path, char* content, size_t csize)
 	return fstatus;
 }
 
-int _file_read_content(char* file_path, char** content, size_t *csize)
+int _file_read_content(int dfd, char* file_path, char** content,
+		       size_t *csize)
 {
 	int fstatus;
 	int rc;
@@ -1072,7 +1164,7 @@ int _file_read_content(char* file_path, char** content, size_t *csize)
 		return fstatus;
 
 	/* open file for reading */
-	fd = open(file_path, O_RDONLY, 0700);
+	fd = openat(dfd, file_path, O_RDONLY, 0700);
 	if (fd < 0) {
 		debug2("%s: unable to open '%s' for reading : %m",
 			__func__, file_path);
@@ -68,6 +68,7 @@ typedef struct xcgroup {
 	uid_t    uid;     /* uid of the owner */
 	gid_t    gid;     /* gid of the owner */
 	int      fd;      /* used for locking */
+	int      dir_fd;  /* cached fd of the cgroup directory, -1 if none */
 } xcgroup_t;
 
 /*
@@ -189,6 +190,8 @@ int xcgroup_load(xcgroup_ns_t* cgns, xcgroup_t* cg, char* uri);
 
 /*
  * delete a cgroup instance in a cgroup namespace (rmdir)
+ * only cg->path is used, the cached directory fd is closed by
+ * xcgroup_destroy()
  *
  * returned values:
  *  - XCGROUP_ERROR
@@ -97,6 +97,7 @@
 
 #include "src/slurmd/slurmd/get_mach_stat.h"
 #include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/stepd_registry.h"
 
 #include "src/slurmd/common/fname.h"
 #include "src/slurmd/common/job_container_plugin.h"
@@ -208,6 +209,7 @@ static int  _run_prolog(job_env_t *job_env, slurm_cred_t *cred,
 			bool remove_running);
 static void _rpc_forward_data(slurm_msg_t *msg);
 static int  _rpc_network_callerid(slurm_msg_t *msg);
+static int  _rpc_step_list(slurm_msg_t *msg);
 
 static bool _pause_for_job_completion(uint32_t jobid, char *nodes,
 				      int maxtime);
@@ -227,6 +229,7 @@ static uid_t _get_job_uid(uint32_t jobid);
 
 static int  _add_starting_step(uint16_t type, void *req);
 static int  _remove_starting_step(uint16_t type, void *req);
+static void _register_stepd(uint16_t type, void *req);
 static int  _compare_starting_steps(void *s0, void *s1);
 static int  _wait_for_starting_step(uint32_t job_id, uint32_t step_id);
 static bool _step_is_starting(uint32_t job_id, uint32_t step_id);
@@ -437,6 +440,10 @@ slurmd_req(slurm_msg_t *msg)
 		debug2("Processing RPC: REQUEST_NETWORK_CALLERID");
 		_rpc_network_callerid(msg);
 		break;
+	case REQUEST_STEP_LIST:
+		debug2("Processing RPC: REQUEST_STEP_LIST");
+		(void) _rpc_step_list(msg);
+		break;
 	case MESSAGE_COMPOSITE:
 		error("Processing RPC: MESSAGE_COMPOSITE: "
 		      "This should never happen");
@@ -472,25 +479,19 @@ rwfail:
 	return (-1);
 }
 
+/*
+ * Send the step independent part of the slurmstepd initialization data:
+ * the slurmd configuration and the TRES list.
+ */
 static int
-_send_slurmstepd_init(int fd, int type, void *req,
-		      slurm_addr_t *cli, slurm_addr_t *self,
-		      hostset_t step_hset, uint16_t protocol_version)
+_send_slurmstepd_conf(int fd)
 {
 	int len = 0;
 	Buf buffer = NULL;
-	slurm_msg_t msg;
-
-	int rank;
-	int parent_rank, children, depth, max_depth;
-	char *parent_alias = NULL;
-	slurm_addr_t parent_addr = {0};
 	assoc_mgr_lock_t locks = {
 		NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 		READ_LOCK, NO_LOCK, NO_LOCK };
 
-	slurm_msg_t_init(&msg);
-
 	/* send conf over to slurmstepd */
 	if (_send_slurmd_conf_lite(fd, conf) < 0)
 		goto rwfail;
@@ -498,7 +499,8 @@ _send_slurmstepd_init(int fd, int type, void *req,
 	/*
 	 * Send over right after the slurmd_conf_lite! We don't care about the
 	 * assoc/qos locks assoc_mgr_post_tres_list is requesting as those lists
-	 * don't exist here.
+	 * don't exist here. Only pack under the lock, the slurmstepd may not
+	 * be reading yet.
 	 */
 	assoc_mgr_lock(&locks);
 	if (assoc_mgr_tres_list) {
@@ -506,6 +508,10 @@ _send_slurmstepd_init(int fd, int type, void *req,
 		slurm_pack_list(assoc_mgr_tres_list,
 				slurmdb_pack_tres_rec, buffer,
 				SLURM_PROTOCOL_VERSION);
+	}
+	assoc_mgr_unlock(&locks);
+
+	if (buffer) {
 		len = get_buf_offset(buffer);
 		safe_write(fd, &len, sizeof(int));
 		safe_write(fd, get_buf_data(buffer), len);
@@ -515,7 +521,35 @@ _send_slurmstepd_init(int fd, int type, void *req,
 		len = 0;
 		safe_write(fd, &len, sizeof(int));
 	}
-	assoc_mgr_unlock(&locks);
+
+	return 0;
+
+rwfail:
+	if (buffer)
+		free_buf(buffer);
+	error("%s failed", __func__);
+	return errno;
+}
+
+/*
+ * Send the step specific part of the slurmstepd initialization data.
+ * Must follow _send_slurmstepd_conf().
+ */
+static int
+_send_slurmstepd_init(int fd, int type, void *req,
+		      slurm_addr_t *cli, slurm_addr_t *self,
+		      hostset_t step_hset, uint16_t protocol_version)
+{
+	int len = 0;
+	Buf buffer = NULL;
+	slurm_msg_t msg;
+
+	int rank;
+	int parent_rank, children, depth, max_depth;
+	char *parent_alias = NULL;
+	slurm_addr_t parent_addr = {0};
+
+	slurm_msg_t_init(&msg);
 
 	/* send type over to slurmstepd */
 	safe_write(fd, &type, sizeof(int));
@@ -669,6 +703,419 @@ rwfail:
 }
 
 
+/*
+ * Wait for the slurmstepd to send its initialization return code, then
+ * acknowledge it.
+ * RET the slurmstepd's return code
+ */
+static int
+_recv_slurmstepd_rc(int to_stepd, int to_slurmd, time_t start_time)
+{
+	int rc = SLURM_SUCCESS;
+
+	/* If running under valgrind/memcheck, this pipe doesn't work
+	 * correctly so just skip it. */
+#if (SLURMSTEPD_MEMCHECK == 0)
+	int i;
+
+	i = read(to_slurmd, &rc, sizeof(int));
+	if (i < 0) {
+		error("%s: Can not read return code from slurmstepd "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
+	} else if (i != sizeof(int)) {
+		error("%s: slurmstepd failed to send return code "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
+	} else {
+		int delta_time = time(NULL) - start_time;
+		int cc;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
+		}
+		if (rc != SLURM_SUCCESS)
+			error("slurmstepd return code %d", rc);
+
+		cc = SLURM_SUCCESS;
+		cc = write(to_stepd, &cc, sizeof(int));
+		if (cc != sizeof(int)) {
+			error("%s: failed to send ack to stepd %d: %m",
+			      __func__, cc);
+		}
+	}
+#endif
+	return rc;
+}
+
+/*
+ * Executed in a child of slurmd: fork again and exec the slurmstepd in the
+ * grandchild with to_stepd and to_slurmd as its stdin and stdout, so that
+ * the slurmstepd's parent process will be init, not slurmd.
+ * Never returns.
+ */
+static void
+_exec_slurmstepd(int to_stepd[2], int to_slurmd[2], uint16_t type, void *req)
+{
+	pid_t pid;
+#if (SLURMSTEPD_MEMCHECK == 1)
+	/* memcheck test of slurmstepd, option #1 */
+	char *const argv[3] = {"memcheck",
+			       (char *)conf->stepd_loc, NULL};
+#elif (SLURMSTEPD_MEMCHECK == 2)
+	/* valgrind test of slurmstepd, option #2 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[13] = {"valgrind", "--tool=memcheck",
+				"--error-limit=no",
+				"--leak-check=summary",
+				"--show-reachable=yes",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				"--track-origins=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 3)
+	/* valgrind/drd test of slurmstepd, option #3 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=drd",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 4)
+	/* valgrind/helgrind test of slurmstepd, option #4 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=helgrind",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#else
+	/* no memory checking, default */
+	char *const argv[2] = { (char *)conf->stepd_loc, NULL};
+#endif
+	int i;
+	int failed = 0;
+	/* inform slurmstepd about our config */
+	setenv("SLURM_CONF", conf->conffile, 1);
+
+	/*
+	 * Child forks and exits
+	 */
+	if (setsid() < 0) {
+		error("_forkexec_slurmstepd: setsid: %m");
+		failed = 1;
+	}
+	if ((pid = fork()) < 0) {
+		error("_forkexec_slurmstepd: "
+		      "Unable to fork grandchild: %m");
+		failed = 2;
+	} else if (pid > 0) { /* child */
+		exit(0);
+	}
+
+	/*
+	 * Just in case we (or someone we are linking to)
+	 * opened a file and didn't do a close on exec.  This
+	 * is needed mostly to protect us against libs we link
+	 * to that don't set the flag as we should already be
+	 * setting it for those that we open.  The number 256
+	 * is an arbitrary number based off test7.9.
+	 */
+	for (i=3; i<256; i++) {
+		(void) fcntl(i, F_SETFD, FD_CLOEXEC);
+	}
+
+	/*
+	 * Grandchild exec's the slurmstepd
+	 *
+	 * If the slurmd is being shutdown/restarted before
+	 * the pipe happens the old conf->lfd could be reused
+	 * and if we close it the dup2 below will fail.
+	 */
+	if ((to_stepd[0] != conf->lfd)
+	    && (to_slurmd[1] != conf->lfd))
+		slurm_shutdown_msg_engine(conf->lfd);
+
+	if (close(to_stepd[1]) < 0)
+		error("close write to_stepd in grandchild: %m");
+	if (close(to_slurmd[0]) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	(void) close(STDIN_FILENO); /* ignore return */
+	if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
+		error("dup2 over STDIN_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_stepd[0]);
+	(void) close(STDOUT_FILENO); /* ignore return */
+	if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
+		error("dup2 over STDOUT_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_slurmd[1]);
+	(void) close(STDERR_FILENO); /* ignore return */
+	if (dup2(devnull, STDERR_FILENO) == -1) {
+		error("dup2 /dev/null to STDERR_FILENO: %m");
+		exit(1);
+	}
+	fd_set_noclose_on_exec(STDERR_FILENO);
+	log_fini();
+	if (!failed) {
+		execvp(argv[0], argv);
+		error("exec of slurmstepd failed: %m");
+	}
+	exit(2);
+}
+
+/*
+ * Pool of slurmstepd processes which have already been started, received
+ * the slurmd configuration and loaded their plugins, and are waiting for
+ * the step specific initialization data (LaunchParameters=slurmstepd_pool).
+ */
+typedef struct {
+	int to_stepd;		/* write end of the slurmstepd's stdin */
+	int to_slurmd;		/* read end of the slurmstepd's stdout */
+} stepd_pool_ent_t;
+
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List stepd_pool = NULL;		/* list of stepd_pool_ent_t */
+static int stepd_pool_size = 0;		/* configured size */
+static int stepd_pool_pending = 0;	/* slurmstepds being started */
+static uint32_t stepd_pool_gen = 0;	/* bumped by stepd_pool_init() */
+
+/* Discard a pooled slurmstepd. It exits when its stdin gets closed. */
+static void _stepd_pool_ent_del(void *x)
+{
+	stepd_pool_ent_t *ent = (stepd_pool_ent_t *) x;
+
+	if (!ent)
+		return;
+	if (ent->to_stepd >= 0)
+		(void) close(ent->to_stepd);
+	if (ent->to_slurmd >= 0)
+		(void) close(ent->to_slurmd);
+	xfree(ent);
+}
+
+/* Start a slurmstepd and send it the slurmd configuration */
+static stepd_pool_ent_t *_stepd_pool_spawn(void)
+{
+	stepd_pool_ent_t *ent;
+	int to_stepd[2] = {-1, -1};
+	int to_slurmd[2] = {-1, -1};
+	pid_t pid;
+
+	if ((pipe(to_stepd) < 0) || (pipe(to_slurmd) < 0)) {
+		error("%s: pipe failed: %m", __func__);
+		goto fail;
+	}
+	/* Don't let other children of slurmd hold the pipes open */
+	fd_set_close_on_exec(to_stepd[1]);
+	fd_set_close_on_exec(to_slurmd[0]);
+
+	if ((pid = fork()) < 0) {
+		error("%s: fork: %m", __func__);
+		goto fail;
+	} else if (pid == 0) {
+		_exec_slurmstepd(to_stepd, to_slurmd, 0, NULL);
+	}
+
+	/* Reap child */
+	if (waitpid(pid, NULL, 0) < 0)
+		error("Unable to reap slurmd child process");
+	(void) close(to_stepd[0]);
+	(void) close(to_slurmd[1]);
+
+	ent = xmalloc(sizeof(stepd_pool_ent_t));
+	ent->to_stepd = to_stepd[1];
+	ent->to_slurmd = to_slurmd[0];
+	if (_send_slurmstepd_conf(ent->to_stepd) != 0) {
+		_stepd_pool_ent_del(ent);
+		return NULL;
+	}
+	return ent;
+
+fail:
+	if (to_stepd[0] >= 0)
+		(void) close(to_stepd[0]);
+	if (to_stepd[1] >= 0)
+		(void) close(to_stepd[1]);
+	if (to_slurmd[0] >= 0)
+		(void) close(to_slurmd[0]);
+	if (to_slurmd[1] >= 0)
+		(void) close(to_slurmd[1]);
+	return NULL;
+}
+
+/* Start slurmstepds until the pool is back to its configured size */
+static void *_stepd_pool_fill(void *arg)
+{
+	stepd_pool_ent_t *ent;
+	uint32_t gen;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (stepd_pool && ((list_count(stepd_pool) + stepd_pool_pending) <
+			      stepd_pool_size)) {
+		stepd_pool_pending++;
+		gen = stepd_pool_gen;
+		slurm_mutex_unlock(&stepd_pool_mutex);
+
+		ent = _stepd_pool_spawn();
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		stepd_pool_pending--;
+		if (!ent)
+			break;
+		if (!stepd_pool || (gen != stepd_pool_gen)) {
+			/* Configured from a stale slurmd configuration */
+			_stepd_pool_ent_del(ent);
+			continue;
+		}
+		list_append(stepd_pool, ent);
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return NULL;
+}
+
+/* Take a slurmstepd from the pool, if any, and start its replacement */
+static stepd_pool_ent_t *_stepd_pool_get(void)
+{
+	stepd_pool_ent_t *ent = NULL;
+	bool refill = false;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (stepd_pool && stepd_pool_size) {
+		ent = list_pop(stepd_pool);
+		refill = true;
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (refill)
+		slurm_thread_create_detached(NULL, _stepd_pool_fill, NULL);
+
+	return ent;
+}
+
+extern void stepd_pool_init(void)
+{
+	char *launch_params, *tmp_ptr;
+	int size = 0;
+
+	launch_params = slurm_get_launch_params();
+	if ((tmp_ptr = xstrcasestr(launch_params, "slurmstepd_pool=")))
+		size = atoi(tmp_ptr + 16);
+	xfree(launch_params);
+#if (SLURMSTEPD_MEMCHECK != 0)
+	size = 0;
+#endif
+	if (size < 0)
+		size = 0;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (!stepd_pool)
+		stepd_pool = list_create(_stepd_pool_ent_del);
+	else
+		list_flush(stepd_pool);
+	stepd_pool_gen++;
+	stepd_pool_size = size;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (size) {
+		debug("%s: keeping %d slurmstepd ready", __func__, size);
+		slurm_thread_create_detached(NULL, _stepd_pool_fill, NULL);
+	}
+}
+
+extern void stepd_pool_fini(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	FREE_NULL_LIST(stepd_pool);
+	stepd_pool_size = 0;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+/*
+ * Hand a step to a pooled slurmstepd.
+ * RET false if the slurmstepd could not take the step, in which case the
+ *     caller should start a new one. Otherwise true and *rc is set to the
+ *     slurmstepd's return code.
+ */
+static bool
+_launch_pooled_slurmstepd(stepd_pool_ent_t *ent, uint16_t type, void *req,
+			  slurm_addr_t *cli, slurm_addr_t *self,
+			  const hostset_t step_hset, uint16_t protocol_version,
+			  int *rc)
+{
+	time_t start_time = time(NULL);
+
+	if (_add_starting_step(type, req)) {
+		error("%s: failed in _add_starting_step: %m", __func__);
+		_stepd_pool_ent_del(ent);
+		*rc = SLURM_FAILURE;
+		return true;
+	}
+
+	if (_send_slurmstepd_init(ent->to_stepd, type, req, cli, self,
+				  step_hset, protocol_version) != 0) {
+		/* The slurmstepd is gone, nothing was started */
+		debug("%s: pooled slurmstepd unusable", __func__);
+		if (_remove_starting_step(type, req))
+			error("Error cleaning up starting_step list");
+		_stepd_pool_ent_del(ent);
+		return false;
+	}
+
+	*rc = _recv_slurmstepd_rc(ent->to_stepd, ent->to_slurmd, start_time);
+	if (*rc == SLURM_SUCCESS)
+		_register_stepd(type, req);
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+	_stepd_pool_ent_del(ent);
+
+	return true;
+}
+
 /*
  * Fork and exec the slurmstepd, then send the slurmstepd its
  * initialization data.  Then wait for slurmstepd to send an "ok"
@@ -676,6 +1123,9 @@ rwfail:
  * the slurmstepd has created and begun listening on its unix
  * domain socket.
  *
+ * If LaunchParameters=slurmstepd_pool is configured, a slurmstepd
+ * started ahead of time is used instead whenever one is available.
+ *
  * Note that this code forks twice and it is the grandchild that
  * becomes the slurmstepd process, so the slurmstepd's parent process
  * will be init, not slurmd.
@@ -688,6 +1138,13 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 	pid_t pid;
 	int to_stepd[2] = {-1, -1};
 	int to_slurmd[2] = {-1, -1};
+	stepd_pool_ent_t *ent;
+	int rc = SLURM_SUCCESS;
+
+	if ((ent = _stepd_pool_get()) &&
+	    _launch_pooled_slurmstepd(ent, type, req, cli, self, step_hset,
+				      protocol_version, &rc))
+		return rc;
 
 	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
 		error("_forkexec_slurmstepd pipe failed: %m");
@@ -708,11 +1165,7 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		_remove_starting_step(type, req);
 		return SLURM_FAILURE;
 	} else if (pid > 0) {
-		int rc = SLURM_SUCCESS;
-#if (SLURMSTEPD_MEMCHECK == 0)
-		int i;
 		time_t start_time = time(NULL);
-#endif
 		/*
 		 * Parent sends initialization data to the slurmstepd
 		 * over the to_stepd pipe, and waits for the return code
@@ -723,45 +1176,19 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		if (close(to_slurmd[1]) < 0)
 			error("Unable to close write to_slurmd in parent: %m");
 
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset,
-						protocol_version)) != 0) {
+		if (((rc = _send_slurmstepd_conf(to_stepd[1])) != 0) ||
+		    ((rc = _send_slurmstepd_init(to_stepd[1], type,
+						 req, cli, self,
+						 step_hset,
+						 protocol_version)) != 0)) {
 			error("Unable to init slurmstepd");
 			goto done;
 		}
 
-		/* If running under valgrind/memcheck, this pipe doesn't work
-		 * correctly so just skip it. */
-#if (SLURMSTEPD_MEMCHECK == 0)
-		i = read(to_slurmd[0], &rc, sizeof(int));
-		if (i < 0) {
-			error("%s: Can not read return code from slurmstepd "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else if (i != sizeof(int)) {
-			error("%s: slurmstepd failed to send return code "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			int cc;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-			if (rc != SLURM_SUCCESS)
-				error("slurmstepd return code %d", rc);
-
-			cc = SLURM_SUCCESS;
-			cc = write(to_stepd[1], &cc, sizeof(int));
-			if (cc != sizeof(int)) {
-				error("%s: failed to send ack to stepd %d: %m",
-				      __func__, cc);
-			}
-		}
-#endif
+		rc = _recv_slurmstepd_rc(to_stepd[1], to_slurmd[0],
+					 start_time);
+		if (rc == SLURM_SUCCESS)
+			_register_stepd(type, req);
 	done:
 		if (_remove_starting_step(type, req))
 			error("Error cleaning up starting_step list");
@@ -775,153 +1202,10 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 			error("close read to_slurmd in parent: %m");
 		return rc;
 	} else {
-#if (SLURMSTEPD_MEMCHECK == 1)
-		/* memcheck test of slurmstepd, option #1 */
-		char *const argv[3] = {"memcheck",
-				       (char *)conf->stepd_loc, NULL};
-#elif (SLURMSTEPD_MEMCHECK == 2)
-		/* valgrind test of slurmstepd, option #2 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[13] = {"valgrind", "--tool=memcheck",
-					"--error-limit=no",
-					"--leak-check=summary",
-					"--show-reachable=yes",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					"--track-origins=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
-		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 3)
-		/* valgrind/drd test of slurmstepd, option #3 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=drd",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
-		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 4)
-		/* valgrind/helgrind test of slurmstepd, option #4 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=helgrind",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
-		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#else
-		/* no memory checking, default */
-		char *const argv[2] = { (char *)conf->stepd_loc, NULL};
-#endif
-		int i;
-		int failed = 0;
-		/* inform slurmstepd about our config */
-		setenv("SLURM_CONF", conf->conffile, 1);
-
-		/*
-		 * Child forks and exits
-		 */
-		if (setsid() < 0) {
-			error("_forkexec_slurmstepd: setsid: %m");
-			failed = 1;
-		}
-		if ((pid = fork()) < 0) {
-			error("_forkexec_slurmstepd: "
-			      "Unable to fork grandchild: %m");
-			failed = 2;
-		} else if (pid > 0) { /* child */
-			exit(0);
-		}
-
-		/*
-		 * Just in case we (or someone we are linking to)
-		 * opened a file and didn't do a close on exec.  This
-		 * is needed mostly to protect us against libs we link
-		 * to that don't set the flag as we should already be
-		 * setting it for those that we open.  The number 256
-		 * is an arbitrary number based off test7.9.
-		 */
-		for (i=3; i<256; i++) {
-			(void) fcntl(i, F_SETFD, FD_CLOEXEC);
-		}
-
-		/*
-		 * Grandchild exec's the slurmstepd
-		 *
-		 * If the slurmd is being shutdown/restarted before
-		 * the pipe happens the old conf->lfd could be reused
-		 * and if we close it the dup2 below will fail.
-		 */
-		if ((to_stepd[0] != conf->lfd)
-		    && (to_slurmd[1] != conf->lfd))
-			slurm_shutdown_msg_engine(conf->lfd);
-
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in grandchild: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-
-		(void) close(STDIN_FILENO); /* ignore return */
-		if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
-			error("dup2 over STDIN_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_stepd[0]);
-		(void) close(STDOUT_FILENO); /* ignore return */
-		if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
-			error("dup2 over STDOUT_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_slurmd[1]);
-		(void) close(STDERR_FILENO); /* ignore return */
-		if (dup2(devnull, STDERR_FILENO) == -1) {
-			error("dup2 /dev/null to STDERR_FILENO: %m");
-			exit(1);
-		}
-		fd_set_noclose_on_exec(STDERR_FILENO);
-		log_fini();
-		if (!failed) {
-			execvp(argv[0], argv);
-			error("exec of slurmstepd failed: %m");
-		}
-		exit(2);
+		_exec_slurmstepd(to_stepd, to_slurmd, type, req);
 	}
+
+	return SLURM_FAILURE;	/* not reached */
 }
 
 static void _setup_x11_display(uint32_t job_id, uint32_t step_id,
@@ -2533,7 +2817,7 @@ _rpc_job_notify(slurm_msg_t *msg)
 		return;
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(req->job_id, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if ((stepd->jobid  != req->job_id) ||
@@ -2804,7 +3088,7 @@ _load_job_limits(void)
 		job_limits_list = list_create(_job_limits_free);
 	job_limits_loaded = true;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	step_iter = list_iterator_create(steps);
 	while ((stepd = list_next(step_iter))) {
 		job_limits_ptr = list_find_first(job_limits_list,
@@ -2948,7 +3232,7 @@ _enforce_job_mem_limit(void)
 		job_mem_info_ptr[i].vsize_limit *= (vsize_factor / 100.0);
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	step_iter = list_iterator_create(steps);
 	while ((stepd = list_next(step_iter))) {
 		for (job_inx=0; job_inx<job_cnt; job_inx++) {
@@ -3511,7 +3795,7 @@ _get_step_list(void)
 	ListIterator i;
 	step_loc_t *stepd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -3753,6 +4037,48 @@ _rpc_network_callerid(slurm_msg_t *msg)
 	return rc;
 }
 
+/*
+ * Report the job steps running on this node from the slurmstepd registry.
+ * Users other than root and SlurmUser only get their own steps.
+ */
+static int
+_rpc_step_list(slurm_msg_t *msg)
+{
+	step_list_request_msg_t *req = (step_list_request_msg_t *)msg->data;
+	step_list_response_msg_t *resp;
+	slurm_msg_t resp_msg;
+	List steps;
+	ListIterator i;
+	step_loc_t *stepd;
+	uint32_t uid = req->uid;
+	uid_t req_uid;
+
+	req_uid = g_slurm_auth_get_uid(msg->auth_cred, conf->auth_info);
+	if (!_slurm_authorized_user(req_uid))
+		uid = req_uid;
+
+	steps = stepd_registry_list(req->job_id, uid);
+	resp = xmalloc(sizeof(step_list_response_msg_t));
+	resp->job_id = xmalloc(sizeof(uint32_t) * list_count(steps));
+	resp->step_id = xmalloc(sizeof(uint32_t) * list_count(steps));
+	i = list_iterator_create(steps);
+	while ((stepd = list_next(i))) {
+		resp->job_id[resp->step_cnt] = stepd->jobid;
+		resp->step_id[resp->step_cnt] = stepd->stepid;
+		resp->step_cnt++;
+	}
+	list_iterator_destroy(i);
+	FREE_NULL_LIST(steps);
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_STEP_LIST;
+	resp_msg.data     = resp;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+	slurm_free_step_list_response_msg(resp);
+
+	return SLURM_SUCCESS;
+}
+
 static int
 _rpc_list_pids(slurm_msg_t *msg)
 {
@@ -3912,7 +4238,7 @@ static void  _rpc_pid2jid(slurm_msg_t *msg)
 	ListIterator i;
 	step_loc_t *stepd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -4197,10 +4523,15 @@ static int _rpc_file_bcast(slurm_msg_t *msg)
 		return SLURM_FAILURE;
 	}
 
+	/*
+	 * Write at the block's own offset rather than appending: a pipelined
+	 * sbcast sends all but the first and last blocks concurrently.
+	 */
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(file_info->fd, &req->block[offset],
-			    (req->block_len - offset));
+		inx = pwrite(file_info->fd, &req->block[offset],
+			     (req->block_len - offset),
+			     req->block_offset + offset);
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
@@ -4448,10 +4779,13 @@ static uid_t _get_job_uid(uint32_t jobid)
 	List steps;
 	ListIterator i;
 	step_loc_t *stepd;
-	uid_t uid = -1;
+	uid_t uid;
 	int fd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	if ((int)(uid = stepd_registry_get_uid(jobid)) >= 0)
+		return uid;
+
+	steps = stepd_registry_list(jobid, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -4499,7 +4833,7 @@ _kill_all_active_steps(uint32_t jobid, int sig, int flags, bool batch,
 	int step_cnt  = 0;
 	int rc = SLURM_SUCCESS;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(jobid, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -4547,7 +4881,7 @@ extern int ume_notify(void)
 	int step_cnt  = 0;
 	int fd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		step_cnt++;
@@ -4591,7 +4925,7 @@ _terminate_all_steps(uint32_t jobid, bool batch)
 	int step_cnt  = 0;
 	int fd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(jobid, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -4636,7 +4970,7 @@ _job_still_running(uint32_t job_id)
 	ListIterator i;
 	step_loc_t  *s     = NULL;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(job_id, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((s = list_next(i))) {
 		if (s->jobid == job_id) {
@@ -4689,7 +5023,7 @@ _steps_completed_now(uint32_t jobid)
 	step_loc_t *stepd;
 	bool rc = true;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(jobid, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid == jobid) {
@@ -4830,7 +5164,7 @@ extern void record_launched_jobs(void)
 	ListIterator i;
 	step_loc_t *stepd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		_launch_complete_add(stepd->jobid);
@@ -4913,7 +5247,7 @@ _rpc_suspend_job(slurm_msg_t *msg)
 	 * as appropriate. Since the "suspend" action may contains a sleep
 	 * (if the launch is in progress) suspend multiple jobsteps in parallel.
 	 */
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(req->job_id, NO_VAL);
 	i = list_iterator_create(steps);
 
 	while (1) {
@@ -6248,6 +6582,28 @@ _add_starting_step(uint16_t type, void *req)
 }
 
 
+/* Record a slurmstepd which has been started in the registry */
+static void
+_register_stepd(uint16_t type, void *req)
+{
+	switch (type) {
+	case LAUNCH_BATCH_JOB:
+		stepd_registry_add(((batch_job_launch_msg_t *)req)->job_id,
+				   ((batch_job_launch_msg_t *)req)->step_id,
+				   ((batch_job_launch_msg_t *)req)->uid);
+		break;
+	case LAUNCH_TASKS:
+		stepd_registry_add(
+			((launch_tasks_request_msg_t *)req)->job_id,
+			((launch_tasks_request_msg_t *)req)->job_step_id,
+			((launch_tasks_request_msg_t *)req)->uid);
+		break;
+	default:
+		error("%s called with an invalid type: %u", __func__, type);
+		break;
+	}
+}
+
 static int
 _remove_starting_step(uint16_t type, void *req)
 {
@@ -54,6 +54,16 @@ void gids_cache_purge(void);
 /* Add record for every launched job so we know they are ready for suspend */
 extern void record_launched_jobs(void);
 
+/*
+ * stepd_pool_init - (Re)build the pool of slurmstepd processes started ahead
+ *	of time to speed up job step launches, sized by
+ *	LaunchParameters=slurmstepd_pool. Pooled slurmstepds received the
+ *	slurmd configuration when started, so this must be called again
+ *	whenever that configuration or the TRES list changes.
+ */
+extern void stepd_pool_init(void);
+extern void stepd_pool_fini(void);
+
 void file_bcast_init(void);
 void file_bcast_purge(void);
 
@@ -111,6 +111,7 @@
 #include "src/slurmd/common/set_oomadj.h"
 #include "src/slurmd/common/setproctitle.h"
 #include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/stepd_registry.h"
 #include "src/slurmd/common/slurmd_cgroup.h"
 #include "src/slurmd/common/xcpuinfo.h"
 
@@ -363,6 +364,7 @@ main (int argc, char **argv)
 	_install_fork_handlers();
 	list_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
+	stepd_registry_init();
 	record_launched_jobs();
 
 	run_script_health_check();
@@ -595,6 +597,9 @@ static void _handle_node_reg_resp(slurm_msg_t *resp_msg)
 		assoc_mgr_unlock(&locks);
 		/* assoc_mgr_post_tres_list will destroy the list */
 		resp->tres_list = NULL;
+
+		/* Pooled slurmstepds hold a copy of the TRES list */
+		stepd_pool_init();
 	}
 }
 
@@ -741,7 +746,7 @@ _fill_registration_msg(slurm_node_registration_status_msg_t *msg)
 			error("switch_g_build_node_info: %m");
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	msg->job_count = list_count(steps);
 	msg->job_id    = xmalloc(msg->job_count * sizeof(*msg->job_id));
 	/* Note: Running batch jobs will have step_id == NO_VAL */
@@ -1080,6 +1085,9 @@ _reconfigure(void)
 	msg_aggr_sender_reconfig(conf->msg_aggr_window_time,
 				 conf->msg_aggr_window_msgs);
 
+	/* Pooled slurmstepds hold a copy of the old configuration */
+	stepd_pool_init();
+
 	/*
 	 * In case the administrator changed the cpu frequency set capabilities
 	 * on this node, rebuild the cpu frequency table information
@@ -1677,6 +1685,8 @@ cleanup:
 static int
 _slurmd_fini(void)
 {
+	stepd_pool_fini();
+	stepd_registry_fini();
 	node_features_g_fini();
 	core_spec_g_fini();
 	switch_g_node_fini();
@@ -1953,7 +1963,7 @@ static void _update_logging(void)
 	 * Send reconfig to each stepd so they will rotate as well.
 	 */
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = stepd_registry_list(NO_VAL, NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -0,0 +1,305 @@
+/*****************************************************************************\
+ *  stepd_registry.c - in-memory registry of the slurmstepds started by slurmd
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/stepd_api.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/stepd_registry.h"
+
+/*
+ * The slurmstepds of a job. Steps are only added once their slurmstepd is
+ * listening and are dropped lazily, once their socket has been removed, so
+ * that looking up the steps of a job never needs to scan the spool
+ * directory nor connect to the slurmstepds of other jobs.
+ */
+typedef struct {
+	char key[11];		/* job_id as a string, the xhash key */
+	uint32_t job_id;
+	uid_t uid;
+	uint32_t step_cnt;
+	uint32_t step_size;
+	uint32_t *step_id;
+} stepd_job_t;
+
+typedef struct {
+	List steps;		/* step_loc_t records being built */
+	List empty;		/* stepd_job_t records left with no step */
+	uint32_t uid;
+} stepd_list_args_t;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *registry = NULL;
+
+static const char *_job_key(void *item)
+{
+	return ((stepd_job_t *) item)->key;
+}
+
+static void _job_free(void *item)
+{
+	stepd_job_t *job = (stepd_job_t *) item;
+
+	if (job) {
+		xfree(job->step_id);
+		xfree(job);
+	}
+}
+
+static void _step_loc_free(void *x)
+{
+	step_loc_t *loc = (step_loc_t *) x;
+
+	if (loc) {
+		xfree(loc->directory);
+		xfree(loc->nodename);
+		xfree(loc);
+	}
+}
+
+/* Return true if the slurmstepd's socket is still present */
+static bool _step_alive(uint32_t job_id, uint32_t step_id)
+{
+	struct stat stat_buf;
+	char *name = NULL;
+	bool alive;
+
+	xstrfmtcat(name, "%s/%s_%u.%u", conf->spooldir, conf->node_name,
+		   job_id, step_id);
+	alive = ((stat(name, &stat_buf) == 0) && S_ISSOCK(stat_buf.st_mode));
+	xfree(name);
+
+	return alive;
+}
+
+/* Add one record to the registry, registry_mutex must be locked */
+static void _add(uint32_t job_id, uint32_t step_id, uid_t uid)
+{
+	stepd_job_t *job;
+	char key[11];
+	int i;
+
+	snprintf(key, sizeof(key), "%u", job_id);
+	if (!(job = xhash_get(registry, key))) {
+		job = xmalloc(sizeof(stepd_job_t));
+		strlcpy(job->key, key, sizeof(job->key));
+		job->job_id = job_id;
+		job->uid = uid;
+		xhash_add(registry, job);
+	}
+	if ((job->uid == (uid_t) -1) || (job->uid == (uid_t) NO_VAL))
+		job->uid = uid;
+
+	for (i = 0; i < job->step_cnt; i++) {
+		if (job->step_id[i] == step_id)
+			return;
+	}
+	if (job->step_cnt >= job->step_size) {
+		job->step_size = job->step_size ? (job->step_size * 2) : 4;
+		xrealloc(job->step_id, sizeof(uint32_t) * job->step_size);
+	}
+	job->step_id[job->step_cnt++] = step_id;
+}
+
+/*
+ * Append a job's live steps to args->steps, dropping those which are gone.
+ * registry_mutex must be locked.
+ */
+static void _list_job(void *item, void *arg)
+{
+	stepd_job_t *job = (stepd_job_t *) item;
+	stepd_list_args_t *args = (stepd_list_args_t *) arg;
+	step_loc_t *loc;
+	int i, j;
+
+	for (i = 0, j = 0; i < job->step_cnt; i++) {
+		if (!_step_alive(job->job_id, job->step_id[i])) {
+			debug3("%s: step %u.%u is gone",
+			       __func__, job->job_id, job->step_id[i]);
+			continue;
+		}
+		job->step_id[j++] = job->step_id[i];
+
+		if ((args->uid != NO_VAL) && (args->uid != job->uid))
+			continue;
+		loc = xmalloc(sizeof(step_loc_t));
+		loc->directory = xstrdup(conf->spooldir);
+		loc->nodename = xstrdup(conf->node_name);
+		loc->jobid = job->job_id;
+		loc->stepid = job->step_id[i];
+		list_append(args->steps, loc);
+	}
+	job->step_cnt = j;
+
+	if (!job->step_cnt)
+		list_append(args->empty, job);
+}
+
+static int _step_job_mismatch(void *x, void *key)
+{
+	step_loc_t *loc = (step_loc_t *) x;
+	uint32_t job_id = *(uint32_t *) key;
+
+	return (loc->jobid != job_id);
+}
+
+/* stepd_available() filtered by job, used until the registry is loaded */
+static List _list_unregistered(uint32_t job_id)
+{
+	List steps = stepd_available(conf->spooldir, conf->node_name);
+
+	if (job_id != NO_VAL)
+		(void) list_delete_all(steps, _step_job_mismatch, &job_id);
+	return steps;
+}
+
+extern void stepd_registry_init(void)
+{
+	List steps;
+	ListIterator itr;
+	step_loc_t *stepd;
+	uid_t uid;
+	int fd;
+
+	slurm_mutex_lock(&registry_mutex);
+	if (registry)
+		xhash_clear(registry);
+	else
+		registry = xhash_init(_job_key, _job_free, NULL, 0);
+	slurm_mutex_unlock(&registry_mutex);
+
+	steps = stepd_available(conf->spooldir, conf->node_name);
+	itr = list_iterator_create(steps);
+	while ((stepd = list_next(itr))) {
+		fd = stepd_connect(stepd->directory, stepd->nodename,
+				   stepd->jobid, stepd->stepid,
+				   &stepd->protocol_version);
+		if (fd == -1)
+			continue;	/* stale socket */
+		uid = stepd_get_uid(fd, stepd->protocol_version);
+		close(fd);
+
+		slurm_mutex_lock(&registry_mutex);
+		_add(stepd->jobid, stepd->stepid, uid);
+		slurm_mutex_unlock(&registry_mutex);
+	}
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(steps);
+}
+
+extern void stepd_registry_fini(void)
+{
+	slurm_mutex_lock(&registry_mutex);
+	xhash_free(registry);
+	slurm_mutex_unlock(&registry_mutex);
+}
+
+extern void stepd_registry_add(uint32_t job_id, uint32_t step_id, uid_t uid)
+{
+	slurm_mutex_lock(&registry_mutex);
+	if (registry)
+		_add(job_id, step_id, uid);
+	slurm_mutex_unlock(&registry_mutex);
+}
+
+extern List stepd_registry_list(uint32_t job_id, uint32_t uid)
+{
+	stepd_list_args_t args;
+	stepd_job_t *job;
+	char key[11];
+
+	args.steps = list_create(_step_loc_free);
+	args.empty = list_create(NULL);
+	args.uid = uid;
+
+	slurm_mutex_lock(&registry_mutex);
+	if (!registry) {
+		/* Not loaded yet, scan the spool directory */
+		slurm_mutex_unlock(&registry_mutex);
+		FREE_NULL_LIST(args.steps);
+		FREE_NULL_LIST(args.empty);
+		return _list_unregistered(job_id);
+	} else if (job_id == NO_VAL) {
+		xhash_walk(registry, _list_job, &args);
+	} else {
+		snprintf(key, sizeof(key), "%u", job_id);
+		if ((job = xhash_get(registry, key)))
+			_list_job(job, &args);
+	}
+	while ((job = list_pop(args.empty)))
+		xhash_delete(registry, job->key);
+	slurm_mutex_unlock(&registry_mutex);
+
+	FREE_NULL_LIST(args.empty);
+	return args.steps;
+}
+
+extern uid_t stepd_registry_get_uid(uint32_t job_id)
+{
+	stepd_list_args_t args;
+	stepd_job_t *job;
+	uid_t uid = (uid_t) -1;
+	char key[11];
+
+	args.steps = list_create(_step_loc_free);
+	args.empty = list_create(NULL);
+	args.uid = NO_VAL;
+
+	snprintf(key, sizeof(key), "%u", job_id);
+	slurm_mutex_lock(&registry_mutex);
+	if (registry && (job = xhash_get(registry, key))) {
+		_list_job(job, &args);
+		if (job->step_cnt)
+			uid = job->uid;
+		else
+			xhash_delete(registry, key);
+	}
+	slurm_mutex_unlock(&registry_mutex);
+
+	FREE_NULL_LIST(args.empty);
+	FREE_NULL_LIST(args.steps);
+	return uid;
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************\
+ *  stepd_registry.h - in-memory registry of the slurmstepds started by slurmd
+ *****************************************************************************
+ *  Copyright (C) 2018 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURMD_STEPD_REGISTRY_H
+#define _SLURMD_STEPD_REGISTRY_H
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+#include "src/common/list.h"
+
+/*
+ * Initialize the registry from the slurmstepd sockets found in the spool
+ * directory. Called once when slurmd starts, to pick up the slurmstepds
+ * started by a previous slurmd.
+ */
+extern void stepd_registry_init(void);
+
+extern void stepd_registry_fini(void);
+
+/* Record a slurmstepd which has been started and is now listening */
+extern void stepd_registry_add(uint32_t job_id, uint32_t step_id, uid_t uid);
+
+/*
+ * Return a List of step_loc_t (as stepd_available() does) for the
+ * slurmstepds of the given job and user. NO_VAL matches every job or user.
+ * slurmstepds whose socket is gone are dropped from the registry. Until
+ * stepd_registry_init() has been called, the spool directory is scanned and
+ * the uid filter is ignored.
+ */
+extern List stepd_registry_list(uint32_t job_id, uint32_t uid);
+
+/*
+ * Return the uid of the job's owner, or (uid_t) -1 if the job has no
+ * slurmstepd on this node
+ */
+extern uid_t stepd_registry_get_uid(uint32_t job_id);
+
+#endif	/* _SLURMD_STEPD_REGISTRY_H */
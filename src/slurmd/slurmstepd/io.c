@@ -56,6 +56,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -78,6 +79,9 @@
 #include "src/slurmd/slurmstepd/io.h"
 #include "src/slurmd/slurmstepd/slurmstepd.h"
 
+/* Most queued messages gathered into a single writev() to a client */
+#define IO_BATCH_MAX 64
+
 /**********************************************************************
  * IO client socket declarations
  **********************************************************************/
@@ -203,8 +207,12 @@ static int _send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job);
 static void _send_eof_msg(struct task_read_info *out);
 static struct io_buf *_task_build_message(struct task_read_info *out,
 					  stepd_step_rec_t *job, cbuf_t cbuf);
+static void _task_pack_header(struct task_read_info *out, struct io_buf *msg,
+			      int length);
+static int _task_read_direct(eio_obj_t *obj);
 static void *_io_thr(void *arg);
 static void _route_msg_task_to_client(eio_obj_t *obj);
+static void _route_msg(struct task_read_info *out, struct io_buf *msg);
 static void _free_outgoing_msg(struct io_buf *msg, stepd_step_rec_t *job);
 static void _free_incoming_msg(struct io_buf *msg, stepd_step_rec_t *job);
 static void _free_all_outgoing_msgs(List msg_queue, stepd_step_rec_t *job);
@@ -427,14 +435,66 @@ _client_read(eio_obj_t *obj, List objs)
 }
 
 /*
- * Write outgoing packed messages to the client socket.
+ * Gather what is left of client->out_msg and the messages queued behind it
+ * into iov[], skipping the first "skip" bytes (the packed header) of queued
+ * messages. Return the number of iov entries used.
+ */
+static int
+_client_gather(struct client_io_info *client, struct iovec *iov, int skip)
+{
+	ListIterator msgs;
+	struct io_buf *msg;
+	int cnt = 0;
+
+	if (client->out_remaining > 0) {
+		iov[cnt].iov_base = client->out_msg->data +
+			(client->out_msg->length - client->out_remaining);
+		iov[cnt++].iov_len = client->out_remaining;
+	}
+
+	msgs = list_iterator_create(client->msg_queue);
+	while ((cnt < IO_BATCH_MAX) && (msg = list_next(msgs))) {
+		if (msg->length <= skip)
+			continue;
+		iov[cnt].iov_base = msg->data + skip;
+		iov[cnt++].iov_len = msg->length - skip;
+	}
+	list_iterator_destroy(msgs);
+
+	return cnt;
+}
+
+/*
+ * Account for "n" bytes written from the buffers of _client_gather(): free
+ * every message written in full and leave the first one not completely
+ * written in client->out_msg.
+ */
+static void
+_client_consume(struct client_io_info *client, int n, int skip)
+{
+	while (client->out_msg) {
+		if (n < client->out_remaining) {
+			client->out_remaining -= n;
+			return;
+		}
+		n -= client->out_remaining;
+		_free_outgoing_msg(client->out_msg, client->job);
+		client->out_msg = list_dequeue(client->msg_queue);
+		if (client->out_msg)
+			client->out_remaining = client->out_msg->length - skip;
+	}
+}
+
+/*
+ * Write outgoing packed messages to the client socket, gathering as many
+ * queued messages as possible into one writev().
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct iovec iov[IO_BATCH_MAX];
+	int cnt, n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -458,12 +518,11 @@ _client_write(eio_obj_t *obj, List objs)
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
 	/*
-	 * Write message to socket.
+	 * Write messages to socket.
 	 */
-	buf = client->out_msg->data +
-		(client->out_msg->length - client->out_remaining);
+	cnt = _client_gather(client, iov, 0);
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, cnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -475,17 +534,8 @@ again:
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket",
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
-
-	_free_outgoing_msg(client->out_msg, client->job);
-	client->out_msg = NULL;
+	debug5("Wrote %d bytes in %d messages to socket", n, cnt);
+	_client_consume(client, n, 0);
 
 	return SLURM_SUCCESS;
 }
@@ -516,8 +566,9 @@ _local_file_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
 	void *buf;
-	int n;
+	int n, cnt;
 	struct slurm_io_header header;
+	struct iovec iov[IO_BATCH_MAX];
 	Buf header_tmp_buf;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
@@ -534,6 +585,21 @@ _local_file_write(eio_obj_t *obj, List objs)
 					io_hdr_packed_size();
 	}
 
+	/*
+	 * Without labels the message bodies are written as they are, so
+	 * write as many as possible at once.
+	 */
+	if (!client->labelio) {
+		cnt = _client_gather(client, iov, io_hdr_packed_size());
+		if ((n = write_unlabelled_iov(obj->fd, iov, cnt)) < 0) {
+			client->out_eof = true;
+			_free_all_outgoing_msgs(client->msg_queue, client->job);
+			return SLURM_ERROR;
+		}
+		_client_consume(client, n, io_hdr_packed_size());
+		return SLURM_SUCCESS;
+	}
+
 	/*
 	 * This code to make a buffer, fill it, unpack its contents, and free
 	 * it is just used to read the header to get the global task id.
@@ -766,6 +832,9 @@ _task_read(eio_obj_t *obj, List objs)
 	xassert(out->magic == TASK_OUT_MAGIC);
 
 	debug4("Entering _task_read for obj %zx", (size_t)obj);
+	if (_task_read_direct(obj))
+		return SLURM_SUCCESS;
+
 	len = cbuf_free(out->buf);
 	if (len > 0 && !out->eof) {
 again:
@@ -803,6 +872,51 @@ again:
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Without line buffering the output is sent in whatever chunks it is read,
+ * so while nothing is held in the cbuf read it straight into a message
+ * buffer rather than through the cbuf. Return 1 if the read was handled.
+ */
+static int
+_task_read_direct(eio_obj_t *obj)
+{
+	struct task_read_info *out = (struct task_read_info *)obj->arg;
+	struct io_buf *msg;
+	int n;
+
+	if ((out->job->flags & LAUNCH_BUFFERED_IO) || out->eof ||
+	    (cbuf_used(out->buf) > 0) || !_outgoing_buf_free(out->job))
+		return 0;
+
+	msg = list_dequeue(out->job->free_outgoing);
+again:
+	if ((n = read(obj->fd, msg->data + io_hdr_packed_size(),
+		      MAX_MSG_LEN)) < 0) {
+		if (errno == EINTR)
+			goto again;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			debug5("_task_read returned EAGAIN");
+			list_enqueue(out->job->free_outgoing, msg);
+			return 1;
+		}
+		debug5("  error in _task_read: %m");
+	}
+	if (n <= 0) {
+		debug5("  got eof on task");
+		list_enqueue(out->job->free_outgoing, msg);
+		out->eof = true;
+		if (!out->eof_msg_sent)
+			_send_eof_msg(out);
+		return 1;
+	}
+
+	debug5("************************ %d bytes read from task %s", n,
+	       out->type == SLURM_IO_STDOUT ? "STDOUT" : "STDERR");
+	_task_pack_header(out, msg, n);
+	_route_msg(out, msg);
+	return 1;
+}
+
 /**********************************************************************
  * Pseudo terminal functions
  **********************************************************************/
@@ -1290,10 +1404,7 @@ static void
 _route_msg_task_to_client(eio_obj_t *obj)
 {
 	struct task_read_info *out = (struct task_read_info *)obj->arg;
-	struct client_io_info *client;
 	struct io_buf *msg = NULL;
-	eio_obj_t *eio;
-	ListIterator clients;
 
 	/* Pack task output into messages for transfer to a client */
 	while (cbuf_used(out->buf) > 0
@@ -1302,38 +1413,49 @@ _route_msg_task_to_client(eio_obj_t *obj)
 		msg = _task_build_message(out, out->job, out->buf);
 		if (msg == NULL)
 			return;
+		_route_msg(out, msg);
+	}
+}
 
-		/* Add message to the msg_queue of all clients */
-		clients = list_iterator_create(out->job->clients);
-		while ((eio = list_next(clients))) {
-			client = (struct client_io_info *)eio->arg;
-			if (client->out_eof == true)
-				continue;
+/* Add a packed task output message to the queues of all clients taking it
+ * and to the outgoing message cache */
+static void
+_route_msg(struct task_read_info *out, struct io_buf *msg)
+{
+	struct client_io_info *client;
+	eio_obj_t *eio;
+	ListIterator clients;
 
-			/* Some clients only take certain I/O streams */
-			if (out->type==SLURM_IO_STDOUT) {
-				if (client->ltaskid_stdout != -1 &&
-				    client->ltaskid_stdout != out->ltaskid)
-					continue;
-			}
-			if (out->type==SLURM_IO_STDERR) {
-				if (client->ltaskid_stderr != -1 &&
-				    client->ltaskid_stderr != out->ltaskid)
-					continue;
-			}
+	/* Add message to the msg_queue of all clients */
+	clients = list_iterator_create(out->job->clients);
+	while ((eio = list_next(clients))) {
+		client = (struct client_io_info *)eio->arg;
+		if (client->out_eof == true)
+			continue;
 
-			debug5("======================== Enqueued message");
-			xassert(client->magic == CLIENT_IO_MAGIC);
-			if (list_enqueue(client->msg_queue, msg))
-				msg->ref_count++;
+		/* Some clients only take certain I/O streams */
+		if (out->type==SLURM_IO_STDOUT) {
+			if (client->ltaskid_stdout != -1 &&
+			    client->ltaskid_stdout != out->ltaskid)
+				continue;
+		}
+		if (out->type==SLURM_IO_STDERR) {
+			if (client->ltaskid_stderr != -1 &&
+			    client->ltaskid_stderr != out->ltaskid)
+				continue;
 		}
-		list_iterator_destroy(clients);
 
-		/* Update the outgoing message cache */
-		if (list_enqueue(out->job->outgoing_cache, msg)) {
+		debug5("======================== Enqueued message");
+		xassert(client->magic == CLIENT_IO_MAGIC);
+		if (list_enqueue(client->msg_queue, msg))
 			msg->ref_count++;
-			_shrink_msg_cache(out->job->outgoing_cache, out->job);
-		}
+	}
+	list_iterator_destroy(clients);
+
+	/* Update the outgoing message cache */
+	if (list_enqueue(out->job->outgoing_cache, msg)) {
+		msg->ref_count++;
+		_shrink_msg_cache(out->job->outgoing_cache, out->job);
 	}
 }
 
@@ -1793,10 +1915,8 @@ _task_build_message(struct task_read_info *out, stepd_step_rec_t *job, cbuf_t cb
 {
 	struct io_buf *msg;
 	char *ptr;
-	Buf packbuf;
 	bool must_truncate = false;
 	int avail;
-	struct slurm_io_header header;
 	int n;
 	bool buffered_stdio = job->flags & LAUNCH_BUFFERED_IO;
 
@@ -1840,16 +1960,32 @@ _task_build_message(struct task_read_info *out, stepd_step_rec_t *job, cbuf_t cb
 		}
 	}
 
+	debug4("%s: header.length = %d", __func__, n);
+	_task_pack_header(out, msg, n);
+
+	debug4("%s: Leaving", __func__);
+	return msg;
+}
+
+/*
+ * Pack the header of a message carrying "length" bytes of output from the
+ * task of "out" into the start of msg.
+ */
+static void
+_task_pack_header(struct task_read_info *out, struct io_buf *msg, int length)
+{
+	struct slurm_io_header header;
+	Buf packbuf;
+
 	header.type = out->type;
 	header.ltaskid = out->ltaskid;
 	header.gtaskid = out->gtaskid;
-	header.length = n;
+	header.length = length;
 
-	debug4("%s: header.length = %d", __func__, n);
 	packbuf = create_buf(msg->data, io_hdr_packed_size());
 	if (!packbuf) {
 		fatal("Failure to allocate memory for a message header");
-		return msg;	/* Fix for CLANG false positive error */
+		return;	/* Fix for CLANG false positive error */
 	}
 	io_hdr_pack(&header, packbuf);
 	msg->length = io_hdr_packed_size() + header.length;
@@ -1858,9 +1994,6 @@ _task_build_message(struct task_read_info *out, stepd_step_rec_t *job, cbuf_t cb
 	/* free the Buf packbuf, but not the memory to which it points */
 	packbuf->head = NULL;	/* CLANG false positive bug here */
 	free_buf(packbuf);
-
-	debug4("%s: Leaving", __func__);
-	return msg;
 }
 
 struct io_buf *
@@ -1171,6 +1171,39 @@ fail1:
 	return rc;
 }
 
+/*
+ * Load every plugin used by the job manager. Each of them is only loaded
+ * once, so this may be called ahead of job_manager() by a slurmstepd still
+ * waiting for its step (see LaunchParameters=slurmstepd_pool).
+ */
+extern int mgr_load_plugins(void)
+{
+	char *ckpt_type = slurm_get_checkpoint_type();
+	int rc = SLURM_SUCCESS;
+
+	/*
+	 * Run acct_gather_conf_init() now so we don't drop permissions on any
+	 * of the gather plugins.
+	 * Preload all plugins afterwards to avoid plugin changes
+	 * (i.e. due to a Slurm upgrade) after the process starts.
+	 */
+	if ((acct_gather_conf_init() != SLURM_SUCCESS)          ||
+	    (core_spec_g_init() != SLURM_SUCCESS)		||
+	    (switch_init(1) != SLURM_SUCCESS)			||
+	    (slurmd_task_init() != SLURM_SUCCESS)		||
+	    (slurm_proctrack_init() != SLURM_SUCCESS)		||
+	    (checkpoint_init(ckpt_type) != SLURM_SUCCESS)	||
+	    (jobacct_gather_init() != SLURM_SUCCESS)		||
+	    (acct_gather_profile_init() != SLURM_SUCCESS)	||
+	    (slurm_crypto_init() != SLURM_SUCCESS)		||
+	    (job_container_init() != SLURM_SUCCESS)		||
+	    (gres_plugin_init() != SLURM_SUCCESS))
+		rc = SLURM_ERROR;
+
+	xfree(ckpt_type);
+	return rc;
+}
+
 /*
  * Executes the functions of the slurmd job manager process,
  * which runs as root and performs shared memory and interconnect
@@ -1184,7 +1217,6 @@ job_manager(stepd_step_rec_t *job)
 {
 	int  rc = SLURM_SUCCESS;
 	bool io_initialized = false;
-	char *ckpt_type = slurm_get_checkpoint_type();
 	char *err_msg = NULL;
 
 	debug3("Entered job_manager for %u.%u pid=%d",
@@ -1195,23 +1227,7 @@ job_manager(stepd_step_rec_t *job)
 		debug ("Unable to set dumpable to 1");
 #endif /* PR_SET_DUMPABLE */
 
-	/*
-	 * Run acct_gather_conf_init() now so we don't drop permissions on any
-	 * of the gather plugins.
-	 * Preload all plugins afterwards to avoid plugin changes
-	 * (i.e. due to a Slurm upgrade) after the process starts.
-	 */
-	if ((acct_gather_conf_init() != SLURM_SUCCESS)          ||
-	    (core_spec_g_init() != SLURM_SUCCESS)		||
-	    (switch_init(1) != SLURM_SUCCESS)			||
-	    (slurmd_task_init() != SLURM_SUCCESS)		||
-	    (slurm_proctrack_init() != SLURM_SUCCESS)		||
-	    (checkpoint_init(ckpt_type) != SLURM_SUCCESS)	||
-	    (jobacct_gather_init() != SLURM_SUCCESS)		||
-	    (acct_gather_profile_init() != SLURM_SUCCESS)	||
-	    (slurm_crypto_init() != SLURM_SUCCESS)		||
-	    (job_container_init() != SLURM_SUCCESS)		||
-	    (gres_plugin_init() != SLURM_SUCCESS)) {
+	if (mgr_load_plugins() != SLURM_SUCCESS) {
 		rc = SLURM_PLUGIN_NAME_INVALID;
 		goto fail1;
 	}
@@ -1470,7 +1486,6 @@ fail1:
 	if (!job->batch && core_spec_g_clear(job->cont_id))
 		error("core_spec_g_clear: %m");
 
-	xfree(ckpt_type);
 	return(rc);
 }
 
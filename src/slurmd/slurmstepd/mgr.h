@@ -68,6 +68,12 @@ stepd_step_rec_t *mgr_launch_batch_job_setup(batch_job_launch_msg_t *msg,
  */
 void mgr_launch_batch_job_cleanup(stepd_step_rec_t *job, int rc);
 
+/*
+ * Load the plugins used by job_manager(). Safe to call more than once.
+ * RET SLURM_SUCCESS or SLURM_ERROR if any plugin failed to load
+ */
+extern int mgr_load_plugins(void);
+
 /*
  * Executes the functions of the slurmd job manager process,
  * which runs as root and performs shared memory and interconnect
@@ -516,8 +516,24 @@ _init_from_slurmd(int sock, char **argv,
 	tmp_list = NULL;
 	assoc_mgr_unlock(&locks);
 
+	/*
+	 * Everything above only depends upon the node configuration, so a
+	 * slurmstepd from the slurmd's pool (LaunchParameters=slurmstepd_pool)
+	 * gets here ahead of time. Load the plugins now and wait for a step.
+	 */
+	if (mgr_load_plugins() != SLURM_SUCCESS)
+		debug("%s: failed to preload plugins", __func__);
+
 	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	while (((len = read(sock, &step_type, sizeof(int))) < 0) &&
+	       ((errno == EINTR) || (errno == EAGAIN)))
+		;
+	if (len == 0) {
+		/* slurmd discarded this pooled slurmstepd */
+		debug("%s: slurmd closed connection, exiting", __func__);
+		exit(0);
+	} else if (len != sizeof(int))
+		goto rwfail;
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
@@ -63,6 +63,39 @@
 #include "src/slurmdbd/slurmdbd.h"
 #include "src/slurmctld/slurmctld.h"
 
+#define MULT_MSG_WORKERS	4	/* threads processing a DBD_SEND_MULT_* */
+#define MULT_MSG_MIN_RUN	8	/* shorter runs are processed in place */
+
+typedef struct mult_batch mult_batch_t;
+struct mult_batch {
+	slurmdbd_conn_t *slurmdbd_conn;
+	uint32_t uid;
+	int cnt;
+	int64_t *key;		/* worker key of each item, -1 for none */
+	int *rc;		/* result of each item */
+	bool *done;		/* set once an item is processed and kept */
+	int *worker_inx;	/* worker of each item, -1 if in place */
+	int (*process) (slurmdbd_conn_t *slurmdbd_conn, mult_batch_t *batch,
+			int inx, uint32_t *uid);
+	persist_msg_t *msgs;	/* DBD_SEND_MULT_MSG requests */
+	Buf *ret_bufs;		/* and their responses */
+	dbd_job_start_msg_t **job_starts; /* DBD_SEND_MULT_JOB_START */
+	dbd_id_rc_msg_t **id_rcs;
+	int start, end;		/* run of items given to the workers */
+	int workers;		/* worker threads, 0 if none */
+	bool failed;		/* an item of the run failed, stop the run */
+	pthread_mutex_t lock;	/* protects rc, done and failed */
+#ifndef NDEBUG
+	bool drop_priv;
+#endif
+};
+
+typedef struct {
+	mult_batch_t *batch;
+	int inx;
+	slurmdbd_conn_t *slurmdbd_conn;	/* from slurmdbd_conn->workers */
+} mult_worker_t;
+
 /* Local functions */
 static bool  _validate_slurm_user(uint32_t uid);
 static bool  _validate_super_user(uint32_t uid, slurmdbd_conn_t *slurmdbd_conn);
@@ -3295,6 +3328,349 @@ end_it:
 	return rc;
 }
 
+/*
+ * Process the items of a DBD_SEND_MULT_MSG or DBD_SEND_MULT_JOB_START batch
+ * on up to MULT_MSG_WORKERS threads, each with its own database connection.
+ * An item's key picks its worker, so the records of one job are still
+ * processed in order. Items without a key, and runs of keyed items shorter
+ * than MULT_MSG_MIN_RUN, are processed in place.
+ */
+static int _mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
+			   mult_batch_t *batch, int inx, uint32_t *uid)
+{
+	_process_job_start(slurmdbd_conn, batch->job_starts[inx],
+			   batch->id_rcs[inx]);
+	return batch->id_rcs[inx]->return_code;
+}
+
+static int _mult_msg(slurmdbd_conn_t *slurmdbd_conn,
+		     mult_batch_t *batch, int inx, uint32_t *uid)
+{
+	return proc_req(slurmdbd_conn, &batch->msgs[inx],
+			&batch->ret_bufs[inx], uid);
+}
+
+/*
+ * Key of a request the workers may process, else -1. These only upsert or
+ * update the records of one job, so the requests of different jobs commute
+ * and one that is processed again, e.g. after a deadlock, does no harm.
+ */
+static int64_t _mult_msg_key(persist_msg_t *msg)
+{
+	switch (msg->msg_type) {
+	case DBD_JOB_COMPLETE:
+		return ((dbd_job_comp_msg_t *) msg->data)->job_id;
+	case DBD_JOB_START:
+		return ((dbd_job_start_msg_t *) msg->data)->job_id;
+	case DBD_STEP_COMPLETE:
+		return ((dbd_step_comp_msg_t *) msg->data)->job_id;
+	case DBD_STEP_START:
+		return ((dbd_step_start_msg_t *) msg->data)->job_id;
+	default:
+		return -1;
+	}
+}
+
+static mult_batch_t *_mult_batch_create(
+	slurmdbd_conn_t *slurmdbd_conn, uint32_t uid, int cnt,
+	int (*process) (slurmdbd_conn_t *slurmdbd_conn, mult_batch_t *batch,
+			int inx, uint32_t *uid))
+{
+	mult_batch_t *batch = xmalloc(sizeof(mult_batch_t));
+	int i;
+
+	batch->slurmdbd_conn = slurmdbd_conn;
+	batch->uid = uid;
+	batch->cnt = cnt;
+	batch->process = process;
+	batch->key = xmalloc(sizeof(int64_t) * MAX(cnt, 1));
+	for (i = 0; i < cnt; i++)
+		batch->key[i] = -1;
+	batch->rc = xmalloc(sizeof(int) * MAX(cnt, 1));
+	batch->done = xmalloc(sizeof(bool) * MAX(cnt, 1));
+	batch->worker_inx = xmalloc(sizeof(int) * MAX(cnt, 1));
+	for (i = 0; i < cnt; i++)
+		batch->worker_inx[i] = -1;
+	slurm_mutex_init(&batch->lock);
+#ifndef NDEBUG
+	batch->drop_priv = drop_priv;
+#endif
+	return batch;
+}
+
+static void _mult_batch_destroy(mult_batch_t *batch)
+{
+	int i;
+
+	if (batch->ret_bufs) {
+		for (i = 0; i < batch->cnt; i++)
+			FREE_NULL_BUFFER(batch->ret_bufs[i]);
+		xfree(batch->ret_bufs);
+	}
+	xfree(batch->msgs);
+	xfree(batch->job_starts);
+	xfree(batch->id_rcs);
+	xfree(batch->key);
+	xfree(batch->rc);
+	xfree(batch->done);
+	xfree(batch->worker_inx);
+	slurm_mutex_destroy(&batch->lock);
+	xfree(batch);
+}
+
+/* Open the worker database connections of slurmdbd_conn, RET their count */
+static int _mult_workers_open(slurmdbd_conn_t *slurmdbd_conn)
+{
+	slurmdbd_conn_t *worker;
+	void *db_conn;
+
+	if (!slurmdbd_conn->workers)
+		slurmdbd_conn->workers =
+			xmalloc(sizeof(slurmdbd_conn_t *) * MULT_MSG_WORKERS);
+
+	while (slurmdbd_conn->worker_cnt < MULT_MSG_WORKERS) {
+		errno = 0;
+		db_conn = acct_storage_g_get_connection(
+			NULL, slurmdbd_conn->conn->fd, true,
+			slurmdbd_conn->conn->cluster_name);
+		if (errno) {
+			acct_storage_g_close_connection(&db_conn);
+			break;
+		}
+		worker = xmalloc(sizeof(slurmdbd_conn_t));
+		worker->conn = slurmdbd_conn->conn;
+		worker->db_conn = db_conn;
+		worker->mult_msg = true;
+		slurmdbd_conn->workers[slurmdbd_conn->worker_cnt++] = worker;
+	}
+
+	return slurmdbd_conn->worker_cnt;
+}
+
+/* Process item i of batch on the worker's connection */
+static int _mult_worker_run(mult_worker_t *worker, int i, uint32_t *uid)
+{
+	mult_batch_t *batch = worker->batch;
+	int rc;
+
+	if (batch->ret_bufs)
+		FREE_NULL_BUFFER(batch->ret_bufs[i]);
+	rc = (batch->process)(worker->slurmdbd_conn, batch, i, uid);
+
+	slurm_mutex_lock(&batch->lock);
+	batch->rc[i] = rc;
+	batch->done[i] = true;
+	batch->worker_inx[i] = worker->inx;
+	if (rc != SLURM_SUCCESS) {
+		/* the DBD_GOT_MULT_MSG reply stops there anyway */
+		if (batch->msgs)
+			batch->failed = true;
+		/* whatever was inserted is rolled back */
+		if (batch->id_rcs)
+			batch->id_rcs[i]->db_index = 0;
+	}
+	slurm_mutex_unlock(&batch->lock);
+
+	return rc;
+}
+
+/* Commit the worker's connection, or roll it back if anything was lost */
+static int _mult_worker_commit(mult_worker_t *worker)
+{
+	void *db_conn = worker->slurmdbd_conn->db_conn;
+
+	if ((jobacct_storage_g_step_start_flush(db_conn) == SLURM_SUCCESS) &&
+	    (acct_storage_g_commit(db_conn, 1) == SLURM_SUCCESS))
+		return SLURM_SUCCESS;
+
+	acct_storage_g_commit(db_conn, 0);
+	return SLURM_ERROR;
+}
+
+/*
+ * Process again the items [begin, end) the worker stored before its
+ * transaction was rolled back, and commit them
+ */
+static int _mult_worker_redo(mult_worker_t *worker, int begin, int end,
+			     uint32_t *uid)
+{
+	mult_batch_t *batch = worker->batch;
+	int i;
+
+	for (i = begin; i < end; i++) {
+		if ((batch->worker_inx[i] != worker->inx) || !batch->done[i] ||
+		    (batch->rc[i] != SLURM_SUCCESS))
+			continue;
+		if (_mult_worker_run(worker, i, uid) != SLURM_SUCCESS)
+			return SLURM_ERROR;
+	}
+
+	return _mult_worker_commit(worker);
+}
+
+/*
+ * Forget the items [begin, end) the worker stored before its transaction
+ * was rolled back. The reply tells the slurmctld to send them again.
+ */
+static void _mult_worker_undo(mult_worker_t *worker, int begin, int end)
+{
+	mult_batch_t *batch = worker->batch;
+	int i;
+
+	slurm_mutex_lock(&batch->lock);
+	for (i = begin; i < end; i++) {
+		if ((batch->worker_inx[i] != worker->inx) || !batch->done[i] ||
+		    (batch->rc[i] != SLURM_SUCCESS))
+			continue;
+		batch->done[i] = false;
+		if (batch->id_rcs) {
+			batch->id_rcs[i]->db_index = 0;
+			batch->id_rcs[i]->return_code = SLURM_ERROR;
+		}
+		if (batch->msgs)
+			batch->failed = true;
+	}
+	slurm_mutex_unlock(&batch->lock);
+}
+
+static void *_mult_worker(void *arg)
+{
+	mult_worker_t *worker = (mult_worker_t *) arg;
+	mult_batch_t *batch = worker->batch;
+	uint32_t uid = batch->uid;
+	bool failed;
+	int i, first = batch->start;	/* first item not committed */
+
+#ifndef NDEBUG
+	drop_priv = batch->drop_priv;
+#endif
+	for (i = batch->start; i < batch->end; i++) {
+		if ((batch->key[i] % batch->workers) != worker->inx)
+			continue;
+		slurm_mutex_lock(&batch->lock);
+		failed = batch->failed;
+		slurm_mutex_unlock(&batch->lock);
+		if (failed)
+			break;
+
+		if (_mult_worker_run(worker, i, &uid) == SLURM_SUCCESS)
+			continue;
+
+		/*
+		 * An error such as an InnoDB deadlock between the workers may
+		 * have rolled back everything since the last commit. Roll
+		 * back the rest too and process those items once more.
+		 */
+		acct_storage_g_commit(worker->slurmdbd_conn->db_conn, 0);
+		if (_mult_worker_redo(worker, first, i, &uid) !=
+		    SLURM_SUCCESS) {
+			_mult_worker_undo(worker, first, i);
+			return NULL;
+		}
+		first = i + 1;
+		if (batch->msgs)
+			break;
+	}
+
+	/* with CommitDelay nothing else commits this connection */
+	if (_mult_worker_commit(worker) != SLURM_SUCCESS)
+		_mult_worker_undo(worker, first, batch->end);
+
+	return NULL;
+}
+
+/*
+ * Process items [0, cnt) of batch. A DBD_SEND_MULT_MSG batch stops at the
+ * first item that fails, since its reply stops there.
+ */
+static void _mult_batch_run(mult_batch_t *batch, int cnt)
+{
+	slurmdbd_conn_t *slurmdbd_conn = batch->slurmdbd_conn;
+	mult_worker_t workers[MULT_MSG_WORKERS];
+	pthread_t threads[MULT_MSG_WORKERS];
+	int i = 0, end, w, rc;
+	bool opened = false;
+
+	while (i < cnt) {
+		for (end = i; (end < cnt) && (batch->key[end] >= 0); end++)
+			;
+
+		/*
+		 * Until the cluster is registered the handlers may register
+		 * it through slurmdbd_conn, so they must run in place.
+		 */
+		if (((end - i) >= MULT_MSG_MIN_RUN) &&
+		    slurmdbd_conn->conn->rem_port && !opened) {
+			batch->workers = _mult_workers_open(slurmdbd_conn);
+			opened = true;
+		}
+		if (((end - i) < MULT_MSG_MIN_RUN) ||
+		    !slurmdbd_conn->conn->rem_port || (batch->workers < 2)) {
+			/* in place, up to and including the next barrier */
+			end = MAX(end, i + 1);
+			for ( ; i < end; i++) {
+				rc = (batch->process)(slurmdbd_conn, batch, i,
+						      &batch->uid);
+				batch->rc[i] = rc;
+				batch->done[i] = true;
+				if ((rc != SLURM_SUCCESS) && batch->msgs)
+					return;
+			}
+			continue;
+		}
+
+		/* the workers' connections must see what came before */
+		acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+
+		batch->start = i;
+		batch->end = end;
+		for (w = 0; w < batch->workers; w++) {
+			workers[w].batch = batch;
+			workers[w].inx = w;
+			workers[w].slurmdbd_conn = slurmdbd_conn->workers[w];
+			slurm_thread_create(&threads[w], _mult_worker,
+					    &workers[w]);
+		}
+		for (w = 0; w < batch->workers; w++)
+			pthread_join(threads[w], NULL);
+
+		if (batch->failed)
+			return;
+		i = end;
+	}
+}
+
+/*
+ * Send the step starts that the items processed in place queued on the
+ * connection of batch->slurmdbd_conn. The workers send theirs before they
+ * commit. If any was lost fail the first DBD_STEP_START processed in place,
+ * so the reply stops there and the slurmctld resends it and everything
+ * after it.
+ */
+static void _mult_step_start_flush(mult_batch_t *batch)
+{
+	slurmdbd_conn_t *slurmdbd_conn = batch->slurmdbd_conn;
+	int i, rc;
+
+	if ((rc = jobacct_storage_g_step_start_flush(slurmdbd_conn->db_conn))
+	    == SLURM_SUCCESS)
+		return;
+
+	for (i = 0; i < batch->cnt; i++) {
+		if (!batch->done[i] || (batch->worker_inx[i] != -1) ||
+		    (batch->msgs[i].msg_type != DBD_STEP_START))
+			continue;
+		error("CONN:%u DBD_SEND_MULT_MSG lost step starts, "
+		      "failing item %d", slurmdbd_conn->conn->fd, i);
+		batch->rc[i] = rc;
+		FREE_NULL_BUFFER(batch->ret_bufs[i]);
+		batch->ret_bufs[i] = slurm_persist_make_rc_msg(
+			slurmdbd_conn->conn, rc, "step start not stored",
+			DBD_STEP_START);
+		break;
+	}
+}
+
 static int   _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 				  persist_msg_t *msg, Buf *out_buffer,
 				  uint32_t *uid)
@@ -3305,6 +3681,8 @@ static int   _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 	ListIterator itr = NULL;
 	dbd_job_start_msg_t *job_start_msg;
 	dbd_id_rc_msg_t *id_rc_msg;
+	mult_batch_t *batch;
+	int i = 0;
 	/* DEF_TIMERS; */
 
 	if (!_validate_slurm_user(*uid)) {
@@ -3319,14 +3697,24 @@ static int   _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 
 	list_msg.my_list = list_create(slurmdbd_free_id_rc_msg);
 	/* START_TIMER; */
+	batch = _mult_batch_create(slurmdbd_conn, *uid,
+				   list_count(get_msg->my_list),
+				   _mult_job_start);
+	batch->job_starts = xmalloc(sizeof(dbd_job_start_msg_t *) *
+				    batch->cnt);
+	batch->id_rcs = xmalloc(sizeof(dbd_id_rc_msg_t *) * batch->cnt);
 	itr = list_iterator_create(get_msg->my_list);
 	while ((job_start_msg = list_next(itr))) {
 	        id_rc_msg = xmalloc(sizeof(dbd_id_rc_msg_t));
 		list_append(list_msg.my_list, id_rc_msg);
 
-		_process_job_start(slurmdbd_conn, job_start_msg, id_rc_msg);
+		batch->job_starts[i] = job_start_msg;
+		batch->id_rcs[i] = id_rc_msg;
+		batch->key[i++] = job_start_msg->job_id;
 	}
 	list_iterator_destroy(itr);
+	_mult_batch_run(batch, batch->cnt);
+	_mult_batch_destroy(batch);
 	/* END_TIMER; */
 	/* info("%d multi job took %s", */
 	/*      list_count(get_msg->my_list), TIME_STR); */
@@ -3348,8 +3736,9 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 	dbd_list_msg_t list_msg = { NULL };
 	char *comment = NULL;
 	ListIterator itr = NULL;
-	Buf req_buf = NULL, ret_buf = NULL;
-	int rc = SLURM_SUCCESS;
+	Buf req_buf = NULL;
+	mult_batch_t *batch;
+	int cnt = 0, i, rc = SLURM_SUCCESS;
 	/* DEF_TIMERS; */
 
 	if (!_validate_slurm_user(*uid)) {
@@ -3364,28 +3753,50 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
 	/* START_TIMER; */
+	batch = _mult_batch_create(slurmdbd_conn, *uid,
+				   list_count(get_msg->my_list), _mult_msg);
+	batch->msgs = xmalloc(sizeof(persist_msg_t) * batch->cnt);
+	batch->ret_bufs = xmalloc(sizeof(Buf) * batch->cnt);
+
+	/* Unpack the requests up to the first one that fails */
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
-		persist_msg_t sub_msg;
-
-		ret_buf = NULL;
-
 		rc = slurm_persist_conn_process_msg(
-			slurmdbd_conn->conn, &sub_msg,
+			slurmdbd_conn->conn, &batch->msgs[cnt],
 			get_buf_data(req_buf),
-			size_buf(req_buf), &ret_buf, 0);
-
-		if (rc == SLURM_SUCCESS) {
-			rc = proc_req(slurmdbd_conn, &sub_msg, &ret_buf, uid);
-			slurmdbd_free_msg((slurmdbd_msg_t *)&sub_msg);
+			size_buf(req_buf), &batch->ret_bufs[cnt], 0);
+		if (rc != SLURM_SUCCESS) {
+			batch->rc[cnt] = rc;
+			batch->done[cnt] = true;
+			break;
 		}
+		batch->key[cnt] = _mult_msg_key(&batch->msgs[cnt]);
+		cnt++;
+	}
+	list_iterator_destroy(itr);
+
+	slurmdbd_conn->mult_msg = true;
+	_mult_batch_run(batch, cnt);
+	slurmdbd_conn->mult_msg = false;
+	_mult_step_start_flush(batch);
 
-		if (ret_buf)
-			list_append(list_msg.my_list, ret_buf);
-		if (rc != SLURM_SUCCESS)
+	/*
+	 * Reply in request order, up to and including the first failure.
+	 * The slurmctld resends the requests past it.
+	 */
+	for (i = 0; i < batch->cnt; i++) {
+		if (!batch->done[i])
+			break;
+		if (batch->ret_bufs[i]) {
+			list_append(list_msg.my_list, batch->ret_bufs[i]);
+			batch->ret_bufs[i] = NULL;
+		}
+		if (batch->rc[i] != SLURM_SUCCESS)
 			break;
 	}
-	list_iterator_destroy(itr);
+	for (i = 0; i < cnt; i++)
+		slurmdbd_free_msg((slurmdbd_msg_t *) &batch->msgs[i]);
+	_mult_batch_destroy(batch);
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
@@ -3522,6 +3933,13 @@ static int  _step_start(slurmdbd_conn_t *slurmdbd_conn,
 	if (rc && errno == 740) /* meaning data is already there */
 		rc = SLURM_SUCCESS;
 
+	/*
+	 * The step may only be queued, send it before saying it is stored.
+	 * _send_mult_msg() does this once for all of its items.
+	 */
+	if ((rc == SLURM_SUCCESS) && !slurmdbd_conn->mult_msg)
+		rc = jobacct_storage_g_step_start_flush(slurmdbd_conn->db_conn);
+
 	/* just in case this gets set we need to clear it */
 	xfree(job.wckey);
 
@@ -43,10 +43,14 @@
 #include "src/common/pack.h"
 #include "src/common/slurm_protocol_defs.h"
 
-typedef struct {
+typedef struct slurmdbd_conn {
 	slurm_persist_conn_t *conn;
 	void *db_conn; /* database connection */
 	char *tres_str;
+	/* DBD_SEND_MULT_* workers, sharing conn but with their own db_conn */
+	struct slurmdbd_conn **workers;
+	int worker_cnt;
+	bool mult_msg; /* processing the items of a DBD_SEND_MULT_MSG */
 } slurmdbd_conn_t;
 
 /* Process an incoming RPC
@@ -136,6 +136,7 @@ extern void rpc_mgr_wake(void)
 static void _connection_fini_callback(void *arg)
 {
 	slurmdbd_conn_t *conn = (slurmdbd_conn_t *) arg;
+	int i;
 
 	if (conn->conn->rem_port) {
 		if (!shutdown_time) {
@@ -169,6 +170,11 @@ static void _connection_fini_callback(void *arg)
 		acct_storage_g_commit(conn->db_conn, 1);
 	}
 
+	for (i = 0; i < conn->worker_cnt; i++) {
+		acct_storage_g_close_connection(&conn->workers[i]->db_conn);
+		xfree(conn->workers[i]);
+	}
+	xfree(conn->workers);
 	acct_storage_g_close_connection(&conn->db_conn);
 	/* handled directly in the internal persist_conn code */
 	//slurm_persist_conn_members_destroy(&conn->conn);
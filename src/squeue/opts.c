@@ -64,6 +64,7 @@
 #define OPT_LONG_LOCAL        0x106
 #define OPT_LONG_SIBLING      0x107
 #define OPT_LONG_FEDR         0x108
+#define OPT_LONG_BINARY       0x109
 
 /* FUNCTIONS */
 static List  _build_job_list( char* str );
@@ -99,6 +100,7 @@ parse_command_line( int argc, char* *argv )
 		{"all",        no_argument,       0, 'a'},
 		{"array",      no_argument,       0, 'r'},
 		{"array-unique",no_argument,      0, OPT_LONG_ARRAY_UNIQUE},
+		{"binary",     no_argument,       0, OPT_LONG_BINARY},
 		{"Format",     required_argument, 0, 'O'},
 		{"format",     required_argument, 0, 'o'},
 		{"federation", no_argument,       0, OPT_LONG_FEDR},
@@ -318,6 +320,9 @@ parse_command_line( int argc, char* *argv )
 		case OPT_LONG_ARRAY_UNIQUE:
 			params.array_unique_flag = true;
 			break;
+		case OPT_LONG_BINARY:
+			params.binary = true;
+			break;
 		case OPT_LONG_HELP:
 			_help();
 			exit(0);
@@ -379,6 +384,16 @@ parse_command_line( int argc, char* *argv )
 		}
 	}
 
+	if (params.binary && params.iterate) {
+		error("Incompatible options --binary and --iterate");
+		exit(1);
+	}
+	if (params.binary && params.clusters &&
+	    (list_count(params.clusters) > 1)) {
+		error("--binary writes one table, specify a single cluster");
+		exit(1);
+	}
+
 	if ( params.nodes ) {
 		char *name1 = NULL;
 		char *name2 = NULL;
@@ -2137,7 +2152,7 @@ Usage: squeue [-A account] [--clusters names] [-i seconds] [--job jobid]\n\
               [--reservation reservation] [--sort fields] [--start]\n\
               [--step step_id] [-t states] [-u user_name] [--usage]\n\
               [-L licenses] [-w nodes] [--federation] [--local] [--sibling]\n\
-	      [-ahjlrsv]\n");
+	      [--binary] [-ahjlrsv]\n");
 }
 
 static void _help(void)
@@ -2149,6 +2164,8 @@ Usage: squeue [OPTIONS]\n\
   -a, --all                       display jobs in hidden partitions\n\
       --array-unique              display one unique pending job array\n\
                                   element per line\n\
+      --binary                    write a binary columnar table, see\n\
+                                  squeue(1), instead of text\n\
       --federation                Report federated information if a member\n\
                                   of one\n\
   -h, --noheader                  no headers on output\n\
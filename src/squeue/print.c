@@ -39,12 +39,14 @@
 \*****************************************************************************/
 
 #include <grp.h>
+#include <stdarg.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 #include <sys/types.h>
 
+#include "src/common/columnar.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/hostlist.h"
 #include "src/common/list.h"
@@ -67,6 +69,11 @@ static void	_job_list_del(void *x);
 static uint32_t	_part_get_prio_tier(char *part_name);
 static void	_part_state_free(void);
 static void	_part_state_load(void);
+static void	_binary_field(int inx, bool header);
+static int	_binary_finish(void);
+static void	_binary_start(List format);
+static int	_out(const char *fmt, ...)
+  __attribute__ ((format (printf, 1, 2)));
 static int	_print_str(char *str, int width, bool right, bool cut_output);
 
 static int _print_job_from_format(void *x, void *arg);
@@ -74,6 +81,12 @@ static int _print_step_from_format(void *x, void *arg);
 
 static partition_info_msg_t *part_info_msg = NULL;
 
+/* --binary: the table being built, the text of the field being printed and
+ * the column of each format list entry (-1 for entries with no header) */
+static columnar_t *print_dump = NULL;
+static char *print_cell = NULL;
+static int *print_cols = NULL;
+
 /*****************************************************************************
  * Global Print Functions
  *****************************************************************************/
@@ -86,7 +99,10 @@ int print_jobs_array(job_info_t * jobs, int size, List format)
 	List l;
 
 	l = list_create(_job_list_del);
-	if (!params.no_header)
+	if (params.binary) {
+		_binary_start(format);
+		_print_job_from_format(NULL, format);
+	} else if (!params.no_header)
 		_print_job_from_format(NULL, format);
 	_part_state_load();
 
@@ -128,12 +144,17 @@ int print_jobs_array(job_info_t * jobs, int size, List format)
 	list_for_each(l, _print_job_from_format, format);
 	FREE_NULL_LIST(l);
 
+	if (params.binary)
+		return _binary_finish();
 	return SLURM_SUCCESS;
 }
 
 int print_steps_array(job_step_info_t * steps, int size, List format)
 {
-	if (!params.no_header)
+	if (params.binary) {
+		_binary_start(format);
+		_print_step_from_format(NULL, format);
+	} else if (!params.no_header)
 		_print_step_from_format(NULL, format);
 
 	if (size > 0) {
@@ -156,6 +177,8 @@ int print_steps_array(job_step_info_t * steps, int size, List format)
 		FREE_NULL_LIST(step_list);
 	}
 
+	if (params.binary)
+		return _binary_finish();
 	return SLURM_SUCCESS;
 }
 
@@ -294,6 +317,75 @@ static void _part_state_load(void)
 		slurm_perror ("slurm_load_partitions");
 }
 
+/* printf() to stdout, or to the current field's text with --binary */
+static int _out(const char *fmt, ...)
+{
+	char buf[256], *tmp;
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	if (!print_dump) {
+		len = vprintf(fmt, ap);
+		va_end(ap);
+		return len;
+	}
+	len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (len < 0)
+		return len;
+	if (len < sizeof(buf)) {
+		xstrcat(print_cell, buf);
+		return len;
+	}
+	tmp = xmalloc(len + 1);
+	va_start(ap, fmt);
+	vsnprintf(tmp, len + 1, fmt, ap);
+	va_end(ap);
+	xstrcat(print_cell, tmp);
+	xfree(tmp);
+	return len;
+}
+
+/* Start a --binary table with one column per entry of a format list */
+static void _binary_start(List format)
+{
+	print_dump = columnar_create();
+	print_cols = xmalloc(sizeof(int) * MAX(list_count(format), 1));
+}
+
+/*
+ * Store the text printed for format list entry inx: as the column name in
+ * the header pass, else as the value of its column in the current row.
+ * Entries with no header (e.g. the %% prefix) get no column.
+ */
+static void _binary_field(int inx, bool header)
+{
+	if (header) {
+		if (print_cell && print_cell[0])
+			print_cols[inx] = columnar_add_column(
+				print_dump, print_cell, COLUMNAR_STRING);
+		else
+			print_cols[inx] = -1;
+	} else if (print_cols[inx] >= 0) {
+		columnar_set_str(print_dump, print_cols[inx], print_cell);
+	}
+	xfree(print_cell);
+}
+
+/* Write the --binary table to stdout and free it */
+static int _binary_finish(void)
+{
+	int rc = columnar_write(print_dump, stdout);
+
+	if (rc != SLURM_SUCCESS)
+		error("write of binary output failed: %m");
+	columnar_destroy(print_dump);
+	print_dump = NULL;
+	xfree(print_cols);
+	return rc;
+}
+
 static int _print_str(char *str, int width, bool right, bool cut_output)
 {
 	char format[64];
@@ -315,17 +407,17 @@ static int _print_str(char *str, int width, bool right, bool cut_output)
 	}
 
 	if ((width <= 0) || (cut_output == false) ) {
-		if ((printed = printf(format, str)) < 0)
+		if ((printed = _out(format, str)) < 0)
 			return printed;
 	} else {
 		char temp[width + 1];
 		snprintf(temp, width + 1, format, str);
-		if ((printed = printf("%s",temp)) < 0)
+		if ((printed = _out("%s",temp)) < 0)
 			return printed;
 	}
 
 	while (printed++ < width)
-		printf(" ");
+		_out(" ");
 
 	return printed;
 }
@@ -400,9 +492,17 @@ static int _print_one_job_from_format(job_info_t * job, List list)
 {
 	ListIterator iter = list_iterator_create(list);
 	job_format_t *current;
-	int total_width = 0;
+	int total_width = 0, inx = 0;
 
 	while ((current = (job_format_t *) list_next(iter)) != NULL) {
+		if (print_dump) {
+			/* the field's own text, with no padding */
+			if (current->function(job, 0, false, NULL) !=
+			    SLURM_SUCCESS)
+				return SLURM_ERROR;
+			_binary_field(inx++, (job == NULL));
+			continue;
+		}
 		if (current->
 		    function(job, current->width, current->right_justify,
 			     current->suffix)
@@ -415,7 +515,10 @@ static int _print_one_job_from_format(job_info_t * job, List list)
 	}
 	list_iterator_destroy(iter);
 
-	printf("\n");
+	if (!print_dump)
+		printf("\n");
+	else if (job)
+		columnar_end_row(print_dump);
 	return SLURM_SUCCESS;
 }
 
@@ -1122,12 +1225,12 @@ int _print_job_node_inx(job_info_t * job, int width, bool right, char* suffix)
 		int curr_width = 0;
 		while (*current != -1 && curr_width < width) {
 			if (curr_width)
-				printf(",");
+				_out(",");
 			curr_width += _print_int(*current, width, right, true);
 			current++;
 		}
 		while (curr_width < width)
-			curr_width += printf(" ");
+			curr_width += _out(" ");
 	}
 	if (suffix)
 		printf("%s", suffix);
@@ -1423,10 +1526,10 @@ _print_job_req_node_inx(job_info_t * job, int width, bool right_justify,
 			curr_width +=
 			    _print_int(*current, width, right_justify,
 				       true);
-			printf(",");
+			_out(",");
 		}
 		while (curr_width < width)
-			curr_width += printf(" ");
+			curr_width += _out(" ");
 	}
 	if (suffix)
 		printf("%s", suffix);
@@ -1446,10 +1549,10 @@ _print_job_exc_node_inx(job_info_t * job, int width, bool right_justify,
 			curr_width +=
 			    _print_int(*current, width, right_justify,
 				       true);
-			printf(",");
+			_out(",");
 		}
 		while (curr_width < width)
-			curr_width += printf(" ");
+			curr_width += _out(" ");
 	}
 	if (suffix)
 		printf("%s", suffix);
@@ -2357,9 +2460,17 @@ static int _print_step_from_format(void *x, void *arg)
 	List list = (List) arg;
 	ListIterator i = list_iterator_create(list);
 	step_format_t *current;
-	int total_width = 0;
+	int total_width = 0, inx = 0;
 
 	while ((current = (step_format_t *) list_next(i)) != NULL) {
+		if (print_dump) {
+			/* the field's own text, with no padding */
+			if (current->function(job_step, 0, false, NULL) !=
+			    SLURM_SUCCESS)
+				return SLURM_ERROR;
+			_binary_field(inx++, (job_step == NULL));
+			continue;
+		}
 		if (current->
 		    function(job_step, current->width,
 			     current->right_justify, current->suffix)
@@ -2371,7 +2482,10 @@ static int _print_step_from_format(void *x, void *arg)
 			total_width += 10;
 	}
 	list_iterator_destroy(i);
-	printf("\n");
+	if (!print_dump)
+		printf("\n");
+	else if (job_step)
+		columnar_end_row(print_dump);
 
 	return SLURM_SUCCESS;
 }
@@ -2694,12 +2808,12 @@ int _print_step_node_inx(job_step_info_t * step, int width, bool right,
 		int curr_width = 0;
 		while (*current != -1 && curr_width < width) {
 			if (curr_width)
-				printf(",");
+				_out(",");
 			curr_width += _print_int(*current, width, right, true);
 			current++;
 		}
 		while (curr_width < width)
-			curr_width += printf(" ");
+			curr_width += _out(" ");
 	}
 
 	if (suffix)
@@ -87,7 +87,7 @@ main (int argc, char **argv)
 		working_cluster_rec = list_peek(params.clusters);
 
 	while (1) {
-		if ((!params.no_header) &&
+		if (!params.no_header && !params.binary &&
 		    (params.iterate || params.verbose || params.long_list))
 			_print_date ();
 
@@ -122,7 +122,8 @@ static int _multi_cluster(List clusters)
 			first = false;
 		else
 			printf("\n");
-		printf("CLUSTER: %s\n", working_cluster_rec->name);
+		if (!params.binary)
+			printf("CLUSTER: %s\n", working_cluster_rec->name);
 		rc2 = _get_info(true);
 		rc = MAX(rc, rc2);
 	}
@@ -251,9 +252,8 @@ _print_job ( bool clear_old )
 			parse_long_format(params.format_long);
 	}
 
-	print_jobs_array(new_job_ptr->job_array, new_job_ptr->record_count,
-			 params.format_list) ;
-	return SLURM_SUCCESS;
+	return print_jobs_array(new_job_ptr->job_array,
+				new_job_ptr->record_count, params.format_list);
 }
 
 
@@ -310,10 +310,9 @@ _print_job_steps( bool clear_old )
 			parse_long_format(params.format_long);
 	}
 
-	print_steps_array( new_step_ptr->job_steps,
-			   new_step_ptr->job_step_count,
-			   params.format_list );
-	return SLURM_SUCCESS;
+	return print_steps_array(new_step_ptr->job_steps,
+				 new_step_ptr->job_step_count,
+				 params.format_list);
 }
 
 
@@ -68,6 +68,7 @@ struct squeue_parameters {
 	bool all_flag;
 	bool array_flag;
 	bool array_unique_flag;
+	bool binary;
 	bool federation_flag;
 	int  iterate;
 	bool job_flag;
@@ -79,7 +79,7 @@ static int _set_wckey_cond(int *start, int argc, char **argv,
 		return -1;
 	}
 
-	wckey_cond->with_usage = 1;
+	wckey_cond->with_usage = SLURMDB_USAGE_SUMMED;
 	wckey_cond->with_deleted = 1;
 
 	if (!wckey_cond->cluster_list)
@@ -187,7 +187,7 @@ static int _set_assoc_cond(int *start, int argc, char **argv,
 		return SLURM_ERROR;
 	}
 
-	assoc_cond->with_usage = 1;
+	assoc_cond->with_usage = SLURMDB_USAGE_SUMMED;
 	assoc_cond->with_deleted = 1;
 
 	if (!assoc_cond->cluster_list)
@@ -75,7 +75,7 @@ static int _set_cond(int *start, int argc, char **argv,
 	if (!user_cond->assoc_cond) {
 		user_cond->assoc_cond =
 			xmalloc(sizeof(slurmdb_assoc_cond_t));
-		user_cond->assoc_cond->with_usage = 1;
+		user_cond->assoc_cond->with_usage = SLURMDB_USAGE_SUMMED;
 	}
 	assoc_cond = user_cond->assoc_cond;
 
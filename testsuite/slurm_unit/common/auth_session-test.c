@@ -0,0 +1,327 @@
+/* Test of src/common/auth_session.c, with a stand-in for munge that counts
+ * how often credentials are encoded and decoded and remembers which were,
+ * and a stand-in for the MAC.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include <src/common/auth_session.h>
+#include <src/common/slurm_auth.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NMSGS 2000
+#define MAX_DECODED 64
+
+static int encode_cnt = 0, decode_cnt = 0;
+static time_t encode_offset = 0;	/* added to the encode time */
+static bool encode_unrestricted = false; /* anyone may decode creds */
+static char *decoded[MAX_DECODED];	/* like the replay cache of munged */
+static int decoded_cnt = 0;
+
+/*
+ * "fake:<uid>:<serial>:<encode time>:<ttl>:<restrict uid>:<hex payload>",
+ * the serial keeps creds unique
+ */
+static char *_fake_encode(void *payload, int len, int ttl,
+			  uid_t restrict_uid, void *arg)
+{
+	unsigned char *p = payload;
+	char *cred = NULL;
+	int i;
+
+	if (encode_unrestricted)
+		restrict_uid = (uid_t) -1;
+	xstrfmtcat(cred, "fake:%d:%d:%ld:%d:%u:", *(int *) arg, ++encode_cnt,
+		   (long) (time(NULL) + encode_offset), ttl,
+		   (unsigned int) restrict_uid);
+	for (i = 0; i < len; i++)
+		xstrfmtcat(cred, "%02x", p[i]);
+	return cred;
+}
+
+static int _fake_decode(char *cred, void *payload, int *len,
+			auth_session_cred_info_t *info, void *arg)
+{
+	unsigned char *p = payload;
+	char *hex;
+	long encoded;
+	unsigned int restrict_uid;
+	int i, n, serial;
+
+	decode_cnt++;
+	if (sscanf(cred, "fake:%d:%d:%ld:%d:%u:", &i, &serial, &encoded,
+		   &info->ttl, &restrict_uid) != 5)
+		return SLURM_AUTH_INVALID;
+	info->uid = info->gid = i;
+	info->encoded = encoded;
+	info->restrict_uid = restrict_uid;
+	for (i = 0, hex = cred; (i < 6) && hex; i++)
+		hex = strchr(hex + 1, ':');
+	if (!hex)
+		return SLURM_AUTH_INVALID;
+	hex++;
+	n = strlen(hex) / 2;
+	if (n > *len)
+		return SLURM_AUTH_INVALID;
+	for (i = 0; i < n; i++) {
+		unsigned int byte;
+		if (sscanf(hex + (i * 2), "%2x", &byte) != 1)
+			return SLURM_AUTH_INVALID;
+		p[i] = byte;
+	}
+	*len = n;
+
+	info->replayed = false;
+	for (i = 0; i < decoded_cnt; i++) {
+		if (!xstrcmp(decoded[i], cred))
+			info->replayed = true;
+	}
+	if (!info->replayed && (decoded_cnt < MAX_DECODED))
+		decoded[decoded_cnt++] = xstrdup(cred);
+	return SLURM_SUCCESS;
+}
+
+/* Each byte of the MAC depends upon the key and every byte of data */
+static void _fake_mac(const unsigned char *key, int key_len,
+		      const unsigned char *data, int data_len,
+		      unsigned char *mac)
+{
+	uint32_t hash;
+	int i, j;
+
+	for (i = 0; i < AUTH_SESSION_MAC_LEN; i++) {
+		hash = 2166136261U ^ i;
+		for (j = 0; j < key_len; j++)
+			hash = (hash ^ key[j]) * 16777619;
+		for (j = 0; j < data_len; j++)
+			hash = (hash ^ data[j]) * 16777619;
+		mac[i] = (unsigned char) (hash ^ (hash >> 8) ^ (hash >> 16));
+	}
+}
+
+/*
+ * Make the MAC of token for recipient peer with the key of its credential,
+ * as its real recipient could, see _token_mac() in auth_session.c
+ */
+static void _forge_mac(auth_session_token_t *token, char *peer,
+		       unsigned char *digest)
+{
+	unsigned char key[AUTH_SESSION_KEY_LEN], *data, *p;
+	uint64_t time64 = (uint64_t) token->time;
+	char *hex = token->cred;
+	int cred_len = strlen(token->cred), peer_len = strlen(peer), i, len;
+
+	for (i = 0; (i < 6) && hex; i++)
+		hex = strchr(hex + 1, ':');
+	hex += 1 + (8 * 2);	/* past the magic */
+	for (i = 0; i < AUTH_SESSION_KEY_LEN; i++) {
+		unsigned int byte = 0;
+		sscanf(hex + (i * 2), "%2x", &byte);
+		key[i] = byte;
+	}
+
+	len = cred_len + 12 + AUTH_SESSION_DIGEST_LEN + peer_len;
+	p = data = xmalloc(len);
+	memcpy(p, token->cred, cred_len);
+	p += cred_len;
+	for (i = 0; i < 4; i++)
+		*p++ = (unsigned char) (token->seq >> (24 - i * 8));
+	for (i = 0; i < 8; i++)
+		*p++ = (unsigned char) (time64 >> (56 - i * 8));
+	memcpy(p, digest, AUTH_SESSION_DIGEST_LEN);
+	p += AUTH_SESSION_DIGEST_LEN;
+	memcpy(p, peer, peer_len);
+	_fake_mac(key, AUTH_SESSION_KEY_LEN, data, len, token->mac);
+	xfree(data);
+}
+
+static void _token_copy(auth_session_token_t *dst, auth_session_token_t *src)
+{
+	memcpy(dst, src, sizeof(auth_session_token_t));
+	dst->cred = xstrdup(src->cred);
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned char body[AUTH_SESSION_DIGEST_LEN];
+	unsigned char other_body[AUTH_SESSION_DIGEST_LEN];
+	static auth_session_token_t tokens[NMSGS];
+	auth_session_token_t copy, other, tok;
+	char *peer = "10.0.0.1:6817", *other_peer = "10.0.0.2:6818";
+	int uid = 1234, other_uid = 0, i, rc, ok;
+	uid_t me = geteuid(), got_uid = 0;
+	gid_t got_gid = 0;
+	void *dummy;
+
+	memset(body, 1, sizeof(body));
+	memset(other_body, 2, sizeof(other_body));
+
+	ok = 1;
+	for (i = 0; i < NMSGS; i++) {
+		if (auth_session_sign(&tokens[i], NULL, peer, me, body, 300,
+				      _fake_encode, _fake_mac, &uid) !=
+		    SLURM_SUCCESS)
+			ok = 0;
+	}
+	TEST(ok, "sign tokens");
+	TEST(encode_cnt == 1, "one credential encoded per session");
+
+	/* Verify out of order within the window, newest first */
+	ok = 1;
+	for (i = NMSGS - 1; i >= NMSGS - 512; i--) {
+		rc = auth_session_verify(&tokens[i], peer, body, _fake_decode,
+					 _fake_mac, NULL, &got_uid, &got_gid);
+		if ((rc != SLURM_SUCCESS) || (got_uid != uid))
+			ok = 0;
+	}
+	TEST(ok, "verify tokens out of order");
+	TEST(decode_cnt == 1, "one credential decoded per session");
+
+	rc = auth_session_verify(&tokens[NMSGS - 1], peer, body, _fake_decode,
+				 _fake_mac, NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "replayed token rejected");
+
+	rc = auth_session_verify(&tokens[0], peer, body, _fake_decode,
+				 _fake_mac, NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "token older than window rejected");
+
+	_token_copy(&copy, &tokens[NMSGS - 513]);
+	copy.mac[0] ^= 1;
+	rc = auth_session_verify(&copy, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "altered MAC rejected");
+	copy.mac[0] ^= 1;
+	copy.seq++;
+	rc = auth_session_verify(&copy, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "altered sequence number rejected");
+	auth_session_token_free(&copy);
+
+	rc = auth_session_verify(&tokens[NMSGS - 513], peer, other_body,
+				 _fake_decode, _fake_mac, NULL, &got_uid,
+				 &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "token with another body rejected");
+	rc = auth_session_verify(&tokens[NMSGS - 513], other_peer, body,
+				 _fake_decode, _fake_mac, NULL, &got_uid,
+				 &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "token sent elsewhere rejected");
+
+	rc = auth_session_verify(&tokens[NMSGS - 513], peer, body,
+				 _fake_decode, _fake_mac, NULL, &got_uid,
+				 &got_gid);
+	TEST(rc == SLURM_SUCCESS, "untouched token still accepted");
+
+	rc = auth_session_sign(&other, NULL, other_peer, me, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	TEST((rc == SLURM_SUCCESS) && (encode_cnt == 2) &&
+	     xstrcmp(other.cred, tokens[0].cred) && (other.seq == 1),
+	     "separate session and sequence per recipient");
+	auth_session_token_free(&other);
+
+	rc = auth_session_sign(&other, "other", peer, me, body, 300,
+			       _fake_encode, _fake_mac, &other_uid);
+	TEST((rc == SLURM_SUCCESS) && (encode_cnt == 3) &&
+	     xstrcmp(other.cred, tokens[0].cred),
+	     "separate session per name");
+	rc = auth_session_verify(&other, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST((rc == SLURM_SUCCESS) && (got_uid == 0) && (decode_cnt == 2),
+	     "verify second session");
+	rc = auth_session_verify(&other, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "replay of second session rejected");
+	auth_session_token_free(&other);
+
+	/* Someone else on this host decoded the credential first */
+	rc = auth_session_sign(&tok, "third", peer, me, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	i = AUTH_SESSION_KEY_LEN + 128;
+	dummy = xmalloc(i);
+	(void) _fake_decode(tok.cred, dummy, &i,
+			    &(auth_session_cred_info_t) {0}, NULL);
+	xfree(dummy);
+	rc = auth_session_verify(&tok, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID,
+	     "credential decoded elsewhere starts no session");
+	auth_session_token_free(&tok);
+
+	/* The lifetime counts from when the credential was made */
+	encode_offset = -400;
+	rc = auth_session_sign(&tok, "fourth", peer, me, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	encode_offset = 0;
+	rc = auth_session_verify(&tok, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID, "session expired by encode time");
+	auth_session_token_free(&tok);
+
+	/* The session key must only be readable by the recipient */
+	rc = auth_session_sign(&tok, "fifth", peer, (uid_t) NO_VAL, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	TEST(rc == SLURM_ERROR, "no session for a recipient of unknown uid");
+	auth_session_token_free(&tok);
+
+	rc = auth_session_sign(&tok, "sixth", peer, me + 1, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	rc = auth_session_verify(&tok, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID,
+	     "credential made for another uid rejected");
+	auth_session_token_free(&tok);
+
+	encode_unrestricted = true;
+	rc = auth_session_sign(&tok, "seventh", peer, me, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	encode_unrestricted = false;
+	rc = auth_session_verify(&tok, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID,
+	     "credential anyone could decode rejected");
+	auth_session_token_free(&tok);
+
+	/* A credential for another address, with a MAC made for this one */
+	rc = auth_session_sign(&tok, "eighth", other_peer, me, body, 300,
+			       _fake_encode, _fake_mac, &uid);
+	_forge_mac(&tok, peer, body);
+	rc = auth_session_verify(&tok, peer, body, _fake_decode, _fake_mac,
+				 NULL, &got_uid, &got_gid);
+	TEST(rc == SLURM_AUTH_INVALID,
+	     "credential made for another address rejected");
+	auth_session_token_free(&tok);
+
+	i = encode_cnt;
+	auth_session_forget(peer);
+	rc = auth_session_sign(&tok, NULL, peer, me, body, 300, _fake_encode,
+			       _fake_mac, &uid);
+	TEST((rc == SLURM_SUCCESS) && (encode_cnt == i + 1) && (tok.seq == 1),
+	     "new session after forgetting the recipient");
+	auth_session_token_free(&tok);
+
+	for (i = 0; i < NMSGS; i++)
+		auth_session_token_free(&tokens[i]);
+	for (i = 0; i < decoded_cnt; i++)
+		xfree(decoded[i]);
+	auth_session_fini();
+
+	totals();
+	return failed;
+}
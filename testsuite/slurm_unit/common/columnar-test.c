@@ -0,0 +1,143 @@
+/* Test of src/common/columnar.c, reading back a dump written to a file.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <src/common/columnar.h>
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NROWS 1000
+
+static char *data = NULL;
+
+static uint32_t _u32(uint64_t offset)
+{
+	uint32_t val;
+
+	memcpy(&val, data + offset, sizeof(val));
+	return val;
+}
+
+static uint64_t _u64(uint64_t offset)
+{
+	uint64_t val;
+
+	memcpy(&val, data + offset, sizeof(val));
+	return val;
+}
+
+/* offset of field (0: type, 1: data_offset, 2: dict_cnt) of column col */
+static uint64_t _entry(int col, int field)
+{
+	uint64_t entry = 32 + col * 40;
+
+	if (field == 0)
+		return _u32(entry);
+	if (field == 1)
+		return _u64(entry + 16);
+	return _u64(entry + 32);
+}
+
+static int _valid(int col, uint64_t row)
+{
+	return (_u64(_entry(col, 1) + (row / 64) * 8) >> (row % 64)) & 1;
+}
+
+/* string of row in string column col, NULL if null */
+static char *_str(int col, uint64_t row, uint64_t row_cnt)
+{
+	uint64_t base = _entry(col, 1), dict_cnt = _entry(col, 2);
+	uint64_t index_off = base + ((row_cnt + 63) / 64) * 8;
+	uint64_t offsets_off = index_off + ((row_cnt * 4 + 7) & ~7);
+	uint64_t chars_off = offsets_off + (dict_cnt + 1) * 8;
+
+	if (!_valid(col, row))
+		return NULL;
+	return data + chars_off +
+	       _u64(offsets_off + _u32(index_off + row * 4) * 8);
+}
+
+static int64_t _int(int col, uint64_t row, uint64_t row_cnt)
+{
+	return (int64_t) _u64(_entry(col, 1) + ((row_cnt + 63) / 64) * 8 +
+			      row * 8);
+}
+
+int
+main(int argc, char *argv[])
+{
+	columnar_t *dump = columnar_create();
+	FILE *fp = tmpfile();
+	char name[32], *str;
+	uint64_t row_cnt;
+	long len;
+	int i, ok;
+
+	note("Testing columnar_write");
+	TEST(columnar_add_column(dump, "Name", COLUMNAR_STRING) == 0,
+	     "add string column");
+	TEST(columnar_add_column(dump, "Start", COLUMNAR_TIME) == 1,
+	     "add time column");
+	for (i = 0; i < NROWS; i++) {
+		snprintf(name, sizeof(name), "job%d", i % 10);
+		if (i % 7)
+			columnar_set_str(dump, 0, name);
+		if (i % 5)
+			columnar_set_int64(dump, 1, 1500000000 + i);
+		/* a value of the wrong type is ignored */
+		columnar_set_uint64(dump, 0, 1);
+		columnar_end_row(dump);
+	}
+	/* an unfinished row is not written */
+	columnar_set_str(dump, 0, "job1");
+	TEST(columnar_write(dump, fp) == 0, "write");
+	columnar_destroy(dump);
+
+	len = ftell(fp);
+	data = malloc(len);
+	rewind(fp);
+	TEST(fread(data, 1, len, fp) == len, "read back");
+	fclose(fp);
+
+	TEST(!memcmp(data, COLUMNAR_MAGIC, 8), "magic");
+	TEST(_u32(8) == COLUMNAR_VERSION, "version");
+	TEST(_u32(12) == COLUMNAR_BYTE_ORDER, "byte order");
+	row_cnt = _u64(16);
+	TEST(row_cnt == NROWS, "row count");
+	TEST(_u32(24) == 2, "column count");
+	TEST(!strcmp(data + _u64(32 + 8), "Name"), "column name");
+	TEST(!strcmp(data + _u64(72 + 8), "Start"), "second column name");
+	TEST(_entry(0, 0) == COLUMNAR_STRING, "string type");
+	TEST(_entry(1, 0) == COLUMNAR_TIME, "time type");
+	TEST(_entry(0, 2) == 10, "dictionary count");
+	TEST(!(_entry(0, 1) % 8) && !(_entry(1, 1) % 8), "alignment");
+
+	for (i = 0, ok = 1; i < NROWS; i++) {
+		snprintf(name, sizeof(name), "job%d", i % 10);
+		str = _str(0, i, row_cnt);
+		if ((i % 7) ? (!str || strcmp(str, name)) : (str != NULL))
+			ok = 0;
+		if (_valid(1, i) != ((i % 5) != 0))
+			ok = 0;
+		if ((i % 5) && (_int(1, i, row_cnt) != 1500000000 + i))
+			ok = 0;
+		if (!(i % 5) && _int(1, i, row_cnt))
+			ok = 0;
+	}
+	TEST(ok, "values and nulls");
+	TEST(!_valid(0, NROWS), "unfinished row");
+
+	free(data);
+	totals();
+	return failed;
+}
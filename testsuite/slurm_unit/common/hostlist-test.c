@@ -0,0 +1,211 @@
+/* Test of src/common/hostlist.c lookups and set operations, with timings
+ * on lists of 100k hosts.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <src/common/hostlist.h>
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NHOSTS 100000
+
+static struct timeval tv_start;
+
+static void _start(void)
+{
+	gettimeofday(&tv_start, NULL);
+}
+
+static void _stop(const char *what)
+{
+	struct timeval tv_end;
+	long usec;
+
+	gettimeofday(&tv_end, NULL);
+	usec = (tv_end.tv_sec - tv_start.tv_sec) * 1000000 +
+	       (tv_end.tv_usec - tv_start.tv_usec);
+	note("%s: %ld usec", what, usec);
+}
+
+/* hostset of the hosts n0..n(NHOSTS-1) whose number is a multiple of step */
+static hostset_t _multiples(int step)
+{
+	hostlist_t hl = hostlist_create(NULL);
+	hostset_t set;
+	char name[32], *str;
+	int i;
+
+	for (i = 0; i < NHOSTS; i += step) {
+		snprintf(name, sizeof(name), "n%d", i);
+		hostlist_push_host(hl, name);
+	}
+	str = hostlist_ranged_string_malloc(hl);
+	set = hostset_create(str);
+	free(str);
+	hostlist_destroy(hl);
+	return set;
+}
+
+static int _string_is(hostset_t set, const char *expect)
+{
+	char buf[256];
+
+	if (hostset_ranged_string(set, sizeof(buf), buf) < 0)
+		return 0;
+	return !strcmp(buf, expect);
+}
+
+int
+main(int argc, char *argv[])
+{
+	note("Testing hostlist_uniq");
+	{
+		hostlist_t hl = hostlist_create(NULL);
+		char name[32], *str;
+		int i;
+
+		/* push every host twice, in an order nothing can join */
+		for (i = 0; i < NHOSTS; i++) {
+			snprintf(name, sizeof(name), "n%d",
+				 (int) (((long) i * 7919) % NHOSTS));
+			hostlist_push_host(hl, name);
+			hostlist_push_host(hl, name);
+		}
+		_start();
+		hostlist_uniq(hl);
+		_stop("hostlist_uniq of 200k single host ranges");
+		str = hostlist_ranged_string_malloc(hl);
+		TEST(hostlist_count(hl) == NHOSTS, "uniq count");
+		TEST(!strcmp(str, "n[0-99999]"), "uniq string");
+		free(str);
+		hostlist_destroy(hl);
+	}
+
+	note("Testing hostset_find");
+	{
+		hostset_t set = _multiples(2);
+		char name[32];
+		int i, ok = 1;
+
+		_start();
+		for (i = 0; i < NHOSTS; i++) {
+			snprintf(name, sizeof(name), "n%d", i);
+			if (hostset_find(set, name) != ((i % 2) ? -1 : (i / 2)))
+				ok = 0;
+		}
+		_stop("hostset_find of 100k hosts in 50k ranges");
+		TEST(ok, "find positions");
+		TEST(hostset_within(set, "n[0,2,99998]"), "within");
+		TEST(!hostset_within(set, "n[0-2]"), "not within");
+		TEST(hostset_intersects(set, "n[1-2]"), "intersects");
+		TEST(!hostset_intersects(set, "n[1,3,99999]"), "no intersect");
+		hostset_destroy(set);
+
+		/* sorted as login,n[08-12] */
+		set = hostset_create("n[08-12],login");
+		TEST(hostset_find(set, "n09") == 2, "find padded");
+		TEST(hostset_find(set, "n10") == 3, "find past padding");
+		TEST(hostset_find(set, "n9") == -1, "find unpadded");
+		TEST(hostset_find(set, "n010") == -1, "find wider");
+		TEST(hostset_find(set, "login") == 0, "find single host");
+		TEST(hostset_within(set, "n[09-11],login"), "within padded");
+		TEST(!hostset_within(set, "n[8-9]"), "not within unpadded");
+		hostset_destroy(set);
+
+		set = hostset_create("nid0000[2-7]");
+		TEST(hostset_find(set, "nid00004") == 2, "find digit prefix");
+		TEST(hostset_within(set, "nid[00002-00003]"),
+		     "within digit prefix");
+		hostset_destroy(set);
+	}
+
+	note("Testing hostlist_delete");
+	{
+		/* hostlist_create() limits a single range to 64k hosts */
+		hostset_t set = hostset_create("n[0-49999],n[50000-99999]");
+		hostlist_t hl = hostlist_create("n3,n1,n2,n5,login");
+		char *str;
+		int n;
+
+		TEST(hostlist_delete(hl, "n[1-2],login,n7") == 3,
+		     "delete count");
+		str = hostlist_ranged_string_malloc(hl);
+		TEST(!strcmp(str, "n[3,5]"), "delete keeps order");
+		free(str);
+		hostlist_destroy(hl);
+
+		hl = hostlist_create("n1,n1,n2");
+		TEST(hostlist_delete(hl, "n1") == 1, "delete first duplicate");
+		TEST(hostlist_count(hl) == 2, "delete duplicate count");
+		hostlist_destroy(hl);
+
+		_start();
+		n = hostset_delete(set, "n[1000-49999],n[50000-98999]");
+		_stop("hostset_delete of 98k hosts");
+		TEST(n == 98000, "delete range count");
+		TEST(_string_is(set, "n[0-999,99000-99999]"), "delete range");
+		hostset_destroy(set);
+	}
+
+	note("Testing hostset_union/intersection/difference");
+	{
+		hostset_t a = _multiples(2), b = _multiples(3), c;
+		hostset_t lo = hostset_create("n[0-59999]");
+		hostset_t hi = hostset_create("n[40000-99999]");
+
+		_start();
+		c = hostset_union(a, b);
+		_stop("hostset_union of 50k and 33k ranges");
+		TEST(hostset_count(c) == 66667, "union count");
+		TEST(hostset_within(c, "n[0,2,3,4,6,99999]"), "union hosts");
+		TEST(!hostset_intersects(c, "n[1,5,7,99997]"), "union missing");
+		hostset_destroy(c);
+
+		_start();
+		c = hostset_intersection(a, b);
+		_stop("hostset_intersection of 50k and 33k ranges");
+		TEST(hostset_count(c) == 16667, "intersection count");
+		TEST(hostset_within(c, "n[0,6,99996]"), "intersection hosts");
+		TEST(!hostset_intersects(c, "n[2,3,4]"), "intersection missing");
+		hostset_destroy(c);
+
+		_start();
+		c = hostset_difference(a, b);
+		_stop("hostset_difference of 50k and 33k ranges");
+		TEST(hostset_count(c) == 33333, "difference count");
+		TEST(hostset_within(c, "n[2,4,8,99998]"), "difference hosts");
+		TEST(!hostset_intersects(c, "n[0,3,6]"), "difference missing");
+		hostset_destroy(c);
+
+		c = hostset_union(lo, hi);
+		TEST(_string_is(c, "n[0-99999]"), "union ranges");
+		hostset_destroy(c);
+		c = hostset_intersection(lo, hi);
+		TEST(_string_is(c, "n[40000-59999]"), "intersection ranges");
+		hostset_destroy(c);
+		c = hostset_difference(lo, hi);
+		TEST(_string_is(c, "n[0-39999]"), "difference ranges");
+		hostset_destroy(c);
+		c = hostset_difference(lo, lo);
+		TEST(hostset_count(c) == 0, "difference with itself");
+		hostset_destroy(c);
+
+		hostset_destroy(a);
+		hostset_destroy(b);
+		hostset_destroy(lo);
+		hostset_destroy(hi);
+	}
+
+	totals();
+	return failed;
+}
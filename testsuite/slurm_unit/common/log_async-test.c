@@ -0,0 +1,102 @@
+/* Test of asynchronous logging in src/common/log.c: messages which do not
+ * fit in the queue are dropped and counted, and log_fini() writes out every
+ * message queued before it, even while the log options are being altered.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "src/common/log.h"
+#include "src/common/xmalloc.h"
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NMSGS 1000
+
+static volatile int altering = 1;
+
+/* Keep changing the options producers read while they log */
+static void *_alter_thread(void *arg)
+{
+	while (altering) {
+		log_set_timefmt(LOG_FMT_SHORT);
+		log_set_timefmt(LOG_FMT_ISO8601_MS);
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	log_options_t log_opts = LOG_OPTS_INITIALIZER;
+	char path[] = "/tmp/log_async-test.XXXXXX";
+	char line[4096], *big;
+	pthread_t thread;
+	FILE *fp;
+	int fd, i, found = 0, in_order = 1, big_seen = 0;
+	uint32_t dropped;
+
+	if ((fd = mkstemp(path)) < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	close(fd);
+
+	log_opts.stderr_level  = LOG_LEVEL_QUIET;
+	log_opts.syslog_level  = LOG_LEVEL_QUIET;
+	log_opts.logfile_level = LOG_LEVEL_INFO;
+	log_init("log_async-test", log_opts, 0, path);
+
+	/* One slot has a 1024 byte budget, so this can never be queued */
+	log_set_async(1);
+	dropped = log_async_dropped();
+	big = xmalloc(4000);
+	memset(big, 'x', 3999);
+	info("big %s", big);
+	xfree(big);
+	TEST(log_async_dropped() == dropped + 1,
+	     "message larger than the queue dropped and counted");
+
+	/* Room for every message, so none may be lost */
+	log_set_async(NMSGS * 2);
+	pthread_create(&thread, NULL, _alter_thread, NULL);
+	for (i = 0; i < NMSGS; i++)
+		info("msg %d", i);
+	altering = 0;
+	pthread_join(thread, NULL);
+	TEST(log_async_dropped() == dropped + 1, "no message dropped");
+	log_fini();
+
+	if (!(fp = fopen(path, "r"))) {
+		perror("fopen");
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		char *p = strstr(line, "] msg ");
+		if (strstr(line, "] big "))
+			big_seen = 1;
+		if (!p)
+			continue;
+		if (atoi(p + 6) != found)
+			in_order = 0;
+		found++;
+	}
+	fclose(fp);
+	unlink(path);
+
+	TEST(!big_seen, "dropped message not written");
+	TEST(found == NMSGS, "all queued messages written by log_fini");
+	TEST(in_order, "messages written in order");
+
+	totals();
+	return failed;
+}
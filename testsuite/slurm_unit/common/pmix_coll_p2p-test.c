@@ -0,0 +1,303 @@
+/* Test of the ring and Bruck fence algorithms of the mpi/pmix plugin in
+ * src/plugins/mpi/pmix/pmixp_coll_p2p.c. All nodes of the collective are
+ * simulated in one process: the messages they send are queued and delivered
+ * in random order, and for every node count, power of two or not, each node
+ * must hand libpmix the contribution of every node exactly once, fence after
+ * fence. The plugin's server and libpmix calls are replaced by stubs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/plugins/mpi/pmix/pmixp_common.h"
+#include "src/plugins/mpi/pmix/pmixp_client.h"
+#include "src/plugins/mpi/pmix/pmixp_coll.h"
+#include "src/plugins/mpi/pmix/pmixp_server.h"
+
+/* the plugin headers pull in <sys/wait.h>, keep clear of its wait() */
+#define wait dejagnu_wait
+#include <testsuite/dejagnu.h>
+#undef wait
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NFENCES 4
+#define MAX_NODES 100
+
+typedef struct {
+	int dest;
+	uint32_t seq;
+	char *data;
+	uint32_t size;
+	/* completion still to be reported, PMIXP_P2P_REGULAR */
+	pmixp_server_sent_cb_t cb;
+	void *cb_data;
+} msg_t;
+
+typedef struct {
+	pmixp_coll_t coll;
+	int fence;		/* next fence to contribute to */
+	int done;		/* fences delivered to libpmix */
+	int errors;		/* fences delivered with bad data */
+} node_t;
+
+pmix_jobinfo_t _pmixp_job_info;
+
+static node_t nodes[MAX_NODES];
+static int nnodes;
+static msg_t *msgs;
+static int msg_cnt, msg_size, sent_cnt;
+static msg_t *cbs;
+static int cb_cnt, cb_size;
+
+/* The sender travels in place of the collective's process set */
+int pmixp_coll_pack_info(pmixp_coll_t *coll, Buf buf)
+{
+	pack32(coll->my_peerid, buf);
+	return SLURM_SUCCESS;
+}
+
+Buf pmixp_server_buf_new(void)
+{
+	return init_buf(BUF_SIZE);
+}
+
+int pmixp_server_send_nb(pmixp_ep_t *ep, pmixp_srv_cmd_t type,
+			 uint32_t seq, Buf buf,
+			 pmixp_server_sent_cb_t complete_cb,
+			 void *cb_data)
+{
+	msg_t *msg;
+
+	if (msg_cnt >= msg_size) {
+		msg_size = MAX(1024, msg_size * 2);
+		xrealloc(msgs, sizeof(msg_t) * msg_size);
+	}
+	msg = &msgs[msg_cnt++];
+	msg->dest = ep->ep.nodeid;
+	msg->seq = seq;
+	msg->size = get_buf_offset(buf);
+	msg->data = xmalloc(msg->size);
+	memcpy(msg->data, get_buf_data(buf), msg->size);
+	sent_cnt++;
+
+	/* report half of the completions inline, the rest later */
+	if (rand() % 2) {
+		complete_cb(SLURM_SUCCESS, PMIXP_P2P_INLINE, cb_data);
+		return SLURM_SUCCESS;
+	}
+	if (cb_cnt >= cb_size) {
+		cb_size = MAX(1024, cb_size * 2);
+		xrealloc(cbs, sizeof(msg_t) * cb_size);
+	}
+	cbs[cb_cnt].cb = complete_cb;
+	cbs[cb_cnt].cb_data = cb_data;
+	cb_cnt++;
+	return SLURM_SUCCESS;
+}
+
+/* Check that data holds the contribution of every node to fence once */
+void pmixp_lib_modex_invoke(void *mdx_fn, int status, const char *data,
+			    size_t ndata, void *cbdata, void *rel_fn,
+			    void *rel_data)
+{
+	node_t *node = (node_t *) cbdata;
+	char seen[MAX_NODES];
+	const char *p = data, *end = data + ndata;
+	int fence, id, len, i;
+
+	memset(seen, 0, sizeof(seen));
+	if (status != SLURM_SUCCESS)
+		node->errors++;
+	while (status == SLURM_SUCCESS && p < end) {
+		if ((sscanf(p, "<%d:%d:%n", &fence, &id, &len) != 2) ||
+		    (fence != node->done) || (id < 0) || (id >= nnodes) ||
+		    seen[id]) {
+			node->errors++;
+			break;
+		}
+		seen[id] = 1;
+		p += len;
+		/* contributions have different sizes */
+		for (i = 0; i < id % 7; i++, p++) {
+			if ((p >= end) || (*p != 'x'))
+				break;
+		}
+		if ((p >= end) || (*p != '>')) {
+			node->errors++;
+			break;
+		}
+		p++;
+	}
+	for (i = 0; i < nnodes; i++) {
+		if (!seen[i]) {
+			node->errors++;
+			break;
+		}
+	}
+	node->done++;
+
+	if (rel_fn)
+		((void (*)(void *)) rel_fn)(rel_data);
+}
+
+/* Stands in for the callback of libpmix, which the collective only passes
+ * back to pmixp_lib_modex_invoke() */
+static void _modex_cb(void)
+{
+}
+
+static void _contrib(node_t *node, int id)
+{
+	char data[64];
+	int len, i;
+
+	len = snprintf(data, sizeof(data), "<%d:%d:", node->fence, id);
+	for (i = 0; i < id % 7; i++)
+		data[len++] = 'x';
+	data[len++] = '>';
+	if (pmixp_coll_p2p_contrib_local(&node->coll, data, len,
+					 (void *) _modex_cb, node) ==
+	    SLURM_SUCCESS)
+		node->fence++;
+}
+
+static void _deliver(int inx)
+{
+	msg_t msg = msgs[inx];
+	uint32_t sender;
+	Buf buf;
+
+	msgs[inx] = msgs[--msg_cnt];
+	buf = create_buf(msg.data, msg.size);
+	unpack32(&sender, buf);
+	pmixp_coll_p2p_contrib_peer(&nodes[msg.dest].coll, sender, msg.seq,
+				    buf);
+	free_buf(buf);
+}
+
+static void _complete(int inx)
+{
+	msg_t msg = cbs[inx];
+
+	cbs[inx] = cbs[--cb_cnt];
+	msg.cb(SLURM_SUCCESS, PMIXP_P2P_REGULAR, msg.cb_data);
+}
+
+/* Run NFENCES fences of type on n nodes, RET the number of bad nodes */
+static int _run(pmixp_coll_type_t type, int n, int *msgs_per_fence)
+{
+	hostlist_t hl;
+	char hosts[32];
+	int i, id, ready, bad = 0, stuck = 0;
+
+	snprintf(hosts, sizeof(hosts), "n[0-%d]", n - 1);
+	hl = hostlist_create(hosts);
+	_pmixp_job_info.job_hl = hl;
+	_pmixp_job_info.nnodes_job = n;
+	nnodes = n;
+	sent_cnt = 0;
+
+	for (id = 0; id < n; id++) {
+		node_t *node = &nodes[id];
+		memset(node, 0, sizeof(node_t));
+#ifndef NDEBUG
+		node->coll.magic = PMIXP_COLL_STATE_MAGIC;
+#endif
+		node->coll.type = type;
+		node->coll.peers_cnt = n;
+		node->coll.my_peerid = id;
+		slurm_mutex_init(&node->coll.lock);
+		if (pmixp_coll_p2p_init(&node->coll, hl) != SLURM_SUCCESS)
+			bad++;
+	}
+	if (bad) {
+		hostlist_destroy(hl);
+		return bad;
+	}
+
+	/*
+	 * Contribute, deliver and complete in random order. A node only
+	 * starts the next fence once libpmix got the previous one, but its
+	 * peers may already be sending it data for the next one.
+	 */
+	while (!stuck) {
+		int choice;
+
+		for (id = 0, ready = 0; id < n; id++) {
+			if ((nodes[id].fence == nodes[id].done) &&
+			    (nodes[id].fence < NFENCES))
+				ready++;
+		}
+		if (!ready && !msg_cnt && !cb_cnt)
+			break;
+		choice = rand() % (ready + msg_cnt + cb_cnt);
+		if (choice < ready) {
+			for (id = 0; id < n; id++) {
+				if ((nodes[id].fence == nodes[id].done) &&
+				    (nodes[id].fence < NFENCES) &&
+				    (choice-- == 0))
+					break;
+			}
+			i = nodes[id].fence;
+			_contrib(&nodes[id], id);
+			if (nodes[id].fence == i)
+				stuck = 1;
+		} else if (choice < (ready + msg_cnt)) {
+			_deliver(choice - ready);
+		} else {
+			_complete(choice - ready - msg_cnt);
+		}
+	}
+
+	for (id = 0; id < n; id++) {
+		if (nodes[id].errors || (nodes[id].done != NFENCES))
+			bad++;
+		pmixp_coll_p2p_free(&nodes[id].coll);
+		slurm_mutex_destroy(&nodes[id].coll.lock);
+	}
+	hostlist_destroy(hl);
+	*msgs_per_fence = sent_cnt / NFENCES;
+
+	return bad;
+}
+
+int main(int argc, char *argv[])
+{
+	int counts[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 16, 17, 31, 32, 33,
+			 64, 100 };
+	int i, n, steps, per_fence;
+	char msg[128];
+
+	srand(1);
+	_pmixp_job_info.hostname = "test";
+
+	for (i = 0; i < (sizeof(counts) / sizeof(counts[0])); i++) {
+		n = counts[i];
+
+		snprintf(msg, sizeof(msg), "ring fence on %d nodes", n);
+		TEST(!_run(PMIXP_COLL_TYPE_FENCE_RING, n, &per_fence), msg);
+		snprintf(msg, sizeof(msg), "ring fence on %d nodes sends "
+			 "N * (N - 1) messages", n);
+		TEST(per_fence == (n * (n - 1)), msg);
+
+		snprintf(msg, sizeof(msg), "bruck fence on %d nodes", n);
+		TEST(!_run(PMIXP_COLL_TYPE_FENCE_BRUCK, n, &per_fence), msg);
+		for (steps = 0; (1 << steps) < n; steps++)
+			;
+		snprintf(msg, sizeof(msg), "bruck fence on %d nodes sends "
+			 "N * ceil(log2(N)) messages", n);
+		TEST(per_fence == (n * steps), msg);
+	}
+
+	xfree(msgs);
+	xfree(cbs);
+
+	totals();
+	return failed;
+}